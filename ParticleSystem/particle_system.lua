@@ -14,6 +14,7 @@ project "ParticleSystem"
         "**.vert", 
         "**.frag",
         "**.comp",
+        "**.glsl",
         "**.json"
     }
 
@@ -107,6 +108,13 @@ project "ParticleSystem"
             '%{file.directory}/%{file.name}.spv'
         }
 
+        -- Shared code included by the shaders, recompiles them when it changes
+        buildinputs
+        {
+            "shaders/prefix_scan.glsl",
+            "shaders/morton.glsl"
+        }
+
     -- prebuild command to automatically compile .vert/.frag/.comp files for Linux
     filter { "files:**.vert or **.frag or **.comp", "system:linux" }
         -- A message to display while this build step is running (optional)
@@ -126,6 +134,13 @@ project "ParticleSystem"
             '%{file.directory}/%{file.name}.spv'
         }
 
+        -- Shared code included by the shaders, recompiles them when it changes
+        buildinputs
+        {
+            "shaders/prefix_scan.glsl",
+            "shaders/morton.glsl"
+        }
+
     filter "system:windows"
         staticruntime "On"
         systemversion "latest"
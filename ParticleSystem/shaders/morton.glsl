@@ -0,0 +1,18 @@
+// Z-order (Morton) codes of 2D cells, shared by the reorder and the Barnes-Hut tree
+
+// Spreads the low 16 bits over the even bits
+uint spread_bits(uint value)
+{
+    value &= 0x0000FFFFu;
+    value = (value | (value << 8)) & 0x00FF00FFu;
+    value = (value | (value << 4)) & 0x0F0F0F0Fu;
+    value = (value | (value << 2)) & 0x33333333u;
+    value = (value | (value << 1)) & 0x55555555u;
+    return value;
+}
+
+// Interleaves the low 16 bits of both axes, x on the even bits
+uint morton_code(uvec2 cell)
+{
+    return spread_bits(cell.x) | (spread_bits(cell.y) << 1);
+}
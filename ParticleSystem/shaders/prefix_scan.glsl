@@ -0,0 +1,64 @@
+// Workgroup exclusive prefix scan, shared by the counting sorts of the grid, the reorder and the Barnes-Hut tree
+// Expects WORKGROUP_SIZE and a BlockSums buffer named blockSums declared before the include.
+// Every invocation scans 4 consecutive values, a block is SCAN_BLOCK_SIZE values.
+
+#define SCAN_BLOCK_SIZE (4u * WORKGROUP_SIZE)
+
+shared uint scanTotals[WORKGROUP_SIZE];
+
+// Exclusive prefix sums of the 4 values of every invocation over the whole workgroup, total is the sum of the block
+uvec4 scan_block(uvec4 values, out uint total)
+{
+    uint lid = gl_LocalInvocationIndex;
+    uvec4 inclusive = uvec4(values.x, values.x + values.y, values.x + values.y + values.z, values.x + values.y + values.z + values.w);
+
+    // Hillis-Steele over the invocation totals
+    scanTotals[lid] = inclusive.w;
+    barrier();
+    for (uint offset = 1; offset < uint(WORKGROUP_SIZE); offset *= 2)
+    {
+        uint value = lid >= offset ? scanTotals[lid - offset] : 0u;
+        barrier();
+        scanTotals[lid] += value;
+        barrier();
+    }
+
+    total = scanTotals[WORKGROUP_SIZE - 1];
+    uint prefix = scanTotals[lid] - inclusive.w;
+    return uvec4(prefix) + inclusive - values;
+}
+
+uint load_block_sum(uint block, uint blockCount)
+{
+    return block < blockCount ? blockSums.sums[block] : 0u;
+}
+
+void store_block_sum(uint block, uint blockCount, uint sum)
+{
+    if (block < blockCount)
+    {
+        blockSums.sums[block] = sum;
+    }
+}
+
+// Exclusive prefix sums of the block sums in place, run by a single workgroup
+// Walks the block sums SCAN_BLOCK_SIZE at a time, carrying the running total
+void scan_block_sums(uint blockCount)
+{
+    uint carry = 0;
+    for (uint chunk = 0; chunk < blockCount; chunk += SCAN_BLOCK_SIZE)
+    {
+        uint first = chunk + 4u * gl_LocalInvocationIndex;
+        uvec4 values = uvec4(load_block_sum(first, blockCount), load_block_sum(first + 1, blockCount), load_block_sum(first + 2, blockCount), load_block_sum(first + 3, blockCount));
+
+        uint total;
+        uvec4 starts = uvec4(carry) + scan_block(values, total);
+        store_block_sum(first, blockCount, starts.x);
+        store_block_sum(first + 1, blockCount, starts.y);
+        store_block_sum(first + 2, blockCount, starts.z);
+        store_block_sum(first + 3, blockCount, starts.w);
+
+        carry += total;
+        barrier();
+    }
+}
@@ -4,7 +4,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <vector>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstring>
 #include <stdexcept>
 #include <random>
@@ -16,11 +18,18 @@
 #include "Particle.h"
 #include "FrameTimeHistory.h"
 #include "FPSCounter.h"
+#include "ParticleImporter.h"
+#include "Profiler.h"
+#include "JobSystem.h"
 
 namespace VulkanCore {
 
-	ApplicationConfiguration::ApplicationConfiguration(const WindowConfiguration& windowConfig)
+	ApplicationConfiguration::ApplicationConfiguration(const WindowConfiguration& windowConfig, const std::string& sweepFilePath, const std::string& checkpointFilePath, const std::string& importFilePath, const std::string& metricsEndpoint)
 		: windowConfig(windowConfig)
+		, sweepFilePath(sweepFilePath)
+		, checkpointFilePath(checkpointFilePath)
+		, importFilePath(importFilePath)
+		, metricsEndpoint(metricsEndpoint)
 	{
 
 	}
@@ -32,68 +41,477 @@ namespace VulkanCore {
 		, renderer(window, device)
 		, ui(window, inputManager, device, renderer)
 		, bIsRunning(true)
+		, bIsRenderThreadRunning(false)
+		, renderThreadException(nullptr)
 		, particleCount(131072 * 64) // 8_388_608
 		, lastUpdate(0.0)
+		, frameCapture(device)
 		, captureInputTimer(0.0f)
+		, particleSeed(static_cast<unsigned>(std::time(nullptr)))
+		, substeps(1)
+		, tickSubsteps(1)
+		, bWasInBenchmark(false)
+		, bIsBenchmarkReseeded(false)
+		, benchmarkFrameCount(0)
+		, benchmarkSweep(std::nullopt)
+		, sweepState(SweepState::Apply)
+		, sweepWarmupFramesLeft(0)
+		, bExitAfterSweep(false)
+		, particleCheckpoint(device)
+		, trajectoryRecorder(device)
+		, tickCount(0)
+		, gpuProfiler(device)
+		, pipelineStatistics(device)
+		, metricsExporter(device)
+		, nbodySimulation(device)
+		, simulationMode(SimulationMode::Attractor)
+		, fluidSimulation(device)
+		, particleEmitters(device)
+		, spatialGrid(device)
+		, particleReorder(device)
+		, reorderInterval(0)
 	{
 		lastUpdate = glfwGetTime();
 
 		// Buffers Setup
 		CreateShaderStorageBuffer();
 		CreateUniformBuffer();
+		CreateForceSourceBuffer();
+		particleEmitters.SetUniformBuffer(uniformBuffer, sizeof(UniformBufferObject));
 
 		// Descriptors Setup
-		CreateDescriptorPool();
 		CreateDescriptorSetLayout();
 		CreateDescriptorSets();
 
 		// Pipelines
 		CreatePipeline();
+
+		if (!config.importFilePath.empty())
+		{
+			ui.SetImportFilePath(config.importFilePath);
+			ImportParticles(config.importFilePath);
+		}
+
+		if (!config.checkpointFilePath.empty())
+		{
+			RestoreCheckpoint(config.checkpointFilePath);
+		}
+
+		if (!config.metricsEndpoint.empty())
+		{
+			metricsExporter.Start(config.metricsEndpoint);
+		}
+
+		if (!config.sweepFilePath.empty())
+		{
+			bExitAfterSweep = true;
+			StartSweep(config.sweepFilePath);
+		}
 	}
 
 	Application::~Application()
 	{
 		// Cleanup
 		CleanupUniformBuffer();
+		CleanupForceSourceBuffer();
 		CleanupShaderStorageBuffer();
 	}
 
 	void Application::Run()
 	{
-		time.Start(Time::Now());
-		FPSCounter::GetInstance().Start(time);
+		Profiler::GetInstance().SetThreadName("Main");
+
+		// The main thread only pumps window events and samples input, a stall in vkQueuePresentKHR or vkWaitForFences
+		// on the render thread no longer delays them
+		bIsRenderThreadRunning.store(true, std::memory_order_relaxed);
+		renderThread = std::thread(&Application::RenderLoop, this);
 
-		while (!window.ShouldClose() && bIsRunning)
+		while (bIsRenderThreadRunning.load(std::memory_order_acquire))
 		{
 			window.Update();
+		}
+
+		renderThread.join();
+		if (renderThreadException)
+		{
+			std::rethrow_exception(renderThreadException);
+		}
+	}
+
+	void Application::RenderLoop()
+	{
+		Profiler::GetInstance().SetThreadName("Render");
 
-			// Empty submission
-			renderer.SyncNewFrame();
+		try
+		{
+			time.Start(Time::Now());
+			FPSCounter::GetInstance().Start(time);
+
+			while (!window.ShouldClose() && bIsRunning)
+			{
+				PROFILE_ZONE("Frame");
+				gpuProfiler.NewFrame();
+				pipelineStatistics.NewFrame();
 
-			Update();
-			Draw();
+				// Empty submission
+				{
+					PROFILE_ZONE("Renderer::SyncNewFrame");
+					renderer.SyncNewFrame();
+				}
+
+				Update();
+				Draw();
+
+				FrameTimeHistory::GetInstance().MarkLatency(LatencyMarker::PresentSubmitted, Time::Now());
+
+				// Frame limiter, benchmark replay renders as fast as it can
+				if (!inputManager.GetIsInBenchmark())
+				{
+					PROFILE_ZONE("FramePacer::Wait");
+					framePacer.Wait();
+				}
+
+				FrameTimeHistory::GetInstance().MarkLatency(LatencyMarker::FrameEnd, Time::Now());
+			}
+
+			vkDeviceWaitIdle(device.GetVKDevice());
+		}
+		catch (...)
+		{
+			// Rethrown on the main thread by Run
+			renderThreadException = std::current_exception();
 		}
 
-		vkDeviceWaitIdle(device.GetVKDevice());
+		bIsRenderThreadRunning.store(false, std::memory_order_release);
+		window.Wake();
 	}
 
 	void Application::Reset()
 	{
+		ui.ToggleShouldReset();
+
+		// The sweep owns the settings until it finishes
+		if (benchmarkSweep.has_value())
+		{
+			return;
+		}
+
+		substeps = ui.GetSubsteps();
+		ApplySampleCount(ui.GetSampleCount());
+
+		if (ui.GetImportInitialState())
+		{
+			ImportParticles(ui.GetImportFilePath());
+			return;
+		}
+
 		particleCount = ui.GetParticleCount();
+		RestartSimulation(static_cast<unsigned>(std::time(nullptr)));
+	}
+
+	void Application::RestartSimulation(unsigned seed)
+	{
+		if (simulationMode == SimulationMode::NBodyAllPairs && particleCount > NBodySimulation::MAX_DIRECT_BODY_COUNT)
+		{
+			std::cout << "All-pairs N-body is limited to " << NBodySimulation::MAX_DIRECT_BODY_COUNT << " bodies, " << particleCount << " requested" << std::endl;
+			particleCount = NBodySimulation::MAX_DIRECT_BODY_COUNT;
+		}
+
+		particleSeed = seed;
+		RecreateShaderStorageBuffer();
+	}
+
+	// Never blocks, the readback is picked up by ParticleCheckpoint::Poll once the GPU is done with it
+	void Application::SaveCheckpoint(const std::string& filePath)
+	{
+		if (!particleCheckpoint.Save(filePath, shaderStorageBuffer, particleCount, particleSeed))
+		{
+			std::cout << "ERROR: The previous checkpoint is still being saved" << std::endl;
+		}
+	}
+
+	void Application::RestoreCheckpoint(const std::string& filePath)
+	{
+		try
+		{
+			MappedFile file(filePath, MappedFileMode::Read);
+			const CheckpointHeader& header = ParticleCheckpoint::ReadHeader(file);
+
+			// The simulation is dispatched in workgroups of 64 particles
+			if (header.particleCount % 64 != 0 || header.particleCount > GetMaxParticleCount())
+			{
+				throw std::runtime_error("ERROR: " + filePath + " has " + std::to_string(header.particleCount) + " particles, expected a multiple of 64 up to " + std::to_string(GetMaxParticleCount()));
+			}
+
+			const Time restoreStartTime = Time::Now();
+
+			particleCount = static_cast<uint32_t>(header.particleCount);
+			particleSeed = header.seed;
+			RecreateShaderStorageBuffer(ParticleCheckpoint::GetParticleData(file));
+
+			std::cout << "Checkpoint restored from " << filePath << ": " << particleCount << " particles in "
+				<< TimeToMilliseconds<double>(Time::Now() - restoreStartTime) << "ms" << std::endl;
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << e.what() << std::endl;
+		}
+	}
+
+	void Application::ImportParticles(const std::string& filePath)
+	{
+		try
+		{
+			const Time importStartTime = Time::Now();
+
+			const ParticleImporter importer(filePath);
+			if (importer.GetParticleCount() > GetMaxParticleCount())
+			{
+				throw std::runtime_error("ERROR: " + filePath + " has " + std::to_string(importer.GetParticleCount()) + " particles, this GPU supports up to " + std::to_string(GetMaxParticleCount()));
+			}
+
+			// The simulation is dispatched in workgroups of 64 particles, the remainder is left out
+			const uint32_t importedParticleCount = static_cast<uint32_t>(importer.GetParticleCount() / 64 * 64);
+			if (importedParticleCount == 0)
+			{
+				throw std::runtime_error("ERROR: " + filePath + " has less than 64 particles");
+			}
+
+			if (importedParticleCount != importer.GetParticleCount())
+			{
+				std::cout << "Imported particle count rounded down to a multiple of 64, " << importer.GetParticleCount() - importedParticleCount << " particles left out" << std::endl;
+			}
+
+			particleCount = importedParticleCount;
+			RecreateShaderStorageBuffer(importer.GetParticles());
+
+			std::cout << "Imported " << particleCount << " particles from " << filePath << " in "
+				<< TimeToMilliseconds<double>(Time::Now() - importStartTime) << "ms" << std::endl;
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << e.what() << std::endl;
+		}
+	}
+
+	uint32_t Application::GetMaxParticleCount() const
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(device.GetPhysicalDevice(), &properties);
+
+		return static_cast<uint32_t>(properties.limits.maxStorageBufferRange / sizeof(Particle)) / 64u * 64u;
+	}
+
+	void Application::ApplySampleCount(VkSampleCountFlagBits sampleCount)
+	{
+		const VkSampleCountFlagBits previousSampleCount = renderer.GetSampleCount();
+		renderer.SetPreferredSampleCount(sampleCount);
+
+		// Pipelines are only compatible with render passes that have the same attachments
+		if (renderer.GetSampleCount() != previousSampleCount)
+		{
+			CreatePipeline();
+			ui.RecreateRendererBackend();
+		}
+	}
+
+	void Application::ApplySimulationMode(SimulationMode mode)
+	{
+		const SimulationMode previousMode = simulationMode;
+		simulationMode = mode;
+
+		// Both N-body kernels continue the same bodies, any other switch starts from the initial state of the new mode
+		if (NBodySimulation::GetIsNBodyMode(previousMode) && NBodySimulation::GetIsNBodyMode(mode)
+			&& (mode != SimulationMode::NBodyAllPairs || particleCount <= NBodySimulation::MAX_DIRECT_BODY_COUNT))
+		{
+			nbodySimulation.ResetEnergy();
+			return;
+		}
+
+		RestartSimulation(particleSeed);
+	}
+
+	void Application::StartSweep(const std::string& sweepFilePath)
+	{
+		if (benchmarkSweep.has_value() || inputManager.GetIsInBenchmark())
+		{
+			return;
+		}
+
+		try
+		{
+			benchmarkSweep.emplace(BenchmarkSweep::LoadJSON(sweepFilePath));
+		}
+		catch (const std::exception& e)
+		{
+			benchmarkSweep = std::nullopt;
+			std::cout << e.what() << std::endl;
+			bIsRunning = !bExitAfterSweep;
+			return;
+		}
+
+		std::cout << "Benchmark sweep: " << benchmarkSweep->GetCellCount() << " runs" << std::endl;
+		sweepState = SweepState::Apply;
+	}
+
+	void Application::ApplySweepCell()
+	{
+		const SweepCell& cell = benchmarkSweep->GetCurrentCell();
+
+		particleCount = cell.particleMultiplier * BenchmarkSweep::PARTICLES_PER_MULTIPLIER;
+		substeps = cell.substeps;
+		reorderInterval = cell.reorderInterval;
+
+		framePacer.SetPolicy(cell.framePacingPolicy);
+		renderer.SetPreferredPresentMode(FramePacer::GetPresentMode(cell.framePacingPolicy));
+		ApplySampleCount(static_cast<VkSampleCountFlagBits>(cell.sampleCount));
+
+		RestartSimulation(BENCHMARK_SEED);
+
+		// Let shader caches, clocks and the driver settle before measuring
+		sweepState = SweepState::Warmup;
+		sweepWarmupFramesLeft = benchmarkSweep->GetWarmupFrames();
+	}
+
+	// Called before the UI frame is built, applying a cell may recreate the ImGui backend
+	void Application::UpdateSweep()
+	{
+		if (!benchmarkSweep.has_value() || sweepState == SweepState::Running)
+		{
+			return;
+		}
+
+		if (sweepState == SweepState::Apply)
+		{
+			ApplySweepCell();
+			return;
+		}
+
+		if (sweepWarmupFramesLeft > 0)
+		{
+			--sweepWarmupFramesLeft;
+			return;
+		}
+
+		inputManager.StartBenchmark(benchmarkSweep->GetCurrentCell().benchmark);
+		if (!inputManager.GetIsInBenchmark())
+		{
+			std::cout << "ERROR: Benchmark sweep aborted, the scenario could not be started" << std::endl;
+			FinishSweep();
+			return;
+		}
+
+		sweepState = SweepState::Running;
+	}
+
+	void Application::FinishSweep()
+	{
+		try
+		{
+			benchmarkSweep->WriteCSV(benchmarkSweep->GetOutputFilePath());
+			std::cout << "Benchmark sweep results written to " << benchmarkSweep->GetOutputFilePath() << std::endl;
+
+			const std::string& csvFilePath = benchmarkSweep->GetOutputFilePath();
+			const std::string histogramsFilePath = csvFilePath.substr(0, csvFilePath.rfind('.')) + "-histograms.json";
+			benchmarkSweep->WriteHistograms(histogramsFilePath);
+			std::cout << "Benchmark sweep frame time histograms written to " << histogramsFilePath << std::endl;
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << e.what() << std::endl;
+		}
+		benchmarkSweep->PrintSummary(std::cout);
+
+		benchmarkSweep = std::nullopt;
+
+		// Back to the settings from the UI
 		ui.ToggleShouldReset();
+		if (bExitAfterSweep)
+		{
+			bIsRunning = false;
+		}
+	}
 
-		vkDeviceWaitIdle(device.GetVKDevice());
+	void Application::OnBenchmarkFinished()
+	{
+		const uint64_t stepCount = inputManager.GetBenchmarkStep();
+		const double elapsed = TimeToSeconds<double>(Time::Now() - benchmarkStartTime);
+		std::cout << "Benchmark finished: " << stepCount << " steps of " << particleCount << " particles in " << elapsed << "s, "
+			<< static_cast<double>(stepCount) * static_cast<double>(particleCount) * static_cast<double>(tickSubsteps) / elapsed << " particle-steps/s" << std::endl;
+
+		// Statistics over the raw frame times, startup and shader compilation frames are detected and excluded
+		const FrameTimeSummary frameTimeSummary = BenchmarkAnalyzer::Summarize(benchmarkFrameTimes);
+		BenchmarkAnalyzer::PrintSummary(std::cout, frameTimeSummary);
+
+		const PipelineStatisticsAverages pipelineStatisticsAverages = pipelineStatistics.GetAverages();
+		PipelineStatistics::PrintAverages(std::cout, pipelineStatisticsAverages, particleCount);
+		gpuProfiler.PrintAverages(std::cout);
+
+		const Benchmark benchmark = inputManager.GetLastBenchmark();
+		const std::string frameTimesFilePath = "benchmark-test-" + std::to_string(static_cast<uint32_t>(benchmark)) + "-frametimes.csv";
+		const std::string histogramFilePath = "benchmark-test-" + std::to_string(static_cast<uint32_t>(benchmark)) + "-histogram.json";
+		try
+		{
+			BenchmarkAnalyzer::SaveFrameTimes(frameTimesFilePath, benchmarkFrameTimes);
 
-		CleanupShaderStorageBuffer();
-		CreateShaderStorageBuffer();
+			std::ofstream histogramFile(histogramFilePath);
+			if (!histogramFile)
+			{
+				throw std::runtime_error("ERROR: Failed to open " + histogramFilePath + "!");
+			}
+			histogramFile << benchmarkFrameTimeHistogram.ToJSON().dump() << std::endl;
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << e.what() << std::endl;
+		}
 
-		UpdateUniformBuffer();
+		if (Profiler::GetInstance().GetIsEnabled())
+		{
+			Profiler::GetInstance().ExportChromeTrace("benchmark-test-" + std::to_string(static_cast<uint32_t>(benchmark)) + "-trace.json");
+		}
 
-		CreateDescriptorSets();
+		if (!benchmarkSweep.has_value() || sweepState != SweepState::Running)
+		{
+			// Compare against the previous run of the same scenario in this session
+			if (const auto it = previousBenchmarkFrameTimes.find(benchmark); it != previousBenchmarkFrameTimes.end())
+			{
+				std::cout << "Compared to the previous run:" << std::endl;
+				BenchmarkAnalyzer::PrintComparison(std::cout, BenchmarkAnalyzer::Compare(it->second, benchmarkFrameTimes));
+			}
+			previousBenchmarkFrameTimes[benchmark] = benchmarkFrameTimes;
+			return;
+		}
+
+		SweepResult result = {};
+		result.cell = benchmarkSweep->GetCurrentCell();
+		result.appliedSampleCount = static_cast<uint32_t>(renderer.GetSampleCount());
+		result.appliedSubsteps = tickSubsteps;
+		result.stepCount = stepCount;
+		result.frameCount = benchmarkFrameCount;
+		result.seconds = elapsed;
+		result.frameTimeSummary = frameTimeSummary;
+		result.frameTimeHistogram = benchmarkFrameTimeHistogram;
+		result.pipelineStatistics = pipelineStatisticsAverages;
+		result.simulationZone = gpuProfiler.GetAverage("Simulation");
+		result.reorderZone = gpuProfiler.GetAverage("Reorder");
+		result.renderPassZone = gpuProfiler.GetAverage("Render Pass");
+		benchmarkSweep->Record(result);
+
+		if (benchmarkSweep->GetIsFinished())
+		{
+			FinishSweep();
+		}
+		else
+		{
+			sweepState = SweepState::Apply;
+		}
 	}
 
 	void Application::Update()
 	{
+		PROFILE_ZONE("Application::Update");
+
 		// Update Delta Time
 		time.NewFrameFromNow(Time::Now());
 		FPSCounter::GetInstance().NewFrame(time);
@@ -105,6 +523,9 @@ namespace VulkanCore {
 			Reset();
 		}
 
+		// Advance the Benchmark Sweep
+		UpdateSweep();
+
 		// Update Uniform Buffer if window has been resized
 		if (window.GetWasWindowResized())
 		{
@@ -112,180 +533,493 @@ namespace VulkanCore {
 		}
 
 		// Update Input Manager
-		inputManager.Update(time.deltaTimeFloat);
+		inputManager.Update();
+		const Time inputSampleTime = inputManager.GetInputSampleTime();
+		FrameTimeHistory::GetInstance().MarkLatency(LatencyMarker::InputSampled, inputManager.GetIsInBenchmark() || inputSampleTime.IsZero() ? Time::Now() : inputSampleTime);
 		
 		// Update UI
-		ui.Update();
+		{
+			PROFILE_ZONE("UserInterface::Update");
+			ui.Update();
+		}
 
-		// Update the application, only tick once every 15 milliseconds
-		static constexpr float TICK_MILLIS = 0.015f;
+		// Update Benchmark Sweep
+		if (ui.GetStartSweep())
+		{
+			ui.ResetStartSweep();
+			StartSweep("benchmark/sweep.json");
+		}
+
+		// Update Recording Benchmark, measured while drawing
+		if (ui.GetStartRecordingBenchmark())
+		{
+			ui.ResetStartRecordingBenchmark();
+			if (!recordingBenchmark.has_value())
+			{
+				recordingBenchmark.emplace(JobSystem::GetInstance().GetThreadCount());
+				std::cout << "Recording benchmark started" << std::endl;
+			}
+		}
+
+		if (recordingBenchmark.has_value() && recordingBenchmark->GetIsFinished())
+		{
+			recordingBenchmark->PrintResults(std::cout);
+			recordingBenchmark = std::nullopt;
+		}
+
+		// Restore Checkpoint, a benchmark or sweep owns the simulation state until it finishes
+		if (ui.GetLoadCheckpoint())
+		{
+			ui.ResetLoadCheckpoint();
+			if (!benchmarkSweep.has_value() && !inputManager.GetIsInBenchmark())
+			{
+				RestoreCheckpoint(CHECKPOINT_FILE_PATH);
+			}
+		}
+
+		// Update Simulation Mode, a benchmark or sweep owns the simulation state until it finishes
+		if (ui.GetSimulationMode() != simulationMode && !benchmarkSweep.has_value() && !inputManager.GetIsInBenchmark())
+		{
+			ApplySimulationMode(ui.GetSimulationMode());
+		}
+
+		// Validate N-Body, the readback is taken by the next tick
+		if (ui.GetValidateNBody())
+		{
+			ui.ResetValidateNBody();
+			if (!NBodySimulation::GetIsNBodyMode(simulationMode))
+			{
+				std::cout << "ERROR: N-body validation needs an N-body simulation mode" << std::endl;
+			}
+			else if (!nbodySimulation.Validate())
+			{
+				std::cout << "ERROR: The previous N-body validation is still running" << std::endl;
+			}
+		}
+
+		// Update Fluid, a new smoothing length waits for the GPU before reallocating the grid
+		fluidSimulation.SetParameters(ui.GetFluidParameters());
+
+		// Update Emitters
+		particleEmitters.SetParameters(ui.GetEmitterParameters());
+
+		// Validate Fluid, the readback is taken by the next tick
+		if (ui.GetValidateFluid())
+		{
+			ui.ResetValidateFluid();
+			if (simulationMode != SimulationMode::Fluid)
+			{
+				std::cout << "ERROR: Fluid validation needs the fluid simulation mode" << std::endl;
+			}
+			else if (particleCount > FluidReference::MAX_PARTICLE_COUNT)
+			{
+				std::cout << "ERROR: Fluid validation is limited to " << FluidReference::MAX_PARTICLE_COUNT << " particles" << std::endl;
+			}
+			else if (!fluidSimulation.Validate())
+			{
+				std::cout << "ERROR: The previous fluid validation is still running" << std::endl;
+			}
+		}
+
+		// Update Particle Reorder, the sweep picks its own interval
+		if (!benchmarkSweep.has_value())
+		{
+			reorderInterval = ui.GetReorderInterval();
+		}
+
+		// Update Spatial Grid, a new resolution waits for the GPU before reallocating
+		if (ui.GetBuildSpatialGrid())
+		{
+			spatialGrid.SetCellSize(ui.GetSpatialGridCellSize());
+		}
+
+		// Update Frame Pacing, the sweep picks its own policy
+		if (!benchmarkSweep.has_value() && ui.GetFramePacingPolicy() != framePacer.GetPolicy())
+		{
+			framePacer.SetPolicy(ui.GetFramePacingPolicy());
+			renderer.SetPreferredPresentMode(FramePacer::GetPresentMode(ui.GetFramePacingPolicy()));
+		}
+
+		if (!benchmarkSweep.has_value() && ui.GetTargetFPS() != framePacer.GetTargetFPS())
+		{
+			framePacer.SetTargetFPS(ui.GetTargetFPS());
+		}
+
+		// Update Pipeline Statistics, a few frames old
+		ui.SetPipelineStatistics(pipelineStatistics.GetIsSupported(), pipelineStatistics.GetLatest(), particleCount);
+
+		// Update Profiler
+		Profiler::GetInstance().SetEnabled(ui.GetProfilerEnabled());
+		if (ui.GetExportProfile())
+		{
+			ui.ResetExportProfile();
+			Profiler::GetInstance().ExportChromeTrace(PROFILE_FILE_PATH);
+		}
+
+		// Update Metrics Exporter, only snapshots once per publish interval
+		metricsExporter.Publish(time, particleCount, gpuProfiler);
+
+		// Update Frame Capture, a capture stopped by Record is refused by Start and resets the toggle
+		if (ui.GetCaptureVideo() && !frameCapture.GetIsCapturing())
+		{
+			const uint32_t frameRate = framePacer.GetPolicy() == FramePacingPolicy::TargetFPS ? framePacer.GetTargetFPS() : FramePacer::DEFAULT_TARGET_FPS;
+			frameCapture.Start(std::string("captured-video") + FrameCapture::GetFileExtension(ui.GetCaptureVideoFormat()), ui.GetCaptureVideoFormat(), frameRate, renderer.GetSwapChain()->GetSupportsTransferSource());
+			if (!frameCapture.GetIsCapturing())
+			{
+				ui.ResetCaptureVideo();
+			}
+		}
+		else if (!ui.GetCaptureVideo() && frameCapture.GetIsCapturing())
+		{
+			frameCapture.Stop();
+		}
+		frameCapture.Poll();
+
+		// Update Trajectory Recording, RecreateShaderStorageBuffer stops a recording whose particle count changed
+		if (ui.GetRecordTrajectory() && !trajectoryRecorder.GetIsRecording())
+		{
+			trajectoryRecorder.Start("trajectory.pstr", particleCount, ui.GetTrajectoryParticleStride(), ui.GetTrajectoryTickInterval());
+			if (!trajectoryRecorder.GetIsRecording())
+			{
+				ui.ResetRecordTrajectory();
+			}
+		}
+		else if (!ui.GetRecordTrajectory() && trajectoryRecorder.GetIsRecording())
+		{
+			trajectoryRecorder.Stop();
+		}
+		trajectoryRecorder.Poll();
+
+		// Update N-Body energy, SyncNewFrame waited for the last tick
+		nbodySimulation.Poll();
+		ui.SetNBodyEnergy(nbodySimulation.GetHasEnergy(), nbodySimulation.GetEnergy(), nbodySimulation.GetHasEnergy() ? nbodySimulation.GetEnergyDrift() : 0.0);
+		fluidSimulation.Poll();
+		particleEmitters.Poll();
+		ui.SetEmitterCounters(particleEmitters.GetHasCounters(), particleEmitters.GetCounters());
+
+		// Update the application
 		static float lastTickTime = time.timeFloat;
-		if (float deltaTickTime = time.timeFloat - lastTickTime; deltaTickTime >= TICK_MILLIS)
+		if (inputManager.GetIsInBenchmark() && !bWasInBenchmark && !bIsBenchmarkReseeded)
+		{
+			// Reseeding millions of particles takes longer than a frame, it gets a frame of its own before the clock starts
+			// The scenario is not stepped, the replay begins with the next frame
+			if (const std::optional<SimulationMode> benchmarkMode = inputManager.GetBenchmarkSimulationMode())
+			{
+				simulationMode = *benchmarkMode;
+			}
+
+			// Once per run, the particle buffer and its descriptor pool are replaced so repeated runs allocate nothing extra
+			RestartSimulation(BENCHMARK_SEED);
+			bIsBenchmarkReseeded = true;
+			lastTickTime = time.timeFloat;
+		}
+		else if (inputManager.GetIsInBenchmark())
 		{
-			Tick(deltaTickTime);
+			if (!bWasInBenchmark)
+			{
+				// The delta time of this frame still covers the reseed, the first recorded frame is the next one
+				bIsBenchmarkReseeded = false;
+				benchmarkStartTime = Time::Now();
+				benchmarkFrameCount = 0;
+				benchmarkFrameTimes.clear();
+				benchmarkFrameTimeHistogram.Reset();
+				pipelineStatistics.ResetAverages();
+				gpuProfiler.ResetAverages();
+				bWasInBenchmark = true;
+
+				// The trace exported at the end covers the benchmark only
+				Profiler::GetInstance().Clear();
+			}
+			else
+			{
+				++benchmarkFrameCount;
+				benchmarkFrameTimes.push_back(TimeToMilliseconds<double>(time.deltaTime));
+				benchmarkFrameTimeHistogram.Record(time.deltaTime);
+			}
+
+			// Deterministic replay, one fixed step per frame driven by the scenario clock instead of the wall-clock
+			if (inputManager.StepBenchmark(TICK_SECONDS))
+			{
+				Tick(TICK_SECONDS);
+			}
 			lastTickTime = time.timeFloat;
 		}
+		else
+		{
+			if (bWasInBenchmark)
+			{
+				bWasInBenchmark = false;
+				OnBenchmarkFinished();
+			}
+			bIsBenchmarkReseeded = false;
+
+			// Only tick once every 15 milliseconds
+			if (float deltaTickTime = time.timeFloat - lastTickTime; deltaTickTime >= TICK_SECONDS)
+			{
+				Tick(deltaTickTime);
+				lastTickTime = time.timeFloat;
+			}
+		}
+
+		// Save Checkpoint, after the simulation step so the snapshot matches what is drawn this frame
+		if (ui.GetSaveCheckpoint())
+		{
+			ui.ResetSaveCheckpoint();
+			SaveCheckpoint(CHECKPOINT_FILE_PATH);
+		}
+		particleCheckpoint.Poll();
 	}
 
 	// Tick the application state based on the wall-clock time since the last tick deltaTime seconds since last frame
 	void Application::Tick(const float deltaTime)
 	{
+		PROFILE_ZONE("Application::Tick");
+
 		// Capture Input
-		static bool wasCapturingInput = false;
 		if (ui.GetCaptureInput())
 		{
-			if (!wasCapturingInput)
+			if (!inputCapture.GetIsCapturing())
 			{
 				captureInputTimer = 0.0f;
-				wasCapturingInput = true;
+				inputCapture.Start("captured-input.bin", "captured-input.json");
 			}
 
 			captureInputTimer += deltaTime;
-			if (captureInputTimer > std::numeric_limits<double>::max())
-			{
-				ui.ResetCaptureInput();
-			}
 
-			nlohmann::json currentMousePosition;
-			currentMousePosition["x"] = inputManager.GetMousePosition().x;
-			currentMousePosition["y"] = inputManager.GetMousePosition().y;
-			currentMousePosition["time"] = captureInputTimer;
-			currentMousePosition["interpolate"] = true;
-			captureInputJSON["mousePosition"].push_back(currentMousePosition);
-
-			nlohmann::json currentMouseButtonLeftPressed;
-			currentMouseButtonLeftPressed["value"] = inputManager.GetMouseButtonLeftPressed();
-			currentMouseButtonLeftPressed["time"] = captureInputTimer;
-			captureInputJSON["mouseButtonLeftPressed"].push_back(currentMouseButtonLeftPressed);
+			InputRecord record = {};
+			record.time = captureInputTimer;
+			record.mouseX = static_cast<float>(inputManager.GetMousePosition().x);
+			record.mouseY = static_cast<float>(inputManager.GetMousePosition().y);
+			record.mouseButtonLeftPressed = inputManager.GetMouseButtonLeftPressed() ? 1 : 0;
+			inputCapture.Push(record);
 		}
-		else
+		else if (inputCapture.GetIsCapturing())
 		{
-			std::ofstream fout("captured-input.json");
-			fout << captureInputJSON.dump(4);
-			fout.close();
-			wasCapturingInput = false;
+			inputCapture.Stop();
 		}
 
 		const float world_width = static_cast<float>(window.GetWidth()) / static_cast<float>(window.GetHeight());
 
 		// Update Push-Constants
 		PushConstants pushConstantsData = {};
-		pushConstantsData.enabled = (!ui.GetIsUIFocused() && inputManager.GetMouseButtonLeftPressed()) ? 1 : 0;
+		pushConstantsData.enabled = ((inputManager.GetIsInBenchmark() || !ui.GetIsUIFocused()) && inputManager.GetMouseButtonLeftPressed()) ? 1 : 0;
 		pushConstantsData.attractor = glm::vec2(
 			glm::mix(-world_width, world_width, inputManager.GetMousePosition().x / window.GetWidth()),
 			glm::mix(1.0f, -1.0f, inputManager.GetMousePosition().y / window.GetHeight())
 		);
-		pushConstantsData.timestep = deltaTime;
+		// The leapfrog of the N-body modes only conserves energy with a constant step, they advance a fixed tick
+		const bool bIsNBody = NBodySimulation::GetIsNBodyMode(simulationMode);
+		const bool bIsFluid = simulationMode == SimulationMode::Fluid;
+		const bool bIsEmitters = simulationMode == SimulationMode::Emitters;
+		const float tickSeconds = bIsNBody ? TICK_SECONDS : deltaTime;
+
+		// The fluid never steps past its stable timestep, it takes as many substeps as the tick needs up to MAX_FLUID_SUBSTEPS
+		// and only runs slower than real time past that
+		tickSubsteps = substeps;
+		if (bIsFluid)
+		{
+			const float stableTimestep = fluidSimulation.GetStableTimestep();
+			const float neededSubsteps = glm::min(std::ceil(tickSeconds / stableTimestep), static_cast<float>(MAX_FLUID_SUBSTEPS));
+			tickSubsteps = glm::max(substeps, static_cast<uint32_t>(neededSubsteps));
+
+			pushConstantsData.timestep = glm::min(tickSeconds / static_cast<float>(tickSubsteps), stableTimestep);
+			ui.SetFluidSubsteps(tickSubsteps, pushConstantsData.timestep * static_cast<float>(tickSubsteps) / tickSeconds);
+		}
+		else
+		{
+			pushConstantsData.timestep = tickSeconds / static_cast<float>(tickSubsteps);
+		}
+
+		// Scripted force sources of the benchmark, SyncNewFrame waited for the last tick that read the buffer
+		const ForceField& forceField = inputManager.GetBenchmarkForceField();
+		forceField.Evaluate(inputManager.GetBenchmarkTime(), static_cast<ForceSource*>(forceSourceBufferMapped));
+		pushConstantsData.forceSourceCount = forceField.GetSourceCount();
 
 		// Compute submission
 		if (VkCommandBuffer commandBuffer = renderer.BeginCompute())
 		{
-			particleSystemPipeline->BindComputePipeline(commandBuffer);
-			vkCmdPushConstants(commandBuffer, particleSystemPipeline->GetComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstantsData);
-			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particleSystemPipeline->GetComputePipelineLayout(), 0, 1, &particleSystemComputeDescriptorSet, 0, nullptr);
-			vkCmdDispatch(commandBuffer, particleCount / 64u, 1, 1);
+			// Particle indices change, a trajectory has to follow the same particles and the emitter lists hold slot indices
+			if (reorderInterval > 0 && tickCount % reorderInterval == 0 && !trajectoryRecorder.GetIsRecording() && !bIsEmitters)
+			{
+				const uint32_t reorderZone = gpuProfiler.BeginZone(commandBuffer, "Reorder");
+				particleReorder.Record(commandBuffer);
+				gpuProfiler.EndZone(commandBuffer, reorderZone);
+			}
+
+			const uint32_t simulationZone = gpuProfiler.BeginZone(commandBuffer, "Simulation");
+			pipelineStatistics.ResetQuery(commandBuffer, PipelineStatisticsScope::Simulation);
+			pipelineStatistics.BeginQuery(commandBuffer, PipelineStatisticsScope::Simulation);
+
+			if (bIsEmitters)
+			{
+				particleEmitters.RecordEmit(commandBuffer, deltaTime);
+			}
+			else if (!bIsNBody && !bIsFluid)
+			{
+				particleSystemPipeline->BindComputePipeline(commandBuffer);
+				vkCmdPushConstants(commandBuffer, particleSystemPipeline->GetComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushConstants), &pushConstantsData);
+				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, particleSystemPipeline->GetComputePipelineLayout(), 0, 1, &particleSystemComputeDescriptorSet, 0, nullptr);
+			}
+
+			for (uint32_t substep = 0; substep < tickSubsteps; ++substep)
+			{
+				// Each substep integrates the particles written by the previous one
+				if (substep > 0)
+				{
+					VkMemoryBarrier barrier = {};
+					barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+					barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+					barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+					vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+				}
+
+				if (bIsNBody)
+				{
+					nbodySimulation.RecordStep(commandBuffer, simulationMode, pushConstantsData.timestep, substep + 1 == tickSubsteps);
+				}
+				else if (bIsFluid)
+				{
+					fluidSimulation.RecordStep(commandBuffer, pushConstantsData.timestep, pushConstantsData.attractor, pushConstantsData.enabled != 0, substep + 1 == tickSubsteps);
+				}
+				else if (bIsEmitters)
+				{
+					particleEmitters.RecordStep(commandBuffer, pushConstantsData.timestep, pushConstantsData.attractor, pushConstantsData.enabled != 0, substep + 1 == tickSubsteps);
+				}
+				else
+				{
+					vkCmdDispatch(commandBuffer, particleCount / 64u, 1, 1);
+				}
+			}
+
+			pipelineStatistics.EndQuery(commandBuffer, PipelineStatisticsScope::Simulation);
+			gpuProfiler.EndZone(commandBuffer, simulationZone);
+
+			if (ui.GetBuildSpatialGrid())
+			{
+				const uint32_t spatialGridZone = gpuProfiler.BeginZone(commandBuffer, "Spatial Grid");
+				spatialGrid.Record(commandBuffer);
+				gpuProfiler.EndZone(commandBuffer, spatialGridZone);
+			}
 		}
 		renderer.EndCompute();
+
+		// Readback behind the simulation step on the compute queue
+		trajectoryRecorder.Record(shaderStorageBuffer, tickCount);
+		++tickCount;
 	}
 
 	void Application::Draw()
 	{
+		PROFILE_ZONE("Application::Draw");
+
+		VkFence captureFence = VK_NULL_HANDLE;
+
 		// Graphics submission
 		if (VkCommandBuffer commandBuffer = renderer.BeginFrame())
 		{
-			// Pipeline Barrier
-			{
-				VkImageSubresourceRange imageSubresourceRangeInfo = {};
-				imageSubresourceRangeInfo.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				imageSubresourceRangeInfo.baseMipLevel = 0;
-				imageSubresourceRangeInfo.levelCount = 1;
-				imageSubresourceRangeInfo.baseArrayLayer = 0;
-				imageSubresourceRangeInfo.layerCount = 1;
-
-				std::array<VkImageMemoryBarrier, 2> imageMemoryBarriers = {};
-				imageMemoryBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-				imageMemoryBarriers[0].srcAccessMask = VK_ACCESS_NONE;
-				imageMemoryBarriers[0].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-				imageMemoryBarriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-				imageMemoryBarriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-				imageMemoryBarriers[0].srcQueueFamilyIndex = -1;
-				imageMemoryBarriers[0].dstQueueFamilyIndex = -1;
-				imageMemoryBarriers[0].image = renderer.GetCurrentIntermediaryImage();
-				imageMemoryBarriers[0].subresourceRange = imageSubresourceRangeInfo;
-
-				imageMemoryBarriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-				imageMemoryBarriers[1].srcAccessMask = VK_ACCESS_NONE;
-				imageMemoryBarriers[1].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-				imageMemoryBarriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-				imageMemoryBarriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-				imageMemoryBarriers[1].srcQueueFamilyIndex = -1;
-				imageMemoryBarriers[1].dstQueueFamilyIndex = -1;
-				imageMemoryBarriers[1].image = renderer.GetCurrentSwapchainImage();
-				imageMemoryBarriers[1].subresourceRange = imageSubresourceRangeInfo;
-
-				vkCmdPipelineBarrier(
-					commandBuffer,
-					VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-					VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-					VK_DEPENDENCY_BY_REGION_BIT,
-					0, nullptr,
-					0, nullptr,
-					2, imageMemoryBarriers.data()
-				);
-			}
-
-			// Draw Particle System
-			renderer.BeginSwapChainRenderPass(commandBuffer);
-			{
-				particleSystemPipeline->BindGraphicsPipeline(commandBuffer);
-				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, particleSystemPipeline->GetGraphicsPipelineLayout(), 0, 1, &particleSystemGraphicsDescriptorSet, 0, nullptr);
-				vkCmdDraw(commandBuffer, particleCount, 1, 0, 0);
+			// Timestamps can not be reset inside the render pass, the zone covers the particles and the UI subpass
+			const uint32_t renderPassZone = gpuProfiler.BeginZone(commandBuffer, "Render Pass");
+			const uint32_t drawGroupCount = GetParticleDrawGroupCount();
+			pipelineStatistics.ResetQuery(commandBuffer, PipelineStatisticsScope::ParticlePass, drawGroupCount);
+
+			// Draw Particle System, one secondary command buffer per group, recorded in parallel
+			renderer.BeginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+			{
+				PROFILE_ZONE("Record Particle Pass");
+
+				const uint32_t drawsPerGroup = recordingBenchmark.has_value() ? RecordingBenchmark::DRAWS_PER_GROUP : 1;
+				const uint32_t recordingThreadCount = recordingBenchmark.has_value() ? recordingBenchmark->GetThreadCount() : 0;
+
+				const Time recordingStartTime = Time::Now();
+				renderer.RecordSecondaryCommandBuffers(commandBuffer, SwapChain::PARTICLE_SUBPASS, drawGroupCount, [this, drawGroupCount, drawsPerGroup](VkCommandBuffer groupCommandBuffer, uint32_t group)
+				{
+					RecordParticleDrawGroup(groupCommandBuffer, group, drawGroupCount, drawsPerGroup);
+				}, recordingThreadCount);
+
+				if (recordingBenchmark.has_value())
+				{
+					recordingBenchmark->AddFrame(Time::Now() - recordingStartTime);
+				}
+			}
+
+			// Draw UI
+			renderer.NextSwapChainSubpass(commandBuffer);
+			{
+				ui.Draw(commandBuffer);
 			}
 			renderer.EndSwapChainRenderPass(commandBuffer);
+			gpuProfiler.EndZone(commandBuffer, renderPassZone);
+
+			// Copy the final image for the video capture
+			const SwapChain* swapChain = renderer.GetSwapChain().get();
+			captureFence = frameCapture.Record(commandBuffer, renderer.GetCurrentSwapchainImage(), swapChain->GetSwapChainImageFormat(), swapChain->GetSwapChainExtent(), swapChain->GetSupportsTransferSource());
+		}
+		{
+			PROFILE_ZONE("Renderer::EndFrame");
+			renderer.EndFrame(captureFence);
+		}
+	}
 
-			// Pipeline Barrier
-			{
-				VkImageSubresourceRange imageSubresourceRangeInfo = {};
-				imageSubresourceRangeInfo.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-				imageSubresourceRangeInfo.baseMipLevel = 0;
-				imageSubresourceRangeInfo.levelCount = 1;
-				imageSubresourceRangeInfo.baseArrayLayer = 0;
-				imageSubresourceRangeInfo.layerCount = 1;
-
-				std::array<VkImageMemoryBarrier, 1> imageMemoryBarriers = {};
-				imageMemoryBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-				imageMemoryBarriers[0].srcAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-				imageMemoryBarriers[0].dstAccessMask = VK_ACCESS_NONE;
-				imageMemoryBarriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-				imageMemoryBarriers[0].newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-				imageMemoryBarriers[0].srcQueueFamilyIndex = -1;
-				imageMemoryBarriers[0].dstQueueFamilyIndex = -1;
-				imageMemoryBarriers[0].image = renderer.GetCurrentSwapchainImage();
-				imageMemoryBarriers[0].subresourceRange = imageSubresourceRangeInfo;
-
-				vkCmdPipelineBarrier(
-					commandBuffer,
-					VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-					VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-					VK_DEPENDENCY_BY_REGION_BIT,
-					0, nullptr,
-					0, nullptr,
-					1, imageMemoryBarriers.data()
-				);
+	uint32_t Application::GetParticleDrawGroupCount() const
+	{
+		static_assert(RecordingBenchmark::GROUP_COUNT <= PipelineStatistics::MAX_SCOPE_PARTS, "Every draw group has its own pipeline statistics query");
+
+		if (recordingBenchmark.has_value())
+		{
+			return RecordingBenchmark::GROUP_COUNT;
+		}
+
+		// One indirect draw, only the GPU knows how many particles are alive
+		if (simulationMode == SimulationMode::Emitters)
+		{
+			return 1;
+		}
+
+		const uint32_t maxGroupCount = std::min(JobSystem::GetInstance().GetThreadCount(), PipelineStatistics::MAX_SCOPE_PARTS);
+		return std::clamp(particleCount / MIN_PARTICLES_PER_DRAW_GROUP, 1u, maxGroupCount);
+	}
+
+	// Consecutive draws of consecutive ranges, the particles are rasterized in the same order as with a single draw
+	void Application::RecordParticleDrawGroup(VkCommandBuffer commandBuffer, uint32_t group, uint32_t groupCount, uint32_t drawCount)
+	{
+		const uint64_t groupBegin = static_cast<uint64_t>(particleCount) * group / groupCount;
+		const uint64_t groupEnd = static_cast<uint64_t>(particleCount) * (group + 1) / groupCount;
+
+		pipelineStatistics.BeginQuery(commandBuffer, PipelineStatisticsScope::ParticlePass, group);
+
+		if (simulationMode == SimulationMode::Emitters)
+		{
+			if (group == 0)
+			{
+				particleEmitters.RecordDraw(commandBuffer);
 			}
+			pipelineStatistics.EndQuery(commandBuffer, PipelineStatisticsScope::ParticlePass, group);
+			return;
+		}
 
-			// Draw UI
-			ui.Draw(commandBuffer);
+		particleSystemPipeline->BindGraphicsPipeline(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, particleSystemPipeline->GetGraphicsPipelineLayout(), 0, 1, &particleSystemGraphicsDescriptorSet, 0, nullptr);
+
+		for (uint32_t draw = 0; draw < drawCount; ++draw)
+		{
+			const uint32_t first = static_cast<uint32_t>(groupBegin + (groupEnd - groupBegin) * draw / drawCount);
+			const uint32_t end = static_cast<uint32_t>(groupBegin + (groupEnd - groupBegin) * (draw + 1) / drawCount);
+			if (end > first)
+			{
+				vkCmdDraw(commandBuffer, end - first, 1, first, 0);
+			}
 		}
-		renderer.EndFrame();
+
+		pipelineStatistics.EndQuery(commandBuffer, PipelineStatisticsScope::ParticlePass, group);
 	}
 
 	void Application::CreateDescriptorPool()
 	{
+		// Exactly the compute and the graphics set, replacing the pool frees the sets of the previous particle buffer
 		particleSystemDescriptorPool = DescriptorPool::Builder(device)
-			.SetMaxSets(20 * SwapChain::MAX_FRAMES_IN_FLIGHT)
-			.AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 10 * SwapChain::MAX_FRAMES_IN_FLIGHT)			// uniform buffer
-			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 20 * SwapChain::MAX_FRAMES_IN_FLIGHT)			// x2 storage buffers
+			.SetMaxSets(2)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1)			// uniform buffer
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3)			// particles and force sources, particles
 			.Build();
 	}
 
@@ -293,6 +1027,7 @@ namespace VulkanCore {
 	{
 		particleSystemComputeDescriptorSetLayout = DescriptorSetLayout::Builder(device)
 			.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)
 			.Build();
 
 		particleSystemGraphicsDescriptorSetLayout = DescriptorSetLayout::Builder(device)
@@ -303,6 +1038,8 @@ namespace VulkanCore {
 
 	void Application::CreateDescriptorSets()
 	{
+		CreateDescriptorPool();
+
 		// Descriptor Set for Compute Pipeline
 		{
 			VkDescriptorBufferInfo storageBufferInfo = {};
@@ -310,9 +1047,19 @@ namespace VulkanCore {
 			storageBufferInfo.offset = 0;
 			storageBufferInfo.range = sizeof(Particle) * particleCount;
 
-			DescriptorWriter(*particleSystemComputeDescriptorSetLayout, *particleSystemDescriptorPool)
+			VkDescriptorBufferInfo forceSourceBufferInfo = {};
+			forceSourceBufferInfo.buffer = forceSourceBuffer;
+			forceSourceBufferInfo.offset = 0;
+			forceSourceBufferInfo.range = sizeof(ForceSource) * ForceField::MAX_SOURCE_COUNT;
+
+			const bool bIsAllocated = DescriptorWriter(*particleSystemComputeDescriptorSetLayout, *particleSystemDescriptorPool)
 				.WriteBuffer(0, storageBufferInfo)
+				.WriteBuffer(1, forceSourceBufferInfo)
 				.Build(particleSystemComputeDescriptorSet);
+			if (!bIsAllocated)
+			{
+				throw std::runtime_error("ERROR: Failed to allocate the particle compute descriptor set!");
+			}
 		}
 
 		// Descriptor Set for Graphics Pipeline
@@ -327,10 +1074,14 @@ namespace VulkanCore {
 			storageBufferInfo.offset = 0;
 			storageBufferInfo.range = sizeof(Particle) * particleCount;
 
-			DescriptorWriter(*particleSystemGraphicsDescriptorSetLayout, *particleSystemDescriptorPool)
+			const bool bIsAllocated = DescriptorWriter(*particleSystemGraphicsDescriptorSetLayout, *particleSystemDescriptorPool)
 				.WriteBuffer(0, uniformBufferInfo)
 				.WriteBuffer(1, storageBufferInfo)
 				.Build(particleSystemGraphicsDescriptorSet);
+			if (!bIsAllocated)
+			{
+				throw std::runtime_error("ERROR: Failed to allocate the particle graphics descriptor set!");
+			}
 		}
 	}
 
@@ -352,8 +1103,9 @@ namespace VulkanCore {
 		static const std::string particleFragShaderFilePath = "ParticleSystem/shaders/particle.frag.spv";
 #endif
 
-		// pipeline = std::make_unique<Pipeline>(device, renderer.GetSwapChain()->GetRenderPass(), globalSetLayout->GetDescriptorSetLayout(), Model::Vertex::GetBindingDescription(), Model::Vertex::GetAttributeDescription(), triangleVertShaderFilePath, triangleFragShaderFilePath);
-		particleSystemPipeline = std::make_unique<Pipeline>(device, renderer.GetSwapChain()->GetRenderPass(), particleSystemGraphicsDescriptorSetLayout->GetDescriptorSetLayout(), particleSystemComputeDescriptorSetLayout->GetDescriptorSetLayout(), particleVertShaderFilePath, particleFragShaderFilePath, particleComputeShaderFilePath);
+		// pipeline = std::make_unique<Pipeline>(device, renderer.GetSwapChain()->GetRenderPass(), renderer.GetSampleCount(), globalSetLayout->GetDescriptorSetLayout(), Model::Vertex::GetBindingDescription(), Model::Vertex::GetAttributeDescription(), triangleVertShaderFilePath, triangleFragShaderFilePath);
+		particleSystemPipeline = std::make_unique<Pipeline>(device, renderer.GetSwapChain()->GetRenderPass(), renderer.GetSampleCount(), particleSystemGraphicsDescriptorSetLayout->GetDescriptorSetLayout(), particleSystemComputeDescriptorSetLayout->GetDescriptorSetLayout(), particleVertShaderFilePath, particleFragShaderFilePath, particleComputeShaderFilePath);
+		particleEmitters.CreateDrawPipeline(renderer.GetSwapChain()->GetRenderPass(), renderer.GetSampleCount());
 	}
 
 	void Application::CreateUniformBuffer()
@@ -403,23 +1155,30 @@ namespace VulkanCore {
 		vkFreeMemory(device.GetVKDevice(), uniformBufferMemory, nullptr);
 	}
 
-	void Application::CreateShaderStorageBuffer()
+	void Application::CreateForceSourceBuffer()
 	{
-		// Initialize particles positions on a circle
-		std::default_random_engine randomEngine(static_cast<unsigned>(std::time(nullptr)));
-		std::uniform_real_distribution<float> randomDistribution(0.2f, 1.0f);
-		const float step = 2.0f * glm::pi<float>() / static_cast<float>(particleCount);
+		VkDeviceSize bufferSize = sizeof(ForceSource) * ForceField::MAX_SOURCE_COUNT;
 
-		std::vector<Particle> particles(particleCount);
-		for (size_t i = 0; i < particles.size(); ++i)
-		{
-			const float radius = randomDistribution(randomEngine);
-			const float angle = static_cast<float>(i) * step;
+		// Small and rewritten every tick, read straight from host memory
+		device.CreateBuffer(
+			bufferSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			forceSourceBuffer,
+			forceSourceBufferMemory
+		);
 
-			particles[i].position = glm::vec2(radius * glm::cos(angle), radius * glm::sin(angle));
-			particles[i].velocity = glm::vec2(0.0f, 0.0f);
-		}
+		vkMapMemory(device.GetVKDevice(), forceSourceBufferMemory, 0, bufferSize, 0, &forceSourceBufferMapped);
+	}
 
+	void Application::CleanupForceSourceBuffer()
+	{
+		vkDestroyBuffer(device.GetVKDevice(), forceSourceBuffer, nullptr);
+		vkFreeMemory(device.GetVKDevice(), forceSourceBufferMemory, nullptr);
+	}
+
+	void Application::CreateShaderStorageBuffer(const void* initialParticles)
+	{
 		VkDeviceSize bufferSize = sizeof(Particle) * particleCount;
 
 		// Create a staging buffer used to upload data to the GPU
@@ -436,7 +1195,62 @@ namespace VulkanCore {
 		// Filling staging buffer
 		void* data;
 		vkMapMemory(device.GetVKDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
-			std::memcpy(data, particles.data(), static_cast<size_t>(bufferSize));
+		if (initialParticles != nullptr)
+		{
+			std::memcpy(data, initialParticles, static_cast<size_t>(bufferSize));
+		}
+		else
+		{
+			// Initialize particles positions on a circle, written straight into the staging buffer
+			// Every chunk has its own engine seeded from (seed, chunk), the result does not depend on how the chunks are spread over the workers
+			const float step = 2.0f * glm::pi<float>() / static_cast<float>(particleCount);
+			const uint64_t chunkCount = (static_cast<uint64_t>(particleCount) + INIT_CHUNK_PARTICLE_COUNT - 1) / INIT_CHUNK_PARTICLE_COUNT;
+			const bool bIsGalaxy = NBodySimulation::GetIsNBodyMode(simulationMode);
+			const bool bIsFluid = simulationMode == SimulationMode::Fluid;
+			const float gravitationalConstant = nbodySimulation.GetParameters().gravitationalConstant;
+
+			Particle* particles = static_cast<Particle*>(data);
+			JobSystem::GetInstance().ParallelFor(chunkCount, 1, [this, particles, step, bIsGalaxy, bIsFluid, gravitationalConstant](uint64_t firstChunk, uint64_t endChunk)
+			{
+				for (uint64_t chunk = firstChunk; chunk < endChunk; ++chunk)
+				{
+					std::seed_seq seed{ particleSeed, static_cast<unsigned>(chunk) };
+					std::mt19937 randomEngine(seed);
+					std::uniform_real_distribution<float> randomDistribution(0.2f, 1.0f);
+					std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+
+					const uint64_t end = std::min(static_cast<uint64_t>(particleCount), (chunk + 1) * INIT_CHUNK_PARTICLE_COUNT);
+					for (uint64_t i = chunk * INIT_CHUNK_PARTICLE_COUNT; i < end; ++i)
+					{
+						if (bIsGalaxy)
+						{
+							// Uniform disk on circular orbits around the enclosed mass M r^2 / R^2, v = sqrt(G M r) / R
+							const float radius = NBodySimulation::GALAXY_RADIUS * glm::sqrt(unitDistribution(randomEngine));
+							const float angle = 2.0f * glm::pi<float>() * unitDistribution(randomEngine);
+							const float speed = glm::sqrt(gravitationalConstant * NBodySimulation::TOTAL_MASS * radius) / NBodySimulation::GALAXY_RADIUS;
+
+							particles[i].position = glm::vec2(radius * glm::cos(angle), radius * glm::sin(angle));
+							particles[i].velocity = glm::vec2(-speed * glm::sin(angle), speed * glm::cos(angle));
+							continue;
+						}
+
+						if (bIsFluid)
+						{
+							// Dam at rest in the lower left corner of the box
+							particles[i].position = FluidSimulation::GetInitialPosition(static_cast<uint32_t>(i), particleCount);
+							particles[i].velocity = glm::vec2(0.0f, 0.0f);
+							continue;
+						}
+
+						const float radius = randomDistribution(randomEngine);
+						const float angle = static_cast<float>(i) * step;
+
+						particles[i].position = glm::vec2(radius * glm::cos(angle), radius * glm::sin(angle));
+						particles[i].velocity = glm::vec2(0.0f, 0.0f);
+					}
+				}
+			});
+		}
 		vkUnmapMemory(device.GetVKDevice(), stagingBufferMemory);
 
 		// Create Shader Storage Buffer
@@ -454,6 +1268,12 @@ namespace VulkanCore {
 		// Cleanup
 		vkDestroyBuffer(device.GetVKDevice(), stagingBuffer, nullptr);
 		vkFreeMemory(device.GetVKDevice(), stagingBufferMemory, nullptr);
+
+		nbodySimulation.SetBodies(shaderStorageBuffer, particleCount);
+		fluidSimulation.SetParticles(shaderStorageBuffer, particleCount);
+		particleEmitters.SetParticles(shaderStorageBuffer, particleCount);
+		spatialGrid.SetParticles(shaderStorageBuffer, particleCount);
+		particleReorder.SetParticles(shaderStorageBuffer, particleCount);
 	}
 
 	void Application::CleanupShaderStorageBuffer()
@@ -462,4 +1282,32 @@ namespace VulkanCore {
 		vkFreeMemory(device.GetVKDevice(), shaderStorageBufferMemory, nullptr);
 	}
 
+	void Application::RecreateShaderStorageBuffer(const void* initialParticles)
+	{
+		vkDeviceWaitIdle(device.GetVKDevice());
+
+		// Imported states keep all of their bodies, all-pairs gravity hands them to the tree above its limit
+		if (simulationMode == SimulationMode::NBodyAllPairs && particleCount > NBodySimulation::MAX_DIRECT_BODY_COUNT)
+		{
+			std::cout << "All-pairs N-body is limited to " << NBodySimulation::MAX_DIRECT_BODY_COUNT << " bodies, switched to Barnes-Hut" << std::endl;
+			simulationMode = SimulationMode::NBodyBarnesHut;
+			ui.SetSimulationMode(simulationMode);
+		}
+
+		// A recording keeps the particle count it was started with, the next tick would copy past the end of the new buffer
+		if (trajectoryRecorder.GetIsRecording() && trajectoryRecorder.GetParticleCount() != particleCount)
+		{
+			std::cout << "ERROR: The particle count changed, trajectory recording stopped" << std::endl;
+			trajectoryRecorder.Stop();
+			ui.ResetRecordTrajectory();
+		}
+
+		CleanupShaderStorageBuffer();
+		CreateShaderStorageBuffer(initialParticles);
+
+		UpdateUniformBuffer();
+
+		CreateDescriptorSets();
+	}
+
 } // namespace VulkanCore
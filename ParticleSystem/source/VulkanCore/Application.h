@@ -1,15 +1,38 @@
 #pragma once
 
+#include <atomic>
+#include <exception>
 #include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unordered_map>
 
 #include "Window.h"
 #include "InputManager.h"
+#include "ForceField.h"
 #include "GPUDevice.h"
 #include "Renderer.h"
 #include "Descriptor.h"
 #include "Texture.h"
 #include "UserInterface.h"
 #include "Time.h"
+#include "FramePacer.h"
+#include "FrameCapture.h"
+#include "InputCapture.h"
+#include "ParticleCheckpoint.h"
+#include "TrajectoryRecorder.h"
+#include "GPUProfiler.h"
+#include "PipelineStatistics.h"
+#include "MetricsExporter.h"
+#include "BenchmarkSweep.h"
+#include "RecordingBenchmark.h"
+#include "NBodySimulation.h"
+#include "FluidSimulation.h"
+#include "ParticleEmitters.h"
+#include "SpatialGrid.h"
+#include "ParticleReorder.h"
 
 namespace VulkanCore {
 
@@ -17,8 +40,20 @@ namespace VulkanCore {
     {
         const WindowConfiguration windowConfig;
 
+        // Runs this sweep description on startup and exits once it is done, empty for an interactive session
+        const std::string sweepFilePath;
+
+        // Starts from this checkpoint instead of a freshly generated particle state, empty for none
+        const std::string checkpointFilePath;
+
+        // Starts from the particles in this binary or CSV file, see ParticleImporter, empty for none
+        const std::string importFilePath;
+
+        // Serves live metrics on this localhost port or Unix-domain socket path, see MetricsExporter, empty for none
+        const std::string metricsEndpoint;
+
         // Constructor
-        ApplicationConfiguration(const WindowConfiguration& windowConfig);
+        ApplicationConfiguration(const WindowConfiguration& windowConfig, const std::string& sweepFilePath = "", const std::string& checkpointFilePath = "", const std::string& importFilePath = "", const std::string& metricsEndpoint = "");
     };
 
     struct UniformBufferObject
@@ -56,14 +91,95 @@ namespace VulkanCore {
         UserInterface ui;
 
         bool bIsRunning;
+
+        // Render thread, see RenderLoop
+        std::thread renderThread;
+        std::atomic<bool> bIsRenderThreadRunning;
+        std::exception_ptr renderThreadException;
+
         uint32_t particleCount;
 
         double lastUpdate;
         TimeData time;
 
-        nlohmann::json captureInputJSON;
+        FramePacer framePacer;
+        FrameCapture frameCapture;
+
+        InputCapture inputCapture;
         float captureInputTimer;
 
+        // Benchmarks replay with a fixed seed and a fixed timestep so every run simulates the same particle-steps
+        static constexpr float TICK_SECONDS = 0.015f;
+        static constexpr unsigned BENCHMARK_SEED = 1;
+
+        // Particles generated from one random engine, the unit of work of the parallel initialization
+        static constexpr uint64_t INIT_CHUNK_PARTICLE_COUNT = 65536;
+
+        // Upper bound of the fluid substeps, stiffer fluids past it run slower than real time
+        static constexpr uint32_t MAX_FLUID_SUBSTEPS = 32;
+
+        unsigned particleSeed;
+        uint32_t substeps;
+        uint32_t tickSubsteps; // dispatched by the last tick, at least substeps
+        bool bWasInBenchmark;
+        bool bIsBenchmarkReseeded;
+        Time benchmarkStartTime;
+        uint64_t benchmarkFrameCount;
+        std::vector<double> benchmarkFrameTimes;
+        FrameTimeHistogram benchmarkFrameTimeHistogram;
+        std::unordered_map<Benchmark, std::vector<double>> previousBenchmarkFrameTimes;
+
+        // Benchmark Sweep
+        enum class SweepState : uint32_t
+        {
+            Apply = 0,
+            Warmup = 1,
+            Running = 2
+        };
+
+        std::optional<BenchmarkSweep> benchmarkSweep;
+        SweepState sweepState;
+        uint32_t sweepWarmupFramesLeft;
+        bool bExitAfterSweep;
+
+        // Parallel Recording, the particle pass is split in draw groups recorded into secondary command buffers on the job system
+        static constexpr uint32_t MIN_PARTICLES_PER_DRAW_GROUP = 1 << 16;
+
+        std::optional<RecordingBenchmark> recordingBenchmark;
+
+        // Checkpoints
+        static constexpr const char* CHECKPOINT_FILE_PATH = "checkpoint.psck";
+
+        ParticleCheckpoint particleCheckpoint;
+
+        // Trajectory Recording
+        TrajectoryRecorder trajectoryRecorder;
+        uint64_t tickCount;
+
+        // Profiling
+        static constexpr const char* PROFILE_FILE_PATH = "profile-trace.json";
+
+        GPUProfiler gpuProfiler;
+        PipelineStatistics pipelineStatistics;
+        MetricsExporter metricsExporter;
+
+        // N-Body, integrates the particle buffer in place instead of particle.comp
+        NBodySimulation nbodySimulation;
+        SimulationMode simulationMode;
+
+        // SPH fluid, integrates the particle buffer in place over its own neighbour grid
+        FluidSimulation fluidSimulation;
+
+        // Emitters, the particle buffer is a pool of slots spawned and killed on the GPU
+        ParticleEmitters particleEmitters;
+
+        // Neighbour index of the particles, rebuilt after the simulation of every tick when enabled
+        SpatialGrid spatialGrid;
+
+        // Morton reorder of the particle buffer every reorderInterval ticks, 0 never reorders
+        ParticleReorder particleReorder;
+        uint32_t reorderInterval;
+
         // Particle System Descriptors
         std::unique_ptr<DescriptorPool> particleSystemDescriptorPool;
 
@@ -83,10 +199,40 @@ namespace VulkanCore {
         VkBuffer shaderStorageBuffer;
         VkDeviceMemory shaderStorageBufferMemory;
 
+        // ForceField::MAX_SOURCE_COUNT sources, rewritten every tick
+        VkBuffer forceSourceBuffer;
+        VkDeviceMemory forceSourceBufferMemory;
+        void* forceSourceBufferMapped;
+
+        void RestartSimulation(unsigned seed);
+        void SaveCheckpoint(const std::string& filePath);
+        void RestoreCheckpoint(const std::string& filePath);
+        void ImportParticles(const std::string& filePath);
+
+        // Largest particle count a single storage buffer binding can hold on this GPU, in whole workgroups
+        uint32_t GetMaxParticleCount() const;
+        void ApplySampleCount(VkSampleCountFlagBits sampleCount);
+        void ApplySimulationMode(SimulationMode mode);
+
+        void StartSweep(const std::string& sweepFilePath);
+        void ApplySweepCell();
+        void UpdateSweep();
+        void FinishSweep();
+        void OnBenchmarkFinished();
+
+        // Render thread, owns the simulation, ImGui and every Vulkan submission
+        void RenderLoop();
+
         void Update();
         void Tick(const float deltaTime);
         void Draw();
 
+        // One group per recording thread, or the benchmark's groups
+        uint32_t GetParticleDrawGroupCount() const;
+
+        // Job thread, records the particles of one group in drawCount consecutive draws
+        void RecordParticleDrawGroup(VkCommandBuffer commandBuffer, uint32_t group, uint32_t groupCount, uint32_t drawCount);
+
         void CreateDescriptorPool();
         void CreateDescriptorSetLayout();
         void CreateDescriptorSets();
@@ -97,8 +243,13 @@ namespace VulkanCore {
         void UpdateUniformBuffer();
         void CleanupUniformBuffer();
 
-        void CreateShaderStorageBuffer();
+        void CreateForceSourceBuffer();
+        void CleanupForceSourceBuffer();
+
+        // Generates the initial particles on a circle (a galaxy in the N-body modes) unless initialParticles (particleCount particles) is given
+        void CreateShaderStorageBuffer(const void* initialParticles = nullptr);
         void CleanupShaderStorageBuffer();
+        void RecreateShaderStorageBuffer(const void* initialParticles = nullptr);
     };
 
 } // namespace VulkanCore
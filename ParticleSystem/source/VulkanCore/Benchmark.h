@@ -8,7 +8,9 @@ namespace VulkanCore {
         Test2 = 2,
         Test3 = 3,
         Test4 = 4,
-        Test5 = 5
+        Test5 = 5,
+        Test6 = 6,
+        Test7 = 7
     };
 
 } // namespace VulkanCore
@@ -0,0 +1,357 @@
+#include "BenchmarkAnalyzer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "JobSystem.h"
+
+namespace VulkanCore {
+
+	size_t BenchmarkAnalyzer::DetectWarmup(const std::vector<double>& frameTimes)
+	{
+		constexpr size_t batchSize = 5;
+		const size_t batchCount = frameTimes.size() / batchSize;
+		if (batchCount < 4)
+		{
+			return 0;
+		}
+
+		std::vector<double> batchMeans(batchCount);
+		for (size_t i = 0; i < batchCount; ++i)
+		{
+			batchMeans[i] = std::accumulate(frameTimes.begin() + i * batchSize, frameTimes.begin() + (i + 1) * batchSize, 0.0) / batchSize;
+		}
+
+		// Suffix sums give the variance of every truncated tail in O(n)
+		std::vector<double> suffixSum(batchCount + 1, 0.0);
+		std::vector<double> suffixSquareSum(batchCount + 1, 0.0);
+		for (size_t i = batchCount; i-- > 0;)
+		{
+			suffixSum[i] = suffixSum[i + 1] + batchMeans[i];
+			suffixSquareSum[i] = suffixSquareSum[i + 1] + batchMeans[i] * batchMeans[i];
+		}
+
+		// MSER(d) = sum of squared deviations of the tail / (tail length)^2, the minimum balances bias against variance
+		size_t bestTruncation = 0;
+		double bestScore = std::numeric_limits<double>::max();
+		for (size_t d = 0; d <= batchCount / 2; ++d)
+		{
+			const double length = static_cast<double>(batchCount - d);
+			const double mean = suffixSum[d] / length;
+			const double squaredDeviations = std::max(0.0, suffixSquareSum[d] - length * mean * mean);
+			const double score = squaredDeviations / (length * length);
+			if (score < bestScore)
+			{
+				bestScore = score;
+				bestTruncation = d;
+			}
+		}
+
+		return bestTruncation * batchSize;
+	}
+
+	double BenchmarkAnalyzer::Percentile(const std::vector<double>& sortedValues, double p)
+	{
+		if (sortedValues.empty())
+		{
+			return 0.0;
+		}
+
+		const double rank = std::clamp(p, 0.0, 1.0) * static_cast<double>(sortedValues.size() - 1);
+		const size_t lower = static_cast<size_t>(std::floor(rank));
+		const size_t upper = std::min(lower + 1, sortedValues.size() - 1);
+		return sortedValues[lower] + (sortedValues[upper] - sortedValues[lower]) * (rank - static_cast<double>(lower));
+	}
+
+	FrameTimeSummary BenchmarkAnalyzer::Summarize(const std::vector<double>& frameTimes)
+	{
+		FrameTimeSummary summary = {};
+		summary.warmupCount = DetectWarmup(frameTimes);
+
+		std::vector<double> steadyState = SteadyState(frameTimes);
+		summary.sampleCount = steadyState.size();
+		if (steadyState.empty())
+		{
+			return summary;
+		}
+
+		const double count = static_cast<double>(steadyState.size());
+		summary.mean = std::accumulate(steadyState.begin(), steadyState.end(), 0.0) / count;
+
+		double squaredDeviations = 0.0;
+		for (double frameTime : steadyState)
+		{
+			squaredDeviations += (frameTime - summary.mean) * (frameTime - summary.mean);
+		}
+		summary.standardDeviation = steadyState.size() > 1 ? std::sqrt(squaredDeviations / (count - 1.0)) : 0.0;
+
+		std::vector<double> sorted = steadyState;
+		std::sort(sorted.begin(), sorted.end());
+		summary.p50 = Percentile(sorted, 0.50);
+		summary.p90 = Percentile(sorted, 0.90);
+		summary.p99 = Percentile(sorted, 0.99);
+		summary.p999 = Percentile(sorted, 0.999);
+
+		// Bootstrap, every resample starts from its own position of the random sequence so they run in parallel with the same result
+		const size_t blockLength = GetBlockLength(steadyState.size());
+		const uint64_t drawCount = GetDrawCount(steadyState.size(), blockLength);
+
+		std::vector<double> means(BOOTSTRAP_RESAMPLES);
+		std::vector<double> medians(BOOTSTRAP_RESAMPLES);
+		std::vector<double> p99s(BOOTSTRAP_RESAMPLES);
+		JobSystem::GetInstance().ParallelFor(BOOTSTRAP_RESAMPLES, MIN_RESAMPLES_PER_JOB, [&](uint64_t first, uint64_t end)
+		{
+			std::vector<double> resample;
+			for (uint64_t i = first; i < end; ++i)
+			{
+				uint64_t state = SkipDraws(BOOTSTRAP_SEED, i * drawCount);
+				Resample(steadyState, blockLength, state, resample);
+				means[i] = std::accumulate(resample.begin(), resample.end(), 0.0) / count;
+
+				std::sort(resample.begin(), resample.end());
+				medians[i] = Percentile(resample, 0.50);
+				p99s[i] = Percentile(resample, 0.99);
+			}
+		});
+
+		summary.meanCI = GetInterval(means);
+		summary.p50CI = GetInterval(medians);
+		summary.p99CI = GetInterval(p99s);
+
+		return summary;
+	}
+
+	RunComparison BenchmarkAnalyzer::Compare(const std::vector<double>& baselineFrameTimes, const std::vector<double>& candidateFrameTimes)
+	{
+		RunComparison comparison = {};
+
+		std::vector<double> baseline = SteadyState(baselineFrameTimes);
+		std::vector<double> candidate = SteadyState(candidateFrameTimes);
+		if (baseline.empty() || candidate.empty())
+		{
+			comparison.pValue = 1.0;
+			comparison.verdict = ComparisonVerdict::NoSignificantDifference;
+			return comparison;
+		}
+
+		std::vector<double> sortedBaseline = baseline;
+		std::vector<double> sortedCandidate = candidate;
+		const double baselineMedian = SelectPercentile(sortedBaseline, 0.5);
+		const double candidateMedian = SelectPercentile(sortedCandidate, 0.5);
+
+		comparison.medianDifference = candidateMedian - baselineMedian;
+		comparison.relativeMedianDifference = baselineMedian > 0.0 ? comparison.medianDifference / baselineMedian : 0.0;
+
+		// Both runs are resampled independently, the spread of the difference gives its confidence interval
+		const size_t baselineBlockLength = GetBlockLength(baseline.size());
+		const size_t candidateBlockLength = GetBlockLength(candidate.size());
+		const uint64_t drawCount = GetDrawCount(baseline.size(), baselineBlockLength) + GetDrawCount(candidate.size(), candidateBlockLength);
+
+		std::vector<double> differences(BOOTSTRAP_RESAMPLES);
+		JobSystem::GetInstance().ParallelFor(BOOTSTRAP_RESAMPLES, MIN_RESAMPLES_PER_JOB, [&](uint64_t first, uint64_t end)
+		{
+			std::vector<double> baselineResample;
+			std::vector<double> candidateResample;
+			for (uint64_t i = first; i < end; ++i)
+			{
+				uint64_t state = SkipDraws(BOOTSTRAP_SEED, i * drawCount);
+				Resample(baseline, baselineBlockLength, state, baselineResample);
+				Resample(candidate, candidateBlockLength, state, candidateResample);
+				differences[i] = SelectPercentile(candidateResample, 0.5) - SelectPercentile(baselineResample, 0.5);
+			}
+		});
+
+		size_t crossesZero = 0;
+		for (double difference : differences)
+		{
+			if ((comparison.medianDifference >= 0.0 && difference <= 0.0) || (comparison.medianDifference <= 0.0 && difference >= 0.0))
+			{
+				++crossesZero;
+			}
+		}
+
+		comparison.medianDifferenceCI = GetInterval(differences);
+
+		// Two-sided bootstrap p-value for "the medians are equal"
+		comparison.pValue = std::min(1.0, 2.0 * static_cast<double>(crossesZero) / static_cast<double>(BOOTSTRAP_RESAMPLES));
+
+		const bool bSignificant = comparison.medianDifferenceCI.low > 0.0 || comparison.medianDifferenceCI.high < 0.0;
+		if (!bSignificant || std::abs(comparison.relativeMedianDifference) < MIN_RELATIVE_EFFECT)
+		{
+			comparison.verdict = ComparisonVerdict::NoSignificantDifference;
+		}
+		else
+		{
+			comparison.verdict = comparison.medianDifference > 0.0 ? ComparisonVerdict::Regression : ComparisonVerdict::Improvement;
+		}
+
+		return comparison;
+	}
+
+	std::vector<double> BenchmarkAnalyzer::LoadFrameTimes(const std::string& filePath)
+	{
+		std::ifstream fin(filePath);
+		if (!fin.is_open())
+		{
+			throw std::runtime_error("ERROR: Could not find " + filePath);
+		}
+
+		std::vector<double> frameTimes;
+		std::string line;
+		std::getline(fin, line);	// header
+		while (std::getline(fin, line))
+		{
+			if (line.empty())
+			{
+				continue;
+			}
+
+			try
+			{
+				frameTimes.push_back(std::stod(line));
+			}
+			catch (const std::exception&)
+			{
+				throw std::runtime_error("ERROR: Invalid input: " + filePath + " contains '" + line + "'");
+			}
+		}
+
+		return frameTimes;
+	}
+
+	void BenchmarkAnalyzer::SaveFrameTimes(const std::string& filePath, const std::vector<double>& frameTimes)
+	{
+		std::ofstream fout(filePath);
+		if (!fout)
+		{
+			throw std::runtime_error("ERROR: Failed to open " + filePath + "!");
+		}
+
+		fout << "frame_time_ms\n" << std::setprecision(9);
+		for (double frameTime : frameTimes)
+		{
+			fout << frameTime << '\n';
+		}
+	}
+
+	const char* BenchmarkAnalyzer::GetVerdictName(ComparisonVerdict verdict)
+	{
+		switch (verdict)
+		{
+			case ComparisonVerdict::NoSignificantDifference:	return "No significant difference";
+			case ComparisonVerdict::Regression:					return "Regression";
+			case ComparisonVerdict::Improvement:				return "Improvement";
+			default:											return "Unknown";
+		}
+	}
+
+	void BenchmarkAnalyzer::PrintSummary(std::ostream& out, const FrameTimeSummary& summary)
+	{
+		const int confidence = static_cast<int>(CONFIDENCE_LEVEL * 100.0);
+		out << std::fixed << std::setprecision(3)
+			<< "Frames: " << summary.sampleCount << " steady-state, " << summary.warmupCount << " warm-up excluded\n"
+			<< "Mean:   " << summary.mean << " ms [" << summary.meanCI.low << ", " << summary.meanCI.high << "] (" << confidence << "% CI), stddev " << summary.standardDeviation << " ms\n"
+			<< "p50:    " << summary.p50 << " ms [" << summary.p50CI.low << ", " << summary.p50CI.high << "]\n"
+			<< "p90:    " << summary.p90 << " ms\n"
+			<< "p99:    " << summary.p99 << " ms [" << summary.p99CI.low << ", " << summary.p99CI.high << "]\n"
+			<< "p99.9:  " << summary.p999 << " ms\n"
+			<< std::defaultfloat;
+	}
+
+	void BenchmarkAnalyzer::PrintComparison(std::ostream& out, const RunComparison& comparison)
+	{
+		const int confidence = static_cast<int>(CONFIDENCE_LEVEL * 100.0);
+		out << std::fixed << std::setprecision(3)
+			<< "Median difference: " << comparison.medianDifference << " ms (" << comparison.relativeMedianDifference * 100.0 << "%) ["
+			<< comparison.medianDifferenceCI.low << ", " << comparison.medianDifferenceCI.high << "] (" << confidence << "% CI), p = " << comparison.pValue << '\n'
+			<< "Verdict: " << GetVerdictName(comparison.verdict) << '\n'
+			<< std::defaultfloat;
+	}
+
+	std::vector<double> BenchmarkAnalyzer::SteadyState(const std::vector<double>& frameTimes)
+	{
+		const size_t warmupCount = DetectWarmup(frameTimes);
+		return std::vector<double>(frameTimes.begin() + warmupCount, frameTimes.end());
+	}
+
+	// n^(1/3) is the usual rate for block bootstrap of variance-like statistics
+	size_t BenchmarkAnalyzer::GetBlockLength(size_t sampleCount)
+	{
+		return std::max<size_t>(1, static_cast<size_t>(std::round(std::cbrt(static_cast<double>(sampleCount)))));
+	}
+
+	void BenchmarkAnalyzer::Resample(const std::vector<double>& values, size_t blockLength, uint64_t& state, std::vector<double>& out)
+	{
+		out.resize(values.size());
+
+		size_t written = 0;
+		while (written < values.size())
+		{
+			// splitmix64, deterministic and independent of the standard library implementation
+			state += SPLITMIX_INCREMENT;
+			uint64_t random = state;
+			random = (random ^ (random >> 30)) * 0xbf58476d1ce4e5b9ull;
+			random = (random ^ (random >> 27)) * 0x94d049bb133111ebull;
+			random ^= random >> 31;
+
+			// Copy the block in at most two contiguous pieces, it wraps around the end of the run
+			size_t start = static_cast<size_t>(random % values.size());
+			size_t remaining = std::min(blockLength, values.size() - written);
+			while (remaining > 0)
+			{
+				const size_t length = std::min(remaining, values.size() - start);
+				std::copy(values.begin() + start, values.begin() + start + length, out.begin() + written);
+				written += length;
+				remaining -= length;
+				start = 0;
+			}
+		}
+	}
+
+	// Resample draws one random block start per block
+	uint64_t BenchmarkAnalyzer::GetDrawCount(size_t sampleCount, size_t blockLength)
+	{
+		return (static_cast<uint64_t>(sampleCount) + blockLength - 1) / blockLength;
+	}
+
+	// The splitmix64 state only advances by a constant, any position of the sequence is reached in O(1)
+	uint64_t BenchmarkAnalyzer::SkipDraws(uint64_t state, uint64_t drawCount)
+	{
+		return state + drawCount * SPLITMIX_INCREMENT;
+	}
+
+	// Same result as Percentile on the sorted values, in O(n) with two partial selections
+	double BenchmarkAnalyzer::SelectPercentile(std::vector<double>& values, double p)
+	{
+		if (values.empty())
+		{
+			return 0.0;
+		}
+
+		const double rank = std::clamp(p, 0.0, 1.0) * static_cast<double>(values.size() - 1);
+		const size_t lower = static_cast<size_t>(std::floor(rank));
+		std::nth_element(values.begin(), values.begin() + lower, values.end());
+
+		const double lowerValue = values[lower];
+		if (lower + 1 >= values.size())
+		{
+			return lowerValue;
+		}
+
+		const double upperValue = *std::min_element(values.begin() + lower + 1, values.end());
+		return lowerValue + (upperValue - lowerValue) * (rank - static_cast<double>(lower));
+	}
+
+	ConfidenceInterval BenchmarkAnalyzer::GetInterval(std::vector<double>& estimates)
+	{
+		std::sort(estimates.begin(), estimates.end());
+		const double alpha = 1.0 - CONFIDENCE_LEVEL;
+		return { Percentile(estimates, 0.5 * alpha), Percentile(estimates, 1.0 - 0.5 * alpha) };
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace VulkanCore {
+
+	struct ConfidenceInterval
+	{
+		double low;
+		double high;
+	};
+
+	// All times in milliseconds, computed over the steady-state frames only
+	struct FrameTimeSummary
+	{
+		size_t sampleCount;
+		size_t warmupCount;
+
+		double mean;
+		double standardDeviation;
+		double p50;
+		double p90;
+		double p99;
+		double p999;
+
+		ConfidenceInterval meanCI;
+		ConfidenceInterval p50CI;
+		ConfidenceInterval p99CI;
+	};
+
+	enum class ComparisonVerdict : uint32_t
+	{
+		NoSignificantDifference = 0,
+		Regression = 1,
+		Improvement = 2
+	};
+
+	// candidate - baseline, positive means the candidate is slower
+	struct RunComparison
+	{
+		double medianDifference;
+		double relativeMedianDifference;
+		ConfidenceInterval medianDifferenceCI;
+		double pValue;
+		ComparisonVerdict verdict;
+	};
+
+	// Offline statistics over raw frame times
+	// Frame times are autocorrelated, so resampling uses a circular block bootstrap instead of drawing single frames
+	class BenchmarkAnalyzer final
+	{
+	public:
+		static constexpr uint32_t BOOTSTRAP_RESAMPLES = 1000;
+		static constexpr double CONFIDENCE_LEVEL = 0.95;
+
+		// Smaller relative changes are reported as no difference even when they are statistically significant
+		static constexpr double MIN_RELATIVE_EFFECT = 0.01;
+
+		// Number of leading frames to drop, MSER-5 truncation rule (never more than half of the run)
+		static size_t DetectWarmup(const std::vector<double>& frameTimes);
+
+		// Linear interpolation between closest ranks, p in [0, 1]
+		static double Percentile(const std::vector<double>& sortedValues, double p);
+
+		static FrameTimeSummary Summarize(const std::vector<double>& frameTimes);
+		static RunComparison Compare(const std::vector<double>& baselineFrameTimes, const std::vector<double>& candidateFrameTimes);
+
+		// One frame time in milliseconds per line after a header
+		static std::vector<double> LoadFrameTimes(const std::string& filePath);
+		static void SaveFrameTimes(const std::string& filePath, const std::vector<double>& frameTimes);
+
+		static const char* GetVerdictName(ComparisonVerdict verdict);
+		static void PrintSummary(std::ostream& out, const FrameTimeSummary& summary);
+		static void PrintComparison(std::ostream& out, const RunComparison& comparison);
+
+	private:
+		static constexpr uint64_t BOOTSTRAP_SEED = 0x5eed;
+		static constexpr uint64_t SPLITMIX_INCREMENT = 0x9e3779b97f4a7c15ull;
+		static constexpr uint64_t MIN_RESAMPLES_PER_JOB = 32;
+
+		static std::vector<double> SteadyState(const std::vector<double>& frameTimes);
+		static size_t GetBlockLength(size_t sampleCount);
+		static void Resample(const std::vector<double>& values, size_t blockLength, uint64_t& state, std::vector<double>& out);
+		static uint64_t GetDrawCount(size_t sampleCount, size_t blockLength);
+		static uint64_t SkipDraws(uint64_t state, uint64_t drawCount);
+		static double SelectPercentile(std::vector<double>& values, double p);
+		static ConfidenceInterval GetInterval(std::vector<double>& estimates);
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,344 @@
+#include "BenchmarkSweep.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+
+namespace VulkanCore {
+
+	// Every substep is a full pass over the particles, so it counts as a step
+	double SweepResult::GetParticleStepsPerSecond() const
+	{
+		if (seconds <= 0.0)
+		{
+			return 0.0;
+		}
+
+		const double particleCount = static_cast<double>(cell.particleMultiplier) * BenchmarkSweep::PARTICLES_PER_MULTIPLIER;
+		return particleCount * static_cast<double>(stepCount) * static_cast<double>(appliedSubsteps) / seconds;
+	}
+
+	double SweepResult::GetReorderMillisecondsPerTick() const
+	{
+		return simulationZone.count > 0 ? reorderZone.totalMilliseconds / static_cast<double>(simulationZone.count) : 0.0;
+	}
+
+	double SweepResult::GetMeanFrameTimeMilliseconds() const
+	{
+		return frameCount > 0 ? seconds * 1000.0 / static_cast<double>(frameCount) : 0.0;
+	}
+
+	BenchmarkSweep::BenchmarkSweep(const nlohmann::json& json)
+		: currentCell(0)
+		, warmupFrames(120)
+		, outputFilePath("benchmark-sweep.csv")
+	{
+		const std::vector<uint32_t> benchmarks = ReadRange(json, "benchmarks", { static_cast<uint32_t>(Benchmark::Test1) });
+		const std::vector<uint32_t> particleMultipliers = ReadRange(json, "particleMultiplier", { 131072 });
+		const std::vector<uint32_t> sampleCounts = ReadRange(json, "sampleCount", { 8 });
+		const std::vector<uint32_t> substeps = ReadRange(json, "substeps", { 1 });
+		const std::vector<FramePacingPolicy> framePacingPolicies = ReadFramePacing(json);
+		const std::vector<uint32_t> reorderIntervals = ReadRange(json, "reorderInterval", { 0 });
+		const uint32_t repeats = json.value("repeats", 1u);
+
+		warmupFrames = json.value("warmupFrames", warmupFrames);
+		outputFilePath = json.value("output", outputFilePath);
+
+		for (uint32_t benchmark : benchmarks)
+		{
+			if (benchmark < static_cast<uint32_t>(Benchmark::Test1) || benchmark > static_cast<uint32_t>(Benchmark::Test7))
+			{
+				throw std::runtime_error("ERROR: Invalid input: 'benchmarks' must be in [" + std::to_string(static_cast<uint32_t>(Benchmark::Test1)) + ", " + std::to_string(static_cast<uint32_t>(Benchmark::Test7)) + "]");
+			}
+		}
+
+		for (uint32_t sampleCount : sampleCounts)
+		{
+			if (sampleCount == 0 || (sampleCount & (sampleCount - 1)) != 0 || sampleCount > 64)
+			{
+				throw std::runtime_error("ERROR: Invalid input: 'sampleCount' must be a power of two up to 64");
+			}
+		}
+
+		if (std::find(particleMultipliers.begin(), particleMultipliers.end(), 0u) != particleMultipliers.end()
+			|| std::find(substeps.begin(), substeps.end(), 0u) != substeps.end() || repeats == 0)
+		{
+			throw std::runtime_error("ERROR: Invalid input: 'particleMultiplier', 'substeps' and 'repeats' must be positive");
+		}
+
+		// Repeats are innermost so a configuration is measured while the GPU is in the same state
+		for (uint32_t benchmark : benchmarks)
+		for (uint32_t particleMultiplier : particleMultipliers)
+		for (uint32_t sampleCount : sampleCounts)
+		for (uint32_t substep : substeps)
+		for (FramePacingPolicy framePacingPolicy : framePacingPolicies)
+		for (uint32_t reorderInterval : reorderIntervals)
+		for (uint32_t repeat = 0; repeat < repeats; ++repeat)
+		{
+			cells.push_back({ static_cast<Benchmark>(benchmark), particleMultiplier, sampleCount, substep, framePacingPolicy, reorderInterval, repeat });
+		}
+
+		results.reserve(cells.size());
+	}
+
+	nlohmann::json BenchmarkSweep::LoadJSON(const std::string& fileName)
+	{
+		std::ifstream sweepFile(fileName);
+		if (!sweepFile.is_open())
+		{
+			throw std::runtime_error("ERROR: Could not find " + fileName);
+		}
+
+		nlohmann::json json;
+		try
+		{
+			sweepFile >> json;
+		}
+		catch (const nlohmann::json::parse_error& e)
+		{
+			throw std::runtime_error("ERROR: " + fileName + " is not valid: " + e.what());
+		}
+
+		return json;
+	}
+
+	void BenchmarkSweep::Record(const SweepResult& result)
+	{
+		if (GetIsFinished())
+		{
+			return;
+		}
+
+		results.push_back(result);
+		++currentCell;
+	}
+
+	void BenchmarkSweep::WriteCSV(const std::string& filePath) const
+	{
+		std::ofstream fout(filePath);
+		if (!fout)
+		{
+			throw std::runtime_error("ERROR: Failed to open " + filePath + "!");
+		}
+
+		fout << "benchmark,particle_multiplier,particle_count,sample_count,applied_sample_count,substeps,applied_substeps,frame_pacing,reorder_interval,repeat,steps,frames,seconds,mean_frame_ms,warmup_frames,p50_ms,p50_ci_low_ms,p50_ci_high_ms,p99_ms,p99_ci_low_ms,p99_ci_high_ms,particle_steps_per_second,vs_invocations_per_frame,clipping_primitives_per_frame,fs_invocations_per_frame,cs_invocations_per_tick,fs_invocations_per_particle,simulation_gpu_ms,reorder_gpu_ms,reorder_gpu_ms_per_tick,render_pass_gpu_ms\n";
+		fout << std::setprecision(9);
+		for (const SweepResult& result : results)
+		{
+			const SweepCell& cell = result.cell;
+			fout << static_cast<uint32_t>(cell.benchmark) << ','
+				<< cell.particleMultiplier << ','
+				<< static_cast<uint64_t>(cell.particleMultiplier) * PARTICLES_PER_MULTIPLIER << ','
+				<< cell.sampleCount << ','
+				<< result.appliedSampleCount << ','
+				<< cell.substeps << ','
+				<< result.appliedSubsteps << ','
+				<< '"' << FramePacer::GetPolicyName(cell.framePacingPolicy) << '"' << ','
+				<< cell.reorderInterval << ','
+				<< cell.repeat << ','
+				<< result.stepCount << ','
+				<< result.frameCount << ','
+				<< result.seconds << ','
+				<< result.GetMeanFrameTimeMilliseconds() << ','
+				<< result.frameTimeSummary.warmupCount << ','
+				<< result.frameTimeSummary.p50 << ','
+				<< result.frameTimeSummary.p50CI.low << ','
+				<< result.frameTimeSummary.p50CI.high << ','
+				<< result.frameTimeSummary.p99 << ','
+				<< result.frameTimeSummary.p99CI.low << ','
+				<< result.frameTimeSummary.p99CI.high << ','
+				<< result.GetParticleStepsPerSecond() << ','
+				<< result.pipelineStatistics.vertexShaderInvocations << ','
+				<< result.pipelineStatistics.clippingPrimitives << ','
+				<< result.pipelineStatistics.fragmentShaderInvocations << ','
+				<< result.pipelineStatistics.computeShaderInvocations << ','
+				<< result.pipelineStatistics.fragmentShaderInvocations / static_cast<double>(static_cast<uint64_t>(cell.particleMultiplier) * PARTICLES_PER_MULTIPLIER) << ','
+				<< result.simulationZone.GetMeanMilliseconds() << ','
+				<< result.reorderZone.GetMeanMilliseconds() << ','
+				<< result.GetReorderMillisecondsPerTick() << ','
+				<< result.renderPassZone.GetMeanMilliseconds() << '\n';
+		}
+	}
+
+	void BenchmarkSweep::WriteHistograms(const std::string& filePath) const
+	{
+		using Key = std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>;
+		std::map<Key, std::pair<const SweepResult*, FrameTimeHistogram>> groups;
+		std::map<Key, uint32_t> runCounts;
+		for (const SweepResult& result : results)
+		{
+			const SweepCell& cell = result.cell;
+			const Key key = { static_cast<uint32_t>(cell.benchmark), cell.particleMultiplier, result.appliedSampleCount, cell.substeps, static_cast<uint32_t>(cell.framePacingPolicy), cell.reorderInterval };
+
+			auto [it, bInserted] = groups.try_emplace(key, &result, FrameTimeHistogram());
+			it->second.second.Merge(result.frameTimeHistogram);
+			++runCounts[key];
+		}
+
+		nlohmann::json json = nlohmann::json::array();
+		for (const auto& [key, group] : groups)
+		{
+			const SweepResult& result = *group.first;
+			const FrameTimeHistogram& histogram = group.second;
+
+			nlohmann::json entry;
+			entry["benchmark"] = static_cast<uint32_t>(result.cell.benchmark);
+			entry["particleCount"] = static_cast<uint64_t>(result.cell.particleMultiplier) * PARTICLES_PER_MULTIPLIER;
+			entry["sampleCount"] = result.appliedSampleCount;
+			entry["substeps"] = result.cell.substeps;
+			entry["framePacing"] = FramePacer::GetPolicyName(result.cell.framePacingPolicy);
+			entry["reorderInterval"] = result.cell.reorderInterval;
+			entry["runs"] = runCounts[key];
+			entry["p50Milliseconds"] = histogram.GetPercentileMilliseconds(0.5);
+			entry["p99Milliseconds"] = histogram.GetPercentileMilliseconds(0.99);
+			entry["p999Milliseconds"] = histogram.GetPercentileMilliseconds(0.999);
+			entry["histogram"] = histogram.ToJSON();
+			json.push_back(std::move(entry));
+		}
+
+		std::ofstream fout(filePath);
+		if (!fout)
+		{
+			throw std::runtime_error("ERROR: Failed to open " + filePath + "!");
+		}
+		fout << json.dump(1, '\t') << '\n';
+	}
+
+	void BenchmarkSweep::PrintSummary(std::ostream& out) const
+	{
+		using Key = std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, uint32_t>;
+		std::map<Key, std::vector<const SweepResult*>> groups;
+		for (const SweepResult& result : results)
+		{
+			const SweepCell& cell = result.cell;
+			groups[{ static_cast<uint32_t>(cell.benchmark), cell.particleMultiplier, result.appliedSampleCount, cell.substeps, static_cast<uint32_t>(cell.framePacingPolicy), cell.reorderInterval }].push_back(&result);
+		}
+
+		out << std::left
+			<< std::setw(6) << "Test" << std::setw(12) << "Particles" << std::setw(6) << "MSAA" << std::setw(9) << "Substeps" << std::setw(14) << "Pacing" << std::setw(9) << "Reorder"
+			<< std::right << std::setw(6) << "Runs" << std::setw(12) << "Frame ms" << std::setw(12) << "Sim GPU ms" << std::setw(14) << "Reorder ms/t" << std::setw(12) << "Draw GPU ms" << std::setw(16) << "Median p*s/s" << std::setw(16) << "Min p*s/s" << std::setw(16) << "Max p*s/s" << '\n';
+
+		for (const auto& [key, group] : groups)
+		{
+			std::vector<double> throughputs;
+			double frameTimeSum = 0.0;
+			double simulationSum = 0.0;
+			double reorderSum = 0.0;
+			double renderPassSum = 0.0;
+			for (const SweepResult* result : group)
+			{
+				throughputs.push_back(result->GetParticleStepsPerSecond());
+				frameTimeSum += result->GetMeanFrameTimeMilliseconds();
+				simulationSum += result->simulationZone.GetMeanMilliseconds();
+				reorderSum += result->GetReorderMillisecondsPerTick();
+				renderPassSum += result->renderPassZone.GetMeanMilliseconds();
+			}
+			const double runCount = static_cast<double>(group.size());
+			std::sort(throughputs.begin(), throughputs.end());
+
+			const size_t middle = throughputs.size() / 2;
+			const double median = throughputs.size() % 2 == 0 ? 0.5 * (throughputs[middle - 1] + throughputs[middle]) : throughputs[middle];
+
+			const SweepCell& cell = group.front()->cell;
+			out << std::left
+				<< std::setw(6) << static_cast<uint32_t>(cell.benchmark)
+				<< std::setw(12) << static_cast<uint64_t>(cell.particleMultiplier) * PARTICLES_PER_MULTIPLIER
+				<< std::setw(6) << group.front()->appliedSampleCount
+				<< std::setw(9) << cell.substeps
+				<< std::setw(14) << FramePacer::GetPolicyName(cell.framePacingPolicy)
+				<< std::setw(9) << cell.reorderInterval
+				<< std::right << std::setw(6) << group.size()
+				<< std::fixed << std::setprecision(3) << std::setw(12) << frameTimeSum / runCount
+				<< std::setw(12) << simulationSum / runCount << std::setw(14) << reorderSum / runCount << std::setw(12) << renderPassSum / runCount
+				<< std::scientific << std::setprecision(3) << std::setw(16) << median << std::setw(16) << throughputs.front() << std::setw(16) << throughputs.back()
+				<< std::defaultfloat << '\n';
+		}
+	}
+
+	std::vector<uint32_t> BenchmarkSweep::ReadRange(const nlohmann::json& json, const char* key, const std::vector<uint32_t>& defaultValues)
+	{
+		if (!json.contains(key))
+		{
+			return defaultValues;
+		}
+
+		const nlohmann::json& range = json[key];
+		std::vector<uint32_t> values;
+
+		if (range.is_number_unsigned())
+		{
+			values.push_back(range.get<uint32_t>());
+		}
+		else if (range.is_array())
+		{
+			for (const nlohmann::json& value : range)
+			{
+				if (!value.is_number_unsigned())
+				{
+					throw std::runtime_error(std::string("ERROR: Invalid input: '") + key + "' must only contain non-negative integers");
+				}
+				values.push_back(value.get<uint32_t>());
+			}
+		}
+		else if (range.is_object() && range.contains("from") && range.contains("to"))
+		{
+			const uint32_t from = range["from"].get<uint32_t>();
+			const uint32_t to = range["to"].get<uint32_t>();
+			const uint32_t step = range.value("step", 0u);
+			const uint32_t factor = range.value("factor", 0u);
+			if ((step == 0) == (factor <= 1) || (factor > 1 && from == 0))
+			{
+				throw std::runtime_error(std::string("ERROR: Invalid input: '") + key + "' needs either a positive 'step' or a 'factor' greater than 1 with a positive 'from'");
+			}
+
+			for (uint64_t value = from; value <= to; value = step != 0 ? value + step : value * factor)
+			{
+				values.push_back(static_cast<uint32_t>(value));
+			}
+		}
+
+		if (values.empty())
+		{
+			throw std::runtime_error(std::string("ERROR: Invalid input: '") + key + "' is not a valid range");
+		}
+
+		return values;
+	}
+
+	std::vector<FramePacingPolicy> BenchmarkSweep::ReadFramePacing(const nlohmann::json& json)
+	{
+		static const std::pair<const char*, FramePacingPolicy> policyNames[] = {
+			{ "Uncapped", FramePacingPolicy::Uncapped },
+			{ "VSync", FramePacingPolicy::VSync },
+			{ "Mailbox", FramePacingPolicy::Mailbox },
+			{ "TargetFPS", FramePacingPolicy::TargetFPS }
+		};
+
+		if (!json.contains("framePacing"))
+		{
+			return { FramePacingPolicy::Mailbox };
+		}
+
+		std::vector<FramePacingPolicy> policies;
+		for (const nlohmann::json& value : json["framePacing"])
+		{
+			const auto it = std::find_if(std::begin(policyNames), std::end(policyNames), [&value](const auto& entry) { return value.is_string() && value.get<std::string>() == entry.first; });
+			if (it == std::end(policyNames))
+			{
+				throw std::runtime_error("ERROR: Invalid input: 'framePacing' entries must be one of Uncapped, VSync, Mailbox, TargetFPS");
+			}
+			policies.push_back(it->second);
+		}
+
+		if (policies.empty())
+		{
+			throw std::runtime_error("ERROR: Invalid input: 'framePacing' is empty");
+		}
+
+		return policies;
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include <nlohmann/json.hpp>
+
+#include "Benchmark.h"
+#include "FramePacer.h"
+#include "BenchmarkAnalyzer.h"
+#include "FrameTimeHistogram.h"
+#include "PipelineStatistics.h"
+#include "GPUProfiler.h"
+
+namespace VulkanCore {
+
+	// One run of a benchmark scenario with a fixed configuration
+	struct SweepCell
+	{
+		Benchmark benchmark;
+		uint32_t particleMultiplier;	// particle count = particleMultiplier * 64
+		uint32_t sampleCount;
+		uint32_t substeps;
+		FramePacingPolicy framePacingPolicy;
+		uint32_t reorderInterval;		// ticks between Morton reorders of the particles, 0 never reorders
+		uint32_t repeat;
+	};
+
+	struct SweepResult
+	{
+		SweepCell cell;
+		uint32_t appliedSampleCount;	// the GPU may not support the requested one
+		uint32_t appliedSubsteps;		// the fluid takes more to stay under its stable timestep
+		uint64_t stepCount;
+		uint64_t frameCount;
+		double seconds;
+		FrameTimeSummary frameTimeSummary;
+		FrameTimeHistogram frameTimeHistogram;
+		PipelineStatisticsAverages pipelineStatistics;
+		GPUZoneAverage simulationZone;
+		GPUZoneAverage reorderZone;
+		GPUZoneAverage renderPassZone;
+
+		double GetParticleStepsPerSecond() const;
+
+		// Reorder time spread over every tick, the cost to weigh against the simulation and render pass gains
+		double GetReorderMillisecondsPerTick() const;
+		double GetMeanFrameTimeMilliseconds() const;
+	};
+
+	// Cartesian product of the parameter ranges in a sweep description, expanded up front
+	// Every cell is repeated "repeats" times back to back, the application reports one SweepResult per run
+	class BenchmarkSweep final
+	{
+	public:
+		static constexpr uint32_t PARTICLES_PER_MULTIPLIER = 64;
+
+		// Throws std::runtime_error on malformed input
+		explicit BenchmarkSweep(const nlohmann::json& json);
+
+		static nlohmann::json LoadJSON(const std::string& fileName);
+
+		// Stores the result of the current cell and moves on to the next one
+		void Record(const SweepResult& result);
+
+		// One row per run
+		void WriteCSV(const std::string& filePath) const;
+
+		// One frame time histogram per configuration, the repeats are merged
+		void WriteHistograms(const std::string& filePath) const;
+
+		// Repeats aggregated per configuration
+		void PrintSummary(std::ostream& out) const;
+
+		// Getters
+		inline bool GetIsFinished() const { return currentCell >= cells.size(); }
+		inline const SweepCell& GetCurrentCell() const { return cells[currentCell]; }
+		inline size_t GetCurrentCellIndex() const { return currentCell; }
+		inline size_t GetCellCount() const { return cells.size(); }
+		inline uint32_t GetWarmupFrames() const { return warmupFrames; }
+		inline const std::string& GetOutputFilePath() const { return outputFilePath; }
+
+	private:
+		std::vector<SweepCell> cells;
+		std::vector<SweepResult> results;
+		size_t currentCell;
+
+		uint32_t warmupFrames;
+		std::string outputFilePath;
+
+		// Accepts [a, b, c] or { "from": a, "to": b, "step": s } or { "from": a, "to": b, "factor": f }
+		static std::vector<uint32_t> ReadRange(const nlohmann::json& json, const char* key, const std::vector<uint32_t>& defaultValues);
+		static std::vector<FramePacingPolicy> ReadFramePacing(const nlohmann::json& json);
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,145 @@
+#include "BenchmarkTimeline.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace VulkanCore {
+
+	static double ReadNumber(const nlohmann::json& keyframe, const char* key, const char* trackName, size_t index)
+	{
+		if (!keyframe.contains(key) || !keyframe[key].is_number())
+		{
+			throw std::runtime_error(std::string("ERROR: Invalid input: '") + trackName + "'[" + std::to_string(index) + "] is missing numeric '" + key + "'");
+		}
+
+		return keyframe[key].get<double>();
+	}
+
+	// Stable order by time, keyframes sharing a timestamp keep their order from the file
+	static std::vector<size_t> SortByTime(const std::vector<double>& times)
+	{
+		std::vector<size_t> order(times.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&times](size_t a, size_t b) { return times[a] < times[b]; });
+		return order;
+	}
+
+	template<typename T>
+	static void ApplyOrder(std::vector<T>& values, const std::vector<size_t>& order)
+	{
+		std::vector<T> sorted(values.size());
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			sorted[i] = values[order[i]];
+		}
+		values = std::move(sorted);
+	}
+
+	BenchmarkTimeline::BenchmarkTimeline(const nlohmann::json& json)
+		: mousePositionCursor(0)
+		, mouseButtonLeftPressedCursor(0)
+		, duration(0.0)
+	{
+		const nlohmann::json& mousePosition = json.at("mousePosition");
+		const nlohmann::json& mouseButtonLeftPressed = json.at("mouseButtonLeftPressed");
+
+		if (mousePosition.empty() || mouseButtonLeftPressed.empty())
+		{
+			throw std::runtime_error("ERROR: Invalid input: 'mousePosition' and 'mouseButtonLeftPressed' need at least one keyframe");
+		}
+
+		// Mouse Position track
+		mousePositionTimes.reserve(mousePosition.size());
+		mousePositionX.reserve(mousePosition.size());
+		mousePositionY.reserve(mousePosition.size());
+		mousePositionInterpolate.reserve(mousePosition.size());
+		for (size_t i = 0; i < mousePosition.size(); ++i)
+		{
+			const nlohmann::json& keyframe = mousePosition[i];
+			mousePositionTimes.push_back(ReadNumber(keyframe, "time", "mousePosition", i));
+			mousePositionX.push_back(ReadNumber(keyframe, "x", "mousePosition", i));
+			mousePositionY.push_back(ReadNumber(keyframe, "y", "mousePosition", i));
+			mousePositionInterpolate.push_back(keyframe.contains("interpolate") && keyframe["interpolate"].is_boolean() && keyframe["interpolate"].get<bool>() ? 1 : 0);
+		}
+
+		const std::vector<size_t> mousePositionOrder = SortByTime(mousePositionTimes);
+		ApplyOrder(mousePositionTimes, mousePositionOrder);
+		ApplyOrder(mousePositionX, mousePositionOrder);
+		ApplyOrder(mousePositionY, mousePositionOrder);
+		ApplyOrder(mousePositionInterpolate, mousePositionOrder);
+
+		// There is nothing to interpolate from before the first keyframe
+		mousePositionInterpolate[0] = 0;
+
+		// Mouse Button Left Pressed track
+		mouseButtonLeftPressedTimes.reserve(mouseButtonLeftPressed.size());
+		mouseButtonLeftPressedValues.reserve(mouseButtonLeftPressed.size());
+		for (size_t i = 0; i < mouseButtonLeftPressed.size(); ++i)
+		{
+			const nlohmann::json& keyframe = mouseButtonLeftPressed[i];
+			if (!keyframe.contains("value") || !keyframe["value"].is_boolean())
+			{
+				throw std::runtime_error("ERROR: Invalid input: 'mouseButtonLeftPressed'[" + std::to_string(i) + "] is missing boolean 'value'");
+			}
+
+			mouseButtonLeftPressedTimes.push_back(ReadNumber(keyframe, "time", "mouseButtonLeftPressed", i));
+			mouseButtonLeftPressedValues.push_back(keyframe["value"].get<bool>() ? 1 : 0);
+		}
+
+		const std::vector<size_t> mouseButtonLeftPressedOrder = SortByTime(mouseButtonLeftPressedTimes);
+		ApplyOrder(mouseButtonLeftPressedTimes, mouseButtonLeftPressedOrder);
+		ApplyOrder(mouseButtonLeftPressedValues, mouseButtonLeftPressedOrder);
+
+		duration = std::max(mousePositionTimes.back(), mouseButtonLeftPressedTimes.back());
+	}
+
+	BenchmarkTimeline::Sample BenchmarkTimeline::SampleAt(double time)
+	{
+		Sample sample = {};
+
+		// Mouse Position
+		mousePositionCursor = Seek(mousePositionTimes, mousePositionCursor, time);
+		const size_t next = mousePositionCursor + 1;
+		if (time >= mousePositionTimes[mousePositionCursor] && next < mousePositionTimes.size() && mousePositionInterpolate[next])
+		{
+			const double startTime = mousePositionTimes[mousePositionCursor];
+			const double endTime = mousePositionTimes[next];
+			const double t = endTime > startTime ? (time - startTime) / (endTime - startTime) : 1.0;
+
+			sample.mousePosition.x = glm::mix(mousePositionX[mousePositionCursor], mousePositionX[next], t);
+			sample.mousePosition.y = glm::mix(mousePositionY[mousePositionCursor], mousePositionY[next], t);
+		}
+		else
+		{
+			sample.mousePosition.x = mousePositionX[mousePositionCursor];
+			sample.mousePosition.y = mousePositionY[mousePositionCursor];
+		}
+
+		// Mouse Button Left Pressed
+		mouseButtonLeftPressedCursor = Seek(mouseButtonLeftPressedTimes, mouseButtonLeftPressedCursor, time);
+		sample.mouseButtonLeftPressed = mouseButtonLeftPressedValues[mouseButtonLeftPressedCursor] != 0;
+
+		return sample;
+	}
+
+	size_t BenchmarkTimeline::Seek(const std::vector<double>& times, size_t cursor, double time)
+	{
+		// Went back in time
+		if (time < times[cursor])
+		{
+			const auto it = std::upper_bound(times.begin(), times.end(), time);
+			return it == times.begin() ? 0 : static_cast<size_t>(std::distance(times.begin(), it)) - 1;
+		}
+
+		// Usually advances by zero or one keyframe per frame
+		while (cursor + 1 < times.size() && times[cursor + 1] <= time)
+		{
+			++cursor;
+		}
+
+		return cursor;
+	}
+
+} // namespace VulkanCore
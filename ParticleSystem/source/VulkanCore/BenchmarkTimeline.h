@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+
+namespace VulkanCore {
+
+	// Benchmark script compiled into time-sorted SoA keyframe tracks
+	// Replay walks a cursor forward, so sampling is O(1) per frame while time advances and O(log n) when seeking backwards
+	class BenchmarkTimeline final
+	{
+	public:
+		struct Sample
+		{
+			glm::dvec2 mousePosition;
+			bool mouseButtonLeftPressed;
+		};
+
+		// Compiles the "mousePosition" / "mouseButtonLeftPressed" arrays, throws std::runtime_error on malformed input
+		explicit BenchmarkTimeline(const nlohmann::json& json);
+
+		// Use monotonically increasing times for O(1) lookups
+		Sample SampleAt(double time);
+
+		// Getters
+		inline double GetDuration() const { return duration; }
+		inline size_t GetMousePositionKeyframeCount() const { return mousePositionTimes.size(); }
+		inline size_t GetMouseButtonLeftPressedKeyframeCount() const { return mouseButtonLeftPressedTimes.size(); }
+
+	private:
+		// Mouse Position track
+		std::vector<double> mousePositionTimes;
+		std::vector<double> mousePositionX;
+		std::vector<double> mousePositionY;
+		std::vector<uint8_t> mousePositionInterpolate;	// interpolate from the previous keyframe to this one
+		size_t mousePositionCursor;
+
+		// Mouse Button Left Pressed track
+		std::vector<double> mouseButtonLeftPressedTimes;
+		std::vector<uint8_t> mouseButtonLeftPressedValues;
+		size_t mouseButtonLeftPressedCursor;
+
+		double duration;
+
+		// Index of the last keyframe with keyframeTime <= time, or 0 if time is before the first keyframe
+		static size_t Seek(const std::vector<double>& times, size_t cursor, double time);
+	};
+
+} // namespace VulkanCore
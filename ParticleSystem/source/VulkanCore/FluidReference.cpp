@@ -0,0 +1,164 @@
+#include "FluidReference.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+#include <glm/gtc/constants.hpp>
+
+#include "JobSystem.h"
+
+namespace VulkanCore {
+
+	double FluidReference::ComputeDensity(const Particle* particles, uint32_t particleCount, uint32_t index, const FluidParameters& parameters)
+	{
+		const double h = parameters.smoothingLength;
+		const double inverseSmoothingLengthSquared = 1.0 / (h * h);
+		const double x = particles[index].position.x;
+		const double y = particles[index].position.y;
+
+		double sum = 0.0;
+		for (uint32_t j = 0; j < particleCount; ++j)
+		{
+			const double dx = static_cast<double>(particles[j].position.x) - x;
+			const double dy = static_cast<double>(particles[j].position.y) - y;
+			const double qSquared = (dx * dx + dy * dy) * inverseSmoothingLengthSquared;
+			if (qSquared < 1.0)
+			{
+				const double w = 1.0 - qSquared;
+				sum += w * w * w;
+			}
+		}
+
+		return static_cast<double>(parameters.particleMass) * 4.0 / (glm::pi<double>() * h * h) * sum;
+	}
+
+	double FluidReference::ComputePressure(double density, const FluidParameters& parameters)
+	{
+		return std::max(static_cast<double>(parameters.stiffness) * (density - static_cast<double>(parameters.restDensity)), 0.0);
+	}
+
+	glm::dvec2 FluidReference::ComputeAcceleration(const Particle* particles, const double* densities, uint32_t particleCount, uint32_t index, const FluidParameters& parameters)
+	{
+		const double h = parameters.smoothingLength;
+		const glm::dvec2 position = glm::dvec2(particles[index].position);
+		const glm::dvec2 velocity = glm::dvec2(particles[index].velocity);
+		const double pressureTerm = ComputePressure(densities[index], parameters) / (densities[index] * densities[index]);
+
+		glm::dvec2 pressureSum(0.0);
+		glm::dvec2 viscositySum(0.0);
+		for (uint32_t j = 0; j < particleCount; ++j)
+		{
+			const glm::dvec2 diff = position - glm::dvec2(particles[j].position);
+			const double distanceSquared = diff.x * diff.x + diff.y * diff.y;
+			if (j == index || distanceSquared >= h * h)
+			{
+				continue;
+			}
+
+			const double distance = std::sqrt(distanceSquared);
+			const double w = 1.0 - distance / h;
+
+			if (distance > 0.0)
+			{
+				const double otherPressureTerm = ComputePressure(densities[j], parameters) / (densities[j] * densities[j]);
+				pressureSum += (pressureTerm + otherPressureTerm) * w * w / distance * diff;
+			}
+			viscositySum += (glm::dvec2(particles[j].velocity) - velocity) * (w / densities[j]);
+		}
+
+		const double mass = parameters.particleMass;
+		const glm::dvec2 pressureAcceleration = mass * 30.0 / (glm::pi<double>() * h * h * h) * pressureSum;
+		const glm::dvec2 viscosityAcceleration = static_cast<double>(parameters.viscosity) * mass * 40.0 / (glm::pi<double>() * h * h * h * h) * viscositySum;
+		return pressureAcceleration + viscosityAcceleration + glm::dvec2(0.0, -static_cast<double>(parameters.gravity));
+	}
+
+	float FluidReference::GetStableTimestep(const FluidParameters& parameters)
+	{
+		const float h = parameters.smoothingLength;
+
+		float timestep = 0.25f * h / std::sqrt(std::max(parameters.stiffness, 1e-6f));
+		if (parameters.viscosity > 0.0f)
+		{
+			timestep = std::min(timestep, 0.125f * h * h / parameters.viscosity);
+		}
+		if (parameters.gravity > 0.0f)
+		{
+			timestep = std::min(timestep, 0.25f * std::sqrt(h / parameters.gravity));
+		}
+
+		return timestep;
+	}
+
+	FluidValidationResult FluidReference::Validate(const Particle* particles, const glm::vec2* states, const glm::vec2* accelerations, uint32_t particleCount, const FluidParameters& parameters, uint32_t sampleCount)
+	{
+		FluidValidationResult result = {};
+		result.particleCount = particleCount;
+		result.sampleCount = std::min(sampleCount, particleCount);
+		if (result.sampleCount == 0)
+		{
+			return result;
+		}
+
+		// The accelerations need the density of every neighbour
+		std::vector<double> densities(particleCount);
+		JobSystem::GetInstance().ParallelFor(particleCount, 64, [&](uint64_t begin, uint64_t end)
+		{
+			for (uint64_t i = begin; i < end; ++i)
+			{
+				densities[i] = ComputeDensity(particles, particleCount, static_cast<uint32_t>(i), parameters);
+			}
+		});
+
+		std::vector<glm::dvec2> references(result.sampleCount);
+		JobSystem::GetInstance().ParallelFor(result.sampleCount, 16, [&](uint64_t begin, uint64_t end)
+		{
+			for (uint64_t sample = begin; sample < end; ++sample)
+			{
+				const uint32_t index = static_cast<uint32_t>(sample * particleCount / result.sampleCount);
+				references[sample] = ComputeAcceleration(particles, densities.data(), particleCount, index, parameters);
+			}
+		});
+
+		double squaredReferenceSum = 0.0;
+		for (const glm::dvec2& reference : references)
+		{
+			squaredReferenceSum += reference.x * reference.x + reference.y * reference.y;
+		}
+		const double rmsReference = std::max(std::sqrt(squaredReferenceSum / result.sampleCount), 1e-30);
+
+		double squaredDensityErrorSum = 0.0;
+		double squaredAccelerationErrorSum = 0.0;
+		for (uint32_t sample = 0; sample < result.sampleCount; ++sample)
+		{
+			const uint32_t index = static_cast<uint32_t>(static_cast<uint64_t>(sample) * particleCount / result.sampleCount);
+
+			const double densityError = std::abs(static_cast<double>(states[index].x) - densities[index]) / densities[index];
+			result.maxDensityError = std::max(result.maxDensityError, densityError);
+			squaredDensityErrorSum += densityError * densityError;
+
+			const glm::dvec2& reference = references[sample];
+			const glm::dvec2 error = glm::dvec2(accelerations[index]) - reference;
+			const double referenceLength = std::sqrt(reference.x * reference.x + reference.y * reference.y);
+			const double accelerationError = std::sqrt(error.x * error.x + error.y * error.y) / std::max(referenceLength, rmsReference);
+			result.maxAccelerationError = std::max(result.maxAccelerationError, accelerationError);
+			squaredAccelerationErrorSum += accelerationError * accelerationError;
+		}
+		result.rmsDensityError = std::sqrt(squaredDensityErrorSum / result.sampleCount);
+		result.rmsAccelerationError = std::sqrt(squaredAccelerationErrorSum / result.sampleCount);
+
+		return result;
+	}
+
+	void FluidReference::PrintResult(std::ostream& out, const FluidValidationResult& result)
+	{
+		out << "Fluid validation (" << result.particleCount << " particles, " << result.sampleCount << " sampled):" << '\n'
+			<< std::scientific << std::setprecision(3)
+			<< "  density relative error:      max " << result.maxDensityError << ", rms " << result.rmsDensityError << '\n'
+			<< "  acceleration relative error: max " << result.maxAccelerationError << ", rms " << result.rmsAccelerationError << '\n'
+			<< std::defaultfloat << std::flush;
+	}
+
+} // namespace VulkanCore
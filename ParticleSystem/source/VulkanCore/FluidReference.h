@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+#include <glm/glm.hpp>
+
+#include "Particle.h"
+
+namespace VulkanCore {
+
+	// Weakly compressible SPH shared by sph_fluid.comp and the CPU reference, h is the smoothing length and q = r / h
+	// density:   rho_i = m * sum_j 4 / (pi h^2) * (1 - q^2)^3							(poly6, the particle itself included)
+	// pressure:  p_i = max(stiffness * (rho_i - rho_0), 0)
+	// pressure:  a_i = m * sum_j (p_i / rho_i^2 + p_j / rho_j^2) * 30 / (pi h^3) * (1 - q)^2 * r_ij / |r_ij|	(spiky gradient)
+	// viscosity: a_i = viscosity * m * sum_j (v_j - v_i) / rho_j * 40 / (pi h^4) * (1 - q)			(viscosity laplacian)
+	// plus gravity along -y
+	struct FluidParameters
+	{
+		float restDensity;
+		float stiffness;			// squared speed of sound
+		float viscosity;			// kinematic
+		float gravity;
+		float smoothingFactor;		// smoothing length in initial particle spacings
+		float wallRestitution;
+		float attractorStrength;	// mouse pull, only used by the integration
+
+		// Derived from the particle count, see FluidSimulation::SetParticles
+		float spacing;
+		float smoothingLength;
+		float particleMass;
+	};
+
+	struct FluidValidationResult
+	{
+		uint32_t particleCount;
+		uint32_t sampleCount;
+		double maxDensityError;			// |rho_gpu - rho_ref| / rho_ref over the sampled particles
+		double rmsDensityError;
+		double maxAccelerationError;	// |a_gpu - a_ref| / max(|a_ref|, rms |a_ref|), the fluid at rest has near zero accelerations
+		double rmsAccelerationError;
+	};
+
+	// Double precision SPH over every pair the GPU kernels are validated against
+	class FluidReference final
+	{
+	public:
+		// Every density is summed over every particle, O(N^2)
+		static constexpr uint32_t MAX_PARTICLE_COUNT = 32768;
+
+		static double ComputeDensity(const Particle* particles, uint32_t particleCount, uint32_t index, const FluidParameters& parameters);
+		static double ComputePressure(double density, const FluidParameters& parameters);
+
+		// densities holds the reference density of every particle
+		static glm::dvec2 ComputeAcceleration(const Particle* particles, const double* densities, uint32_t particleCount, uint32_t index, const FluidParameters& parameters);
+
+		// Largest stable step, limited by the speed of sound (CFL) and by the viscosity
+		static float GetStableTimestep(const FluidParameters& parameters);
+
+		// particles, states (density, pressure) and accelerations were read back after the forces of a step, before the integration
+		// Compares sampleCount evenly strided particles on the job system, needs at most MAX_PARTICLE_COUNT particles
+		static FluidValidationResult Validate(const Particle* particles, const glm::vec2* states, const glm::vec2* accelerations, uint32_t particleCount, const FluidParameters& parameters, uint32_t sampleCount);
+
+		static void PrintResult(std::ostream& out, const FluidValidationResult& result);
+	};
+
+} // namespace VulkanCore
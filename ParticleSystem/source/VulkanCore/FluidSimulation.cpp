@@ -0,0 +1,272 @@
+#include "FluidSimulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#include "Particle.h"
+
+namespace VulkanCore {
+
+	FluidSimulation::FluidSimulation(GPUDevice& device)
+		: device(device)
+		, parameters(GetDefaultParameters())
+		, particleBuffer(VK_NULL_HANDLE)
+		, particleCount(0)
+		, bHasBuffers(false)
+		, grid(device)
+		, descriptorSet(VK_NULL_HANDLE)
+		, validationParameters({})
+		, validationParticleCount(0)
+		, validationResult({})
+		, validation(device, "Fluid",
+			[this](const void* data)
+			{
+				const Particle* particles = static_cast<const Particle*>(data);
+				const glm::vec2* states = reinterpret_cast<const glm::vec2*>(particles + validationParticleCount);
+				const glm::vec2* accelerations = states + validationParticleCount;
+				validationResult = FluidReference::Validate(particles, states, accelerations, validationParticleCount, validationParameters, VALIDATION_SAMPLE_COUNT);
+			},
+			[this]()
+			{
+				FluidReference::PrintResult(std::cout, validationResult);
+			})
+	{
+#if defined(PLATFORM_WINDOWS) || (defined(PLATFORM_LINUX) && defined(NDEBUG))
+		static const std::string fluidShaderFilePath = "shaders/sph_fluid.comp.spv";
+#elif defined(PLATFORM_LINUX) && defined(DEBUG)
+		static const std::string fluidShaderFilePath = "ParticleSystem/shaders/sph_fluid.comp.spv";
+#endif
+
+		descriptorSetLayout = DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// particles
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// cell starts
+			.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// sorted indices
+			.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// states
+			.AddBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// accelerations
+			.Build();
+
+		pipeline = std::make_unique<Pipeline>(device, descriptorSetLayout->GetDescriptorSetLayout(), fluidShaderFilePath, static_cast<uint32_t>(sizeof(FluidPushConstants)));
+	}
+
+	FluidSimulation::~FluidSimulation()
+	{
+		CleanupBuffers();
+	}
+
+	void FluidSimulation::SetParticles(VkBuffer newParticleBuffer, uint32_t newParticleCount)
+	{
+		CleanupBuffers();
+
+		particleBuffer = newParticleBuffer;
+		particleCount = newParticleCount;
+
+		UpdateDerivedParameters();
+		grid.SetParticles(newParticleBuffer, newParticleCount);
+		grid.SetCellSize(parameters.smoothingLength);
+	}
+
+	void FluidSimulation::SetParameters(const FluidParameters& newParameters)
+	{
+		parameters.restDensity = newParameters.restDensity;
+		parameters.stiffness = newParameters.stiffness;
+		parameters.viscosity = newParameters.viscosity;
+		parameters.gravity = newParameters.gravity;
+		parameters.smoothingFactor = newParameters.smoothingFactor;
+		parameters.wallRestitution = newParameters.wallRestitution;
+		parameters.attractorStrength = newParameters.attractorStrength;
+
+		UpdateDerivedParameters();
+
+		// A new resolution reallocates the grid (the GPU is idle by then), the descriptors are rewritten by the next step
+		const glm::uvec2 previousResolution = grid.GetResolution();
+		grid.SetCellSize(parameters.smoothingLength);
+		if (grid.GetResolution() != previousResolution)
+		{
+			CleanupBuffers();
+		}
+	}
+
+	void FluidSimulation::RecordStep(VkCommandBuffer commandBuffer, float timestep, glm::vec2 attractor, bool bAttractorEnabled, bool bIsLastStep)
+	{
+		// Also waits for the previous step to be done with the particles
+		grid.Record(commandBuffer);
+
+		if (!bHasBuffers)
+		{
+			CreateBuffers();
+		}
+
+		pipeline->BindComputePipeline(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetComputePipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+
+		FluidPushConstants pushConstants = {};
+		pushConstants.gridOrigin = grid.GetOrigin();
+		pushConstants.inverseCellSize = 1.0f / grid.GetCellSize();
+		pushConstants.particleCount = particleCount;
+		pushConstants.gridResolution = grid.GetResolution();
+		pushConstants.smoothingLength = parameters.smoothingLength;
+		pushConstants.particleMass = parameters.particleMass;
+		pushConstants.restDensity = parameters.restDensity;
+		pushConstants.stiffness = parameters.stiffness;
+		pushConstants.viscosity = parameters.viscosity;
+		pushConstants.gravity = parameters.gravity;
+		pushConstants.boxHalfSize = glm::vec2(BOX_HALF_WIDTH, BOX_HALF_HEIGHT);
+		pushConstants.wallRestitution = parameters.wallRestitution;
+		pushConstants.timestep = timestep;
+		pushConstants.attractor = attractor;
+		pushConstants.attractorEnabled = bAttractorEnabled ? 1 : 0;
+		pushConstants.attractorStrength = parameters.attractorStrength;
+
+		// Every pass reads what the previous one wrote
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		const uint32_t workgroupCount = (particleCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+		const auto dispatchPass = [this, commandBuffer, &pushConstants, &barrier, workgroupCount](FluidPass pass)
+		{
+			pushConstants.pass = static_cast<uint32_t>(pass);
+			vkCmdPushConstants(commandBuffer, pipeline->GetComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(FluidPushConstants), &pushConstants);
+			vkCmdDispatch(commandBuffer, workgroupCount, 1, 1);
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		};
+
+		dispatchPass(FluidPass::Density);
+		dispatchPass(FluidPass::Forces);
+
+		// The positions the forces were computed from are only moved by the integration
+		if (bIsLastStep && validation.GetIsRequested())
+		{
+			RecordValidationReadback(commandBuffer);
+		}
+
+		dispatchPass(FluidPass::Integrate);
+	}
+
+	void FluidSimulation::Poll()
+	{
+		validation.Poll();
+	}
+
+	bool FluidSimulation::Validate()
+	{
+		if (particleCount > FluidReference::MAX_PARTICLE_COUNT)
+		{
+			return false;
+		}
+
+		return validation.Request();
+	}
+
+	FluidParameters FluidSimulation::GetDefaultParameters()
+	{
+		FluidParameters defaultParameters = {};
+		defaultParameters.restDensity = 1.0f;
+		defaultParameters.stiffness = 200.0f;
+		defaultParameters.viscosity = 0.01f;
+		defaultParameters.gravity = 1.0f;
+		defaultParameters.smoothingFactor = 2.0f;
+		defaultParameters.wallRestitution = 0.3f;
+		defaultParameters.attractorStrength = 2.0f;
+		return defaultParameters;
+	}
+
+	glm::vec2 FluidSimulation::GetInitialPosition(uint32_t index, uint32_t particleCount)
+	{
+		// Square lattice filling BLOCK_WIDTH row by row, the last row may be partial
+		const float spacing = std::sqrt(BLOCK_WIDTH * BLOCK_HEIGHT / static_cast<float>(std::max(particleCount, 1u)));
+		const uint32_t columnCount = std::max(static_cast<uint32_t>(BLOCK_WIDTH / spacing), 1u);
+
+		return glm::vec2(
+			-BOX_HALF_WIDTH + (static_cast<float>(index % columnCount) + 0.5f) * spacing,
+			-BOX_HALF_HEIGHT + (static_cast<float>(index / columnCount) + 0.5f) * spacing
+		);
+	}
+
+	void FluidSimulation::UpdateDerivedParameters()
+	{
+		// One particle per spacing^2 of the dam, at rest density
+		parameters.spacing = std::sqrt(BLOCK_WIDTH * BLOCK_HEIGHT / static_cast<float>(std::max(particleCount, 1u)));
+		parameters.particleMass = parameters.restDensity * parameters.spacing * parameters.spacing;
+
+		// The grid cells hold every neighbour only while they are at least one smoothing length wide
+		parameters.smoothingLength = std::min(parameters.smoothingFactor * parameters.spacing, SpatialGrid::MAX_CELL_SIZE);
+	}
+
+	void FluidSimulation::CreateBuffers()
+	{
+		const VkDeviceSize particles = static_cast<VkDeviceSize>(std::max(particleCount, 1u));
+
+		stateBuffer.Create(device, sizeof(glm::vec2) * particles, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		accelerationBuffer.Create(device, sizeof(glm::vec2) * particles, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		descriptorPool = DescriptorPool::Builder(device)
+			.SetMaxSets(1)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5)
+			.Build();
+
+		const VkDescriptorBufferInfo particleBufferInfo = { particleBuffer, 0, sizeof(Particle) * static_cast<VkDeviceSize>(particleCount) };
+		const VkDescriptorBufferInfo cellStartBufferInfo = { grid.GetCellStartBuffer(), 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo sortedIndexBufferInfo = { grid.GetSortedIndexBuffer(), 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo stateBufferInfo = { stateBuffer.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo accelerationBufferInfo = { accelerationBuffer.buffer, 0, VK_WHOLE_SIZE };
+
+		DescriptorWriter(*descriptorSetLayout, *descriptorPool)
+			.WriteBuffer(0, particleBufferInfo)
+			.WriteBuffer(1, cellStartBufferInfo)
+			.WriteBuffer(2, sortedIndexBufferInfo)
+			.WriteBuffer(3, stateBufferInfo)
+			.WriteBuffer(4, accelerationBufferInfo)
+			.Build(descriptorSet);
+
+		bHasBuffers = true;
+	}
+
+	void FluidSimulation::CleanupBuffers()
+	{
+		if (!bHasBuffers)
+		{
+			return;
+		}
+
+		descriptorPool.reset();
+		descriptorSet = VK_NULL_HANDLE;
+
+		stateBuffer.Cleanup(device);
+		accelerationBuffer.Cleanup(device);
+
+		bHasBuffers = false;
+	}
+
+	void FluidSimulation::RecordValidationReadback(VkCommandBuffer commandBuffer)
+	{
+		// Particles followed by the states and the accelerations
+		const VkDeviceSize particleSize = sizeof(Particle) * static_cast<VkDeviceSize>(particleCount);
+		const VkDeviceSize vectorSize = sizeof(glm::vec2) * static_cast<VkDeviceSize>(particleCount);
+
+		const VkBuffer readbackBuffer = validation.BeginReadback(commandBuffer, particleSize + 2 * vectorSize);
+
+		VkBufferCopy particleRegion = {};
+		particleRegion.size = particleSize;
+		vkCmdCopyBuffer(commandBuffer, particleBuffer, readbackBuffer, 1, &particleRegion);
+
+		VkBufferCopy stateRegion = {};
+		stateRegion.dstOffset = particleSize;
+		stateRegion.size = vectorSize;
+		vkCmdCopyBuffer(commandBuffer, stateBuffer.buffer, readbackBuffer, 1, &stateRegion);
+
+		VkBufferCopy accelerationRegion = {};
+		accelerationRegion.dstOffset = particleSize + vectorSize;
+		accelerationRegion.size = vectorSize;
+		vkCmdCopyBuffer(commandBuffer, accelerationBuffer.buffer, readbackBuffer, 1, &accelerationRegion);
+
+		// The integration overwrites the particles that were just read
+		validation.EndReadback(commandBuffer);
+
+		validationParameters = parameters;
+		validationParticleCount = particleCount;
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "GPUDevice.h"
+#include "Descriptor.h"
+#include "Pipeline.h"
+#include "StorageBuffer.h"
+#include "ReadbackValidation.h"
+#include "SpatialGrid.h"
+#include "FluidReference.h"
+
+namespace VulkanCore {
+
+	// Push constants of sph_fluid.comp
+	struct FluidPushConstants
+	{
+		glm::vec2 gridOrigin;
+		float inverseCellSize;
+		uint32_t particleCount;
+		glm::uvec2 gridResolution;
+		float smoothingLength;
+		float particleMass;
+		float restDensity;
+		float stiffness;
+		float viscosity;
+		float gravity;
+		glm::vec2 boxHalfSize;
+		float wallRestitution;
+		float timestep;
+		glm::vec2 attractor;
+		uint32_t attractorEnabled;
+		float attractorStrength;
+		uint32_t pass;
+	};
+
+	// 2D SPH fluid integrated in place on the particle buffer, see FluidReference for the equations
+	// A step rebuilds the neighbour grid (SpatialGrid with one smoothing length per cell), then runs the density, forces and
+	// integration passes of sph_fluid.comp. The fluid starts as a dam of BLOCK_WIDTH x BLOCK_HEIGHT in the lower left corner
+	// of the box, the particle spacing and mass follow from the particle count so the dam is at rest density.
+	class FluidSimulation final
+	{
+	public:
+		// Matches sph_fluid.comp
+		static constexpr uint32_t WORKGROUP_SIZE = 128;
+
+		// Walls, inside the grid domain
+		static constexpr float BOX_HALF_WIDTH = 1.6f;
+		static constexpr float BOX_HALF_HEIGHT = 1.0f;
+
+		// Initial dam, see Application::CreateShaderStorageBuffer
+		static constexpr float BLOCK_WIDTH = 1.4f;
+		static constexpr float BLOCK_HEIGHT = 1.4f;
+
+		// Particles compared against the CPU reference by Validate
+		static constexpr uint32_t VALIDATION_SAMPLE_COUNT = 4096;
+
+		// Constructor
+		FluidSimulation(GPUDevice& device);
+
+		// Destructor
+		~FluidSimulation();
+
+		// Not copyable
+		FluidSimulation(const FluidSimulation&) = delete;
+		FluidSimulation& operator = (const FluidSimulation&) = delete;
+
+		// Not moveable
+		FluidSimulation(FluidSimulation&&) = delete;
+		FluidSimulation& operator = (FluidSimulation&&) = delete;
+
+		// Call with the GPU idle whenever the particle buffer is recreated, the buffers are allocated by the next step
+		void SetParticles(VkBuffer particleBuffer, uint32_t particleCount);
+
+		// Only the settings are taken, the derived fields are recomputed. Waits for the GPU if the grid has to be reallocated.
+		void SetParameters(const FluidParameters& parameters);
+
+		// Records one step of timestep seconds, keep it under GetStableTimestep
+		// The last step of a tick takes the validation readback
+		void RecordStep(VkCommandBuffer commandBuffer, float timestep, glm::vec2 attractor, bool bAttractorEnabled, bool bIsLastStep);
+
+		// Call once per frame after Renderer::SyncNewFrame, runs the CPU reference of a validation readback on the job system, never blocks
+		void Poll();
+
+		// Compares the densities and accelerations of the next step against the CPU reference and prints the result
+		// Returns false while the previous validation is still running or with more than FluidReference::MAX_PARTICLE_COUNT particles
+		bool Validate();
+
+		static FluidParameters GetDefaultParameters();
+
+		// Position of particle index of particleCount on the lattice of the initial dam
+		static glm::vec2 GetInitialPosition(uint32_t index, uint32_t particleCount);
+
+		// Getters
+		inline const FluidParameters& GetParameters() const { return parameters; }
+		inline float GetStableTimestep() const { return FluidReference::GetStableTimestep(parameters); }
+
+	private:
+		// sph_fluid.comp passes in recording order
+		enum class FluidPass : uint32_t
+		{
+			Density = 0,
+			Forces,
+			Integrate
+		};
+
+		GPUDevice& device;
+
+		FluidParameters parameters;
+
+		VkBuffer particleBuffer;
+		uint32_t particleCount;
+		bool bHasBuffers;
+
+		SpatialGrid grid;
+
+		StorageBuffer stateBuffer;				// vec2(density, pressure) per particle
+		StorageBuffer accelerationBuffer;
+
+		// Descriptors
+		std::unique_ptr<DescriptorSetLayout> descriptorSetLayout;
+		std::unique_ptr<DescriptorPool> descriptorPool;
+		VkDescriptorSet descriptorSet;
+
+		std::unique_ptr<Pipeline> pipeline;
+
+		// Validation, the particles, states and accelerations right after the forces
+		FluidParameters validationParameters;
+		uint32_t validationParticleCount;
+		FluidValidationResult validationResult;
+		ReadbackValidation validation;
+
+		void UpdateDerivedParameters();
+
+		void CreateBuffers();
+		void CleanupBuffers();
+
+		void RecordValidationReadback(VkCommandBuffer commandBuffer);
+	};
+
+} // namespace VulkanCore
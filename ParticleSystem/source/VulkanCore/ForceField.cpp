@@ -0,0 +1,133 @@
+#include "ForceField.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include <glm/gtc/constants.hpp>
+
+namespace VulkanCore {
+
+	static double ReadNumber(const nlohmann::json& entry, const char* key, size_t index, double defaultValue)
+	{
+		if (!entry.contains(key))
+		{
+			return defaultValue;
+		}
+
+		if (!entry[key].is_number())
+		{
+			throw std::runtime_error("ERROR: Invalid input: 'forceSources'[" + std::to_string(index) + "] '" + key + "' is not a number");
+		}
+
+		return entry[key].get<double>();
+	}
+
+	static glm::dvec2 ReadPoint(const nlohmann::json& entry, const char* key, size_t index)
+	{
+		if (!entry.contains(key))
+		{
+			return glm::dvec2(0.0, 0.0);
+		}
+
+		const nlohmann::json& point = entry[key];
+		if (!point.is_array() || point.size() != 2 || !point[0].is_number() || !point[1].is_number())
+		{
+			throw std::runtime_error("ERROR: Invalid input: 'forceSources'[" + std::to_string(index) + "] '" + key + "' is not an [x, y] pair");
+		}
+
+		return glm::dvec2(point[0].get<double>(), point[1].get<double>());
+	}
+
+	ForceField::ForceField()
+		: sourceCount(0)
+	{
+
+	}
+
+	ForceField::ForceField(const nlohmann::json& json)
+		: sourceCount(0)
+	{
+		if (!json.contains("forceSources"))
+		{
+			return;
+		}
+
+		const nlohmann::json& entries = json["forceSources"];
+		if (!entries.is_array())
+		{
+			throw std::runtime_error("ERROR: Invalid input: 'forceSources' is not an array");
+		}
+
+		rings.reserve(entries.size());
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			const nlohmann::json& entry = entries[i];
+
+			SourceRing ring = {};
+			ring.type = ParseType(entry, i);
+			ring.center = ReadPoint(entry, "center", i);
+			ring.radius = ReadNumber(entry, "radius", i, 0.0);
+			ring.period = ReadNumber(entry, "period", i, 0.0);
+			ring.phase = ReadNumber(entry, "phase", i, 0.0);
+			ring.strength = static_cast<float>(ReadNumber(entry, "strength", i, 1.0));
+			ring.falloff = static_cast<float>(ReadNumber(entry, "falloff", i, 2.0));
+
+			const double count = ReadNumber(entry, "count", i, 1.0);
+			if (count < 1.0 || count > MAX_SOURCE_COUNT || count != std::floor(count))
+			{
+				throw std::runtime_error("ERROR: Invalid input: 'forceSources'[" + std::to_string(i) + "] 'count' has to be a whole number in [1, " + std::to_string(MAX_SOURCE_COUNT) + "]");
+			}
+			ring.count = static_cast<uint32_t>(count);
+
+			if (sourceCount + ring.count > MAX_SOURCE_COUNT)
+			{
+				throw std::runtime_error("ERROR: Invalid input: more than " + std::to_string(MAX_SOURCE_COUNT) + " force sources");
+			}
+
+			sourceCount += ring.count;
+			rings.push_back(ring);
+		}
+	}
+
+	void ForceField::Evaluate(double time, ForceSource* sources) const
+	{
+		uint32_t index = 0;
+		for (const SourceRing& ring : rings)
+		{
+			// In turns, the angle is only formed once per source to keep the precision over long runs
+			const double rotation = ring.period != 0.0 ? std::fmod(time / ring.period, 1.0) : 0.0;
+			for (uint32_t i = 0; i < ring.count; ++i)
+			{
+				const double angle = glm::two_pi<double>() * (ring.phase + rotation + static_cast<double>(i) / static_cast<double>(ring.count));
+
+				ForceSource& source = sources[index++];
+				source.position = glm::vec2(ring.center + ring.radius * glm::dvec2(std::cos(angle), std::sin(angle)));
+				source.strength = ring.strength;
+				source.falloff = ring.falloff;
+				source.type = ring.type;
+				source.padding = 0;
+			}
+		}
+	}
+
+	ForceSourceType ForceField::ParseType(const nlohmann::json& entry, size_t index)
+	{
+		const std::string type = entry.contains("type") && entry["type"].is_string() ? entry["type"].get<std::string>() : "";
+		if (type == "attractor")
+		{
+			return ForceSourceType::Attractor;
+		}
+		else if (type == "repulsor")
+		{
+			return ForceSourceType::Repulsor;
+		}
+		else if (type == "vortex")
+		{
+			return ForceSourceType::Vortex;
+		}
+
+		throw std::runtime_error("ERROR: Invalid input: 'forceSources'[" + std::to_string(index) + "] 'type' has to be \"attractor\", \"repulsor\" or \"vortex\"");
+	}
+
+} // namespace VulkanCore
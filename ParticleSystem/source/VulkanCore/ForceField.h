@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+
+namespace VulkanCore {
+
+	enum class ForceSourceType : uint32_t
+	{
+		Attractor = 0,		// pulls towards the source
+		Repulsor = 1,		// pushes away from the source
+		Vortex = 2			// swirls counterclockwise around the source
+	};
+
+	// std430 layout of ForceSource in particle.comp
+	struct ForceSource
+	{
+		glm::vec2 position;
+		float strength;
+		float falloff;		// acceleration = strength / (distance^falloff + eps)
+		ForceSourceType type;
+		uint32_t padding;
+	};
+
+	static_assert(sizeof(ForceSource) == 24, "ForceSource has to match the std430 layout of the shader");
+
+	// Scripted force sources of a benchmark scenario, the optional "forceSources" array of the scenario file
+	// Every entry places "count" sources evenly on a circle of "radius" world units around "center" (a single source at the center by default),
+	// the circle turns once every "period" seconds (0 for static sources, negative for clockwise), "phase" offsets it in turns.
+	// Sources are evaluated from the simulation time, so a replay always sees the same sources at the same step.
+	class ForceField final
+	{
+	public:
+		// Size of the force source buffer
+		static constexpr uint32_t MAX_SOURCE_COUNT = 4096;
+
+		// Constructors
+		ForceField();
+
+		// Throws std::runtime_error on malformed input
+		explicit ForceField(const nlohmann::json& json);
+
+		// Writes GetSourceCount sources at simulation time seconds
+		void Evaluate(double time, ForceSource* sources) const;
+
+		// Getters
+		inline uint32_t GetSourceCount() const { return sourceCount; }
+
+	private:
+		struct SourceRing
+		{
+			ForceSourceType type;
+			uint32_t count;
+			glm::dvec2 center;
+			double radius;
+			double period;
+			double phase;
+			float strength;
+			float falloff;
+		};
+
+		std::vector<SourceRing> rings;
+		uint32_t sourceCount;
+
+		static ForceSourceType ParseType(const nlohmann::json& entry, size_t index);
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,416 @@
+#include "FrameCapture.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <algorithm>
+
+#include "JobSystem.h"
+
+namespace VulkanCore {
+
+	FrameCapture::FrameCapture(GPUDevice& device)
+		: device(device)
+		, nextSlot(0)
+		, bIsCapturing(false)
+		, format(CaptureFormat::Y4M)
+		, frameRate(60)
+		, captureExtent({ 0, 0 })
+		, capturedFrameCount(0)
+		, droppedFrameCount(0)
+		, bStopWriter(false)
+	{
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		for (ReadbackSlot& slot : slots)
+		{
+			if (vkCreateFence(device.GetVKDevice(), &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create frame capture fence!");
+			}
+		}
+	}
+
+	FrameCapture::~FrameCapture()
+	{
+		Stop();
+
+		for (ReadbackSlot& slot : slots)
+		{
+			CleanupSlot(slot);
+			vkDestroyFence(device.GetVKDevice(), slot.fence, nullptr);
+		}
+	}
+
+	void FrameCapture::Start(const std::string& filePath, CaptureFormat newFormat, uint32_t newFrameRate, bool bSwapChainSupportsTransferSource)
+	{
+		if (bIsCapturing)
+		{
+			return;
+		}
+
+		if (!bSwapChainSupportsTransferSource)
+		{
+			std::cout << "ERROR: Frame capture is not available, the surface does not allow copying from swap chain images" << std::endl;
+			return;
+		}
+
+		file.open(filePath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR: Could not open " << filePath << " for frame capture" << std::endl;
+			return;
+		}
+
+		format = newFormat;
+		frameRate = std::max(newFrameRate, 1u);
+		captureExtent = { 0, 0 };
+		capturedFrameCount = 0;
+		droppedFrameCount = 0;
+
+		bStopWriter = false;
+		writerThread = std::thread(&FrameCapture::WriterLoop, this);
+
+		bIsCapturing = true;
+	}
+
+	void FrameCapture::Stop()
+	{
+		if (!bIsCapturing)
+		{
+			return;
+		}
+
+		// Flush the readbacks still on the GPU, stopping is allowed to block
+		WaitForInFlightSlots();
+
+		{
+			std::lock_guard<std::mutex> lock(writerMutex);
+			bStopWriter = true;
+		}
+		writerCondition.notify_one();
+		writerThread.join();
+
+		file.close();
+		bIsCapturing = false;
+	}
+
+	void FrameCapture::Poll()
+	{
+		bool bHasNewFrames = false;
+
+		for (uint32_t i = 0; i < READBACK_SLOT_COUNT; ++i)
+		{
+			ReadbackSlot& slot = slots[i];
+			if (slot.state.load(std::memory_order_acquire) != SlotState::InFlight)
+			{
+				continue;
+			}
+
+			if (vkGetFenceStatus(device.GetVKDevice(), slot.fence) != VK_SUCCESS)
+			{
+				continue;
+			}
+
+			slot.state.store(SlotState::Writing, std::memory_order_release);
+
+			std::lock_guard<std::mutex> lock(writerMutex);
+			writerQueue.push_back(i);
+			bHasNewFrames = true;
+		}
+
+		if (bHasNewFrames)
+		{
+			writerCondition.notify_one();
+		}
+	}
+
+	VkFence FrameCapture::Record(VkCommandBuffer commandBuffer, VkImage swapChainImage, VkFormat swapChainImageFormat, VkExtent2D extent, bool bSwapChainSupportsTransferSource)
+	{
+		if (!bIsCapturing)
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		if (!bSwapChainSupportsTransferSource)
+		{
+			std::cout << "ERROR: Frame capture stopped, the recreated swap chain images can not be copied from" << std::endl;
+			Stop();
+			return VK_NULL_HANDLE;
+		}
+
+		// The output stream has fixed dimensions, frames of a different size are skipped
+		if (captureExtent.width == 0 && captureExtent.height == 0)
+		{
+			captureExtent = extent;
+		}
+
+		ReadbackSlot& slot = slots[nextSlot];
+		if (slot.state.load(std::memory_order_acquire) != SlotState::Free
+			|| extent.width != captureExtent.width || extent.height != captureExtent.height)
+		{
+			++droppedFrameCount;
+			return VK_NULL_HANDLE;
+		}
+
+		if (slot.extent.width != extent.width || slot.extent.height != extent.height)
+		{
+			CleanupSlot(slot);
+			CreateSlot(slot, extent);
+		}
+
+		slot.bIsBGRA = swapChainImageFormat == VK_FORMAT_B8G8R8A8_SRGB || swapChainImageFormat == VK_FORMAT_B8G8R8A8_UNORM;
+
+		VkImageSubresourceRange imageSubresourceRangeInfo = {};
+		imageSubresourceRangeInfo.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageSubresourceRangeInfo.baseMipLevel = 0;
+		imageSubresourceRangeInfo.levelCount = 1;
+		imageSubresourceRangeInfo.baseArrayLayer = 0;
+		imageSubresourceRangeInfo.layerCount = 1;
+
+		// PRESENT_SRC -> TRANSFER_SRC
+		{
+			VkImageMemoryBarrier imageMemoryBarrier = {};
+			imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageMemoryBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			imageMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+			imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageMemoryBarrier.image = swapChainImage;
+			imageMemoryBarrier.subresourceRange = imageSubresourceRangeInfo;
+
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0,
+				0, nullptr,
+				0, nullptr,
+				1, &imageMemoryBarrier
+			);
+		}
+
+		// Copy
+		VkBufferImageCopy region = {};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;			// tightly packed
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { extent.width, extent.height, 1 };
+
+		vkCmdCopyImageToBuffer(commandBuffer, swapChainImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.buffer, 1, &region);
+
+		// TRANSFER_SRC -> PRESENT_SRC + make the copy visible to the host
+		{
+			VkImageMemoryBarrier imageMemoryBarrier = {};
+			imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			imageMemoryBarrier.dstAccessMask = VK_ACCESS_NONE;
+			imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+			imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			imageMemoryBarrier.image = swapChainImage;
+			imageMemoryBarrier.subresourceRange = imageSubresourceRangeInfo;
+
+			VkBufferMemoryBarrier bufferMemoryBarrier = {};
+			bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			bufferMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			bufferMemoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			bufferMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			bufferMemoryBarrier.buffer = slot.buffer;
+			bufferMemoryBarrier.offset = 0;
+			bufferMemoryBarrier.size = VK_WHOLE_SIZE;
+
+			vkCmdPipelineBarrier(
+				commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+				0,
+				0, nullptr,
+				1, &bufferMemoryBarrier,
+				1, &imageMemoryBarrier
+			);
+		}
+
+		vkResetFences(device.GetVKDevice(), 1, &slot.fence);
+		slot.state.store(SlotState::InFlight, std::memory_order_release);
+		nextSlot = (nextSlot + 1) % READBACK_SLOT_COUNT;
+
+		return slot.fence;
+	}
+
+	const char* FrameCapture::GetFileExtension(CaptureFormat format)
+	{
+		switch (format)
+		{
+			case CaptureFormat::RawRGBA:	return ".rgba";
+			case CaptureFormat::Y4M:		return ".y4m";
+			default:						return ".bin";
+		}
+	}
+
+	void FrameCapture::CreateSlot(ReadbackSlot& slot, VkExtent2D extent)
+	{
+		slot.extent = extent;
+		slot.size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+
+		// Prefer cached memory, CPU reads from uncached memory are an order of magnitude slower
+		VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		{
+			VkPhysicalDeviceMemoryProperties memoryProperties;
+			vkGetPhysicalDeviceMemoryProperties(device.GetPhysicalDevice(), &memoryProperties);
+
+			const VkMemoryPropertyFlags cachedProperties = properties | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+			{
+				if ((memoryProperties.memoryTypes[i].propertyFlags & cachedProperties) == cachedProperties)
+				{
+					properties = cachedProperties;
+					break;
+				}
+			}
+		}
+
+		device.CreateBuffer(
+			slot.size,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			properties,
+			slot.buffer,
+			slot.memory
+		);
+
+		// Persistently mapped
+		vkMapMemory(device.GetVKDevice(), slot.memory, 0, slot.size, 0, &slot.mapped);
+	}
+
+	void FrameCapture::CleanupSlot(ReadbackSlot& slot)
+	{
+		if (slot.buffer == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		vkUnmapMemory(device.GetVKDevice(), slot.memory);
+		vkDestroyBuffer(device.GetVKDevice(), slot.buffer, nullptr);
+		vkFreeMemory(device.GetVKDevice(), slot.memory, nullptr);
+
+		slot.buffer = VK_NULL_HANDLE;
+		slot.memory = VK_NULL_HANDLE;
+		slot.mapped = nullptr;
+		slot.size = 0;
+		slot.extent = { 0, 0 };
+	}
+
+	void FrameCapture::WaitForInFlightSlots()
+	{
+		for (ReadbackSlot& slot : slots)
+		{
+			if (slot.state.load(std::memory_order_acquire) == SlotState::InFlight)
+			{
+				vkWaitForFences(device.GetVKDevice(), 1, &slot.fence, VK_TRUE, UINT64_MAX);
+			}
+		}
+
+		Poll();
+	}
+
+	void FrameCapture::WriterLoop()
+	{
+		std::vector<uint8_t> scratch;
+
+		while (true)
+		{
+			uint32_t slotIndex = 0;
+			{
+				std::unique_lock<std::mutex> lock(writerMutex);
+				writerCondition.wait(lock, [this]() { return bStopWriter || !writerQueue.empty(); });
+
+				// Drain the queue before stopping
+				if (writerQueue.empty())
+				{
+					break;
+				}
+
+				slotIndex = writerQueue.front();
+				writerQueue.pop_front();
+			}
+
+			WriteFrame(slots[slotIndex], scratch);
+			capturedFrameCount.fetch_add(1, std::memory_order_relaxed);
+
+			slots[slotIndex].state.store(SlotState::Free, std::memory_order_release);
+		}
+
+		file.flush();
+	}
+
+	void FrameCapture::WriteFrame(const ReadbackSlot& slot, std::vector<uint8_t>& scratch)
+	{
+		const uint8_t* pixels = static_cast<const uint8_t*>(slot.mapped);
+		const size_t pixelCount = static_cast<size_t>(slot.extent.width) * slot.extent.height;
+
+		// Byte offsets of the R, G, B channels
+		const size_t r = slot.bIsBGRA ? 2 : 0;
+		const size_t g = 1;
+		const size_t b = slot.bIsBGRA ? 0 : 2;
+
+		if (format == CaptureFormat::RawRGBA)
+		{
+			if (!slot.bIsBGRA)
+			{
+				file.write(reinterpret_cast<const char*>(pixels), static_cast<std::streamsize>(pixelCount * 4));
+				return;
+			}
+
+			scratch.resize(pixelCount * 4);
+			for (size_t i = 0; i < pixelCount; ++i)
+			{
+				scratch[4 * i + 0] = pixels[4 * i + r];
+				scratch[4 * i + 1] = pixels[4 * i + g];
+				scratch[4 * i + 2] = pixels[4 * i + b];
+				scratch[4 * i + 3] = pixels[4 * i + 3];
+			}
+
+			file.write(reinterpret_cast<const char*>(scratch.data()), static_cast<std::streamsize>(scratch.size()));
+			return;
+		}
+
+		// Y4M stream header, written once the first frame dictates the dimensions
+		if (capturedFrameCount.load(std::memory_order_relaxed) == 0)
+		{
+			file << "YUV4MPEG2 W" << slot.extent.width << " H" << slot.extent.height << " F" << frameRate << ":1 Ip A1:1 C444\n";
+		}
+
+		// BT.601 limited range, planar Y, U, V
+		scratch.resize(pixelCount * 3);
+		uint8_t* planeY = scratch.data();
+		uint8_t* planeU = planeY + pixelCount;
+		uint8_t* planeV = planeU + pixelCount;
+
+		JobSystem::GetInstance().ParallelFor(pixelCount, MIN_PIXELS_PER_JOB, [=](uint64_t first, uint64_t end)
+		{
+			for (size_t i = first; i < end; ++i)
+			{
+				const int32_t R = pixels[4 * i + r];
+				const int32_t G = pixels[4 * i + g];
+				const int32_t B = pixels[4 * i + b];
+
+				planeY[i] = static_cast<uint8_t>(((66 * R + 129 * G + 25 * B + 128) >> 8) + 16);
+				planeU[i] = static_cast<uint8_t>(((-38 * R - 74 * G + 112 * B + 128) >> 8) + 128);
+				planeV[i] = static_cast<uint8_t>(((112 * R - 94 * G - 18 * B + 128) >> 8) + 128);
+			}
+		});
+
+		file << "FRAME\n";
+		file.write(reinterpret_cast<const char*>(scratch.data()), static_cast<std::streamsize>(scratch.size()));
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GPUDevice.h"
+
+namespace VulkanCore {
+
+	enum class CaptureFormat : uint32_t
+	{
+		RawRGBA = 0,	// tightly packed 8-bit RGBA frames, one after another
+		Y4M = 1			// YUV4MPEG2, 4:4:4 planar, readable by ffmpeg / mpv
+	};
+
+	// In-engine video capture
+	// The swap chain image is copied into one of READBACK_SLOT_COUNT host-visible buffers as part of the frame command buffer.
+	// Slots are polled with fences a few frames later and handed to a writer thread, the render loop never waits on a readback.
+	// If every slot is busy (GPU copy or disk write still pending) the frame is dropped instead.
+	class FrameCapture final
+	{
+	public:
+		static constexpr uint32_t READBACK_SLOT_COUNT = 4;
+
+		// Color conversion is split into jobs of at least this many pixels
+		static constexpr uint64_t MIN_PIXELS_PER_JOB = 1 << 16;
+
+		// Constructor
+		FrameCapture(GPUDevice& device);
+
+		// Destructor
+		~FrameCapture();
+
+		// Not copyable
+		FrameCapture(const FrameCapture&) = delete;
+		FrameCapture& operator = (const FrameCapture&) = delete;
+
+		// Not moveable
+		FrameCapture(FrameCapture&&) = delete;
+		FrameCapture& operator = (FrameCapture&&) = delete;
+
+		// Refused unless the swap chain images were created with VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+		void Start(const std::string& filePath, CaptureFormat format, uint32_t frameRate, bool bSwapChainSupportsTransferSource);
+		void Stop();
+
+		// Hands every finished readback to the writer thread, never blocks
+		void Poll();
+
+		// Records the copy of the swap chain image (expected in VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) into the frame command buffer
+		// Returns the fence that must be signaled by the submission of commandBuffer or VK_NULL_HANDLE if nothing was recorded
+		// A swap chain recreated without VK_IMAGE_USAGE_TRANSFER_SRC_BIT stops the capture
+		VkFence Record(VkCommandBuffer commandBuffer, VkImage swapChainImage, VkFormat swapChainImageFormat, VkExtent2D extent, bool bSwapChainSupportsTransferSource);
+
+		static const char* GetFileExtension(CaptureFormat format);
+
+		// Getters
+		inline bool GetIsCapturing() const { return bIsCapturing; }
+		inline uint64_t GetCapturedFrameCount() const { return capturedFrameCount.load(std::memory_order_relaxed); }
+		inline uint64_t GetDroppedFrameCount() const { return droppedFrameCount; }
+
+	private:
+		enum class SlotState : uint32_t
+		{
+			Free = 0,
+			InFlight,		// copy recorded, waiting for the GPU
+			Writing			// owned by the writer thread
+		};
+
+		struct ReadbackSlot
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			void* mapped = nullptr;
+			VkDeviceSize size = 0;
+			VkFence fence = VK_NULL_HANDLE;
+			VkExtent2D extent = { 0, 0 };
+			bool bIsBGRA = true;
+			std::atomic<SlotState> state = SlotState::Free;
+		};
+
+		GPUDevice& device;
+
+		std::array<ReadbackSlot, READBACK_SLOT_COUNT> slots;
+		uint32_t nextSlot;
+
+		bool bIsCapturing;
+		CaptureFormat format;
+		uint32_t frameRate;
+		VkExtent2D captureExtent;
+		std::ofstream file;
+
+		std::atomic<uint64_t> capturedFrameCount;
+		uint64_t droppedFrameCount;
+
+		// Writer thread
+		std::thread writerThread;
+		std::mutex writerMutex;
+		std::condition_variable writerCondition;
+		std::deque<uint32_t> writerQueue;
+		bool bStopWriter;
+
+		void CreateSlot(ReadbackSlot& slot, VkExtent2D extent);
+		void CleanupSlot(ReadbackSlot& slot);
+		void WaitForInFlightSlots();
+
+		void WriterLoop();
+		void WriteFrame(const ReadbackSlot& slot, std::vector<uint8_t>& scratch);
+	};
+
+} // namespace VulkanCore
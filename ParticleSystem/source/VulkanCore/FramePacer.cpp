@@ -0,0 +1,90 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace VulkanCore {
+
+    FramePacer::FramePacer()
+        : policy(FramePacingPolicy::Mailbox)
+        , targetFPS(DEFAULT_TARGET_FPS)
+        , nextDeadline({ 0 })
+    {
+
+    }
+
+    Time FramePacer::Wait()
+    {
+        const Time start = Time::Now();
+        if (policy != FramePacingPolicy::TargetFPS || targetFPS == 0)
+        {
+            nextDeadline = { 0 };
+            return { 0 };
+        }
+
+        const Time interval = SecondsToTime(1.0 / static_cast<double>(targetFPS));
+        const Time spinThreshold = SecondsToTime(SPIN_THRESHOLD_SECONDS);
+
+        // First paced frame or we fell more than a whole frame behind: resync instead of bursting to catch up
+        if (nextDeadline.IsZero() || start > nextDeadline + interval)
+        {
+            nextDeadline = start;
+        }
+
+        // Coarse wait
+        Time now = start;
+        while (nextDeadline - now > spinThreshold)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds((nextDeadline - now - spinThreshold).value));
+            now = Time::Now();
+        }
+
+        // Fine wait
+        while (now < nextDeadline)
+        {
+            std::this_thread::yield();
+            now = Time::Now();
+        }
+
+        nextDeadline += interval;
+        return now - start;
+    }
+
+    void FramePacer::SetPolicy(FramePacingPolicy newPolicy)
+    {
+        policy = newPolicy;
+        nextDeadline = { 0 };
+    }
+
+    void FramePacer::SetTargetFPS(uint32_t newTargetFPS)
+    {
+        targetFPS = std::max(newTargetFPS, 1u);
+        nextDeadline = { 0 };
+    }
+
+    VkPresentModeKHR FramePacer::GetPresentMode(FramePacingPolicy policy)
+    {
+        switch (policy)
+        {
+            case FramePacingPolicy::VSync:      return VK_PRESENT_MODE_FIFO_KHR;
+            case FramePacingPolicy::Mailbox:    return VK_PRESENT_MODE_MAILBOX_KHR;
+            case FramePacingPolicy::Uncapped:
+            case FramePacingPolicy::TargetFPS:
+            default:                            return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        }
+    }
+
+    const char* FramePacer::GetPolicyName(FramePacingPolicy policy)
+    {
+        switch (policy)
+        {
+            case FramePacingPolicy::Uncapped:   return "Uncapped";
+            case FramePacingPolicy::VSync:      return "VSync (FIFO)";
+            case FramePacingPolicy::Mailbox:    return "Mailbox";
+            case FramePacingPolicy::TargetFPS:  return "Target FPS";
+            default:                            return "Unknown";
+        }
+    }
+
+} // namespace VulkanCore
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <cstdint>
+
+#include "Time.h"
+
+namespace VulkanCore {
+
+    enum class FramePacingPolicy : uint32_t
+    {
+        Uncapped = 0,   // IMMEDIATE present, no limiter
+        VSync = 1,      // FIFO present, the display paces the loop
+        Mailbox = 2,    // MAILBOX present, no tearing, no limiter
+        TargetFPS = 3   // Uncapped present + CPU frame limiter
+    };
+
+    class FramePacer final
+    {
+    public:
+        static constexpr uint32_t DEFAULT_TARGET_FPS = 60;
+
+        // Constructor
+        FramePacer();
+
+        // Not copyable
+        FramePacer(const FramePacer&) = delete;
+        FramePacer& operator = (const FramePacer&) = delete;
+
+        // Not moveable
+        FramePacer(FramePacer&&) = delete;
+        FramePacer& operator = (FramePacer&&) = delete;
+
+        // Blocks until the next frame deadline (only for FramePacingPolicy::TargetFPS)
+        // Returns the time spent waiting
+        Time Wait();
+
+        void SetPolicy(FramePacingPolicy newPolicy);
+        void SetTargetFPS(uint32_t newTargetFPS);
+
+        static VkPresentModeKHR GetPresentMode(FramePacingPolicy policy);
+        static const char* GetPolicyName(FramePacingPolicy policy);
+
+        // Getters
+        inline FramePacingPolicy GetPolicy() const { return policy; }
+        inline uint32_t GetTargetFPS() const { return targetFPS; }
+
+    private:
+        // Sleeping is only accurate to about a millisecond, the last part of the wait is spent spinning
+        static constexpr double SPIN_THRESHOLD_SECONDS = 0.0015;
+
+        FramePacingPolicy policy;
+        uint32_t targetFPS;
+        Time nextDeadline;
+    };
+
+} // namespace VulkanCore
@@ -0,0 +1,200 @@
+#include "FrameTimeHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace VulkanCore {
+
+	namespace {
+
+		constexpr uint64_t HALF_SUB_BUCKET_COUNT = FrameTimeHistogram::SUB_BUCKET_COUNT / 2;
+
+		inline double NanosecondsToMilliseconds(uint64_t nanoseconds)
+		{
+			return static_cast<double>(nanoseconds) * 1e-6;
+		}
+
+	} // namespace
+
+	FrameTimeHistogram::FrameTimeHistogram()
+		: buckets(BUCKET_COUNT, 0)
+		, count(0)
+		, sum(0)
+		, minimum(std::numeric_limits<uint64_t>::max())
+		, maximum(0)
+	{
+
+	}
+
+	void FrameTimeHistogram::Record(Time frameTime)
+	{
+		const uint64_t value = std::min(static_cast<uint64_t>(std::max<int64_t>(frameTime.value, 0)), MAX_VALUE);
+
+		++buckets[GetBucketIndex(value)];
+		++count;
+		sum += value;
+		minimum = std::min(minimum, value);
+		maximum = std::max(maximum, value);
+	}
+
+	void FrameTimeHistogram::Merge(const FrameTimeHistogram& other)
+	{
+		for (size_t i = 0; i < BUCKET_COUNT; ++i)
+		{
+			buckets[i] += other.buckets[i];
+		}
+
+		count += other.count;
+		sum += other.sum;
+		minimum = std::min(minimum, other.minimum);
+		maximum = std::max(maximum, other.maximum);
+	}
+
+	void FrameTimeHistogram::Reset()
+	{
+		std::fill(buckets.begin(), buckets.end(), 0);
+		count = 0;
+		sum = 0;
+		minimum = std::numeric_limits<uint64_t>::max();
+		maximum = 0;
+	}
+
+	Time FrameTimeHistogram::GetPercentile(double p) const
+	{
+		if (count == 0)
+		{
+			return { 0 };
+		}
+
+		// Nearest rank, walks the fixed bucket array instead of the samples
+		const uint64_t rank = std::clamp<uint64_t>(static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 1.0) * static_cast<double>(count))), 1, count);
+
+		uint64_t seen = 0;
+		for (size_t i = 0; i < BUCKET_COUNT; ++i)
+		{
+			seen += buckets[i];
+			if (seen >= rank)
+			{
+				const uint64_t midpoint = GetBucketLowest(i) + GetBucketWidth(i) / 2;
+				return { static_cast<int64_t>(std::clamp(midpoint, minimum, maximum)) };
+			}
+		}
+
+		return { static_cast<int64_t>(maximum) };
+	}
+
+	double FrameTimeHistogram::GetPercentileMilliseconds(double p) const
+	{
+		return NanosecondsToMilliseconds(static_cast<uint64_t>(GetPercentile(p).value));
+	}
+
+	double FrameTimeHistogram::GetMeanMilliseconds() const
+	{
+		return count == 0 ? 0.0 : NanosecondsToMilliseconds(sum) / static_cast<double>(count);
+	}
+
+	double FrameTimeHistogram::GetMinMilliseconds() const
+	{
+		return count == 0 ? 0.0 : NanosecondsToMilliseconds(minimum);
+	}
+
+	double FrameTimeHistogram::GetMaxMilliseconds() const
+	{
+		return NanosecondsToMilliseconds(maximum);
+	}
+
+	nlohmann::json FrameTimeHistogram::ToJSON() const
+	{
+		nlohmann::json json;
+		json["unit"] = "ns";
+		json["subBucketBits"] = SUB_BUCKET_BITS;
+		json["maxValueBits"] = MAX_VALUE_BITS;
+		json["count"] = count;
+		json["sum"] = sum;
+		json["min"] = count == 0 ? 0 : minimum;
+		json["max"] = maximum;
+
+		// [index, count] pairs
+		nlohmann::json bucketsJSON = nlohmann::json::array();
+		for (size_t i = 0; i < BUCKET_COUNT; ++i)
+		{
+			if (buckets[i] != 0)
+			{
+				bucketsJSON.push_back({ i, buckets[i] });
+			}
+		}
+		json["buckets"] = std::move(bucketsJSON);
+
+		return json;
+	}
+
+	FrameTimeHistogram FrameTimeHistogram::FromJSON(const nlohmann::json& json)
+	{
+		if (json.value("subBucketBits", 0u) != SUB_BUCKET_BITS || json.value("maxValueBits", 0u) != MAX_VALUE_BITS)
+		{
+			throw std::runtime_error("ERROR: Frame time histogram has a different bucket layout!");
+		}
+
+		FrameTimeHistogram histogram;
+		for (const nlohmann::json& bucket : json.at("buckets"))
+		{
+			const size_t index = bucket.at(0).get<size_t>();
+			if (index >= BUCKET_COUNT)
+			{
+				throw std::runtime_error("ERROR: Frame time histogram bucket " + std::to_string(index) + " is out of range!");
+			}
+			histogram.buckets[index] += bucket.at(1).get<uint64_t>();
+			histogram.count += bucket.at(1).get<uint64_t>();
+		}
+
+		if (histogram.count != json.at("count").get<uint64_t>())
+		{
+			throw std::runtime_error("ERROR: Frame time histogram bucket counts do not add up!");
+		}
+
+		histogram.sum = json.at("sum").get<uint64_t>();
+		histogram.minimum = histogram.count == 0 ? std::numeric_limits<uint64_t>::max() : json.at("min").get<uint64_t>();
+		histogram.maximum = json.at("max").get<uint64_t>();
+		return histogram;
+	}
+
+	size_t FrameTimeHistogram::GetBucketIndex(uint64_t value)
+	{
+		if (value < SUB_BUCKET_COUNT)
+		{
+			return static_cast<size_t>(value);
+		}
+
+		// The top SUB_BUCKET_BITS bits of the value pick the bucket inside its power of two
+		const uint32_t exponent = static_cast<uint32_t>(std::bit_width(value)) - 1;
+		const uint64_t subBucket = value >> (exponent - SUB_BUCKET_BITS + 1);
+		return static_cast<size_t>(SUB_BUCKET_COUNT + (exponent - SUB_BUCKET_BITS) * HALF_SUB_BUCKET_COUNT + (subBucket - HALF_SUB_BUCKET_COUNT));
+	}
+
+	uint64_t FrameTimeHistogram::GetBucketLowest(size_t index)
+	{
+		if (index < SUB_BUCKET_COUNT)
+		{
+			return index;
+		}
+
+		const uint64_t exponent = (index - SUB_BUCKET_COUNT) / HALF_SUB_BUCKET_COUNT + SUB_BUCKET_BITS;
+		const uint64_t subBucket = (index - SUB_BUCKET_COUNT) % HALF_SUB_BUCKET_COUNT + HALF_SUB_BUCKET_COUNT;
+		return subBucket << (exponent - SUB_BUCKET_BITS + 1);
+	}
+
+	uint64_t FrameTimeHistogram::GetBucketWidth(size_t index)
+	{
+		if (index < SUB_BUCKET_COUNT)
+		{
+			return 1;
+		}
+
+		const uint64_t exponent = (index - SUB_BUCKET_COUNT) / HALF_SUB_BUCKET_COUNT + SUB_BUCKET_BITS;
+		return uint64_t(1) << (exponent - SUB_BUCKET_BITS + 1);
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "Time.h"
+
+namespace VulkanCore {
+
+	// Streaming frame time distribution, HDR histogram style
+	// Values (nanoseconds) below SUB_BUCKET_COUNT get a bucket each, above that every power of two is split in SUB_BUCKET_COUNT / 2 linear buckets,
+	// so any percentile is within 1 / (SUB_BUCKET_COUNT / 2) of the recorded value whatever the length of the run.
+	// Recording is O(1) and the memory is fixed, histograms with the same layout merge by adding their buckets.
+	class FrameTimeHistogram final
+	{
+	public:
+		static constexpr uint32_t SUB_BUCKET_BITS = 8;
+		static constexpr uint64_t SUB_BUCKET_COUNT = uint64_t(1) << SUB_BUCKET_BITS;
+
+		// Longer frames (about 18 minutes) are counted in the last bucket
+		static constexpr uint32_t MAX_VALUE_BITS = 40;
+		static constexpr uint64_t MAX_VALUE = (uint64_t(1) << MAX_VALUE_BITS) - 1;
+		static constexpr size_t BUCKET_COUNT = SUB_BUCKET_COUNT + (MAX_VALUE_BITS - SUB_BUCKET_BITS) * (SUB_BUCKET_COUNT / 2);
+
+		// Constructor
+		FrameTimeHistogram();
+
+		void Record(Time frameTime);
+		void Merge(const FrameTimeHistogram& other);
+		void Reset();
+
+		// p in [0, 1], the midpoint of the bucket holding the sample of that rank, 0 if empty
+		Time GetPercentile(double p) const;
+		double GetPercentileMilliseconds(double p) const;
+		double GetMeanMilliseconds() const;
+		double GetMinMilliseconds() const;
+		double GetMaxMilliseconds() const;
+
+		// Only the non-empty buckets are stored
+		nlohmann::json ToJSON() const;
+
+		// Throws std::runtime_error if the json was written with a different bucket layout
+		static FrameTimeHistogram FromJSON(const nlohmann::json& json);
+
+		// Getters
+		inline uint64_t GetCount() const { return count; }
+		inline bool GetIsEmpty() const { return count == 0; }
+
+	private:
+		std::vector<uint64_t> buckets;
+		uint64_t count;
+		uint64_t sum;
+		uint64_t minimum;
+		uint64_t maximum;
+
+		static size_t GetBucketIndex(uint64_t value);
+		static uint64_t GetBucketLowest(size_t index);
+		static uint64_t GetBucketWidth(size_t index);
+	};
+
+} // namespace VulkanCore
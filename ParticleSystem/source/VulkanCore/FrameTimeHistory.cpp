@@ -9,6 +9,8 @@ namespace VulkanCore {
 		, front(0)
 		, count(0)
 		, entries(CAPACITY)
+		, markers({})
+		, histogram()
 	{
 
 	}
@@ -35,11 +37,13 @@ namespace VulkanCore {
 		back = 0;
 		front = 0;
 		count = 0;
+		histogram.Reset();
 	}
 
 	void FrameTimeHistory::Post(float deltaTime)
 	{
-		entries[front] = { deltaTime, glm::log2(deltaTime) };
+		entries[front] = { deltaTime, glm::log2(deltaTime), 0.0f, 0.0f };
+		histogram.Record(SecondsToTime(deltaTime));
 		front = (front + 1) % CAPACITY;
 
 		if (count == CAPACITY)
@@ -52,4 +56,23 @@ namespace VulkanCore {
 		}
 	}
 
+	void FrameTimeHistory::MarkLatency(LatencyMarker marker, Time time)
+	{
+		markers[static_cast<size_t>(marker)] = time;
+
+		if (marker != LatencyMarker::FrameEnd || count == 0)
+		{
+			return;
+		}
+
+		const Time inputSampled = markers[static_cast<size_t>(LatencyMarker::InputSampled)];
+		const Time presented = markers[static_cast<size_t>(LatencyMarker::PresentSubmitted)];
+
+		Entry& latest = entries[(front + CAPACITY - 1) % CAPACITY];
+		latest.inputLatency = (!inputSampled.IsZero() && presented >= inputSampled) ? TimeToSeconds<float>(presented - inputSampled) : 0.0f;
+		latest.pacingWait = (!presented.IsZero() && time >= presented) ? TimeToSeconds<float>(time - presented) : 0.0f;
+
+		markers = {};
+	}
+
 } // namespace VulkanCore
@@ -1,9 +1,23 @@
 #pragma once
 
+#include <cstddef>
 #include <vector>
+#include <array>
+
+#include "Time.h"
+#include "FrameTimeHistogram.h"
 
 namespace VulkanCore {
 
+    // Points of interest inside a single iteration of the main loop
+    enum class LatencyMarker : uint32_t
+    {
+        InputSampled = 0,
+        PresentSubmitted,       // vkQueuePresentKHR returned, the image may reach the display later
+        FrameEnd,
+        Count
+    };
+
     class FrameTimeHistory
     {
     public:
@@ -11,6 +25,8 @@ namespace VulkanCore {
         {
             float deltaTime;
             float log2DeltaTime;
+            float inputLatency;     // InputSampled -> PresentSubmitted
+            float pacingWait;       // PresentSubmitted -> FrameEnd
         };
 
         // Constructor
@@ -32,9 +48,15 @@ namespace VulkanCore {
         inline size_t GetCount() const { return count; }
         Entry GetEntry(size_t i) const;
 
+        // Every frame since the last Reset, the entries only keep the last CAPACITY frames
+        inline const FrameTimeHistogram& GetHistogram() const { return histogram; }
+
         void Reset();
         void Post(float deltaTime);
 
+        // Markers are accumulated for the current frame and resolved into the latest entry on LatencyMarker::FrameEnd
+        void MarkLatency(LatencyMarker marker, Time time);
+
     private:
         static constexpr size_t CAPACITY = 4096;
 
@@ -42,6 +64,8 @@ namespace VulkanCore {
         size_t front;
         size_t count;
         std::vector<Entry> entries;
+        std::array<Time, static_cast<size_t>(LatencyMarker::Count)> markers;
+        FrameTimeHistogram histogram;
     };
 
 } // namespace VulkanCore
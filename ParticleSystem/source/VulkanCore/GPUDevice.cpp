@@ -327,7 +327,7 @@ namespace VulkanCore {
         appInfo.pEngineName = "No Engine";
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        appInfo.apiVersion = VK_API_VERSION_1_1;
 
         const std::vector<const char*>& requiredExtensionNames = GetRequiredExtensionNames();
 
@@ -497,6 +497,12 @@ namespace VulkanCore {
         physicalDeviceFeatures2.features.robustBufferAccess = VK_TRUE;
         physicalDeviceFeatures2.features.largePoints = VK_TRUE;
 
+        // Optional, only used by the GPU Metrics counters
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+        bSupportsPipelineStatistics = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+        physicalDeviceFeatures2.features.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+
         // Create Device
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -68,6 +68,7 @@ namespace VulkanCore {
         inline const VkFence& GetComputeFence() const { return computeFence; }
         inline const VkFence& GetImageFence() const { return imageFence; }
         inline const std::string& GetName() const { return name; }
+        inline bool GetSupportsPipelineStatistics() const { return bSupportsPipelineStatistics; }
 
     private:
         VkInstance instance;
@@ -86,6 +87,7 @@ namespace VulkanCore {
         VkFence computeFence;
 
         std::string name;
+        bool bSupportsPipelineStatistics = false;
 
         static const bool bEnableValidationLayers;
         static const std::vector<const char*> instanceExtensions;
@@ -0,0 +1,228 @@
+#include "GPUProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <stdexcept>
+#include <vector>
+
+#include "Profiler.h"
+
+namespace VulkanCore {
+
+	GPUProfiler::GPUProfiler(GPUDevice& device)
+		: device(device)
+		, bIsSupported(false)
+		, timestampPeriod(1.0)
+		, timestampMask(0)
+		, calibrationOffset(0)
+		, slots({})
+		, currentSlot(0)
+		, latestZones({})
+		, latestZoneCount(0)
+		, averageZones({})
+		, averageZoneCount(0)
+	{
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(device.GetPhysicalDevice(), &deviceProperties);
+
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(device.GetPhysicalDevice(), &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(device.GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+		// Graphics and compute are submitted to the same family, timestamps are only written if it has valid bits
+		const uint32_t validBits = queueFamilies[device.GetPhysicalQueueFamilies().graphicsAndComputeFamily.value()].timestampValidBits;
+		bIsSupported = validBits > 0 && deviceProperties.limits.timestampPeriod > 0.0f;
+		if (!bIsSupported)
+		{
+			return;
+		}
+
+		timestampPeriod = static_cast<double>(deviceProperties.limits.timestampPeriod);
+		timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+
+		VkQueryPoolCreateInfo queryPoolInfo = {};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = MAX_ZONES_PER_FRAME * 2;
+
+		for (FrameSlot& slot : slots)
+		{
+			if (vkCreateQueryPool(device.GetVKDevice(), &queryPoolInfo, nullptr, &slot.queryPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create timestamp query pool!");
+			}
+		}
+
+		Calibrate();
+	}
+
+	GPUProfiler::~GPUProfiler()
+	{
+		for (FrameSlot& slot : slots)
+		{
+			if (slot.queryPool != VK_NULL_HANDLE)
+			{
+				vkDestroyQueryPool(device.GetVKDevice(), slot.queryPool, nullptr);
+			}
+		}
+	}
+
+	void GPUProfiler::NewFrame()
+	{
+		if (!bIsSupported)
+		{
+			return;
+		}
+
+		currentSlot = (currentSlot + 1) % FRAME_SLOT_COUNT;
+		Collect(slots[currentSlot]);
+	}
+
+	uint32_t GPUProfiler::BeginZone(VkCommandBuffer commandBuffer, const char* name)
+	{
+		FrameSlot& slot = slots[currentSlot];
+		if (!bIsSupported || !Profiler::GetInstance().GetIsEnabled() || slot.zoneCount == MAX_ZONES_PER_FRAME)
+		{
+			return UINT32_MAX;
+		}
+
+		const uint32_t zone = slot.zoneCount++;
+		slot.names[zone] = name;
+
+		// Every zone resets its own pair, so zones can be spread over the compute and the graphics command buffers
+		vkCmdResetQueryPool(commandBuffer, slot.queryPool, zone * 2, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.queryPool, zone * 2);
+
+		return zone;
+	}
+
+	void GPUProfiler::EndZone(VkCommandBuffer commandBuffer, uint32_t zone)
+	{
+		if (zone == UINT32_MAX)
+		{
+			return;
+		}
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slots[currentSlot].queryPool, zone * 2 + 1);
+	}
+
+	void GPUProfiler::ResetAverages()
+	{
+		averageZones = {};
+		averageZoneCount = 0;
+	}
+
+	void GPUProfiler::PrintAverages(std::ostream& out) const
+	{
+		if (averageZoneCount == 0)
+		{
+			out << "GPU zones: not available" << std::endl;
+			return;
+		}
+
+		out << std::fixed << std::setprecision(3) << "GPU zones:" << '\n';
+		for (uint32_t zone = 0; zone < averageZoneCount; ++zone)
+		{
+			const GPUZoneAverage& average = averageZones[zone];
+			out << "  " << std::left << std::setw(16) << average.name << std::right
+				<< std::setw(10) << average.GetMeanMilliseconds() << " ms mean over " << average.count << " frames, "
+				<< average.totalMilliseconds << " ms total" << '\n';
+		}
+		out << std::defaultfloat << std::flush;
+	}
+
+	GPUZoneAverage GPUProfiler::GetAverage(const char* name) const
+	{
+		for (uint32_t zone = 0; zone < averageZoneCount; ++zone)
+		{
+			if (std::strcmp(averageZones[zone].name, name) == 0)
+			{
+				return averageZones[zone];
+			}
+		}
+
+		return { name, 0.0, 0 };
+	}
+
+	void GPUProfiler::Calibrate()
+	{
+		VkCommandBuffer commandBuffer = device.BeginSingleTimeCommandBuffer();
+		vkCmdResetQueryPool(commandBuffer, slots[0].queryPool, 0, 1);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slots[0].queryPool, 0);
+
+		// The timestamp is written somewhere between the two CPU readings, the midpoint is off by half the round trip at most
+		const Time submitTime = Time::Now();
+		device.EndSingleTimeCommandBuffer(commandBuffer, device.GetComputeQueue());
+		const Time completeTime = Time::Now();
+
+		uint64_t ticks = 0;
+		if (vkGetQueryPoolResults(device.GetVKDevice(), slots[0].queryPool, 0, 1, sizeof(ticks), &ticks, sizeof(ticks), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+		{
+			bIsSupported = false;
+			return;
+		}
+
+		const int64_t midpoint = submitTime.value + (completeTime.value - submitTime.value) / 2;
+		calibrationOffset = midpoint - static_cast<int64_t>(std::llround(static_cast<double>(ticks & timestampMask) * timestampPeriod));
+	}
+
+	void GPUProfiler::Collect(FrameSlot& slot)
+	{
+		if (slot.zoneCount == 0)
+		{
+			return;
+		}
+
+		// Never waits, a slot that is still not available after FRAME_SLOT_COUNT frames is dropped
+		std::array<uint64_t, MAX_ZONES_PER_FRAME * 2> ticks = {};
+		const VkResult result = vkGetQueryPoolResults(device.GetVKDevice(), slot.queryPool, 0, slot.zoneCount * 2, sizeof(ticks), ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+		if (result == VK_SUCCESS)
+		{
+			for (uint32_t zone = 0; zone < slot.zoneCount; ++zone)
+			{
+				const Time start = ToTime(ticks[zone * 2]);
+				const Time end = ToTime(ticks[zone * 2 + 1]);
+				Profiler::GetInstance().RecordGPU(slot.names[zone], start, end);
+
+				// Latest time per zone name, a frame without a tick keeps the last simulation time
+				uint32_t latest = 0;
+				while (latest < latestZoneCount && latestZones[latest].name != slot.names[zone])
+				{
+					++latest;
+				}
+
+				if (latest < MAX_ZONES_PER_FRAME)
+				{
+					latestZones[latest] = { slot.names[zone], TimeToMilliseconds<double>(end - start) };
+					latestZoneCount = std::max(latestZoneCount, latest + 1);
+				}
+
+				uint32_t average = 0;
+				while (average < averageZoneCount && averageZones[average].name != slot.names[zone])
+				{
+					++average;
+				}
+
+				if (average < MAX_ZONES_PER_FRAME)
+				{
+					averageZones[average].name = slot.names[zone];
+					averageZones[average].totalMilliseconds += TimeToMilliseconds<double>(end - start);
+					++averageZones[average].count;
+					averageZoneCount = std::max(averageZoneCount, average + 1);
+				}
+			}
+		}
+
+		slot.zoneCount = 0;
+	}
+
+	Time GPUProfiler::ToTime(uint64_t ticks) const
+	{
+		return { calibrationOffset + static_cast<int64_t>(std::llround(static_cast<double>(ticks & timestampMask) * timestampPeriod)) };
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#include "GPUDevice.h"
+#include "Time.h"
+
+namespace VulkanCore {
+
+	struct GPUZoneTime
+	{
+		const char* name = nullptr;
+		double milliseconds = 0.0;
+	};
+
+	// Time of a zone name summed since GPUProfiler::ResetAverages, count is the number of frames that recorded it
+	struct GPUZoneAverage
+	{
+		const char* name = nullptr;
+		double totalMilliseconds = 0.0;
+		uint64_t count = 0;
+
+		inline double GetMeanMilliseconds() const { return count > 0 ? totalMilliseconds / static_cast<double>(count) : 0.0; }
+	};
+
+	// GPU zones on the Profiler timeline
+	// Every zone writes a timestamp pair into the query pool of the current frame slot. A slot is read back FRAME_SLOT_COUNT frames later
+	// without waiting, by then the GPU is long done with it (results that are still not available are dropped).
+	// GPU ticks are converted to the Time::Now clock with an offset measured once around a timestamp-only submission.
+	class GPUProfiler final
+	{
+	public:
+		static constexpr uint32_t FRAME_SLOT_COUNT = 4;
+		static constexpr uint32_t MAX_ZONES_PER_FRAME = 16;
+
+		// Constructor
+		GPUProfiler(GPUDevice& device);
+
+		// Destructor
+		~GPUProfiler();
+
+		// Not copyable
+		GPUProfiler(const GPUProfiler&) = delete;
+		GPUProfiler& operator = (const GPUProfiler&) = delete;
+
+		// Not moveable
+		GPUProfiler(GPUProfiler&&) = delete;
+		GPUProfiler& operator = (GPUProfiler&&) = delete;
+
+		// Collects the oldest slot and makes it current, call once per frame before recording any zone
+		void NewFrame();
+
+		// Must be recorded outside of a render pass, returns the zone to end or UINT32_MAX if the zone is not recorded
+		uint32_t BeginZone(VkCommandBuffer commandBuffer, const char* name);
+		void EndZone(VkCommandBuffer commandBuffer, uint32_t zone);
+
+		void ResetAverages();
+
+		// Mean per recorded zone and, for zones that do not run every frame (a reorder every few ticks), the total
+		void PrintAverages(std::ostream& out) const;
+
+		// Getters
+		inline bool GetIsSupported() const { return bIsSupported; }
+
+		// Last collected time of every zone name, a few frames old
+		inline const std::array<GPUZoneTime, MAX_ZONES_PER_FRAME>& GetLatestZones() const { return latestZones; }
+		inline uint32_t GetLatestZoneCount() const { return latestZoneCount; }
+
+		// Empty average if the zone was not collected since ResetAverages
+		GPUZoneAverage GetAverage(const char* name) const;
+
+	private:
+		struct FrameSlot
+		{
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			std::array<const char*, MAX_ZONES_PER_FRAME> names = {};
+			uint32_t zoneCount = 0;
+		};
+
+		GPUDevice& device;
+
+		bool bIsSupported;
+		double timestampPeriod;		// nanoseconds per tick
+		uint64_t timestampMask;
+		int64_t calibrationOffset;	// Time::Now nanoseconds at GPU tick 0
+
+		std::array<FrameSlot, FRAME_SLOT_COUNT> slots;
+		uint32_t currentSlot;
+
+		std::array<GPUZoneTime, MAX_ZONES_PER_FRAME> latestZones;
+		uint32_t latestZoneCount;
+
+		std::array<GPUZoneAverage, MAX_ZONES_PER_FRAME> averageZones;
+		uint32_t averageZoneCount;
+
+		void Calibrate();
+		void Collect(FrameSlot& slot);
+		Time ToTime(uint64_t ticks) const;
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,223 @@
+#include "InputCapture.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace VulkanCore {
+
+	InputCapture::InputCapture()
+		: bIsCapturing(false)
+		, droppedRecordCount(0)
+		, bStopWriter(false)
+		, captureGeneration(0)
+		, writtenGeneration(0)
+	{
+
+	}
+
+	InputCapture::~InputCapture()
+	{
+		Stop();
+
+		if (writerThread.joinable())
+		{
+			writerThread.join();
+		}
+
+		JobSystem::GetInstance().Wait(conversionCounter);
+	}
+
+	void InputCapture::Start(const std::string& binaryFilePath, const std::string& jsonFilePath)
+	{
+		if (bIsCapturing)
+		{
+			return;
+		}
+
+		// The previous writer has been told to stop, it only has the tail of its queue left, its conversion runs as a job
+		if (writerThread.joinable())
+		{
+			writerThread.join();
+		}
+
+		// Leftovers from a writer that failed to open its file
+		InputRecord record = {};
+		while (queue.TryPop(record))
+		{
+
+		}
+
+		droppedRecordCount = 0;
+		bStopWriter = false;
+		bIsCapturing = true;
+		++captureGeneration;
+		writerThread = std::thread(&InputCapture::WriterLoop, this, binaryFilePath, jsonFilePath, captureGeneration);
+	}
+
+	void InputCapture::Stop()
+	{
+		if (!bIsCapturing)
+		{
+			return;
+		}
+
+		bIsCapturing = false;
+		bStopWriter.store(true, std::memory_order_release);
+	}
+
+	bool InputCapture::Push(const InputRecord& record)
+	{
+		if (!bIsCapturing)
+		{
+			return false;
+		}
+
+		if (!queue.TryPush(record))
+		{
+			++droppedRecordCount;
+			return false;
+		}
+
+		return true;
+	}
+
+	void InputCapture::WriterLoop(std::string binaryFilePath, std::string jsonFilePath, uint64_t generation)
+	{
+		std::ofstream fout(binaryFilePath, std::ios::binary | std::ios::trunc);
+		if (!fout)
+		{
+			std::cout << "ERROR: Failed to open " << binaryFilePath << " for input capture!" << std::endl;
+			return;
+		}
+
+		// recordCount is patched once the capture ends, readers fall back to the file size if it is still 0
+		FileHeader header = {};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.recordSize = sizeof(InputRecord);
+		header.recordCount = 0;
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		std::vector<InputRecord> batch;
+		batch.reserve(QUEUE_CAPACITY);
+
+		// Kept for the conversion, the next capture may truncate the binary file while it runs
+		std::vector<InputRecord> records;
+
+		uint32_t recordCount = 0;
+		auto lastFlush = std::chrono::steady_clock::now();
+
+		while (true)
+		{
+			// Read the flag before draining so the records pushed before Stop are never lost
+			const bool bStop = bStopWriter.load(std::memory_order_acquire);
+
+			InputRecord record = {};
+			while (queue.TryPop(record))
+			{
+				batch.push_back(record);
+			}
+
+			if (!batch.empty())
+			{
+				fout.write(reinterpret_cast<const char*>(batch.data()), static_cast<std::streamsize>(batch.size() * sizeof(InputRecord)));
+				recordCount += static_cast<uint32_t>(batch.size());
+				if (!jsonFilePath.empty())
+				{
+					records.insert(records.end(), batch.begin(), batch.end());
+				}
+				batch.clear();
+			}
+
+			if (bStop)
+			{
+				break;
+			}
+
+			const auto now = std::chrono::steady_clock::now();
+			if (now - lastFlush >= std::chrono::milliseconds(FLUSH_INTERVAL_MILLISECONDS))
+			{
+				fout.flush();
+				lastFlush = now;
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_SLEEP_MILLISECONDS));
+		}
+
+		header.recordCount = recordCount;
+		fout.seekp(0);
+		fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		fout.close();
+
+		if (jsonFilePath.empty())
+		{
+			return;
+		}
+
+		JobSystem::GetInstance().Run(conversionCounter, [this, records = std::move(records), jsonFilePath, generation]()
+		{
+			// Waited on by the destructor, nothing may escape
+			try
+			{
+				const std::string dump = ConvertToJSON(records).dump(4);
+
+				// Conversions finish in any order, a longer older capture may finish after a newer one
+				std::lock_guard<std::mutex> lock(conversionMutex);
+				if (generation < writtenGeneration)
+				{
+					return;
+				}
+				writtenGeneration = generation;
+
+				std::ofstream jsonOut(jsonFilePath);
+				if (!jsonOut)
+				{
+					throw std::runtime_error("ERROR: Failed to open " + jsonFilePath + "!");
+				}
+
+				jsonOut << dump;
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << e.what() << std::endl;
+			}
+		});
+	}
+
+	nlohmann::json InputCapture::ConvertToJSON(const std::vector<InputRecord>& records)
+	{
+		nlohmann::json json;
+		json["mousePosition"] = nlohmann::json::array();
+		json["mouseButtonLeftPressed"] = nlohmann::json::array();
+
+		for (size_t i = 0; i < records.size(); ++i)
+		{
+			const InputRecord& record = records[i];
+
+			nlohmann::json currentMousePosition;
+			currentMousePosition["x"] = record.mouseX;
+			currentMousePosition["y"] = record.mouseY;
+			currentMousePosition["time"] = record.time;
+			currentMousePosition["interpolate"] = true;
+			json["mousePosition"].push_back(currentMousePosition);
+
+			// The button track is a step function, only its edges are needed
+			if (i > 0 && (record.mouseButtonLeftPressed != 0) == (records[i - 1].mouseButtonLeftPressed != 0))
+			{
+				continue;
+			}
+
+			nlohmann::json currentMouseButtonLeftPressed;
+			currentMouseButtonLeftPressed["value"] = record.mouseButtonLeftPressed != 0;
+			currentMouseButtonLeftPressed["time"] = record.time;
+			json["mouseButtonLeftPressed"].push_back(currentMouseButtonLeftPressed);
+		}
+
+		return json;
+	}
+
+} // namespace VulkanCore
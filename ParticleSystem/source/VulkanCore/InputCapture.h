@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "SPSCQueue.h"
+#include "JobSystem.h"
+
+namespace VulkanCore {
+
+	// Fixed-size input sample, written as-is to the binary capture file
+	struct InputRecord
+	{
+		float time;
+		float mouseX;
+		float mouseY;
+		uint32_t mouseButtonLeftPressed;
+	};
+
+	// Streams input records to disk on a writer thread
+	// The simulation thread only pushes into a lock-free queue, all file I/O happens on the writer thread. Once the capture
+	// stops, the writer hands the conversion to the benchmark JSON schema (see InputManager::LoadJSONBenchmarkTest) to the
+	// job system and exits, so a new capture only waits for the tail of the previous queue.
+	class InputCapture final
+	{
+	public:
+		// Binary file layout: FileHeader followed by FileHeader::recordCount InputRecord (0 if the capture was interrupted)
+		struct FileHeader
+		{
+			char magic[4];
+			uint32_t version;
+			uint32_t recordSize;
+			uint32_t recordCount;
+		};
+
+		static constexpr char MAGIC[4] = { 'P', 'S', 'I', 'C' };
+		static constexpr uint32_t VERSION = 1;
+
+		// Constructor
+		InputCapture();
+
+		// Destructor
+		~InputCapture();
+
+		// Not copyable
+		InputCapture(const InputCapture&) = delete;
+		InputCapture& operator = (const InputCapture&) = delete;
+
+		// Not moveable
+		InputCapture(InputCapture&&) = delete;
+		InputCapture& operator = (InputCapture&&) = delete;
+
+		// jsonFilePath is written by a job once the capture stops, empty to skip the conversion
+		void Start(const std::string& binaryFilePath, const std::string& jsonFilePath);
+
+		// Never blocks, the writer thread drains the queue and finishes on its own
+		void Stop();
+
+		// Returns false if the record was dropped because the writer fell behind
+		bool Push(const InputRecord& record);
+
+		// Converters
+		static nlohmann::json ConvertToJSON(const std::vector<InputRecord>& records);
+
+		// Getters
+		inline bool GetIsCapturing() const { return bIsCapturing; }
+		inline uint64_t GetDroppedRecordCount() const { return droppedRecordCount; }
+
+	private:
+		static constexpr size_t QUEUE_CAPACITY = 4096;
+		static constexpr uint32_t FLUSH_INTERVAL_MILLISECONDS = 1000;
+		static constexpr uint32_t IDLE_SLEEP_MILLISECONDS = 5;
+
+		SPSCQueue<InputRecord, QUEUE_CAPACITY> queue;
+
+		bool bIsCapturing;
+		uint64_t droppedRecordCount;
+
+		std::thread writerThread;
+		std::atomic<bool> bStopWriter;
+
+		// Incremented by every Start, a conversion never overwrites the JSON of a newer capture
+		uint64_t captureGeneration;
+
+		// Conversions still running, writtenGeneration is the capture whose JSON was written last
+		JobCounter conversionCounter;
+		std::mutex conversionMutex;
+		uint64_t writtenGeneration;
+
+		void WriterLoop(std::string binaryFilePath, std::string jsonFilePath, uint64_t generation);
+	};
+
+} // namespace VulkanCore
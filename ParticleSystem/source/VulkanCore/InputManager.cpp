@@ -14,17 +14,20 @@ namespace VulkanCore {
 		{ Benchmark::Test2, "benchmark/test-2.json" },
 		{ Benchmark::Test3, "benchmark/test-3.json" },
 		{ Benchmark::Test4, "benchmark/test-4.json" },
-		{ Benchmark::Test5, "benchmark/test-5.json" }
+		{ Benchmark::Test5, "benchmark/test-5.json" },
+		{ Benchmark::Test6, "benchmark/test-6.json" },
+		{ Benchmark::Test7, "benchmark/test-7.json" }
 	};
 
 	InputManager::InputManager(Window& window)
 		: window(window)
-		, benchmarkJSON(std::nullopt)
+		, benchmarkTimeline(std::nullopt)
 		, mousePosition(glm::dvec2(0.0, 0.0))
 		, mouseButtonLeftPressed(false)
-		, timer(0.0f)
-		, mousePositionIndex(0)
-		, mouseButtonLeftPressedIndex(0)
+		, inputSnapshot({})
+		, benchmarkStep(0)
+		, benchmarkTime(0.0)
+		, lastBenchmark(Benchmark::Test1)
 	{
 
 	}
@@ -34,66 +37,50 @@ namespace VulkanCore {
 
 	}
 
-	void InputManager::Update(float deltaTime)
+	void InputManager::Update()
 	{
-		if (benchmarkJSON.has_value())
-		{
-			timer += deltaTime;
-
-			// Update Mouse Position
-			mousePositionIndex = std::min(mousePositionIndex, benchmarkJSON.value()["mousePosition"].size() - 1);
-			if (benchmarkJSON.value()["mousePosition"][mousePositionIndex]["interpolate"])
-			{
-				const auto& startPoint = benchmarkJSON.value()["mousePosition"][mousePositionIndex - 1];
-				const auto& endPoint = benchmarkJSON.value()["mousePosition"][mousePositionIndex];
-
-				const double& startTime = startPoint["time"];
-				const double& endTime = endPoint["time"];
-				const double t = (timer - startTime) / (endTime - startTime);
-
-				const double startX = startPoint["x"];
-				const double startY = startPoint["y"];
-				const double endX = endPoint["x"];
-				const double endY = endPoint["y"];
-
-				mousePosition.x = startX + t * (endX - startX);
-				mousePosition.y = startY + t * (endY - startY);
-			}
-
-			if (timer >= benchmarkJSON.value()["mousePosition"][mousePositionIndex]["time"])
-			{
-				mousePosition.x = benchmarkJSON.value()["mousePosition"][mousePositionIndex]["x"];
-				mousePosition.y = benchmarkJSON.value()["mousePosition"][mousePositionIndex]["y"];
-				++mousePositionIndex;
-			}
-
-			// Update Mouse Button Left Pressed
-			mouseButtonLeftPressedIndex = std::min(mouseButtonLeftPressedIndex, benchmarkJSON.value()["mouseButtonLeftPressed"].size() - 1);
-			if (timer >= benchmarkJSON.value()["mouseButtonLeftPressed"][mouseButtonLeftPressedIndex]["time"])
-			{
-				mouseButtonLeftPressed = benchmarkJSON.value()["mouseButtonLeftPressed"][mouseButtonLeftPressedIndex]["value"];
-				++mouseButtonLeftPressedIndex;
-			}
-
-			// The benchmark has ended
-			const double mousePositionMaxTime = benchmarkJSON.value()["mousePosition"][benchmarkJSON.value()["mousePosition"].size() - 1]["time"];
-			const double mouseButtonLeftPressedMaxTime = benchmarkJSON.value()["mouseButtonLeftPressed"][benchmarkJSON.value()["mouseButtonLeftPressed"].size() - 1]["time"];
-			if (timer >= mousePositionMaxTime && timer >= mouseButtonLeftPressedMaxTime)
-			{
-				benchmarkJSON = std::nullopt;
-				window.UnblockWindow();
-			}
-		}
-		else
-		{
-			glfwGetCursorPos(window.GetGLFWWindow(), &mousePosition.x, &mousePosition.y);
-			mouseButtonLeftPressed = glfwGetMouseButton(window.GetGLFWWindow(), GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS ? true : false;
+		if (benchmarkTimeline.has_value())
+		{
+			return;
+		}
+
+		// Sampled by the main thread, keeps the previous snapshot if nothing new was published
+		window.ReadInput(inputSnapshot);
+		mousePosition = inputSnapshot.mousePosition;
+		mouseButtonLeftPressed = inputSnapshot.bMouseButtonLeftPressed;
+	}
+
+	bool InputManager::StepBenchmark(double timestep)
+	{
+		if (!benchmarkTimeline.has_value())
+		{
+			return false;
 		}
+
+		// Derived from the step index, accumulating the timestep would drift differently depending on the step count
+		const double simulationTime = static_cast<double>(benchmarkStep) * timestep;
+
+		// The benchmark has ended
+		if (simulationTime > benchmarkTimeline->GetDuration())
+		{
+			benchmarkTimeline = std::nullopt;
+			benchmarkForceField = ForceField();
+			window.UnblockWindow();
+			return false;
+		}
+
+		const BenchmarkTimeline::Sample sample = benchmarkTimeline->SampleAt(simulationTime);
+		mousePosition = sample.mousePosition;
+		mouseButtonLeftPressed = sample.mouseButtonLeftPressed;
+		benchmarkTime = simulationTime;
+
+		++benchmarkStep;
+		return true;
 	}
 
 	void InputManager::StartBenchmark(const Benchmark& benchmark)
 	{
-		if (benchmarkJSON.has_value())
+		if (benchmarkTimeline.has_value())
 		{
 			return;
 		}
@@ -103,14 +90,21 @@ namespace VulkanCore {
 
 		try
 		{
-			benchmarkJSON = LoadJSONBenchmarkTest(benchmarkToFileName.at(benchmark));
-			timer = 0.0f;
-			mousePositionIndex = 1;
-			mouseButtonLeftPressedIndex = 1;
+			// Compiled once, replay never touches the JSON document
+			const nlohmann::json json = LoadJSONBenchmarkTest(benchmarkToFileName.at(benchmark));
+			benchmarkForceField = ForceField(json);
+			benchmarkSimulationMode = ParseSimulationMode(json);
+			benchmarkTimeline.emplace(json);
+			benchmarkStep = 0;
+			benchmarkTime = 0.0;
+			lastBenchmark = benchmark;
 		}
 		catch (const std::exception& e)
 		{
-			benchmarkJSON = std::nullopt;
+			benchmarkTimeline = std::nullopt;
+			benchmarkForceField = ForceField();
+			benchmarkSimulationMode = std::nullopt;
+			window.UnblockWindow();
 			std::cout << e.what() << std::endl;
 		}
 	}
@@ -143,4 +137,36 @@ namespace VulkanCore {
 		return json;
 	}
 
+	std::optional<SimulationMode> InputManager::ParseSimulationMode(const nlohmann::json& json)
+	{
+		if (!json.contains("simulation"))
+		{
+			return std::nullopt;
+		}
+
+		const std::string simulation = json["simulation"].is_string() ? json["simulation"].get<std::string>() : "";
+		if (simulation == "attractor")
+		{
+			return SimulationMode::Attractor;
+		}
+		else if (simulation == "nbody-all-pairs")
+		{
+			return SimulationMode::NBodyAllPairs;
+		}
+		else if (simulation == "nbody-barnes-hut")
+		{
+			return SimulationMode::NBodyBarnesHut;
+		}
+		else if (simulation == "fluid")
+		{
+			return SimulationMode::Fluid;
+		}
+		else if (simulation == "emitters")
+		{
+			return SimulationMode::Emitters;
+		}
+
+		throw std::runtime_error("ERROR: Invalid input: 'simulation' has to be \"attractor\", \"nbody-all-pairs\", \"nbody-barnes-hut\", \"fluid\" or \"emitters\"");
+	}
+
 } // namespace VulkanCore
@@ -8,6 +8,9 @@
 
 #include "Window.h"
 #include "Benchmark.h"
+#include "BenchmarkTimeline.h"
+#include "ForceField.h"
+#include "SimulationMode.h"
 
 namespace VulkanCore {
 
@@ -28,28 +31,47 @@ namespace VulkanCore {
 		InputManager(InputManager&&) = delete;
 		InputManager& operator = (InputManager&&) = delete;
 
-		void Update(float deltaTime);
+		// Reads the latest mouse state sampled by the main thread, benchmark input is driven by StepBenchmark instead
+		void Update();
 		void StartBenchmark(const Benchmark& benchmark);
 
+		// Deterministic replay: samples the benchmark at the start of the next fixed simulation step
+		// Returns false once the scenario is over, the number of steps only depends on the scenario and the timestep
+		bool StepBenchmark(double timestep);
+
 		// Getters
 		inline const glm::dvec2& GetMousePosition() const { return mousePosition; }
 		inline const bool GetMouseButtonLeftPressed() const { return mouseButtonLeftPressed; }
-		inline const bool GetIsInBenchmark() const { return benchmarkJSON.has_value(); }
+		inline const bool GetIsInBenchmark() const { return benchmarkTimeline.has_value(); }
+		inline uint64_t GetBenchmarkStep() const { return benchmarkStep; }
+		inline double GetBenchmarkTime() const { return benchmarkTime; }
+		inline const ForceField& GetBenchmarkForceField() const { return benchmarkForceField; }
+		inline Benchmark GetLastBenchmark() const { return lastBenchmark; }
+		inline std::optional<SimulationMode> GetBenchmarkSimulationMode() const { return benchmarkSimulationMode; }
+		inline Time GetInputSampleTime() const { return inputSnapshot.sampleTime; }
 
 	private:
 		Window& window;
-		std::optional<nlohmann::json> benchmarkJSON;
+		std::optional<BenchmarkTimeline> benchmarkTimeline;
+
+		// Scripted force sources of the running benchmark, empty otherwise
+		ForceField benchmarkForceField;
+
+		// Simulation the benchmark runs in, empty keeps the current one
+		std::optional<SimulationMode> benchmarkSimulationMode;
 
 		glm::dvec2 mousePosition;
 		bool mouseButtonLeftPressed;
+		InputSnapshot inputSnapshot;
 
-		float timer;
-		size_t mousePositionIndex;
-		size_t mouseButtonLeftPressedIndex;
+		uint64_t benchmarkStep;
+		double benchmarkTime;
+		Benchmark lastBenchmark;
 
 		const static std::unordered_map<Benchmark, std::string> benchmarkToFileName;
 
 		nlohmann::json LoadJSONBenchmarkTest(const std::string& fileName) const;
+		static std::optional<SimulationMode> ParseSimulationMode(const nlohmann::json& json);
 	};
 
 } // namespace VulkanCore
@@ -0,0 +1,220 @@
+#include "JobSystem.h"
+
+#include <string>
+
+#include "Profiler.h"
+
+namespace VulkanCore {
+
+	namespace {
+
+		constexpr uint32_t NOT_A_WORKER = UINT32_MAX;
+
+		// Failed attempts before a thread outside the pool sleeps instead of polling the queues
+		constexpr uint32_t WAIT_SPIN_COUNT = 64;
+
+		thread_local uint32_t currentWorkerIndex = NOT_A_WORKER;
+
+	} // namespace
+
+	JobSystem::JobSystem()
+		: queuedJobCount(0)
+		, bStop(false)
+		, completionEpoch(0)
+	{
+		// The workers record profiler zones, the profiler has to outlive them
+		Profiler::GetInstance();
+
+		// One core is left to the thread that submits and waits
+		const uint32_t workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+
+		queues.reserve(workerCount + 1);
+		for (uint32_t i = 0; i < workerCount + 1; ++i)
+		{
+			queues.push_back(std::make_unique<JobQueue>());
+		}
+
+		workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; ++i)
+		{
+			workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			bStop = true;
+		}
+		wakeCondition.notify_all();
+
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	JobSystem& JobSystem::GetInstance()
+	{
+		static JobSystem instance;
+		return instance;
+	}
+
+	void JobSystem::Run(JobCounter& counter, std::function<void()> job)
+	{
+		counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+		// Workers keep their own jobs close, everyone else goes through the shared queue
+		JobQueue& queue = currentWorkerIndex != NOT_A_WORKER ? *queues[currentWorkerIndex] : *queues.back();
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back({ std::move(job), &counter });
+		}
+
+		// Taking the lock orders the increment before a worker that is about to sleep checks it
+		queuedJobCount.fetch_add(1, std::memory_order_release);
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wakeCondition.notify_one();
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		uint32_t failedAttempts = 0;
+		while (true)
+		{
+			// Read before the counter, a job finishing in between changes it and the wait below returns right away
+			const uint32_t epoch = completionEpoch.load(std::memory_order_acquire);
+			if (counter.pending.load(std::memory_order_acquire) == 0)
+			{
+				break;
+			}
+
+			Job job;
+			if (TryPop(job))
+			{
+				Execute(job);
+				failedAttempts = 0;
+				continue;
+			}
+
+			// A worker never blocks, the jobs it waits for could be queued behind it.
+			// Other threads sleep until any job finishes, the workers carry on without them.
+			if (currentWorkerIndex == NOT_A_WORKER && ++failedAttempts >= WAIT_SPIN_COUNT)
+			{
+				completionEpoch.wait(epoch, std::memory_order_acquire);
+				failedAttempts = 0;
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		std::exception_ptr exception = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(counter.exceptionMutex);
+			std::swap(exception, counter.exception);
+		}
+
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+
+	void JobSystem::WorkerLoop(uint32_t workerIndex)
+	{
+		currentWorkerIndex = workerIndex;
+		Profiler::GetInstance().SetThreadName("Job Worker " + std::to_string(workerIndex));
+
+		while (true)
+		{
+			Job job;
+			if (TryPop(job))
+			{
+				Execute(job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wakeCondition.wait(lock, [this]() { return bStop || queuedJobCount.load(std::memory_order_acquire) > 0; });
+			if (bStop)
+			{
+				return;
+			}
+		}
+	}
+
+	bool JobSystem::TryPop(Job& job)
+	{
+		if (queuedJobCount.load(std::memory_order_acquire) == 0)
+		{
+			return false;
+		}
+
+		// Own jobs newest first, they are the most likely to still be in the cache
+		if (currentWorkerIndex != NOT_A_WORKER)
+		{
+			JobQueue& queue = *queues[currentWorkerIndex];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+				queuedJobCount.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		// Then the oldest job of the shared queue or of another worker, starting after this one so thieves spread out
+		const size_t queueCount = queues.size();
+		const size_t first = currentWorkerIndex != NOT_A_WORKER ? currentWorkerIndex + 1 : queueCount - 1;
+		for (size_t i = 0; i < queueCount; ++i)
+		{
+			const size_t index = (first + i) % queueCount;
+			if (index == currentWorkerIndex)
+			{
+				continue;
+			}
+
+			JobQueue& queue = *queues[index];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty())
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+				queuedJobCount.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void JobSystem::Execute(Job& job)
+	{
+		try
+		{
+			job.function();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(job.counter->exceptionMutex);
+			if (!job.counter->exception)
+			{
+				job.counter->exception = std::current_exception();
+			}
+		}
+
+		// Last access to the counter, Wait may return and destroy it right after, waiters are woken through the epoch instead
+		job.function = nullptr;
+		job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+
+		completionEpoch.fetch_add(1, std::memory_order_release);
+		completionEpoch.notify_all();
+	}
+
+} // namespace VulkanCore
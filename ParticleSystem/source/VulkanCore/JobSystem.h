@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VulkanCore {
+
+	// Jobs of a group that are not finished yet, JobSystem::Wait on it to join them
+	// Must outlive the jobs it counts
+	class JobCounter final
+	{
+	public:
+		// Constructor
+		JobCounter() : pending(0), exception(nullptr) {}
+
+		// Not copyable
+		JobCounter(const JobCounter&) = delete;
+		JobCounter& operator = (const JobCounter&) = delete;
+
+		// Not moveable
+		JobCounter(JobCounter&&) = delete;
+		JobCounter& operator = (JobCounter&&) = delete;
+
+		// Getters
+		inline bool GetIsDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		std::atomic<uint32_t> pending;
+
+		// First exception thrown by a job of the group, rethrown by Wait
+		std::mutex exceptionMutex;
+		std::exception_ptr exception;
+	};
+
+	// Work-stealing thread pool for CPU-side engine tasks (initialization, loading, encoding, analysis)
+	// Every worker owns a deque: it pushes and pops its own jobs at the back and steals from the front of the others.
+	// Threads outside the pool (main, render, encoder threads) submit through a shared queue.
+	// Dependencies are expressed with JobCounter: Wait runs queued jobs until the group is done instead of blocking,
+	// so a job can itself spawn and wait for other jobs without starving the pool.
+	class JobSystem final
+	{
+	public:
+		// ParallelFor splits its range in at most this many batches per thread, enough to even out uneven batches
+		static constexpr uint64_t BATCHES_PER_THREAD = 4;
+
+		// Constructor
+		JobSystem();
+
+		// Destructor
+		~JobSystem();
+
+		// Not copyable
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator = (const JobSystem&) = delete;
+
+		// Not moveable
+		JobSystem(JobSystem&&) = delete;
+		JobSystem& operator = (JobSystem&&) = delete;
+
+		static JobSystem& GetInstance();
+
+		void Run(JobCounter& counter, std::function<void()> job);
+
+		// Helps with queued jobs until every job of the group finished, rethrows the first exception one of them threw
+		void Wait(JobCounter& counter);
+
+		// Calls function(begin, end) on batches of at least minBatchSize elements of [0, count), the calling thread takes a batch too
+		template<typename Function>
+		void ParallelFor(uint64_t count, uint64_t minBatchSize, const Function& function);
+
+		// Runs second as a job while the calling thread runs first, returns once both are done
+		template<typename First, typename Second>
+		void ParallelInvoke(const First& first, const Second& second);
+
+		// Getters
+		inline uint32_t GetWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+		// Workers plus the thread that waits
+		inline uint32_t GetThreadCount() const { return GetWorkerCount() + 1; }
+
+	private:
+		struct Job
+		{
+			std::function<void()> function;
+			JobCounter* counter = nullptr;
+		};
+
+		// One per worker plus the shared one at the back, on their own cache lines
+		struct alignas(64) JobQueue
+		{
+			std::mutex mutex;
+			std::deque<Job> jobs;
+		};
+
+		std::vector<std::unique_ptr<JobQueue>> queues;
+		std::vector<std::thread> workers;
+
+		// Workers sleep while nothing is queued
+		std::atomic<uint32_t> queuedJobCount;
+		std::mutex sleepMutex;
+		std::condition_variable wakeCondition;
+		bool bStop;
+
+		// Bumped whenever a job finishes, threads outside the pool block on it in Wait
+		std::atomic<uint32_t> completionEpoch;
+
+		void WorkerLoop(uint32_t workerIndex);
+		bool TryPop(Job& job);
+		void Execute(Job& job);
+	};
+
+	template<typename Function>
+	void JobSystem::ParallelFor(uint64_t count, uint64_t minBatchSize, const Function& function)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		const uint64_t batchCount = std::clamp<uint64_t>(count / std::max<uint64_t>(minBatchSize, 1), 1, GetThreadCount() * BATCHES_PER_THREAD);
+		const uint64_t batchSize = (count + batchCount - 1) / batchCount;
+
+		JobCounter counter;
+		for (uint64_t begin = batchSize; begin < count; begin += batchSize)
+		{
+			const uint64_t end = std::min(begin + batchSize, count);
+			Run(counter, [&function, begin, end]() { function(begin, end); });
+		}
+
+		// The jobs reference this frame, they are joined before any exception leaves it
+		std::exception_ptr exception = nullptr;
+		try
+		{
+			function(0, std::min(batchSize, count));
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+
+		Wait(counter);
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+
+	template<typename First, typename Second>
+	void JobSystem::ParallelInvoke(const First& first, const Second& second)
+	{
+		JobCounter counter;
+		Run(counter, [&second]() { second(); });
+
+		std::exception_ptr exception = nullptr;
+		try
+		{
+			first();
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+
+		Wait(counter);
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,193 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#if defined(PLATFORM_WINDOWS)
+	#define NOMINMAX
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace VulkanCore {
+
+#if defined(PLATFORM_WINDOWS)
+
+	MappedFile::MappedFile(const std::string& filePath, MappedFileMode mode, size_t size)
+		: filePath(filePath)
+		, mode(mode)
+		, data(nullptr)
+		, size(size)
+		, fileHandle(INVALID_HANDLE_VALUE)
+		, mappingHandle(nullptr)
+	{
+		const bool bWrite = mode == MappedFileMode::Write;
+
+		fileHandle = CreateFileA(
+			filePath.c_str(),
+			bWrite ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			bWrite ? CREATE_ALWAYS : OPEN_EXISTING,
+			FILE_ATTRIBUTE_NORMAL | (bWrite ? 0 : FILE_FLAG_SEQUENTIAL_SCAN),
+			nullptr
+		);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+		{
+			throw std::runtime_error("ERROR: Failed to open " + filePath + "!");
+		}
+
+		if (!bWrite)
+		{
+			LARGE_INTEGER fileSize = {};
+			GetFileSizeEx(fileHandle, &fileSize);
+			this->size = static_cast<size_t>(fileSize.QuadPart);
+		}
+
+		// Mapping an empty file is an error on Windows
+		if (this->size == 0)
+		{
+			Close();
+			throw std::runtime_error("ERROR: " + filePath + " is empty!");
+		}
+
+		// For writes the mapping size also extends the file
+		const uint64_t mappingSize = static_cast<uint64_t>(this->size);
+		mappingHandle = CreateFileMappingA(fileHandle, nullptr, bWrite ? PAGE_READWRITE : PAGE_READONLY, static_cast<DWORD>(mappingSize >> 32), static_cast<DWORD>(mappingSize & 0xFFFFFFFF), nullptr);
+		if (mappingHandle == nullptr)
+		{
+			Close();
+			throw std::runtime_error("ERROR: Failed to map " + filePath + "!");
+		}
+
+		data = static_cast<uint8_t*>(MapViewOfFile(mappingHandle, bWrite ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, this->size));
+		if (data == nullptr)
+		{
+			Close();
+			throw std::runtime_error("ERROR: Failed to map " + filePath + "!");
+		}
+	}
+
+	void MappedFile::Flush()
+	{
+		if (data == nullptr || mode != MappedFileMode::Write)
+		{
+			return;
+		}
+
+		FlushViewOfFile(data, size);
+		FlushFileBuffers(fileHandle);
+	}
+
+	void MappedFile::Close()
+	{
+		if (data != nullptr)
+		{
+			UnmapViewOfFile(data);
+			data = nullptr;
+		}
+
+		if (mappingHandle != nullptr)
+		{
+			CloseHandle(mappingHandle);
+			mappingHandle = nullptr;
+		}
+
+		if (fileHandle != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(fileHandle);
+			fileHandle = INVALID_HANDLE_VALUE;
+		}
+	}
+
+#else
+
+	MappedFile::MappedFile(const std::string& filePath, MappedFileMode mode, size_t size)
+		: filePath(filePath)
+		, mode(mode)
+		, data(nullptr)
+		, size(size)
+		, fileDescriptor(-1)
+	{
+		const bool bWrite = mode == MappedFileMode::Write;
+
+		fileDescriptor = bWrite ? open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(filePath.c_str(), O_RDONLY);
+		if (fileDescriptor < 0)
+		{
+			throw std::runtime_error("ERROR: Failed to open " + filePath + "!");
+		}
+
+		if (bWrite)
+		{
+			// Reserve the blocks up front, writing through a mapping past the end of the file raises SIGBUS
+			if (posix_fallocate(fileDescriptor, 0, static_cast<off_t>(this->size)) != 0 && ftruncate(fileDescriptor, static_cast<off_t>(this->size)) != 0)
+			{
+				Close();
+				throw std::runtime_error("ERROR: Failed to resize " + filePath + "!");
+			}
+		}
+		else
+		{
+			struct stat fileStat = {};
+			fstat(fileDescriptor, &fileStat);
+			this->size = static_cast<size_t>(fileStat.st_size);
+		}
+
+		if (this->size == 0)
+		{
+			Close();
+			throw std::runtime_error("ERROR: " + filePath + " is empty!");
+		}
+
+		void* mapping = mmap(nullptr, this->size, bWrite ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fileDescriptor, 0);
+		if (mapping == MAP_FAILED)
+		{
+			Close();
+			throw std::runtime_error("ERROR: Failed to map " + filePath + "!");
+		}
+		data = static_cast<uint8_t*>(mapping);
+
+		// Files are consumed front to back, let the kernel read ahead aggressively
+		if (!bWrite)
+		{
+			madvise(data, this->size, MADV_SEQUENTIAL);
+		}
+	}
+
+	void MappedFile::Flush()
+	{
+		if (data == nullptr || mode != MappedFileMode::Write)
+		{
+			return;
+		}
+
+		msync(data, size, MS_SYNC);
+	}
+
+	void MappedFile::Close()
+	{
+		if (data != nullptr)
+		{
+			munmap(data, size);
+			data = nullptr;
+		}
+
+		if (fileDescriptor >= 0)
+		{
+			close(fileDescriptor);
+			fileDescriptor = -1;
+		}
+	}
+
+#endif
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace VulkanCore {
+
+	enum class MappedFileMode : uint32_t
+	{
+		Read = 0,		// maps an existing file read-only
+		Write = 1		// creates (or truncates) the file with the requested size and maps it read-write
+	};
+
+	// Whole-file memory mapping, the OS pages data in and out on demand instead of going through stream buffers
+	class MappedFile final
+	{
+	public:
+		// Constructor
+		// Throws std::runtime_error if the file can not be opened or mapped
+		MappedFile(const std::string& filePath, MappedFileMode mode, size_t size = 0);
+
+		// Destructor
+		~MappedFile();
+
+		// Not copyable
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator = (const MappedFile&) = delete;
+
+		// Not moveable
+		MappedFile(MappedFile&&) = delete;
+		MappedFile& operator = (MappedFile&&) = delete;
+
+		// Writes the dirty pages back to disk and waits for it
+		void Flush();
+
+		// Getters
+		inline uint8_t* GetData() { return data; }
+		inline const uint8_t* GetData() const { return data; }
+		inline size_t GetSize() const { return size; }
+		inline const std::string& GetFilePath() const { return filePath; }
+
+	private:
+		std::string filePath;
+		MappedFileMode mode;
+		uint8_t* data;
+		size_t size;
+
+#if defined(PLATFORM_WINDOWS)
+		void* fileHandle;
+		void* mappingHandle;
+#else
+		int fileDescriptor;
+#endif
+
+		void Close();
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,407 @@
+#include "MetricsExporter.h"
+
+#if defined(PLATFORM_WINDOWS)
+	#define NOMINMAX
+	#define WIN32_LEAN_AND_MEAN
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	#include <windows.h>
+	#include <psapi.h>
+	#pragma comment(lib, "Ws2_32.lib")
+#else
+	#include <arpa/inet.h>
+	#include <netinet/in.h>
+	#include <poll.h>
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+#include "FPSCounter.h"
+#include "FrameTimeHistory.h"
+
+namespace VulkanCore {
+
+	namespace {
+
+		constexpr intptr_t INVALID_SOCKET_HANDLE = -1;
+		constexpr int POLL_TIMEOUT_MILLISECONDS = 200;
+		constexpr size_t MAX_REQUEST_SIZE = 8192;
+
+#if defined(PLATFORM_WINDOWS)
+		using SocketHandle = SOCKET;
+
+		inline void CloseSocket(intptr_t socketHandle) { closesocket(static_cast<SOCKET>(socketHandle)); }
+		inline int PollSocket(pollfd* fds, int timeout) { return WSAPoll(fds, 1, timeout); }
+		inline int SendBytes(intptr_t socketHandle, const char* data, size_t size) { return send(static_cast<SOCKET>(socketHandle), data, static_cast<int>(size), 0); }
+#else
+		using SocketHandle = int;
+
+		inline void CloseSocket(intptr_t socketHandle) { close(static_cast<int>(socketHandle)); }
+		inline int PollSocket(pollfd* fds, int timeout) { return poll(fds, 1, timeout); }
+
+		// A scraper that hangs up early must not kill the process with SIGPIPE
+		inline int SendBytes(intptr_t socketHandle, const char* data, size_t size) { return static_cast<int>(send(static_cast<int>(socketHandle), data, size, MSG_NOSIGNAL)); }
+#endif
+
+		bool IsPortNumber(const std::string& endpoint)
+		{
+			return !endpoint.empty() && endpoint.size() <= 5 && std::all_of(endpoint.begin(), endpoint.end(), [](char c) { return c >= '0' && c <= '9'; });
+		}
+
+		void WriteMetric(std::ostringstream& out, const char* name, const char* type, const char* help)
+		{
+			out << "# HELP " << name << ' ' << help << '\n' << "# TYPE " << name << ' ' << type << '\n';
+		}
+
+	} // namespace
+
+	MetricsExporter::MetricsExporter(GPUDevice& device)
+		: device(device)
+		, bSupportsMemoryBudget(false)
+		, bIsRunning(false)
+		, listenSocket(INVALID_SOCKET_HANDLE)
+		, nextPublishTime({ 0 })
+		, bStopServer(false)
+	{
+		uint32_t extensionCount = 0;
+		vkEnumerateDeviceExtensionProperties(device.GetPhysicalDevice(), nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> extensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(device.GetPhysicalDevice(), nullptr, &extensionCount, extensions.data());
+
+		bSupportsMemoryBudget = std::any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension)
+		{
+			return std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0;
+		});
+	}
+
+	MetricsExporter::~MetricsExporter()
+	{
+		Stop();
+	}
+
+	void MetricsExporter::Start(const std::string& endpoint)
+	{
+		if (bIsRunning)
+		{
+			return;
+		}
+
+#if defined(PLATFORM_WINDOWS)
+		WSADATA wsaData;
+		if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+		{
+			std::cout << "ERROR: Failed to initialize Winsock, metrics are not exported" << std::endl;
+			return;
+		}
+#endif
+
+		SocketHandle socketHandle;
+		if (IsPortNumber(endpoint))
+		{
+			socketHandle = socket(AF_INET, SOCK_STREAM, 0);
+
+			const int reuseAddress = 1;
+			setsockopt(socketHandle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuseAddress), sizeof(reuseAddress));
+
+			// Loopback only, the metrics are not meant to leave the machine
+			sockaddr_in address = {};
+			address.sin_family = AF_INET;
+			address.sin_port = htons(static_cast<uint16_t>(std::stoi(endpoint)));
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+			if (static_cast<intptr_t>(socketHandle) == INVALID_SOCKET_HANDLE || bind(socketHandle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(socketHandle, 8) != 0)
+			{
+				std::cout << "ERROR: Failed to listen on 127.0.0.1:" << endpoint << ", metrics are not exported" << std::endl;
+				if (static_cast<intptr_t>(socketHandle) != INVALID_SOCKET_HANDLE)
+				{
+					CloseSocket(static_cast<intptr_t>(socketHandle));
+				}
+				return;
+			}
+		}
+		else
+		{
+#if defined(PLATFORM_WINDOWS)
+			std::cout << "ERROR: Unix-domain sockets are not supported on Windows, use a port number, metrics are not exported" << std::endl;
+			WSACleanup();
+			return;
+#else
+			sockaddr_un address = {};
+			address.sun_family = AF_UNIX;
+			if (endpoint.empty() || endpoint.size() >= sizeof(address.sun_path))
+			{
+				std::cout << "ERROR: Invalid metrics socket path " << endpoint << ", metrics are not exported" << std::endl;
+				return;
+			}
+			endpoint.copy(address.sun_path, endpoint.size());
+
+			// A socket file left behind by a crashed run would make bind fail
+			unlink(endpoint.c_str());
+
+			socketHandle = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (socketHandle < 0 || bind(socketHandle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(socketHandle, 8) != 0)
+			{
+				std::cout << "ERROR: Failed to listen on " << endpoint << ", metrics are not exported" << std::endl;
+				if (socketHandle >= 0)
+				{
+					close(socketHandle);
+				}
+				return;
+			}
+			unixSocketPath = endpoint;
+#endif
+		}
+
+		listenSocket = static_cast<intptr_t>(socketHandle);
+		bIsRunning = true;
+		bStopServer.store(false, std::memory_order_relaxed);
+		nextPublishTime = { 0 };
+		serverThread = std::thread(&MetricsExporter::ServerLoop, this);
+
+		std::cout << "Exporting metrics on " << (IsPortNumber(endpoint) ? "127.0.0.1:" : "") << endpoint << std::endl;
+	}
+
+	void MetricsExporter::Stop()
+	{
+		if (!bIsRunning)
+		{
+			return;
+		}
+
+		bStopServer.store(true, std::memory_order_relaxed);
+		serverThread.join();
+
+		CloseSocket(listenSocket);
+		listenSocket = INVALID_SOCKET_HANDLE;
+
+#if defined(PLATFORM_WINDOWS)
+		WSACleanup();
+#else
+		if (!unixSocketPath.empty())
+		{
+			unlink(unixSocketPath.c_str());
+			unixSocketPath.clear();
+		}
+#endif
+
+		bIsRunning = false;
+	}
+
+	void MetricsExporter::Publish(const TimeData& time, uint32_t particleCount, const GPUProfiler& gpuProfiler)
+	{
+		if (!bIsRunning || time.time < nextPublishTime)
+		{
+			return;
+		}
+		nextPublishTime = time.time + SecondsToTime(PUBLISH_INTERVAL_SECONDS);
+
+		MetricsSnapshot& snapshot = snapshots.GetBack();
+		snapshot.uptimeSeconds = TimeToSeconds<double>(time.time);
+		snapshot.frameCount = time.frameIndex;
+		snapshot.particleCount = particleCount;
+
+		snapshot.fps = FPSCounter::GetInstance().GetFPS();
+		snapshot.minFPS = FPSCounter::GetInstance().GetMinFPS();
+		snapshot.maxFPS = FPSCounter::GetInstance().GetMaxFPS();
+
+		const FrameTimeHistogram& histogram = FrameTimeHistory::GetInstance().GetHistogram();
+		snapshot.frameTimeCount = histogram.GetCount();
+		snapshot.frameTimeSumSeconds = histogram.GetMeanMilliseconds() * static_cast<double>(histogram.GetCount()) * 1e-3;
+		snapshot.frameTimeP50 = histogram.GetPercentileMilliseconds(0.5) * 1e-3;
+		snapshot.frameTimeP90 = histogram.GetPercentileMilliseconds(0.9) * 1e-3;
+		snapshot.frameTimeP99 = histogram.GetPercentileMilliseconds(0.99) * 1e-3;
+		snapshot.frameTimeP999 = histogram.GetPercentileMilliseconds(0.999) * 1e-3;
+
+		snapshot.gpuZoneCount = gpuProfiler.GetLatestZoneCount();
+		snapshot.gpuZones = gpuProfiler.GetLatestZones();
+
+		QueryMemoryHeaps(snapshot);
+		snapshot.residentBytes = GetResidentBytes();
+
+		snapshots.Publish();
+	}
+
+	void MetricsExporter::QueryMemoryHeaps(MetricsSnapshot& snapshot) const
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+		budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+		VkPhysicalDeviceMemoryProperties2 memoryProperties = {};
+		memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+		memoryProperties.pNext = bSupportsMemoryBudget ? &budgetProperties : nullptr;
+		vkGetPhysicalDeviceMemoryProperties2(device.GetPhysicalDevice(), &memoryProperties);
+
+		snapshot.bHasMemoryBudget = bSupportsMemoryBudget;
+		snapshot.memoryHeapCount = memoryProperties.memoryProperties.memoryHeapCount;
+		for (uint32_t i = 0; i < snapshot.memoryHeapCount; ++i)
+		{
+			const VkMemoryHeap& heap = memoryProperties.memoryProperties.memoryHeaps[i];
+			snapshot.memoryHeaps[i].size = heap.size;
+			snapshot.memoryHeaps[i].bIsDeviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+			snapshot.memoryHeaps[i].budget = bSupportsMemoryBudget ? budgetProperties.heapBudget[i] : 0;
+			snapshot.memoryHeaps[i].usage = bSupportsMemoryBudget ? budgetProperties.heapUsage[i] : 0;
+		}
+	}
+
+	// Runs on the server thread, one request per connection
+	void MetricsExporter::ServerLoop()
+	{
+		MetricsSnapshot snapshot = {};
+		std::vector<char> request(MAX_REQUEST_SIZE);
+
+		while (!bStopServer.load(std::memory_order_relaxed))
+		{
+			pollfd listenPoll = {};
+			listenPoll.fd = static_cast<SocketHandle>(listenSocket);
+			listenPoll.events = POLLIN;
+			if (PollSocket(&listenPoll, POLL_TIMEOUT_MILLISECONDS) <= 0 || (listenPoll.revents & POLLIN) == 0)
+			{
+				continue;
+			}
+
+			const SocketHandle client = accept(static_cast<SocketHandle>(listenSocket), nullptr, nullptr);
+			if (static_cast<intptr_t>(client) == INVALID_SOCKET_HANDLE)
+			{
+				continue;
+			}
+
+			// Read the request header, its content does not matter, every path gets the metrics
+			size_t received = 0;
+			while (received < request.size())
+			{
+				pollfd clientPoll = {};
+				clientPoll.fd = client;
+				clientPoll.events = POLLIN;
+				if (PollSocket(&clientPoll, POLL_TIMEOUT_MILLISECONDS) <= 0)
+				{
+					break;
+				}
+
+				const int count = static_cast<int>(recv(client, request.data() + received, static_cast<int>(request.size() - received), 0));
+				if (count <= 0)
+				{
+					break;
+				}
+				received += static_cast<size_t>(count);
+
+				if (std::string_view(request.data(), received).find("\r\n\r\n") != std::string_view::npos)
+				{
+					break;
+				}
+			}
+
+			snapshots.TryRead(snapshot);
+			const std::string body = Format(snapshot);
+			const std::string response = "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+
+			size_t sent = 0;
+			while (sent < response.size())
+			{
+				const int count = SendBytes(static_cast<intptr_t>(client), response.data() + sent, response.size() - sent);
+				if (count <= 0)
+				{
+					break;
+				}
+				sent += static_cast<size_t>(count);
+			}
+
+			CloseSocket(static_cast<intptr_t>(client));
+		}
+	}
+
+	std::string MetricsExporter::Format(const MetricsSnapshot& snapshot)
+	{
+		std::ostringstream out;
+		out.precision(12);
+
+		WriteMetric(out, "particle_system_uptime_seconds", "gauge", "Time since the render loop started");
+		out << "particle_system_uptime_seconds " << snapshot.uptimeSeconds << '\n';
+
+		WriteMetric(out, "particle_system_frames_total", "counter", "Frames rendered since the render loop started");
+		out << "particle_system_frames_total " << snapshot.frameCount << '\n';
+
+		WriteMetric(out, "particle_system_particles", "gauge", "Simulated particles");
+		out << "particle_system_particles " << snapshot.particleCount << '\n';
+
+		WriteMetric(out, "particle_system_fps", "gauge", "Frames per second over the last FPS counter interval");
+		out << "particle_system_fps " << snapshot.fps << '\n';
+
+		WriteMetric(out, "particle_system_fps_min", "gauge", "Lowest FPS counter interval since the last reset");
+		out << "particle_system_fps_min " << snapshot.minFPS << '\n';
+
+		WriteMetric(out, "particle_system_fps_max", "gauge", "Highest FPS counter interval since the last reset");
+		out << "particle_system_fps_max " << snapshot.maxFPS << '\n';
+
+		WriteMetric(out, "particle_system_frame_time_seconds", "summary", "Frame times since the last reset of the frame time history");
+		out << "particle_system_frame_time_seconds{quantile=\"0.5\"} " << snapshot.frameTimeP50 << '\n'
+			<< "particle_system_frame_time_seconds{quantile=\"0.9\"} " << snapshot.frameTimeP90 << '\n'
+			<< "particle_system_frame_time_seconds{quantile=\"0.99\"} " << snapshot.frameTimeP99 << '\n'
+			<< "particle_system_frame_time_seconds{quantile=\"0.999\"} " << snapshot.frameTimeP999 << '\n'
+			<< "particle_system_frame_time_seconds_sum " << snapshot.frameTimeSumSeconds << '\n'
+			<< "particle_system_frame_time_seconds_count " << snapshot.frameTimeCount << '\n';
+
+		WriteMetric(out, "particle_system_gpu_pass_seconds", "gauge", "GPU time of the last measured pass");
+		for (uint32_t i = 0; i < snapshot.gpuZoneCount; ++i)
+		{
+			out << "particle_system_gpu_pass_seconds{pass=\"" << snapshot.gpuZones[i].name << "\"} " << snapshot.gpuZones[i].milliseconds * 1e-3 << '\n';
+		}
+
+		WriteMetric(out, "particle_system_gpu_heap_size_bytes", "gauge", "Size of the device memory heap");
+		for (uint32_t i = 0; i < snapshot.memoryHeapCount; ++i)
+		{
+			out << "particle_system_gpu_heap_size_bytes{heap=\"" << i << "\",device_local=\"" << (snapshot.memoryHeaps[i].bIsDeviceLocal ? "true" : "false") << "\"} " << snapshot.memoryHeaps[i].size << '\n';
+		}
+
+		if (snapshot.bHasMemoryBudget)
+		{
+			WriteMetric(out, "particle_system_gpu_heap_budget_bytes", "gauge", "Device memory this process can use without degrading performance (VK_EXT_memory_budget)");
+			for (uint32_t i = 0; i < snapshot.memoryHeapCount; ++i)
+			{
+				out << "particle_system_gpu_heap_budget_bytes{heap=\"" << i << "\"} " << snapshot.memoryHeaps[i].budget << '\n';
+			}
+
+			WriteMetric(out, "particle_system_gpu_heap_usage_bytes", "gauge", "Device memory used by this process (VK_EXT_memory_budget)");
+			for (uint32_t i = 0; i < snapshot.memoryHeapCount; ++i)
+			{
+				out << "particle_system_gpu_heap_usage_bytes{heap=\"" << i << "\"} " << snapshot.memoryHeaps[i].usage << '\n';
+			}
+		}
+
+		WriteMetric(out, "particle_system_resident_memory_bytes", "gauge", "Resident set size of the process");
+		out << "particle_system_resident_memory_bytes " << snapshot.residentBytes << '\n';
+
+		return out.str();
+	}
+
+	uint64_t MetricsExporter::GetResidentBytes()
+	{
+#if defined(PLATFORM_WINDOWS)
+		PROCESS_MEMORY_COUNTERS counters = {};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		{
+			return static_cast<uint64_t>(counters.WorkingSetSize);
+		}
+		return 0;
+#else
+		// Second field of statm, in pages
+		std::ifstream statm("/proc/self/statm");
+		uint64_t totalPages = 0;
+		uint64_t residentPages = 0;
+		if (!(statm >> totalPages >> residentPages))
+		{
+			return 0;
+		}
+		return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "GPUDevice.h"
+#include "GPUProfiler.h"
+#include "Time.h"
+#include "TripleBuffer.h"
+
+namespace VulkanCore {
+
+	struct MemoryHeapMetrics
+	{
+		uint64_t size = 0;
+		uint64_t budget = 0;		// 0 without VK_EXT_memory_budget
+		uint64_t usage = 0;			// 0 without VK_EXT_memory_budget
+		bool bIsDeviceLocal = false;
+	};
+
+	// Everything the exporter serves, plain data so it can be handed over without a lock
+	struct MetricsSnapshot
+	{
+		double uptimeSeconds = 0.0;
+		uint64_t frameCount = 0;
+		uint32_t particleCount = 0;
+
+		float fps = 0.0f;
+		float minFPS = 0.0f;
+		float maxFPS = 0.0f;
+
+		// Since the last reset of the frame time history
+		uint64_t frameTimeCount = 0;
+		double frameTimeSumSeconds = 0.0;
+		double frameTimeP50 = 0.0;
+		double frameTimeP90 = 0.0;
+		double frameTimeP99 = 0.0;
+		double frameTimeP999 = 0.0;
+
+		uint32_t gpuZoneCount = 0;
+		std::array<GPUZoneTime, GPUProfiler::MAX_ZONES_PER_FRAME> gpuZones = {};
+
+		bool bHasMemoryBudget = false;
+		uint32_t memoryHeapCount = 0;
+		std::array<MemoryHeapMetrics, VK_MAX_MEMORY_HEAPS> memoryHeaps = {};
+
+		uint64_t residentBytes = 0;
+	};
+
+	// Prometheus text format metrics for soak tests, served over HTTP on a Unix-domain socket or a localhost TCP port
+	// The render loop fills a snapshot every PUBLISH_INTERVAL_SECONDS and hands it over through a triple buffer,
+	// the server thread formats and sends the latest one, so a slow or stuck scraper never reaches the frame loop.
+	//   curl --unix-socket particle-system.sock http://localhost/metrics
+	//   curl http://127.0.0.1:9464/metrics
+	class MetricsExporter final
+	{
+	public:
+		static constexpr double PUBLISH_INTERVAL_SECONDS = 1.0;
+
+		// Constructor
+		MetricsExporter(GPUDevice& device);
+
+		// Destructor
+		~MetricsExporter();
+
+		// Not copyable
+		MetricsExporter(const MetricsExporter&) = delete;
+		MetricsExporter& operator = (const MetricsExporter&) = delete;
+
+		// Not moveable
+		MetricsExporter(MetricsExporter&&) = delete;
+		MetricsExporter& operator = (MetricsExporter&&) = delete;
+
+		// endpoint: a port number for 127.0.0.1:port, anything else is a Unix-domain socket path (not on Windows)
+		// Prints the error and keeps the exporter stopped if the endpoint can not be opened
+		void Start(const std::string& endpoint);
+		void Stop();
+
+		// Snapshots FPSCounter, FrameTimeHistory, the GPU zones and the memory heaps once the interval elapsed, cheap otherwise
+		void Publish(const TimeData& time, uint32_t particleCount, const GPUProfiler& gpuProfiler);
+
+		// Getters
+		inline bool GetIsRunning() const { return bIsRunning; }
+
+	private:
+		GPUDevice& device;
+		bool bSupportsMemoryBudget;
+
+		bool bIsRunning;
+		std::string unixSocketPath;
+		intptr_t listenSocket;
+		Time nextPublishTime;
+
+		TripleBuffer<MetricsSnapshot> snapshots;
+
+		std::thread serverThread;
+		std::atomic<bool> bStopServer;
+
+		void QueryMemoryHeaps(MetricsSnapshot& snapshot) const;
+
+		void ServerLoop();
+		static std::string Format(const MetricsSnapshot& snapshot);
+		static uint64_t GetResidentBytes();
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,134 @@
+#include "NBodyReference.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <mutex>
+
+#include "JobSystem.h"
+
+namespace VulkanCore {
+
+	glm::dvec2 NBodyReference::ComputeAcceleration(const Particle* bodies, uint32_t bodyCount, uint32_t index, const NBodyParameters& parameters, double* potential)
+	{
+		const double softeningSquared = static_cast<double>(parameters.softening) * static_cast<double>(parameters.softening);
+		const double x = bodies[index].position.x;
+		const double y = bodies[index].position.y;
+
+		double accelerationX = 0.0;
+		double accelerationY = 0.0;
+		double inverseDistanceSum = 0.0;
+		for (uint32_t j = 0; j < bodyCount; ++j)
+		{
+			if (j == index)
+			{
+				continue;
+			}
+
+			const double dx = static_cast<double>(bodies[j].position.x) - x;
+			const double dy = static_cast<double>(bodies[j].position.y) - y;
+			const double inverseDistance = 1.0 / std::sqrt(dx * dx + dy * dy + softeningSquared);
+			const double inverseDistanceCubed = inverseDistance * inverseDistance * inverseDistance;
+
+			accelerationX += dx * inverseDistanceCubed;
+			accelerationY += dy * inverseDistanceCubed;
+			inverseDistanceSum += inverseDistance;
+		}
+
+		const double gm = static_cast<double>(parameters.gravitationalConstant) * static_cast<double>(parameters.bodyMass);
+		if (potential != nullptr)
+		{
+			*potential = -gm * inverseDistanceSum;
+		}
+
+		return glm::dvec2(gm * accelerationX, gm * accelerationY);
+	}
+
+	NBodyValidationResult NBodyReference::Validate(const Particle* bodies, const glm::vec2* accelerations, uint32_t bodyCount, const NBodyParameters& parameters, float timestep, uint32_t sampleCount)
+	{
+		NBodyValidationResult result = {};
+		result.bodyCount = bodyCount;
+		result.sampleCount = std::min(sampleCount, bodyCount);
+		if (result.sampleCount == 0)
+		{
+			return result;
+		}
+
+		// Relative errors of the sampled bodies
+		std::mutex resultMutex;
+		double squaredErrorSum = 0.0;
+		JobSystem::GetInstance().ParallelFor(result.sampleCount, 1, [&](uint64_t begin, uint64_t end)
+		{
+			double batchMaxError = 0.0;
+			double batchSquaredErrorSum = 0.0;
+			for (uint64_t sample = begin; sample < end; ++sample)
+			{
+				const uint32_t index = static_cast<uint32_t>(sample * bodyCount / result.sampleCount);
+				const glm::dvec2 reference = ComputeAcceleration(bodies, bodyCount, index, parameters);
+				const glm::dvec2 error = glm::dvec2(accelerations[index]) - reference;
+
+				const double referenceLength = std::sqrt(reference.x * reference.x + reference.y * reference.y);
+				const double relativeError = std::sqrt(error.x * error.x + error.y * error.y) / std::max(referenceLength, 1e-30);
+				batchMaxError = std::max(batchMaxError, relativeError);
+				batchSquaredErrorSum += relativeError * relativeError;
+			}
+
+			std::lock_guard<std::mutex> lock(resultMutex);
+			result.maxRelativeError = std::max(result.maxRelativeError, batchMaxError);
+			squaredErrorSum += batchSquaredErrorSum;
+		});
+		result.rmsRelativeError = std::sqrt(squaredErrorSum / result.sampleCount);
+
+		if (bodyCount > MAX_ENERGY_BODY_COUNT)
+		{
+			return result;
+		}
+
+		// The kick already moved the velocities a full step, the kernels measured the kinetic energy half a step earlier
+		const double halfStep = 0.5 * static_cast<double>(timestep);
+		const double mass = parameters.bodyMass;
+		JobSystem::GetInstance().ParallelFor(bodyCount, 256, [&](uint64_t begin, uint64_t end)
+		{
+			NBodyEnergy batchEnergy = {};
+			for (uint64_t i = begin; i < end; ++i)
+			{
+				const double vx = static_cast<double>(bodies[i].velocity.x) - halfStep * accelerations[i].x;
+				const double vy = static_cast<double>(bodies[i].velocity.y) - halfStep * accelerations[i].y;
+				batchEnergy.kinetic += 0.5 * mass * (vx * vx + vy * vy);
+
+				double potential = 0.0;
+				ComputeAcceleration(bodies, bodyCount, static_cast<uint32_t>(i), parameters, &potential);
+				batchEnergy.potential += 0.5 * mass * potential;
+			}
+
+			std::lock_guard<std::mutex> lock(resultMutex);
+			result.energy.kinetic += batchEnergy.kinetic;
+			result.energy.potential += batchEnergy.potential;
+		});
+		result.bHasEnergy = true;
+
+		return result;
+	}
+
+	void NBodyReference::PrintResult(std::ostream& out, const char* modeName, const NBodyValidationResult& result, const NBodyEnergy& gpuEnergy)
+	{
+		out << "N-body validation (" << modeName << ", " << result.bodyCount << " bodies, " << result.sampleCount << " sampled):" << '\n'
+			<< std::scientific << std::setprecision(3)
+			<< "  acceleration relative error: max " << result.maxRelativeError << ", rms " << result.rmsRelativeError << '\n';
+
+		if (result.bHasEnergy)
+		{
+			const double energyError = std::abs(gpuEnergy.GetTotal() - result.energy.GetTotal()) / std::max(std::abs(result.energy.GetTotal()), 1e-30);
+			out << "  energy: GPU " << gpuEnergy.GetTotal() << " (kinetic " << gpuEnergy.kinetic << ", potential " << gpuEnergy.potential << ")" << '\n'
+				<< "          CPU " << result.energy.GetTotal() << " (kinetic " << result.energy.kinetic << ", potential " << result.energy.potential << ")" << '\n'
+				<< "  energy relative error: " << energyError << '\n';
+		}
+		else
+		{
+			out << "  energy: not checked, more than " << MAX_ENERGY_BODY_COUNT << " bodies" << '\n';
+		}
+
+		out << std::defaultfloat << std::flush;
+	}
+
+} // namespace VulkanCore
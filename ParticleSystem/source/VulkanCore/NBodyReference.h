@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+#include <glm/glm.hpp>
+
+#include "Particle.h"
+
+namespace VulkanCore {
+
+	// Softened Newtonian gravity shared by the GPU kernels and the CPU reference
+	// a_i = G * sum_j m * (x_j - x_i) / (|x_j - x_i|^2 + softening^2)^1.5
+	struct NBodyParameters
+	{
+		float gravitationalConstant;
+		float bodyMass;
+		float softening;
+		float theta;				// Barnes-Hut opening angle, a node is accepted when size < theta * distance
+	};
+
+	struct NBodyEnergy
+	{
+		double kinetic;
+		double potential;
+
+		inline double GetTotal() const { return kinetic + potential; }
+	};
+
+	struct NBodyValidationResult
+	{
+		uint32_t bodyCount;
+		uint32_t sampleCount;
+		double maxRelativeError;		// |a_gpu - a_ref| / |a_ref| over the sampled bodies
+		double rmsRelativeError;
+
+		// Exact energy of the validated step, only for up to MAX_ENERGY_BODY_COUNT bodies
+		bool bHasEnergy;
+		NBodyEnergy energy;
+	};
+
+	// Double precision direct summation the GPU kernels are validated against
+	class NBodyReference final
+	{
+	public:
+		// The exact potential energy is O(N^2), larger states only compare accelerations
+		static constexpr uint32_t MAX_ENERGY_BODY_COUNT = 131072;
+
+		// Acceleration and potential (per unit mass) of body index from every other body
+		static glm::dvec2 ComputeAcceleration(const Particle* bodies, uint32_t bodyCount, uint32_t index, const NBodyParameters& parameters, double* potential = nullptr);
+
+		// bodies and accelerations were read back right after the kick of a step of timestep seconds, before the drift
+		// Compares sampleCount evenly strided bodies against the exact sum on the job system
+		static NBodyValidationResult Validate(const Particle* bodies, const glm::vec2* accelerations, uint32_t bodyCount, const NBodyParameters& parameters, float timestep, uint32_t sampleCount);
+
+		// gpuEnergy is the energy the kernels reported for the validated step
+		static void PrintResult(std::ostream& out, const char* modeName, const NBodyValidationResult& result, const NBodyEnergy& gpuEnergy);
+	};
+
+} // namespace VulkanCore
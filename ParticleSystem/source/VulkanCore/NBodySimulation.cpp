@@ -0,0 +1,358 @@
+#include "NBodySimulation.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Particle.h"
+#include "JobSystem.h"
+
+namespace VulkanCore {
+
+	NBodySimulation::NBodySimulation(GPUDevice& device)
+		: device(device)
+		, parameters({ 1.0f, TOTAL_MASS, 0.01f, 0.5f })
+		, particleBuffer(VK_NULL_HANDLE)
+		, bodyCount(0)
+		, bHasBuffers(false)
+		, energyBufferMapped(nullptr)
+		, descriptorSet(VK_NULL_HANDLE)
+		, bHasPendingEnergy(false)
+		, bHasInitialEnergy(false)
+		, initialEnergy(0.0)
+		, energy({})
+		, validationMode(SimulationMode::NBodyAllPairs)
+		, validationParameters({})
+		, validationTimestep(0.0f)
+		, validationBodyCount(0)
+		, validationEnergy({})
+		, validationResult({})
+		, validation(device, "N-body",
+			[this](const void* data)
+			{
+				const Particle* bodies = static_cast<const Particle*>(data);
+				const glm::vec2* accelerations = reinterpret_cast<const glm::vec2*>(bodies + validationBodyCount);
+				validationResult = NBodyReference::Validate(bodies, accelerations, validationBodyCount, validationParameters, validationTimestep, VALIDATION_SAMPLE_COUNT);
+			},
+			[this]()
+			{
+				NBodyReference::PrintResult(std::cout, GetModeName(validationMode), validationResult, validationEnergy);
+			})
+	{
+		descriptorSetLayout = DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// particles
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// accelerations
+			.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// energies
+			.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// leaf counts
+			.AddBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// leaf starts
+			.AddBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// scan block sums
+			.AddBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// sorted positions
+			.AddBinding(7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// nodes
+			.Build();
+
+		CreatePipelines();
+	}
+
+	NBodySimulation::~NBodySimulation()
+	{
+		CleanupBuffers();
+	}
+
+	void NBodySimulation::SetBodies(VkBuffer newParticleBuffer, uint32_t newBodyCount)
+	{
+		CleanupBuffers();
+
+		particleBuffer = newParticleBuffer;
+		bodyCount = newBodyCount;
+		parameters.bodyMass = TOTAL_MASS / static_cast<float>(std::max(newBodyCount, 1u));
+
+		bHasPendingEnergy = false;
+		ResetEnergy();
+	}
+
+	void NBodySimulation::RecordStep(VkCommandBuffer commandBuffer, SimulationMode mode, float timestep, bool bIsLastStep)
+	{
+		if (!bHasBuffers)
+		{
+			CreateBuffers();
+		}
+
+		NBodyPushConstants pushConstants = {};
+		pushConstants.bodyCount = bodyCount;
+		pushConstants.timestep = timestep;
+		pushConstants.gravitationalConstant = parameters.gravitationalConstant;
+		pushConstants.bodyMass = parameters.bodyMass;
+		pushConstants.softening = parameters.softening;
+		pushConstants.theta = parameters.theta;
+		pushConstants.captureEnergy = bIsLastStep ? 1 : 0;
+
+		if (mode == SimulationMode::NBodyBarnesHut)
+		{
+			RecordTreeBuild(commandBuffer, pushConstants);
+		}
+
+		// Kick
+		Pipeline& kickPipeline = mode == SimulationMode::NBodyBarnesHut ? *barnesHutPipeline : *directPipeline;
+		kickPipeline.BindComputePipeline(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, kickPipeline.GetComputePipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, kickPipeline.GetComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(NBodyPushConstants), &pushConstants);
+		vkCmdDispatch(commandBuffer, bodyCount / WORKGROUP_SIZE, 1, 1);
+		RecordComputeBarrier(commandBuffer);
+
+		// The positions the accelerations were computed from are only moved by the drift
+		if (bIsLastStep && validation.GetIsRequested())
+		{
+			validationMode = mode;
+			validationTimestep = timestep;
+			RecordValidationReadback(commandBuffer);
+		}
+
+		// Drift
+		driftPipeline->BindComputePipeline(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, driftPipeline->GetComputePipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+		vkCmdPushConstants(commandBuffer, driftPipeline->GetComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(NBodyPushConstants), &pushConstants);
+		vkCmdDispatch(commandBuffer, bodyCount / WORKGROUP_SIZE, 1, 1);
+
+		if (bIsLastStep)
+		{
+			VkMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+			bHasPendingEnergy = true;
+		}
+	}
+
+	void NBodySimulation::Poll()
+	{
+		if (bHasPendingEnergy)
+		{
+			// One partial sum per workgroup of the kick, summed in double
+			const glm::vec2* partialSums = static_cast<const glm::vec2*>(energyBufferMapped);
+
+			NBodyEnergy sum = {};
+			for (uint32_t i = 0; i < bodyCount / WORKGROUP_SIZE; ++i)
+			{
+				sum.kinetic += partialSums[i].x;
+				sum.potential += partialSums[i].y;
+			}
+
+			energy = sum;
+			if (!bHasInitialEnergy)
+			{
+				initialEnergy = energy.GetTotal();
+				bHasInitialEnergy = true;
+			}
+			bHasPendingEnergy = false;
+		}
+
+		// The readback was taken by the step that reported this energy
+		if (validation.GetIsInFlight())
+		{
+			validationEnergy = energy;
+		}
+		validation.Poll();
+	}
+
+	void NBodySimulation::ResetEnergy()
+	{
+		bHasInitialEnergy = false;
+		initialEnergy = 0.0;
+		energy = {};
+	}
+
+	bool NBodySimulation::Validate()
+	{
+		return validation.Request();
+	}
+
+	const char* NBodySimulation::GetModeName(SimulationMode mode)
+	{
+		switch (mode)
+		{
+			case SimulationMode::Attractor:			return "Attractor";
+			case SimulationMode::NBodyAllPairs:		return "N-Body (all pairs)";
+			case SimulationMode::NBodyBarnesHut:	return "N-Body (Barnes-Hut)";
+			case SimulationMode::Fluid:				return "SPH Fluid";
+			case SimulationMode::Emitters:			return "Emitters";
+		}
+
+		return "Unknown";
+	}
+
+	void NBodySimulation::CreatePipelines()
+	{
+#if defined(PLATFORM_WINDOWS) || (defined(PLATFORM_LINUX) && defined(NDEBUG))
+		static const std::string directShaderFilePath = "shaders/nbody_direct.comp.spv";
+		static const std::string barnesHutShaderFilePath = "shaders/nbody_barneshut.comp.spv";
+		static const std::string treeShaderFilePath = "shaders/nbody_tree.comp.spv";
+		static const std::string driftShaderFilePath = "shaders/nbody_drift.comp.spv";
+#elif defined(PLATFORM_LINUX) && defined(DEBUG)
+		static const std::string directShaderFilePath = "ParticleSystem/shaders/nbody_direct.comp.spv";
+		static const std::string barnesHutShaderFilePath = "ParticleSystem/shaders/nbody_barneshut.comp.spv";
+		static const std::string treeShaderFilePath = "ParticleSystem/shaders/nbody_tree.comp.spv";
+		static const std::string driftShaderFilePath = "ParticleSystem/shaders/nbody_drift.comp.spv";
+#endif
+
+		const VkDescriptorSetLayout layout = descriptorSetLayout->GetDescriptorSetLayout();
+
+		// Every pipeline compiles its shader in the driver, half of them are built on a worker meanwhile
+		JobSystem::GetInstance().ParallelInvoke(
+			[&]()
+			{
+				directPipeline = std::make_unique<Pipeline>(device, layout, directShaderFilePath, static_cast<uint32_t>(sizeof(NBodyPushConstants)));
+				driftPipeline = std::make_unique<Pipeline>(device, layout, driftShaderFilePath, static_cast<uint32_t>(sizeof(NBodyPushConstants)));
+			},
+			[&]()
+			{
+				barnesHutPipeline = std::make_unique<Pipeline>(device, layout, barnesHutShaderFilePath, static_cast<uint32_t>(sizeof(NBodyPushConstants)));
+				treePipeline = std::make_unique<Pipeline>(device, layout, treeShaderFilePath, static_cast<uint32_t>(sizeof(NBodyPushConstants)));
+			}
+		);
+	}
+
+	void NBodySimulation::CreateBuffers()
+	{
+		const VkDeviceSize bodies = static_cast<VkDeviceSize>(bodyCount);
+
+		// Per body
+		accelerationBuffer.Create(device, sizeof(glm::vec2) * bodies, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		sortedPositionBuffer.Create(device, sizeof(glm::vec2) * bodies, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		// Read by the host every tick
+		const VkDeviceSize energyBufferSize = sizeof(glm::vec2) * (bodies / WORKGROUP_SIZE);
+		energyBuffer.Create(device, energyBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		vkMapMemory(device.GetVKDevice(), energyBuffer.memory, 0, energyBufferSize, 0, &energyBufferMapped);
+
+		// Tree, independent of the body count
+		cellCountBuffer.Create(device, sizeof(uint32_t) * LEAF_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		cellStartBuffer.Create(device, sizeof(uint32_t) * (LEAF_COUNT + 1), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		blockSumBuffer.Create(device, sizeof(uint32_t) * (LEAF_COUNT / SCAN_BLOCK_SIZE), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		nodeBuffer.Create(device, sizeof(glm::vec4) * NODE_COUNT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		// A fresh pool per set of buffers, destroying it frees the previous set
+		descriptorPool = DescriptorPool::Builder(device)
+			.SetMaxSets(1)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 8)
+			.Build();
+
+		const VkDescriptorBufferInfo bufferInfos[] = {
+			{ particleBuffer, 0, sizeof(Particle) * bodies },
+			{ accelerationBuffer.buffer, 0, VK_WHOLE_SIZE },
+			{ energyBuffer.buffer, 0, VK_WHOLE_SIZE },
+			{ cellCountBuffer.buffer, 0, VK_WHOLE_SIZE },
+			{ cellStartBuffer.buffer, 0, VK_WHOLE_SIZE },
+			{ blockSumBuffer.buffer, 0, VK_WHOLE_SIZE },
+			{ sortedPositionBuffer.buffer, 0, VK_WHOLE_SIZE },
+			{ nodeBuffer.buffer, 0, VK_WHOLE_SIZE }
+		};
+
+		DescriptorWriter writer(*descriptorSetLayout, *descriptorPool);
+		for (uint32_t binding = 0; binding < 8; ++binding)
+		{
+			writer.WriteBuffer(binding, bufferInfos[binding]);
+		}
+		writer.Build(descriptorSet);
+
+		bHasBuffers = true;
+	}
+
+	void NBodySimulation::CleanupBuffers()
+	{
+		if (!bHasBuffers)
+		{
+			return;
+		}
+
+		descriptorPool.reset();
+		descriptorSet = VK_NULL_HANDLE;
+
+		accelerationBuffer.Cleanup(device);
+		sortedPositionBuffer.Cleanup(device);
+		energyBuffer.Cleanup(device);
+		cellCountBuffer.Cleanup(device);
+		cellStartBuffer.Cleanup(device);
+		blockSumBuffer.Cleanup(device);
+		nodeBuffer.Cleanup(device);
+		energyBufferMapped = nullptr;
+
+		bHasBuffers = false;
+	}
+
+	void NBodySimulation::RecordTreeBuild(VkCommandBuffer commandBuffer, NBodyPushConstants& pushConstants)
+	{
+		// Every leaf count is back to 0 after a scatter, cleared anyway for the first build over new buffers
+		vkCmdFillBuffer(commandBuffer, cellCountBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		treePipeline->BindComputePipeline(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, treePipeline->GetComputePipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+
+		// Every pass reads what the previous one wrote
+		const auto dispatchPass = [this, commandBuffer, &pushConstants](TreePass pass, uint32_t invocationCount, uint32_t level)
+		{
+			pushConstants.pass = static_cast<uint32_t>(pass);
+			pushConstants.level = level;
+			vkCmdPushConstants(commandBuffer, treePipeline->GetComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(NBodyPushConstants), &pushConstants);
+			vkCmdDispatch(commandBuffer, (invocationCount + TREE_WORKGROUP_SIZE - 1) / TREE_WORKGROUP_SIZE, 1, 1);
+			RecordComputeBarrier(commandBuffer);
+		};
+
+		// Counting sort of the bodies into the leaves
+		dispatchPass(TreePass::Count, bodyCount, 0);
+		dispatchPass(TreePass::ScanBlocks, LEAF_COUNT / 4, 0);
+		dispatchPass(TreePass::ScanBlockSums, TREE_WORKGROUP_SIZE, 0);
+		dispatchPass(TreePass::ScanAdd, LEAF_COUNT, 0);
+		dispatchPass(TreePass::Scatter, bodyCount, 0);
+
+		// Centers of mass, bottom up
+		dispatchPass(TreePass::ReduceLeaves, LEAF_COUNT, 0);
+		for (uint32_t level = TREE_DEPTH; level-- > 0;)
+		{
+			dispatchPass(TreePass::ReduceLevel, 1u << (2 * level), level);
+		}
+
+		pushConstants.pass = 0;
+		pushConstants.level = 0;
+	}
+
+	void NBodySimulation::RecordValidationReadback(VkCommandBuffer commandBuffer)
+	{
+		// Particles followed by the accelerations
+		const VkDeviceSize particleSize = sizeof(Particle) * static_cast<VkDeviceSize>(bodyCount);
+		const VkDeviceSize accelerationSize = sizeof(glm::vec2) * static_cast<VkDeviceSize>(bodyCount);
+
+		const VkBuffer readbackBuffer = validation.BeginReadback(commandBuffer, particleSize + accelerationSize);
+
+		VkBufferCopy particleRegion = {};
+		particleRegion.size = particleSize;
+		vkCmdCopyBuffer(commandBuffer, particleBuffer, readbackBuffer, 1, &particleRegion);
+
+		VkBufferCopy accelerationRegion = {};
+		accelerationRegion.dstOffset = particleSize;
+		accelerationRegion.size = accelerationSize;
+		vkCmdCopyBuffer(commandBuffer, accelerationBuffer.buffer, readbackBuffer, 1, &accelerationRegion);
+
+		// The drift overwrites the particles that were just read
+		validation.EndReadback(commandBuffer);
+
+		validationParameters = parameters;
+		validationBodyCount = bodyCount;
+	}
+
+	void NBodySimulation::RecordComputeBarrier(VkCommandBuffer commandBuffer)
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include "GPUDevice.h"
+#include "Descriptor.h"
+#include "Pipeline.h"
+#include "StorageBuffer.h"
+#include "ReadbackValidation.h"
+#include "NBodyReference.h"
+#include "SimulationMode.h"
+
+namespace VulkanCore {
+
+	// Push constants of every nbody_*.comp shader
+	struct NBodyPushConstants
+	{
+		uint32_t bodyCount;
+		float timestep;
+		float gravitationalConstant;
+		float bodyMass;
+		float softening;
+		float theta;
+		uint32_t pass;				// nbody_tree.comp pass
+		uint32_t level;				// nbody_tree.comp level reduced by the REDUCE_LEVEL pass
+		uint32_t captureEnergy;
+	};
+
+	// Self-gravitating bodies integrated in place on the particle buffer, all of the same mass
+	// A step is a leapfrog kick (all-pairs or Barnes-Hut accelerations) followed by a drift in a separate dispatch.
+	// The Barnes-Hut tree is a complete quadtree of TREE_DEPTH levels over a fixed square, rebuilt every step on the GPU
+	// by counting sorting the bodies into Morton ordered leaves, then reducing the centers of mass level by level.
+	// The last step of a tick also reports the energy of the system, see Poll.
+	class NBodySimulation final
+	{
+	public:
+		// Matches the shaders
+		static constexpr uint32_t WORKGROUP_SIZE = 64;
+		static constexpr uint32_t TREE_WORKGROUP_SIZE = 128;
+		static constexpr uint32_t TREE_DEPTH = 9;
+		static constexpr float TREE_HALF_SIZE = 2.0f;
+		static constexpr uint32_t LEAF_COUNT = 1u << (2 * TREE_DEPTH);
+		static constexpr uint32_t NODE_COUNT = ((1u << (2 * (TREE_DEPTH + 1))) - 1) / 3;
+		static constexpr uint32_t SCAN_BLOCK_SIZE = 4 * TREE_WORKGROUP_SIZE;
+
+		static_assert(LEAF_COUNT == SCAN_BLOCK_SIZE * SCAN_BLOCK_SIZE, "The leaf counts are scanned in two levels");
+
+		// Past this the all-pairs kernel takes too long for an interactive frame
+		static constexpr uint32_t MAX_DIRECT_BODY_COUNT = 131072;
+
+		// Bodies compared against the CPU reference by Validate
+		static constexpr uint32_t VALIDATION_SAMPLE_COUNT = 256;
+
+		// Initial galaxy, a uniform disk of GALAXY_RADIUS on circular orbits, see Application::CreateShaderStorageBuffer
+		static constexpr float GALAXY_RADIUS = 0.8f;
+		static constexpr float TOTAL_MASS = 1.0f;
+
+		// Constructor
+		NBodySimulation(GPUDevice& device);
+
+		// Destructor
+		~NBodySimulation();
+
+		// Not copyable
+		NBodySimulation(const NBodySimulation&) = delete;
+		NBodySimulation& operator = (const NBodySimulation&) = delete;
+
+		// Not moveable
+		NBodySimulation(NBodySimulation&&) = delete;
+		NBodySimulation& operator = (NBodySimulation&&) = delete;
+
+		// Call with the GPU idle whenever the particle buffer is recreated, the per-body buffers are allocated by the next step
+		void SetBodies(VkBuffer particleBuffer, uint32_t bodyCount);
+
+		// Records one step of timestep seconds, the last step of a tick reports the energy and takes the validation readback
+		void RecordStep(VkCommandBuffer commandBuffer, SimulationMode mode, float timestep, bool bIsLastStep);
+
+		// Call once per frame after Renderer::SyncNewFrame, every recorded step is done
+		// Collects the energy and runs the CPU reference of a validation readback on the job system, never blocks
+		void Poll();
+
+		// The energy drift is measured from the next reported energy
+		void ResetEnergy();
+
+		// Compares the accelerations of the next step against the CPU reference and prints the result
+		// Returns false while the previous validation is still running
+		bool Validate();
+
+		static const char* GetModeName(SimulationMode mode);
+		static inline bool GetIsNBodyMode(SimulationMode mode) { return mode == SimulationMode::NBodyAllPairs || mode == SimulationMode::NBodyBarnesHut; }
+
+		// Getters
+		inline const NBodyParameters& GetParameters() const { return parameters; }
+		inline bool GetHasEnergy() const { return bHasInitialEnergy; }
+		inline const NBodyEnergy& GetEnergy() const { return energy; }
+		inline double GetEnergyDrift() const { return (energy.GetTotal() - initialEnergy) / std::abs(initialEnergy); }
+
+	private:
+		// nbody_tree.comp passes in recording order
+		enum class TreePass : uint32_t
+		{
+			Count = 0,
+			ScanBlocks,
+			ScanBlockSums,
+			ScanAdd,
+			Scatter,
+			ReduceLeaves,
+			ReduceLevel
+		};
+
+		GPUDevice& device;
+
+		NBodyParameters parameters;
+
+		// Bodies
+		VkBuffer particleBuffer;
+		uint32_t bodyCount;
+		bool bHasBuffers;
+
+		StorageBuffer accelerationBuffer;
+		StorageBuffer energyBuffer;				// vec2(kinetic, potential) per workgroup
+		void* energyBufferMapped;
+
+		// Tree
+		StorageBuffer cellCountBuffer;
+		StorageBuffer cellStartBuffer;
+		StorageBuffer blockSumBuffer;
+		StorageBuffer sortedPositionBuffer;
+		StorageBuffer nodeBuffer;
+
+		// Descriptors
+		std::unique_ptr<DescriptorSetLayout> descriptorSetLayout;
+		std::unique_ptr<DescriptorPool> descriptorPool;
+		VkDescriptorSet descriptorSet;
+
+		// Pipelines
+		std::unique_ptr<Pipeline> directPipeline;
+		std::unique_ptr<Pipeline> barnesHutPipeline;
+		std::unique_ptr<Pipeline> treePipeline;
+		std::unique_ptr<Pipeline> driftPipeline;
+
+		// Energy
+		bool bHasPendingEnergy;
+		bool bHasInitialEnergy;
+		double initialEnergy;
+		NBodyEnergy energy;
+
+		// Validation, the particles and accelerations right after the kick
+		SimulationMode validationMode;
+		NBodyParameters validationParameters;
+		float validationTimestep;
+		uint32_t validationBodyCount;
+		NBodyEnergy validationEnergy;
+		NBodyValidationResult validationResult;
+		ReadbackValidation validation;
+
+		void CreatePipelines();
+		void CreateBuffers();
+		void CleanupBuffers();
+
+		void RecordTreeBuild(VkCommandBuffer commandBuffer, NBodyPushConstants& pushConstants);
+		void RecordValidationReadback(VkCommandBuffer commandBuffer);
+
+		static void RecordComputeBarrier(VkCommandBuffer commandBuffer);
+	};
+
+} // namespace VulkanCore
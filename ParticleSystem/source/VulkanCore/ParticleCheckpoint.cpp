@@ -0,0 +1,267 @@
+#include "ParticleCheckpoint.h"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "Particle.h"
+
+namespace VulkanCore {
+
+	ParticleCheckpoint::ParticleCheckpoint(GPUDevice& device)
+		: device(device)
+		, readbackBuffer(VK_NULL_HANDLE)
+		, readbackBufferMemory(VK_NULL_HANDLE)
+		, readbackBufferMapped(nullptr)
+		, readbackBufferSize(0)
+		, commandBuffer(VK_NULL_HANDLE)
+		, fence(VK_NULL_HANDLE)
+		, state(SaveState::Idle)
+		, header({})
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = device.GetCommandPool();
+		allocInfo.commandBufferCount = 1;
+
+		if (vkAllocateCommandBuffers(device.GetVKDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to allocate checkpoint command buffer!");
+		}
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		if (vkCreateFence(device.GetVKDevice(), &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create checkpoint fence!");
+		}
+	}
+
+	ParticleCheckpoint::~ParticleCheckpoint()
+	{
+		// A checkpoint requested right before closing is still written, shutting down is allowed to block
+		if (state.load(std::memory_order_acquire) == SaveState::InFlight)
+		{
+			vkWaitForFences(device.GetVKDevice(), 1, &fence, VK_TRUE, UINT64_MAX);
+			Poll();
+		}
+
+		if (writerThread.joinable())
+		{
+			writerThread.join();
+		}
+
+		CleanupReadbackBuffer();
+		vkDestroyFence(device.GetVKDevice(), fence, nullptr);
+		vkFreeCommandBuffers(device.GetVKDevice(), device.GetCommandPool(), 1, &commandBuffer);
+	}
+
+	bool ParticleCheckpoint::Save(const std::string& newFilePath, VkBuffer shaderStorageBuffer, uint32_t particleCount, uint32_t seed)
+	{
+		if (state.load(std::memory_order_acquire) != SaveState::Idle)
+		{
+			return false;
+		}
+
+		// The previous writer is done, it only has to be joined
+		if (writerThread.joinable())
+		{
+			writerThread.join();
+		}
+
+		const VkDeviceSize size = static_cast<VkDeviceSize>(particleCount) * sizeof(Particle);
+		if (size != readbackBufferSize)
+		{
+			CleanupReadbackBuffer();
+			CreateReadbackBuffer(size);
+		}
+
+		filePath = newFilePath;
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.headerSize = sizeof(CheckpointHeader);
+		header.layout = ParticleLayout::PositionVelocityVec2;
+		header.particleStride = sizeof(Particle);
+		header.seed = seed;
+		header.particleCount = particleCount;
+		saveStartTime = Time::Now();
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin recording checkpoint command buffer!");
+		}
+
+		// The simulation step was submitted earlier on the same queue, wait for its writes
+		VkMemoryBarrier computeToTransfer = {};
+		computeToTransfer.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		computeToTransfer.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		computeToTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &computeToTransfer, 0, nullptr, 0, nullptr);
+
+		VkBufferCopy region = {};
+		region.srcOffset = 0;
+		region.dstOffset = 0;
+		region.size = size;
+		vkCmdCopyBuffer(commandBuffer, shaderStorageBuffer, readbackBuffer, 1, &region);
+
+		VkMemoryBarrier transferToHost = {};
+		transferToHost.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		transferToHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		transferToHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &transferToHost, 0, nullptr, 0, nullptr);
+
+		// The next tick writes the particles from a later submission on this queue, it must not overtake the copy
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record checkpoint command buffer!");
+		}
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+
+		vkResetFences(device.GetVKDevice(), 1, &fence);
+		if (vkQueueSubmit(device.GetComputeQueue(), 1, &submitInfo, fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit checkpoint command buffer!");
+		}
+
+		state.store(SaveState::InFlight, std::memory_order_release);
+		return true;
+	}
+
+	void ParticleCheckpoint::Poll()
+	{
+		if (state.load(std::memory_order_acquire) != SaveState::InFlight)
+		{
+			return;
+		}
+
+		if (vkGetFenceStatus(device.GetVKDevice(), fence) != VK_SUCCESS)
+		{
+			return;
+		}
+
+		state.store(SaveState::Writing, std::memory_order_release);
+		writerThread = std::thread(&ParticleCheckpoint::Write, this);
+	}
+
+	const CheckpointHeader& ParticleCheckpoint::ReadHeader(const MappedFile& file)
+	{
+		if (file.GetSize() < sizeof(CheckpointHeader))
+		{
+			throw std::runtime_error("ERROR: " + file.GetFilePath() + " is not a checkpoint file!");
+		}
+
+		const CheckpointHeader& fileHeader = *reinterpret_cast<const CheckpointHeader*>(file.GetData());
+		if (std::memcmp(fileHeader.magic, MAGIC, sizeof(MAGIC)) != 0)
+		{
+			throw std::runtime_error("ERROR: " + file.GetFilePath() + " is not a checkpoint file!");
+		}
+
+		if (fileHeader.version != VERSION || fileHeader.headerSize != sizeof(CheckpointHeader))
+		{
+			throw std::runtime_error("ERROR: " + file.GetFilePath() + " has checkpoint version " + std::to_string(fileHeader.version) + ", expected " + std::to_string(VERSION) + "!");
+		}
+
+		if (fileHeader.layout != ParticleLayout::PositionVelocityVec2 || fileHeader.particleStride != sizeof(Particle))
+		{
+			throw std::runtime_error("ERROR: " + file.GetFilePath() + " has an unsupported particle layout!");
+		}
+
+		// Truncated files are rejected instead of restoring a partial state
+		const uint64_t dataSize = fileHeader.particleCount * fileHeader.particleStride;
+		if (fileHeader.particleCount == 0 || dataSize / fileHeader.particleStride != fileHeader.particleCount || file.GetSize() - sizeof(CheckpointHeader) < dataSize)
+		{
+			throw std::runtime_error("ERROR: " + file.GetFilePath() + " is truncated or has an invalid particle count!");
+		}
+
+		return fileHeader;
+	}
+
+	const void* ParticleCheckpoint::GetParticleData(const MappedFile& file)
+	{
+		return file.GetData() + ReadHeader(file).headerSize;
+	}
+
+	void ParticleCheckpoint::CreateReadbackBuffer(VkDeviceSize size)
+	{
+		readbackBufferSize = size;
+
+		// Prefer cached memory, CPU reads from uncached memory are an order of magnitude slower
+		VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		{
+			VkPhysicalDeviceMemoryProperties memoryProperties;
+			vkGetPhysicalDeviceMemoryProperties(device.GetPhysicalDevice(), &memoryProperties);
+
+			const VkMemoryPropertyFlags cachedProperties = properties | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+			{
+				if ((memoryProperties.memoryTypes[i].propertyFlags & cachedProperties) == cachedProperties)
+				{
+					properties = cachedProperties;
+					break;
+				}
+			}
+		}
+
+		device.CreateBuffer(
+			readbackBufferSize,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			properties,
+			readbackBuffer,
+			readbackBufferMemory
+		);
+
+		// Persistently mapped
+		vkMapMemory(device.GetVKDevice(), readbackBufferMemory, 0, readbackBufferSize, 0, &readbackBufferMapped);
+	}
+
+	void ParticleCheckpoint::CleanupReadbackBuffer()
+	{
+		if (readbackBuffer == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		vkUnmapMemory(device.GetVKDevice(), readbackBufferMemory);
+		vkDestroyBuffer(device.GetVKDevice(), readbackBuffer, nullptr);
+		vkFreeMemory(device.GetVKDevice(), readbackBufferMemory, nullptr);
+
+		readbackBuffer = VK_NULL_HANDLE;
+		readbackBufferMemory = VK_NULL_HANDLE;
+		readbackBufferMapped = nullptr;
+		readbackBufferSize = 0;
+	}
+
+	// Runs on the writer thread, the readback buffer is not touched by the render loop until the state goes back to Idle
+	void ParticleCheckpoint::Write()
+	{
+		try
+		{
+			MappedFile file(filePath, MappedFileMode::Write, sizeof(CheckpointHeader) + static_cast<size_t>(readbackBufferSize));
+			std::memcpy(file.GetData(), &header, sizeof(CheckpointHeader));
+			std::memcpy(file.GetData() + sizeof(CheckpointHeader), readbackBufferMapped, static_cast<size_t>(readbackBufferSize));
+			file.Flush();
+
+			std::cout << "Checkpoint saved to " << filePath << ": " << header.particleCount << " particles in "
+				<< TimeToMilliseconds<double>(Time::Now() - saveStartTime) << "ms" << std::endl;
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << e.what() << std::endl;
+		}
+
+		state.store(SaveState::Idle, std::memory_order_release);
+	}
+
+} // namespace VulkanCore
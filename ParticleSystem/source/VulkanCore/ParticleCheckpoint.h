@@ -0,0 +1,103 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "GPUDevice.h"
+#include "MappedFile.h"
+#include "Time.h"
+
+namespace VulkanCore {
+
+	// Memory layout of the particle data in a checkpoint, bump when Particle changes
+	enum class ParticleLayout : uint32_t
+	{
+		PositionVelocityVec2 = 0	// array of { vec2 position; vec2 velocity; }
+	};
+
+	struct CheckpointHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t headerSize;		// particle data starts right after the header
+		ParticleLayout layout;
+		uint32_t particleStride;
+		uint32_t seed;				// seed of the simulation the state was taken from, informational
+		uint64_t particleCount;
+	};
+
+	// Simulation snapshots
+	// Saving copies the particle storage buffer into a host-visible readback buffer on the compute queue right behind the simulation step.
+	// The copy is polled with a fence and a writer thread stores it through a memory mapped file, the render loop never waits on it.
+	// Restoring maps the file and uploads the particle data straight from the mapping.
+	class ParticleCheckpoint final
+	{
+	public:
+		static constexpr char MAGIC[4] = { 'P', 'S', 'C', 'K' };
+		static constexpr uint32_t VERSION = 1;
+
+		// Constructor
+		ParticleCheckpoint(GPUDevice& device);
+
+		// Destructor
+		~ParticleCheckpoint();
+
+		// Not copyable
+		ParticleCheckpoint(const ParticleCheckpoint&) = delete;
+		ParticleCheckpoint& operator = (const ParticleCheckpoint&) = delete;
+
+		// Not moveable
+		ParticleCheckpoint(ParticleCheckpoint&&) = delete;
+		ParticleCheckpoint& operator = (ParticleCheckpoint&&) = delete;
+
+		// Submits the readback of shaderStorageBuffer, call after the simulation step of the frame has been submitted
+		// Returns false if the previous checkpoint is still being saved
+		bool Save(const std::string& filePath, VkBuffer shaderStorageBuffer, uint32_t particleCount, uint32_t seed);
+
+		// Hands a finished readback to the writer thread, never blocks
+		void Poll();
+
+		// Throws std::runtime_error if the file is not a checkpoint this build can restore
+		static const CheckpointHeader& ReadHeader(const MappedFile& file);
+		static const void* GetParticleData(const MappedFile& file);
+
+		// Getters
+		inline bool GetIsSaving() const { return state.load(std::memory_order_acquire) != SaveState::Idle; }
+
+	private:
+		enum class SaveState : uint32_t
+		{
+			Idle = 0,
+			InFlight,		// copy submitted, waiting for the GPU
+			Writing			// owned by the writer thread
+		};
+
+		GPUDevice& device;
+
+		// Readback
+		VkBuffer readbackBuffer;
+		VkDeviceMemory readbackBufferMemory;
+		void* readbackBufferMapped;
+		VkDeviceSize readbackBufferSize;
+		VkCommandBuffer commandBuffer;
+		VkFence fence;
+
+		std::atomic<SaveState> state;
+		std::string filePath;
+		CheckpointHeader header;
+		Time saveStartTime;
+
+		// Writer thread
+		std::thread writerThread;
+
+		void CreateReadbackBuffer(VkDeviceSize size);
+		void CleanupReadbackBuffer();
+
+		void Write();
+	};
+
+} // namespace VulkanCore
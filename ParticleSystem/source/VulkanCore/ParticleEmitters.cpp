@@ -0,0 +1,336 @@
+#include "ParticleEmitters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <string>
+
+#include <glm/gtc/constants.hpp>
+
+#include "Particle.h"
+
+namespace VulkanCore {
+
+	const std::array<ParticleEmitters::EmitterSource, ParticleEmitters::EMITTER_COUNT> ParticleEmitters::SOURCES = { {
+		{ glm::vec2(-1.2f, -0.95f), glm::vec2(0.35f, 1.6f), 0.3f, 0.0f },
+		{ glm::vec2(0.0f, -0.95f), glm::vec2(0.0f, 1.9f), 0.15f, 0.0f },
+		{ glm::vec2(1.2f, -0.95f), glm::vec2(-0.35f, 1.6f), 0.3f, 0.0f },
+		{ glm::vec2(0.0f, 0.4f), glm::vec2(0.9f, 0.0f), 0.1f, 1.5f }
+	} };
+
+	ParticleEmitters::ParticleEmitters(GPUDevice& device)
+		: device(device)
+		, parameters({ 3.0f, 1.0f, 1.5f })
+		, particleBuffer(VK_NULL_HANDLE)
+		, capacity(0)
+		, uniformBuffer(VK_NULL_HANDLE)
+		, uniformBufferSize(0)
+		, bHasBuffers(false)
+		, bNeedsInit(false)
+		, aliveIndex(0)
+		, emitterBufferMapped(nullptr)
+		, emitRemainders({})
+		, emitTime(0.0)
+		, emitSeed(0)
+		, argsReadbackBufferMapped(nullptr)
+		, readbackAliveIndex(0)
+		, bHasPendingCounters(false)
+		, bHasCounters(false)
+		, counters({})
+		, descriptorSet(VK_NULL_HANDLE)
+		, drawDescriptorSet(VK_NULL_HANDLE)
+	{
+#if defined(PLATFORM_WINDOWS) || (defined(PLATFORM_LINUX) && defined(NDEBUG))
+		static const std::string emitterShaderFilePath = "shaders/particle_emitter.comp.spv";
+#elif defined(PLATFORM_LINUX) && defined(DEBUG)
+		static const std::string emitterShaderFilePath = "ParticleSystem/shaders/particle_emitter.comp.spv";
+#endif
+
+		descriptorSetLayout = DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// particles
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// lives
+			.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// dead list
+			.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// alive lists
+			.AddBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// indirect args
+			.AddBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// emitters
+			.Build();
+
+		drawDescriptorSetLayout = DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1)
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1)		// particles
+			.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 1)		// alive lists
+			.Build();
+
+		pipeline = std::make_unique<Pipeline>(device, descriptorSetLayout->GetDescriptorSetLayout(), emitterShaderFilePath, static_cast<uint32_t>(sizeof(EmitterPushConstants)));
+
+		// Independent of the particle count
+		const VkDeviceSize emitterBufferSize = sizeof(EmitterData) * EMITTER_COUNT;
+		emitterBuffer.Create(device, emitterBufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		vkMapMemory(device.GetVKDevice(), emitterBuffer.memory, 0, emitterBufferSize, 0, &emitterBufferMapped);
+
+		argsReadbackBuffer.Create(device, sizeof(EmitterIndirectArgs), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		vkMapMemory(device.GetVKDevice(), argsReadbackBuffer.memory, 0, sizeof(EmitterIndirectArgs), 0, &argsReadbackBufferMapped);
+	}
+
+	ParticleEmitters::~ParticleEmitters()
+	{
+		CleanupBuffers();
+		emitterBuffer.Cleanup(device);
+		argsReadbackBuffer.Cleanup(device);
+	}
+
+	void ParticleEmitters::SetParticles(VkBuffer newParticleBuffer, uint32_t newCapacity)
+	{
+		CleanupBuffers();
+
+		particleBuffer = newParticleBuffer;
+		capacity = newCapacity;
+
+		bHasPendingCounters = false;
+		bHasCounters = false;
+		counters = {};
+	}
+
+	void ParticleEmitters::SetUniformBuffer(VkBuffer newUniformBuffer, VkDeviceSize newUniformBufferSize)
+	{
+		uniformBuffer = newUniformBuffer;
+		uniformBufferSize = newUniformBufferSize;
+	}
+
+	void ParticleEmitters::CreateDrawPipeline(VkRenderPass renderPass, VkSampleCountFlagBits sampleCount)
+	{
+#if defined(PLATFORM_WINDOWS) || (defined(PLATFORM_LINUX) && defined(NDEBUG))
+		static const std::string vertShaderFilePath = "shaders/particle_emitter.vert.spv";
+		static const std::string fragShaderFilePath = "shaders/particle.frag.spv";
+#elif defined(PLATFORM_LINUX) && defined(DEBUG)
+		static const std::string vertShaderFilePath = "ParticleSystem/shaders/particle_emitter.vert.spv";
+		static const std::string fragShaderFilePath = "ParticleSystem/shaders/particle.frag.spv";
+#endif
+
+		drawPipeline = std::make_unique<Pipeline>(device, renderPass, sampleCount, drawDescriptorSetLayout->GetDescriptorSetLayout(), vertShaderFilePath, fragShaderFilePath);
+	}
+
+	void ParticleEmitters::RecordEmit(VkCommandBuffer commandBuffer, float seconds)
+	{
+		if (!bHasBuffers)
+		{
+			CreateBuffers();
+		}
+
+		pipeline->BindComputePipeline(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetComputePipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+
+		// Every slot starts on the dead list
+		if (bNeedsInit)
+		{
+			aliveIndex = 0;
+			emitRemainders.fill(0.0);
+			emitTime = 0.0;
+			bNeedsInit = false;
+
+			EmitterPushConstants pushConstants = {};
+			pushConstants.capacity = capacity;
+			DispatchPass(commandBuffer, pushConstants, EmitterPass::Init, capacity);
+		}
+
+		EmitterPushConstants pushConstants = {};
+		pushConstants.capacity = capacity;
+		pushConstants.emitterCount = EMITTER_COUNT;
+		pushConstants.aliveIndex = aliveIndex;
+
+		// The pool is refilled once per lifetime at an emission of 1, the fractions carry over to the next tick
+		const double emitRate = static_cast<double>(parameters.emission) * capacity / std::max(parameters.lifetime, 0.01f) / EMITTER_COUNT;
+		emitTime += seconds;
+
+		EmitterData* emitters = static_cast<EmitterData*>(emitterBufferMapped);
+		uint32_t emitCount = 0;
+		for (uint32_t i = 0; i < EMITTER_COUNT; ++i)
+		{
+			emitRemainders[i] += emitRate * seconds;
+			const uint32_t count = std::min(static_cast<uint32_t>(emitRemainders[i]), capacity - emitCount);
+			emitRemainders[i] -= count;
+
+			const float angle = static_cast<float>(std::fmod(SOURCES[i].spin * emitTime, 2.0 * glm::pi<double>()));
+			const glm::vec2& velocity = SOURCES[i].velocity;
+
+			emitters[i].position = SOURCES[i].position;
+			emitters[i].velocity = glm::vec2(std::cos(angle) * velocity.x - std::sin(angle) * velocity.y, std::sin(angle) * velocity.x + std::cos(angle) * velocity.y);
+			emitters[i].spread = SOURCES[i].spread;
+			emitters[i].lifetime = parameters.lifetime;
+			emitters[i].firstEmit = emitCount;
+			emitters[i].emitCount = count;
+			emitCount += count;
+		}
+
+		// More emits than free slots only drain the dead list, the rest are dropped on the GPU
+		if (emitCount > 0)
+		{
+			pushConstants.emitCount = emitCount;
+			pushConstants.seed = ++emitSeed * 2654435769u;
+			DispatchPass(commandBuffer, pushConstants, EmitterPass::Emit, emitCount);
+		}
+	}
+
+	void ParticleEmitters::RecordStep(VkCommandBuffer commandBuffer, float timestep, glm::vec2 attractor, bool bAttractorEnabled, bool bIsLastStep)
+	{
+		pipeline->BindComputePipeline(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetComputePipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+
+		EmitterPushConstants pushConstants = {};
+		pushConstants.capacity = capacity;
+		pushConstants.emitterCount = EMITTER_COUNT;
+		pushConstants.attractor = attractor;
+		pushConstants.attractorEnabled = bAttractorEnabled ? 1 : 0;
+		pushConstants.timestep = timestep;
+		pushConstants.gravity = parameters.gravity;
+		pushConstants.aliveIndex = aliveIndex;
+
+		// The GPU sizes the dispatch to the particles still alive, the CPU only knows the pool
+		DispatchPass(commandBuffer, pushConstants, EmitterPass::Args, 1);
+		RecordBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+		DispatchPassIndirect(commandBuffer, pushConstants, EmitterPass::Simulate);
+		aliveIndex = 1 - aliveIndex;
+
+		if (!bIsLastStep)
+		{
+			return;
+		}
+
+		// The args are copied for the UI only, the draw reads the alive count straight from the args buffer
+		RecordBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+
+		VkBufferCopy region = {};
+		region.size = sizeof(EmitterIndirectArgs);
+		vkCmdCopyBuffer(commandBuffer, argsBuffer.buffer, argsReadbackBuffer.buffer, 1, &region);
+
+		RecordBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+
+		readbackAliveIndex = aliveIndex;
+		bHasPendingCounters = true;
+	}
+
+	void ParticleEmitters::RecordDraw(VkCommandBuffer commandBuffer)
+	{
+		// Nothing was emitted yet
+		if (!bHasBuffers)
+		{
+			return;
+		}
+
+		drawPipeline->BindGraphicsPipeline(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline->GetGraphicsPipelineLayout(), 0, 1, &drawDescriptorSet, 0, nullptr);
+		vkCmdDrawIndirect(commandBuffer, argsBuffer.buffer, offsetof(EmitterIndirectArgs, aliveDraws) + sizeof(VkDrawIndirectCommand) * aliveIndex, 1, sizeof(VkDrawIndirectCommand));
+	}
+
+	void ParticleEmitters::Poll()
+	{
+		if (!bHasPendingCounters)
+		{
+			return;
+		}
+
+		const EmitterIndirectArgs& args = *static_cast<const EmitterIndirectArgs*>(argsReadbackBufferMapped);
+		counters.aliveCount = args.aliveDraws[readbackAliveIndex].vertexCount;
+		counters.deadCount = args.deadCount;
+		counters.simulateGroupCount = args.simulateDispatch.x;
+		bHasPendingCounters = false;
+		bHasCounters = true;
+	}
+
+	void ParticleEmitters::CreateBuffers()
+	{
+		const VkDeviceSize slots = static_cast<VkDeviceSize>(std::max(capacity, 1u));
+
+		lifeBuffer.Create(device, sizeof(glm::vec2) * slots, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		deadListBuffer.Create(device, sizeof(uint32_t) * slots, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		aliveListBuffer.Create(device, sizeof(uint32_t) * slots * 2, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		argsBuffer.Create(device, sizeof(EmitterIndirectArgs), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		descriptorPool = DescriptorPool::Builder(device)
+			.SetMaxSets(2)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 8)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1)
+			.Build();
+
+		const VkDescriptorBufferInfo particleBufferInfo = { particleBuffer, 0, sizeof(Particle) * static_cast<VkDeviceSize>(capacity) };
+		const VkDescriptorBufferInfo lifeBufferInfo = { lifeBuffer.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo deadListBufferInfo = { deadListBuffer.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo aliveListBufferInfo = { aliveListBuffer.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo argsBufferInfo = { argsBuffer.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo emitterBufferInfo = { emitterBuffer.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo uniformBufferInfo = { uniformBuffer, 0, uniformBufferSize };
+
+		DescriptorWriter(*descriptorSetLayout, *descriptorPool)
+			.WriteBuffer(0, particleBufferInfo)
+			.WriteBuffer(1, lifeBufferInfo)
+			.WriteBuffer(2, deadListBufferInfo)
+			.WriteBuffer(3, aliveListBufferInfo)
+			.WriteBuffer(4, argsBufferInfo)
+			.WriteBuffer(5, emitterBufferInfo)
+			.Build(descriptorSet);
+
+		DescriptorWriter(*drawDescriptorSetLayout, *descriptorPool)
+			.WriteBuffer(0, uniformBufferInfo)
+			.WriteBuffer(1, particleBufferInfo)
+			.WriteBuffer(2, aliveListBufferInfo)
+			.Build(drawDescriptorSet);
+
+		bHasBuffers = true;
+		bNeedsInit = true;
+	}
+
+	void ParticleEmitters::CleanupBuffers()
+	{
+		if (!bHasBuffers)
+		{
+			return;
+		}
+
+		descriptorPool.reset();
+		descriptorSet = VK_NULL_HANDLE;
+		drawDescriptorSet = VK_NULL_HANDLE;
+
+		lifeBuffer.Cleanup(device);
+		deadListBuffer.Cleanup(device);
+		aliveListBuffer.Cleanup(device);
+		argsBuffer.Cleanup(device);
+
+		bHasBuffers = false;
+	}
+
+	// Every pass reads what the previous one wrote
+	void ParticleEmitters::DispatchPass(VkCommandBuffer commandBuffer, EmitterPushConstants& pushConstants, EmitterPass pass, uint32_t invocationCount)
+	{
+		PushPass(commandBuffer, pushConstants, pass);
+		vkCmdDispatch(commandBuffer, (invocationCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+		RecordBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+	}
+
+	// The group count comes from the args buffer, the next args pass must not overwrite it before the dispatch read it
+	void ParticleEmitters::DispatchPassIndirect(VkCommandBuffer commandBuffer, EmitterPushConstants& pushConstants, EmitterPass pass)
+	{
+		PushPass(commandBuffer, pushConstants, pass);
+		vkCmdDispatchIndirect(commandBuffer, argsBuffer.buffer, offsetof(EmitterIndirectArgs, simulateDispatch));
+
+		RecordBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+	}
+
+	void ParticleEmitters::PushPass(VkCommandBuffer commandBuffer, EmitterPushConstants& pushConstants, EmitterPass pass)
+	{
+		pushConstants.pass = static_cast<uint32_t>(pass);
+		vkCmdPushConstants(commandBuffer, pipeline->GetComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(EmitterPushConstants), &pushConstants);
+	}
+
+	void ParticleEmitters::RecordBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask)
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = srcAccessMask;
+		barrier.dstAccessMask = dstAccessMask;
+		vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "GPUDevice.h"
+#include "Descriptor.h"
+#include "Pipeline.h"
+#include "StorageBuffer.h"
+
+namespace VulkanCore {
+
+	// Push constants of particle_emitter.comp
+	struct EmitterPushConstants
+	{
+		uint32_t capacity;
+		uint32_t emitCount;
+		uint32_t emitterCount;
+		uint32_t seed;
+		glm::vec2 attractor;
+		uint32_t attractorEnabled;
+		float timestep;
+		float gravity;
+		uint32_t pass;
+		uint32_t aliveIndex;
+	};
+
+	// std430 layout of particle_emitter.comp
+	struct EmitterData
+	{
+		glm::vec2 position;
+		glm::vec2 velocity;
+		float spread;
+		float lifetime;
+		uint32_t firstEmit;			// emits [firstEmit, firstEmit + emitCount) of the tick belong to this emitter
+		uint32_t emitCount;
+	};
+
+	// Matches the args buffer of particle_emitter.comp, written by the GPU and consumed by the indirect commands
+	struct EmitterIndirectArgs
+	{
+		VkDispatchIndirectCommand simulateDispatch;		// over the alive list the next step reads
+		int32_t deadCount;
+		VkDrawIndirectCommand aliveDraws[2];			// one per alive list, the vertex count is the list length
+	};
+
+	static_assert(offsetof(EmitterIndirectArgs, aliveDraws) == 16, "EmitterIndirectArgs has to match the std430 layout of the shader");
+
+	// Read back for display
+	struct EmitterCounters
+	{
+		uint32_t aliveCount;
+		int32_t deadCount;
+		uint32_t simulateGroupCount;		// workgroups the GPU gave the last step
+	};
+
+	struct EmitterParameters
+	{
+		float lifetime;			// mean, in seconds
+		float emission;			// 1 emits the whole pool once per lifetime
+		float gravity;
+	};
+
+	// Spawns and kills particles entirely on the GPU, the particle buffer is a pool of slots
+	// Free slots live on a dead list, the emit pass pops one per new particle with an atomic counter and appends it to the
+	// alive list. Each step sizes its own dispatch from that list on the GPU, so the simulate pass only runs over the living
+	// particles, pushes the expired ones back and compacts the survivors into a second alive list. The particles are drawn
+	// from the list of the last step by an indirect draw whose vertex count the simulate pass wrote, the live count is never
+	// read on the hot path.
+	class ParticleEmitters final
+	{
+	public:
+		// Matches particle_emitter.comp
+		static constexpr uint32_t WORKGROUP_SIZE = 64;
+
+		static constexpr uint32_t EMITTER_COUNT = 4;
+
+		// Constructor
+		ParticleEmitters(GPUDevice& device);
+
+		// Destructor
+		~ParticleEmitters();
+
+		// Not copyable
+		ParticleEmitters(const ParticleEmitters&) = delete;
+		ParticleEmitters& operator = (const ParticleEmitters&) = delete;
+
+		// Not moveable
+		ParticleEmitters(ParticleEmitters&&) = delete;
+		ParticleEmitters& operator = (ParticleEmitters&&) = delete;
+
+		// Call with the GPU idle whenever the particle buffer is recreated, every slot starts dead
+		void SetParticles(VkBuffer particleBuffer, uint32_t capacity);
+
+		// Bound by the draw, set once before the first draw
+		void SetUniformBuffer(VkBuffer uniformBuffer, VkDeviceSize uniformBufferSize);
+
+		inline void SetParameters(const EmitterParameters& newParameters) { parameters = newParameters; }
+
+		// The draw pipeline is baked against the swap chain render pass, call after its attachments change
+		void CreateDrawPipeline(VkRenderPass renderPass, VkSampleCountFlagBits sampleCount);
+
+		// Records the particles born over seconds, once per tick before its steps
+		void RecordEmit(VkCommandBuffer commandBuffer, float seconds);
+
+		// Records one step of timestep seconds, dispatched indirectly over the alive list the previous step left
+		void RecordStep(VkCommandBuffer commandBuffer, float timestep, glm::vec2 attractor, bool bAttractorEnabled, bool bIsLastStep);
+
+		// Draws the alive list of the last step inside the particle subpass
+		void RecordDraw(VkCommandBuffer commandBuffer);
+
+		// Call once per frame after Renderer::SyncNewFrame, picks up the counters of the last tick without waiting
+		void Poll();
+
+		// Getters
+		inline const EmitterParameters& GetParameters() const { return parameters; }
+		inline bool GetHasCounters() const { return bHasCounters; }
+		inline const EmitterCounters& GetCounters() const { return counters; }
+
+	private:
+		// particle_emitter.comp passes
+		enum class EmitterPass : uint32_t
+		{
+			Init = 0,
+			Emit,
+			Simulate,
+			Args
+		};
+
+		// Fountains along the floor and a sprinkler turning in the middle
+		struct EmitterSource
+		{
+			glm::vec2 position;
+			glm::vec2 velocity;
+			float spread;			// radians
+			float spin;				// radians per second the velocity turns by
+		};
+
+		static const std::array<EmitterSource, EMITTER_COUNT> SOURCES;
+
+		GPUDevice& device;
+
+		EmitterParameters parameters;
+
+		VkBuffer particleBuffer;
+		uint32_t capacity;
+		VkBuffer uniformBuffer;
+		VkDeviceSize uniformBufferSize;
+
+		// Buffers, initialized by the first emit
+		bool bHasBuffers;
+		bool bNeedsInit;
+
+		StorageBuffer lifeBuffer;				// vec2(age, lifetime) per slot
+		StorageBuffer deadListBuffer;
+		StorageBuffer aliveListBuffer;			// two lists of capacity slots
+		StorageBuffer argsBuffer;				// EmitterIndirectArgs
+
+		// Alive list the next step reads, the other one is written, the draw reads this one after the last step
+		uint32_t aliveIndex;
+
+		// Written by the host every tick, SyncNewFrame waited for the tick that read it
+		StorageBuffer emitterBuffer;
+		void* emitterBufferMapped;
+
+		// Emission
+		std::array<double, EMITTER_COUNT> emitRemainders;
+		double emitTime;
+		uint32_t emitSeed;
+
+		// Args of the last step, read a frame later
+		StorageBuffer argsReadbackBuffer;
+		void* argsReadbackBufferMapped;
+		uint32_t readbackAliveIndex;
+		bool bHasPendingCounters;
+		bool bHasCounters;
+		EmitterCounters counters;
+
+		// Descriptors
+		std::unique_ptr<DescriptorSetLayout> descriptorSetLayout;
+		std::unique_ptr<DescriptorSetLayout> drawDescriptorSetLayout;
+		std::unique_ptr<DescriptorPool> descriptorPool;
+		VkDescriptorSet descriptorSet;
+		VkDescriptorSet drawDescriptorSet;
+
+		std::unique_ptr<Pipeline> pipeline;
+		std::unique_ptr<Pipeline> drawPipeline;
+
+		void CreateBuffers();
+		void CleanupBuffers();
+
+		void DispatchPass(VkCommandBuffer commandBuffer, EmitterPushConstants& pushConstants, EmitterPass pass, uint32_t invocationCount);
+		void DispatchPassIndirect(VkCommandBuffer commandBuffer, EmitterPushConstants& pushConstants, EmitterPass pass);
+		void PushPass(VkCommandBuffer commandBuffer, EmitterPushConstants& pushConstants, EmitterPass pass);
+
+		static void RecordBarrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkAccessFlags srcAccessMask, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask);
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,295 @@
+#include "ParticleImporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "JobSystem.h"
+
+namespace VulkanCore {
+
+	const ImportBounds ParticleImporter::DEFAULT_BOUNDS = { glm::vec2(-16.0f, -16.0f), glm::vec2(16.0f, 16.0f) };
+
+	namespace {
+
+		// Below this much work per thread, splitting it into jobs costs more than it saves
+		constexpr uint64_t MIN_BYTES_PER_THREAD = 1 << 20;
+		constexpr uint64_t MIN_PARTICLES_PER_THREAD = 1 << 16;
+
+		inline bool IsDelimiter(char c)
+		{
+			return c == ',' || c == ';' || c == ' ' || c == '\t' || c == '\r';
+		}
+
+		inline bool IsNumberStart(char c)
+		{
+			return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.';
+		}
+
+		struct ParseError
+		{
+			const char* position = nullptr;
+			std::string message;
+		};
+
+		// Parses the complete lines in [begin, end), stops at the first invalid line
+		void ParseLines(const char* begin, const char* end, const ImportBounds& bounds, std::vector<Particle>& out, ParseError& error)
+		{
+			// Roughly 40 bytes per line, one reallocation at most for typical files
+			out.reserve(static_cast<size_t>(end - begin) / 32);
+
+			const char* lineBegin = begin;
+			while (lineBegin < end)
+			{
+				const char* lineEnd = static_cast<const char*>(std::memchr(lineBegin, '\n', static_cast<size_t>(end - lineBegin)));
+				if (lineEnd == nullptr)
+				{
+					lineEnd = end;
+				}
+
+				const char* cursor = lineBegin;
+				while (cursor < lineEnd && IsDelimiter(*cursor))
+				{
+					++cursor;
+				}
+
+				// Empty lines and comments
+				if (cursor == lineEnd || *cursor == '#')
+				{
+					lineBegin = lineEnd + 1;
+					continue;
+				}
+
+				float values[4] = {};
+				uint32_t valueCount = 0;
+				while (cursor < lineEnd)
+				{
+					if (valueCount == 4)
+					{
+						error = { lineBegin, "expected 2 or 4 values" };
+						return;
+					}
+
+					// from_chars does not accept an explicit plus sign
+					if (*cursor == '+')
+					{
+						++cursor;
+					}
+
+					const std::from_chars_result result = std::from_chars(cursor, lineEnd, values[valueCount]);
+					if (result.ec != std::errc())
+					{
+						error = { lineBegin, "invalid number" };
+						return;
+					}
+					++valueCount;
+
+					cursor = result.ptr;
+					if (cursor < lineEnd && !IsDelimiter(*cursor))
+					{
+						error = { lineBegin, "invalid number" };
+						return;
+					}
+
+					while (cursor < lineEnd && IsDelimiter(*cursor))
+					{
+						++cursor;
+					}
+				}
+
+				if (valueCount != 2 && valueCount != 4)
+				{
+					error = { lineBegin, "expected 2 or 4 values" };
+					return;
+				}
+
+				Particle particle = {};
+				particle.position = glm::vec2(values[0], values[1]);
+				particle.velocity = glm::vec2(values[2], values[3]);
+
+				if (!std::isfinite(particle.velocity.x) || !std::isfinite(particle.velocity.y)
+					|| !(particle.position.x >= bounds.minimum.x && particle.position.x <= bounds.maximum.x)
+					|| !(particle.position.y >= bounds.minimum.y && particle.position.y <= bounds.maximum.y))
+				{
+					error = { lineBegin, "particle is outside of the import bounds or not finite" };
+					return;
+				}
+
+				out.push_back(particle);
+				lineBegin = lineEnd + 1;
+			}
+		}
+
+	} // namespace
+
+	ParticleImporter::ParticleImporter(const std::string& filePath, const ImportBounds& bounds)
+		: filePath(filePath)
+		, file(std::nullopt)
+		, particles(nullptr)
+		, particleCount(0)
+	{
+		file.emplace(filePath, MappedFileMode::Read);
+
+		const bool bIsCSV = filePath.size() >= 4 && filePath.compare(filePath.size() - 4, 4, ".csv") == 0;
+		if (bIsCSV)
+		{
+			ImportCSV(bounds);
+
+			// The particles now live in parsedParticles
+			file = std::nullopt;
+		}
+		else
+		{
+			ImportBinary(bounds);
+		}
+
+		if (particleCount == 0)
+		{
+			throw std::runtime_error("ERROR: " + filePath + " contains no particles!");
+		}
+	}
+
+	// The mapping is used as is, the particles are only copied once into the staging buffer
+	void ParticleImporter::ImportBinary(const ImportBounds& bounds)
+	{
+		if (file->GetSize() % sizeof(Particle) != 0)
+		{
+			throw std::runtime_error("ERROR: " + filePath + " is not an array of particles, its size is not a multiple of " + std::to_string(sizeof(Particle)) + " bytes!");
+		}
+
+		particles = reinterpret_cast<const Particle*>(file->GetData());
+		particleCount = file->GetSize() / sizeof(Particle);
+
+		std::atomic<uint64_t> firstInvalid = particleCount;
+		JobSystem::GetInstance().ParallelFor(particleCount, MIN_PARTICLES_PER_THREAD, [this, &bounds, &firstInvalid](uint64_t first, uint64_t end)
+		{
+			const uint64_t invalid = first + Validate(particles + first, end - first, bounds);
+			if (invalid == end)
+			{
+				return;
+			}
+
+			// Keep the lowest index, batches finish in any order
+			uint64_t current = firstInvalid.load(std::memory_order_relaxed);
+			while (invalid < current && !firstInvalid.compare_exchange_weak(current, invalid, std::memory_order_relaxed))
+			{
+			}
+		});
+
+		const uint64_t invalid = firstInvalid.load(std::memory_order_relaxed);
+		if (invalid != particleCount)
+		{
+			throw std::runtime_error("ERROR: " + filePath + ": particle " + std::to_string(invalid) + " is outside of the import bounds or not finite!");
+		}
+	}
+
+	// The file is split at line boundaries, every thread parses its own range into its own array
+	void ParticleImporter::ImportCSV(const ImportBounds& bounds)
+	{
+		const char* const begin = reinterpret_cast<const char*>(file->GetData());
+		const char* const end = begin + file->GetSize();
+
+		// Header line
+		const char* dataBegin = begin;
+		while (dataBegin < end)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(dataBegin, '\n', static_cast<size_t>(end - dataBegin)));
+			lineEnd = lineEnd != nullptr ? lineEnd : end;
+
+			const char* cursor = dataBegin;
+			while (cursor < lineEnd && IsDelimiter(*cursor))
+			{
+				++cursor;
+			}
+
+			if (cursor != lineEnd && *cursor != '#')
+			{
+				if (!IsNumberStart(*cursor))
+				{
+					dataBegin = lineEnd + 1;
+				}
+				break;
+			}
+
+			dataBegin = lineEnd + 1;
+		}
+		dataBegin = std::min(dataBegin, end);
+
+		const uint32_t threadCount = GetThreadCount(static_cast<uint64_t>(end - dataBegin), MIN_BYTES_PER_THREAD);
+
+		// Every range but the last ends right after a newline
+		std::vector<const char*> rangeBegins(threadCount + 1, end);
+		rangeBegins[0] = dataBegin;
+		const size_t bytesPerThread = static_cast<size_t>(end - dataBegin) / threadCount;
+		for (uint32_t i = 1; i < threadCount; ++i)
+		{
+			const char* split = std::max(rangeBegins[i - 1], dataBegin + bytesPerThread * i);
+			const char* newline = static_cast<const char*>(std::memchr(split, '\n', static_cast<size_t>(end - split)));
+			rangeBegins[i] = newline != nullptr ? newline + 1 : end;
+		}
+
+		std::vector<std::vector<Particle>> rangeParticles(threadCount);
+		std::vector<ParseError> rangeErrors(threadCount);
+		JobSystem::GetInstance().ParallelFor(threadCount, 1, [&rangeBegins, &bounds, &rangeParticles, &rangeErrors](uint64_t firstRange, uint64_t endRange)
+		{
+			for (uint64_t i = firstRange; i < endRange; ++i)
+			{
+				ParseLines(rangeBegins[i], rangeBegins[i + 1], bounds, rangeParticles[i], rangeErrors[i]);
+			}
+		});
+
+		// Report the first error in the file with its line number, counting lines is only paid on failure
+		for (const ParseError& error : rangeErrors)
+		{
+			if (error.position != nullptr)
+			{
+				const size_t line = static_cast<size_t>(std::count(begin, error.position, '\n')) + 1;
+				throw std::runtime_error("ERROR: " + filePath + ":" + std::to_string(line) + ": " + error.message + "!");
+			}
+		}
+
+		uint64_t totalCount = 0;
+		for (const std::vector<Particle>& range : rangeParticles)
+		{
+			totalCount += range.size();
+		}
+
+		parsedParticles.reserve(static_cast<size_t>(totalCount));
+		for (std::vector<Particle>& range : rangeParticles)
+		{
+			parsedParticles.insert(parsedParticles.end(), range.begin(), range.end());
+			range = std::vector<Particle>();
+		}
+
+		particles = parsedParticles.data();
+		particleCount = parsedParticles.size();
+	}
+
+	uint64_t ParticleImporter::Validate(const Particle* particles, uint64_t count, const ImportBounds& bounds)
+	{
+		for (uint64_t i = 0; i < count; ++i)
+		{
+			const Particle& particle = particles[i];
+
+			// Written so that NaN fails every comparison
+			if (!(particle.position.x >= bounds.minimum.x && particle.position.x <= bounds.maximum.x)
+				|| !(particle.position.y >= bounds.minimum.y && particle.position.y <= bounds.maximum.y)
+				|| !std::isfinite(particle.velocity.x) || !std::isfinite(particle.velocity.y))
+			{
+				return i;
+			}
+		}
+
+		return count;
+	}
+
+	uint32_t ParticleImporter::GetThreadCount(uint64_t workSize, uint64_t minWorkPerThread)
+	{
+		const uint64_t maxThreads = std::max<uint64_t>(workSize / minWorkPerThread, 1);
+		return static_cast<uint32_t>(std::clamp<uint64_t>(JobSystem::GetInstance().GetThreadCount(), 1, maxThreads));
+	}
+
+} // namespace VulkanCore
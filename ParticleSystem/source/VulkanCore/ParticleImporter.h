@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Particle.h"
+
+namespace VulkanCore {
+
+	// Imported positions must lie inside this box, anything else is most likely a unit or column mix-up
+	struct ImportBounds
+	{
+		glm::vec2 minimum;
+		glm::vec2 maximum;
+	};
+
+	// Initial particle state from an external file
+	// *.csv: one particle per line, "x,y" or "x,y,vx,vy" (commas, semicolons, spaces or tabs), a header line and #-comments are skipped
+	// anything else: raw little-endian array of Particle { float x, y, vx, vy }
+	// Binary files are validated in place through a memory mapping, CSV files are split into one range per job system thread
+	class ParticleImporter final
+	{
+	public:
+		static const ImportBounds DEFAULT_BOUNDS;
+
+		// Constructor
+		// Throws std::runtime_error if the file can not be read or a particle is invalid
+		ParticleImporter(const std::string& filePath, const ImportBounds& bounds = DEFAULT_BOUNDS);
+
+		// Destructor
+		~ParticleImporter() = default;
+
+		// Not copyable
+		ParticleImporter(const ParticleImporter&) = delete;
+		ParticleImporter& operator = (const ParticleImporter&) = delete;
+
+		// Not moveable
+		ParticleImporter(ParticleImporter&&) = delete;
+		ParticleImporter& operator = (ParticleImporter&&) = delete;
+
+		// Getters
+		inline const Particle* GetParticles() const { return particles; }
+		inline uint64_t GetParticleCount() const { return particleCount; }
+
+	private:
+		std::string filePath;
+		std::optional<MappedFile> file;
+		std::vector<Particle> parsedParticles;
+
+		const Particle* particles;
+		uint64_t particleCount;
+
+		void ImportBinary(const ImportBounds& bounds);
+		void ImportCSV(const ImportBounds& bounds);
+
+		// Returns the index of the first invalid particle or count if every one is valid
+		static uint64_t Validate(const Particle* particles, uint64_t count, const ImportBounds& bounds);
+
+		static uint32_t GetThreadCount(uint64_t workSize, uint64_t minWorkPerThread);
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,201 @@
+#include "ParticleReorder.h"
+
+#include <algorithm>
+#include <string>
+
+#include "Particle.h"
+
+namespace VulkanCore {
+
+	ParticleReorder::ParticleReorder(GPUDevice& device)
+		: device(device)
+		, particleBuffer(VK_NULL_HANDLE)
+		, particleCount(0)
+		, bHasBuffers(false)
+		, descriptorSets({ VK_NULL_HANDLE, VK_NULL_HANDLE })
+	{
+#if defined(PLATFORM_WINDOWS) || (defined(PLATFORM_LINUX) && defined(NDEBUG))
+		static const std::string reorderShaderFilePath = "shaders/particle_reorder.comp.spv";
+#elif defined(PLATFORM_LINUX) && defined(DEBUG)
+		static const std::string reorderShaderFilePath = "ParticleSystem/shaders/particle_reorder.comp.spv";
+#endif
+
+		descriptorSetLayout = DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// particles
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// source keys
+			.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// source indices
+			.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// destination keys
+			.AddBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// destination indices
+			.AddBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// digit histograms
+			.AddBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// scan block sums
+			.AddBinding(7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// sorted particles
+			.Build();
+
+		pipeline = std::make_unique<Pipeline>(device, descriptorSetLayout->GetDescriptorSetLayout(), reorderShaderFilePath, static_cast<uint32_t>(sizeof(ParticleReorderPushConstants)));
+	}
+
+	ParticleReorder::~ParticleReorder()
+	{
+		CleanupBuffers();
+	}
+
+	void ParticleReorder::SetParticles(VkBuffer newParticleBuffer, uint32_t newParticleCount)
+	{
+		CleanupBuffers();
+
+		particleBuffer = newParticleBuffer;
+		particleCount = newParticleCount;
+	}
+
+	void ParticleReorder::Record(VkCommandBuffer commandBuffer)
+	{
+		if (particleCount == 0)
+		{
+			return;
+		}
+
+		if (!bHasBuffers)
+		{
+			CreateBuffers();
+		}
+
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		const auto recordComputeBarrier = [commandBuffer, &barrier]()
+		{
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		};
+
+		// Anything recorded earlier in the command buffer may still be writing the particles
+		recordComputeBarrier();
+
+		pipeline->BindComputePipeline(commandBuffer);
+
+		ParticleReorderPushConstants pushConstants = {};
+		pushConstants.origin = glm::vec2(-DOMAIN_HALF_WIDTH, -DOMAIN_HALF_HEIGHT);
+		pushConstants.inverseSize = glm::vec2(0.5f / DOMAIN_HALF_WIDTH, 0.5f / DOMAIN_HALF_HEIGHT);
+		pushConstants.particleCount = particleCount;
+		pushConstants.tileCount = GetTileCount();
+		pushConstants.blockCount = GetBlockCount();
+
+		const auto dispatchPass = [this, commandBuffer, &pushConstants, &recordComputeBarrier](ReorderPass pass, uint32_t set, uint32_t workgroupCount)
+		{
+			pushConstants.pass = static_cast<uint32_t>(pass);
+			vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetComputePipelineLayout(), 0, 1, &descriptorSets[set], 0, nullptr);
+			vkCmdPushConstants(commandBuffer, pipeline->GetComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ParticleReorderPushConstants), &pushConstants);
+			vkCmdDispatch(commandBuffer, workgroupCount, 1, 1);
+			recordComputeBarrier();
+		};
+
+		const uint32_t particleWorkgroupCount = (particleCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+		const uint32_t histogramWorkgroupCount = (RADIX * GetTileCount() + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+
+		// The keys are written to the destination of set 1, which is the source of set 0
+		dispatchPass(ReorderPass::Keys, 1, particleWorkgroupCount);
+
+		for (uint32_t digitPass = 0; digitPass < DIGIT_PASS_COUNT; ++digitPass)
+		{
+			const uint32_t set = digitPass % 2;
+			pushConstants.shift = digitPass * RADIX_BITS;
+
+			dispatchPass(ReorderPass::Histogram, set, GetTileCount());
+			dispatchPass(ReorderPass::ScanBlocks, set, GetBlockCount());
+			dispatchPass(ReorderPass::ScanBlockSums, set, 1);
+			dispatchPass(ReorderPass::ScanAdd, set, histogramWorkgroupCount);
+			dispatchPass(ReorderPass::Scatter, set, GetTileCount());
+		}
+
+		// An even number of digit passes leaves the sorted pairs in the source of set 0
+		pushConstants.pass = static_cast<uint32_t>(ReorderPass::Gather);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetComputePipelineLayout(), 0, 1, &descriptorSets[0], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, pipeline->GetComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ParticleReorderPushConstants), &pushConstants);
+		vkCmdDispatch(commandBuffer, particleWorkgroupCount, 1, 1);
+
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		VkBufferCopy region = {};
+		region.size = sizeof(Particle) * static_cast<VkDeviceSize>(particleCount);
+		vkCmdCopyBuffer(commandBuffer, sortedParticleBuffer.buffer, particleBuffer, 1, &region);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	void ParticleReorder::CreateBuffers()
+	{
+		const VkDeviceSize pairSize = sizeof(uint32_t) * static_cast<VkDeviceSize>(particleCount);
+
+		// Vulkan rejects empty buffers
+		const auto createBuffer = [this](VkDeviceSize size, VkBufferUsageFlags usage, StorageBuffer& storageBuffer)
+		{
+			storageBuffer.Create(device, std::max<VkDeviceSize>(size, sizeof(uint32_t)), usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		};
+
+		createBuffer(pairSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, keyBufferA);
+		createBuffer(pairSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, indexBufferA);
+		createBuffer(pairSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, keyBufferB);
+		createBuffer(pairSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, indexBufferB);
+		createBuffer(sizeof(uint32_t) * static_cast<VkDeviceSize>(RADIX * GetTileCount()), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, histogramBuffer);
+		createBuffer(sizeof(uint32_t) * static_cast<VkDeviceSize>(GetBlockCount()), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, blockSumBuffer);
+		createBuffer(sizeof(Particle) * static_cast<VkDeviceSize>(particleCount), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, sortedParticleBuffer);
+
+		descriptorPool = DescriptorPool::Builder(device)
+			.SetMaxSets(2)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * 8)
+			.Build();
+
+		const VkDescriptorBufferInfo particleBufferInfo = { particleBuffer, 0, sizeof(Particle) * static_cast<VkDeviceSize>(particleCount) };
+		const VkDescriptorBufferInfo keyBufferAInfo = { keyBufferA.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo indexBufferAInfo = { indexBufferA.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo keyBufferBInfo = { keyBufferB.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo indexBufferBInfo = { indexBufferB.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo histogramBufferInfo = { histogramBuffer.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo blockSumBufferInfo = { blockSumBuffer.buffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo sortedParticleBufferInfo = { sortedParticleBuffer.buffer, 0, VK_WHOLE_SIZE };
+
+		for (uint32_t set = 0; set < 2; ++set)
+		{
+			const bool bSortsIntoB = set == 0;
+			DescriptorWriter(*descriptorSetLayout, *descriptorPool)
+				.WriteBuffer(0, particleBufferInfo)
+				.WriteBuffer(1, bSortsIntoB ? keyBufferAInfo : keyBufferBInfo)
+				.WriteBuffer(2, bSortsIntoB ? indexBufferAInfo : indexBufferBInfo)
+				.WriteBuffer(3, bSortsIntoB ? keyBufferBInfo : keyBufferAInfo)
+				.WriteBuffer(4, bSortsIntoB ? indexBufferBInfo : indexBufferAInfo)
+				.WriteBuffer(5, histogramBufferInfo)
+				.WriteBuffer(6, blockSumBufferInfo)
+				.WriteBuffer(7, sortedParticleBufferInfo)
+				.Build(descriptorSets[set]);
+		}
+
+		bHasBuffers = true;
+	}
+
+	void ParticleReorder::CleanupBuffers()
+	{
+		if (!bHasBuffers)
+		{
+			return;
+		}
+
+		descriptorPool.reset();
+		descriptorSets = { VK_NULL_HANDLE, VK_NULL_HANDLE };
+
+		keyBufferA.Cleanup(device);
+		indexBufferA.Cleanup(device);
+		keyBufferB.Cleanup(device);
+		indexBufferB.Cleanup(device);
+		histogramBuffer.Cleanup(device);
+		blockSumBuffer.Cleanup(device);
+		sortedParticleBuffer.Cleanup(device);
+
+		bHasBuffers = false;
+	}
+
+} // namespace VulkanCore
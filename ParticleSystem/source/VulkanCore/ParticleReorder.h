@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "GPUDevice.h"
+#include "Descriptor.h"
+#include "Pipeline.h"
+#include "StorageBuffer.h"
+
+namespace VulkanCore {
+
+	// Push constants of particle_reorder.comp
+	struct ParticleReorderPushConstants
+	{
+		glm::vec2 origin;
+		glm::vec2 inverseSize;
+		uint32_t particleCount;
+		uint32_t tileCount;
+		uint32_t pass;
+		uint32_t shift;
+		uint32_t blockCount;
+	};
+
+	// Sorts the particle buffer in place along a Z-order (Morton) curve over the [-2, 2] x [-1, 1] domain
+	// Particles that are close in space end up close in memory, which keeps the simulation reads and the vertex fetches coherent
+	// and the fragments of consecutive particles close on the framebuffer. The particles drift apart again, so the reorder is
+	// meant to run every few ticks. The sort is an LSD radix sort of (key, index) pairs on the GPU, 4 bits per digit, followed
+	// by a gather of the particles into a scratch buffer that is copied back.
+	class ParticleReorder final
+	{
+	public:
+		// Matches particle_reorder.comp
+		static constexpr uint32_t WORKGROUP_SIZE = 128;
+		static constexpr uint32_t TILE_SIZE = 4 * WORKGROUP_SIZE;
+		static constexpr uint32_t SCAN_BLOCK_SIZE = 4 * WORKGROUP_SIZE;
+		static constexpr uint32_t RADIX_BITS = 4;
+		static constexpr uint32_t RADIX = 1u << RADIX_BITS;
+		static constexpr uint32_t KEY_BITS = 24;
+		static constexpr uint32_t DIGIT_PASS_COUNT = KEY_BITS / RADIX_BITS;
+
+		static_assert(DIGIT_PASS_COUNT % 2 == 0, "The sorted pairs have to end up in the buffers the keys were written to");
+
+		static constexpr float DOMAIN_HALF_WIDTH = 2.0f;
+		static constexpr float DOMAIN_HALF_HEIGHT = 1.0f;
+
+		// Constructor
+		ParticleReorder(GPUDevice& device);
+
+		// Destructor
+		~ParticleReorder();
+
+		// Not copyable
+		ParticleReorder(const ParticleReorder&) = delete;
+		ParticleReorder& operator = (const ParticleReorder&) = delete;
+
+		// Not moveable
+		ParticleReorder(ParticleReorder&&) = delete;
+		ParticleReorder& operator = (ParticleReorder&&) = delete;
+
+		// Call with the GPU idle whenever the particle buffer is recreated, the buffers are allocated by the next reorder
+		void SetParticles(VkBuffer particleBuffer, uint32_t particleCount);
+
+		// Records the reorder, the particles can be read by anything recorded or submitted after it
+		void Record(VkCommandBuffer commandBuffer);
+
+	private:
+		// particle_reorder.comp passes
+		enum class ReorderPass : uint32_t
+		{
+			Keys = 0,
+			Histogram,
+			ScanBlocks,
+			ScanBlockSums,
+			ScanAdd,
+			Scatter,
+			Gather
+		};
+
+		GPUDevice& device;
+
+		VkBuffer particleBuffer;
+		uint32_t particleCount;
+		bool bHasBuffers;
+
+		// Sort pairs, the digit passes ping-pong between A and B
+		StorageBuffer keyBufferA;
+		StorageBuffer indexBufferA;
+		StorageBuffer keyBufferB;
+		StorageBuffer indexBufferB;
+
+		StorageBuffer histogramBuffer;
+		StorageBuffer blockSumBuffer;
+		StorageBuffer sortedParticleBuffer;
+
+		// Descriptors, set 0 sorts A into B and set 1 sorts B into A
+		std::unique_ptr<DescriptorSetLayout> descriptorSetLayout;
+		std::unique_ptr<DescriptorPool> descriptorPool;
+		std::array<VkDescriptorSet, 2> descriptorSets;
+
+		std::unique_ptr<Pipeline> pipeline;
+
+		void CreateBuffers();
+		void CleanupBuffers();
+
+		inline uint32_t GetTileCount() const { return (particleCount + TILE_SIZE - 1) / TILE_SIZE; }
+		inline uint32_t GetBlockCount() const { return (RADIX * GetTileCount() + SCAN_BLOCK_SIZE - 1) / SCAN_BLOCK_SIZE; }
+	};
+
+} // namespace VulkanCore
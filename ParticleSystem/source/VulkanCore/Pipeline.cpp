@@ -4,6 +4,8 @@
 #include <iostream>
 #include <array>
 
+#include "JobSystem.h"
+
 namespace VulkanCore {
 
 	const std::vector<VkDynamicState> Pipeline::dynamicStates = {
@@ -11,27 +13,52 @@ namespace VulkanCore {
 		VK_DYNAMIC_STATE_SCISSOR
 	};
 
-	Pipeline::Pipeline(GPUDevice& device, const VkRenderPass& renderPass, const VkDescriptorSetLayout& descriptorSetLayout, const VkVertexInputBindingDescription& bindingDescription, const std::vector<VkVertexInputAttributeDescription>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath)
+	Pipeline::Pipeline(GPUDevice& device, const VkRenderPass& renderPass, VkSampleCountFlagBits sampleCount, const VkDescriptorSetLayout& descriptorSetLayout, const VkVertexInputBindingDescription& bindingDescription, const std::vector<VkVertexInputAttributeDescription>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath)
 		: device(device)
+		, hasGraphicsPipeline(true)
 		, hasComputePipeline(false)
 	{
-		CreateGraphicsPipeline(renderPass, descriptorSetLayout, bindingDescription, attributeDescription, vertexShaderFilePath, fragmentShaderFilePath);
+		CreateGraphicsPipeline(renderPass, sampleCount, descriptorSetLayout, bindingDescription, attributeDescription, vertexShaderFilePath, fragmentShaderFilePath);
 	}
 
-	Pipeline::Pipeline(GPUDevice& device, const VkRenderPass& renderPass, const VkDescriptorSetLayout& descriptorSetLayout, const VkVertexInputBindingDescription& bindingDescription, const std::vector<VkVertexInputAttributeDescription>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath, const std::string& computeShaderFilePath)
+	Pipeline::Pipeline(GPUDevice& device, const VkRenderPass& renderPass, VkSampleCountFlagBits sampleCount, const VkDescriptorSetLayout& descriptorSetLayout, const VkVertexInputBindingDescription& bindingDescription, const std::vector<VkVertexInputAttributeDescription>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath, const std::string& computeShaderFilePath)
 		: device(device)
+		, hasGraphicsPipeline(true)
 		, hasComputePipeline(true)
 	{
-		CreateGraphicsPipeline(renderPass, std::nullopt, bindingDescription, attributeDescription, vertexShaderFilePath, fragmentShaderFilePath);
-		CreateComputePipeline(descriptorSetLayout, computeShaderFilePath);
+		// Both compile their shaders in the driver, the compute pipeline is built on a worker meanwhile
+		JobSystem::GetInstance().ParallelInvoke(
+			[&]() { CreateGraphicsPipeline(renderPass, sampleCount, std::nullopt, bindingDescription, attributeDescription, vertexShaderFilePath, fragmentShaderFilePath); },
+			[&]() { CreateComputePipeline(descriptorSetLayout, computeShaderFilePath); }
+		);
 	}
 
-	Pipeline::Pipeline(GPUDevice& device, const VkRenderPass& renderPass, const VkDescriptorSetLayout& graphicsDescriptorSetLayout, const VkDescriptorSetLayout& computeDescriptorSetLayou, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath, const std::string& computeShaderFilePath)
+	Pipeline::Pipeline(GPUDevice& device, const VkRenderPass& renderPass, VkSampleCountFlagBits sampleCount, const VkDescriptorSetLayout& graphicsDescriptorSetLayout, const VkDescriptorSetLayout& computeDescriptorSetLayou, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath, const std::string& computeShaderFilePath)
 		: device(device)
+		, hasGraphicsPipeline(true)
 		, hasComputePipeline(true)
 	{
-		CreateGraphicsPipeline(renderPass, graphicsDescriptorSetLayout, std::nullopt, std::nullopt, vertexShaderFilePath, fragmentShaderFilePath);
-		CreateComputePipeline(computeDescriptorSetLayou, computeShaderFilePath);
+		// Both compile their shaders in the driver, the compute pipeline is built on a worker meanwhile
+		JobSystem::GetInstance().ParallelInvoke(
+			[&]() { CreateGraphicsPipeline(renderPass, sampleCount, graphicsDescriptorSetLayout, std::nullopt, std::nullopt, vertexShaderFilePath, fragmentShaderFilePath); },
+			[&]() { CreateComputePipeline(computeDescriptorSetLayou, computeShaderFilePath); }
+		);
+	}
+
+	Pipeline::Pipeline(GPUDevice& device, const VkRenderPass& renderPass, VkSampleCountFlagBits sampleCount, const VkDescriptorSetLayout& graphicsDescriptorSetLayout, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath)
+		: device(device)
+		, hasGraphicsPipeline(true)
+		, hasComputePipeline(false)
+	{
+		CreateGraphicsPipeline(renderPass, sampleCount, graphicsDescriptorSetLayout, std::nullopt, std::nullopt, vertexShaderFilePath, fragmentShaderFilePath);
+	}
+
+	Pipeline::Pipeline(GPUDevice& device, const VkDescriptorSetLayout& computeDescriptorSetLayout, const std::string& computeShaderFilePath, uint32_t pushConstantSize)
+		: device(device)
+		, hasGraphicsPipeline(false)
+		, hasComputePipeline(true)
+	{
+		CreateComputePipeline(computeDescriptorSetLayout, computeShaderFilePath, pushConstantSize);
 	}
 
 	Pipeline::~Pipeline()
@@ -42,8 +69,11 @@ namespace VulkanCore {
 			vkDestroyPipelineLayout(device.GetVKDevice(), computePipelineLayout, nullptr);
 		}
 
-		vkDestroyPipeline(device.GetVKDevice(), graphicsPipeline, nullptr);
-		vkDestroyPipelineLayout(device.GetVKDevice(), pipelineLayout, nullptr);
+		if (hasGraphicsPipeline)
+		{
+			vkDestroyPipeline(device.GetVKDevice(), graphicsPipeline, nullptr);
+			vkDestroyPipelineLayout(device.GetVKDevice(), pipelineLayout, nullptr);
+		}
 	}
 
 	void Pipeline::BindComputePipeline(VkCommandBuffer commandBuffer)
@@ -75,7 +105,7 @@ namespace VulkanCore {
 		return buffer;
 	}
 
-	void Pipeline::CreateGraphicsPipeline(const VkRenderPass& renderPass, const std::optional<VkDescriptorSetLayout>& descriptorSetLayout, const std::optional<VkVertexInputBindingDescription>& bindingDescription, const std::optional<std::vector<VkVertexInputAttributeDescription>>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath)
+	void Pipeline::CreateGraphicsPipeline(const VkRenderPass& renderPass, VkSampleCountFlagBits sampleCount, const std::optional<VkDescriptorSetLayout>& descriptorSetLayout, const std::optional<VkVertexInputBindingDescription>& bindingDescription, const std::optional<std::vector<VkVertexInputAttributeDescription>>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath)
 	{
 		// Shader Code
 		std::vector<char> vertShaderCode = ReadFile(vertexShaderFilePath);
@@ -150,7 +180,7 @@ namespace VulkanCore {
 		// Multisampling
 		VkPipelineMultisampleStateCreateInfo multisamplingInfo = {};
 		multisamplingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisamplingInfo.rasterizationSamples = VK_SAMPLE_COUNT_8_BIT;
+		multisamplingInfo.rasterizationSamples = sampleCount;
 		multisamplingInfo.sampleShadingEnable = VK_FALSE;
 		multisamplingInfo.minSampleShading = 0.0f;
 		multisamplingInfo.pSampleMask = nullptr;				// optional
@@ -242,7 +272,7 @@ namespace VulkanCore {
 		vkDestroyShaderModule(device.GetVKDevice(), vertShaderModule, nullptr);
 	}
 
-	void Pipeline::CreateComputePipeline(const VkDescriptorSetLayout& descriptorSetLayout, const std::string& computeShaderFilePath)
+	void Pipeline::CreateComputePipeline(const VkDescriptorSetLayout& descriptorSetLayout, const std::string& computeShaderFilePath, uint32_t pushConstantSize)
 	{
 		// Shader Code
 		std::vector<char> computeShaderCode = ReadFile(computeShaderFilePath);
@@ -261,7 +291,7 @@ namespace VulkanCore {
 		VkPushConstantRange pushConstantRangeInfo = {};
 		pushConstantRangeInfo.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
 		pushConstantRangeInfo.offset = 0;
-		pushConstantRangeInfo.size = sizeof(PushConstants);
+		pushConstantRangeInfo.size = pushConstantSize;
 
 		// Pipeline Layout
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
@@ -17,15 +17,22 @@ namespace VulkanCore {
 		uint32_t enabled;
 		float timestep;
 		glm::vec2 attractor;
+		uint32_t forceSourceCount;
 	};
 
 	class Pipeline final
 	{
 	public:
 		// Constructor
-		Pipeline(GPUDevice& device, const VkRenderPass& renderPass, const VkDescriptorSetLayout& descriptorSetLayout, const VkVertexInputBindingDescription& bindingDescription, const std::vector<VkVertexInputAttributeDescription>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath);
-		Pipeline(GPUDevice& device, const VkRenderPass& renderPass, const VkDescriptorSetLayout& descriptorSetLayout, const VkVertexInputBindingDescription& bindingDescription, const std::vector<VkVertexInputAttributeDescription>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath, const std::string& computeShaderFilePath);
-		Pipeline(GPUDevice& device, const VkRenderPass& renderPass, const VkDescriptorSetLayout& graphicsDescriptorSetLayout, const VkDescriptorSetLayout& computeDescriptorSetLayou, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath, const std::string& computeShaderFilePath);
+		Pipeline(GPUDevice& device, const VkRenderPass& renderPass, VkSampleCountFlagBits sampleCount, const VkDescriptorSetLayout& descriptorSetLayout, const VkVertexInputBindingDescription& bindingDescription, const std::vector<VkVertexInputAttributeDescription>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath);
+		Pipeline(GPUDevice& device, const VkRenderPass& renderPass, VkSampleCountFlagBits sampleCount, const VkDescriptorSetLayout& descriptorSetLayout, const VkVertexInputBindingDescription& bindingDescription, const std::vector<VkVertexInputAttributeDescription>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath, const std::string& computeShaderFilePath);
+		Pipeline(GPUDevice& device, const VkRenderPass& renderPass, VkSampleCountFlagBits sampleCount, const VkDescriptorSetLayout& graphicsDescriptorSetLayout, const VkDescriptorSetLayout& computeDescriptorSetLayou, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath, const std::string& computeShaderFilePath);
+
+		// Graphics only, the vertex shader reads its vertices from the descriptor set
+		Pipeline(GPUDevice& device, const VkRenderPass& renderPass, VkSampleCountFlagBits sampleCount, const VkDescriptorSetLayout& graphicsDescriptorSetLayout, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath);
+
+		// Compute only, pushConstantSize bytes of push constants
+		Pipeline(GPUDevice& device, const VkDescriptorSetLayout& computeDescriptorSetLayout, const std::string& computeShaderFilePath, uint32_t pushConstantSize);
 
 		// Destructor
 		~Pipeline();
@@ -48,6 +55,7 @@ namespace VulkanCore {
 	private:
 		GPUDevice& device;
 
+		bool hasGraphicsPipeline;
 		VkPipelineLayout pipelineLayout;
 		VkPipeline graphicsPipeline;
 
@@ -59,8 +67,8 @@ namespace VulkanCore {
 
 		static std::vector<char> ReadFile(const std::string& filePath);
 
-		void CreateGraphicsPipeline(const VkRenderPass& renderPass, const std::optional<VkDescriptorSetLayout>& descriptorSetLayout, const std::optional<VkVertexInputBindingDescription>& bindingDescription, const std::optional<std::vector<VkVertexInputAttributeDescription>>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath);
-		void CreateComputePipeline(const VkDescriptorSetLayout& descriptorSetLayout, const std::string& computeShaderFilePath);
+		void CreateGraphicsPipeline(const VkRenderPass& renderPass, VkSampleCountFlagBits sampleCount, const std::optional<VkDescriptorSetLayout>& descriptorSetLayout, const std::optional<VkVertexInputBindingDescription>& bindingDescription, const std::optional<std::vector<VkVertexInputAttributeDescription>>& attributeDescription, const std::string& vertexShaderFilePath, const std::string& fragmentShaderFilePath);
+		void CreateComputePipeline(const VkDescriptorSetLayout& descriptorSetLayout, const std::string& computeShaderFilePath, uint32_t pushConstantSize = sizeof(PushConstants));
 		VkShaderModule CreateShaderModule(const std::vector<char>& code) const;
 	};
 
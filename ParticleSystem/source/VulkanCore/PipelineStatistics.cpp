@@ -0,0 +1,193 @@
+#include "PipelineStatistics.h"
+
+#include <iomanip>
+#include <stdexcept>
+
+namespace VulkanCore {
+
+	PipelineStatistics::PipelineStatistics(GPUDevice& device)
+		: device(device)
+		, bIsSupported(device.GetSupportsPipelineStatistics())
+		, slots({})
+		, currentSlot(0)
+		, latest({})
+		, sums({})
+		, frameCount(0)
+		, tickCount(0)
+	{
+		if (!bIsSupported)
+		{
+			return;
+		}
+
+		VkQueryPoolCreateInfo queryPoolInfo = {};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		queryPoolInfo.queryCount = SCOPE_COUNT * MAX_SCOPE_PARTS;
+		queryPoolInfo.pipelineStatistics = STATISTIC_FLAGS;
+
+		for (FrameSlot& slot : slots)
+		{
+			if (vkCreateQueryPool(device.GetVKDevice(), &queryPoolInfo, nullptr, &slot.queryPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create pipeline statistics query pool!");
+			}
+		}
+	}
+
+	PipelineStatistics::~PipelineStatistics()
+	{
+		for (FrameSlot& slot : slots)
+		{
+			if (slot.queryPool != VK_NULL_HANDLE)
+			{
+				vkDestroyQueryPool(device.GetVKDevice(), slot.queryPool, nullptr);
+			}
+		}
+	}
+
+	void PipelineStatistics::NewFrame()
+	{
+		if (!bIsSupported)
+		{
+			return;
+		}
+
+		currentSlot = (currentSlot + 1) % FRAME_SLOT_COUNT;
+		Collect(slots[currentSlot]);
+	}
+
+	void PipelineStatistics::ResetQuery(VkCommandBuffer commandBuffer, PipelineStatisticsScope scope, uint32_t partCount)
+	{
+		if (!bIsSupported)
+		{
+			return;
+		}
+
+		if (partCount == 0 || partCount > MAX_SCOPE_PARTS)
+		{
+			throw std::runtime_error("ERROR: Pipeline statistics scope split in too many parts!");
+		}
+
+		vkCmdResetQueryPool(commandBuffer, slots[currentSlot].queryPool, GetQueryIndex(scope, 0), partCount);
+		slots[currentSlot].recordedPartCounts[static_cast<size_t>(scope)] = partCount;
+	}
+
+	void PipelineStatistics::BeginQuery(VkCommandBuffer commandBuffer, PipelineStatisticsScope scope, uint32_t part) const
+	{
+		if (!bIsSupported)
+		{
+			return;
+		}
+
+		vkCmdBeginQuery(commandBuffer, slots[currentSlot].queryPool, GetQueryIndex(scope, part), 0);
+	}
+
+	void PipelineStatistics::EndQuery(VkCommandBuffer commandBuffer, PipelineStatisticsScope scope, uint32_t part) const
+	{
+		if (!bIsSupported)
+		{
+			return;
+		}
+
+		vkCmdEndQuery(commandBuffer, slots[currentSlot].queryPool, GetQueryIndex(scope, part));
+	}
+
+	void PipelineStatistics::ResetAverages()
+	{
+		sums = {};
+		frameCount = 0;
+		tickCount = 0;
+	}
+
+	PipelineStatisticsAverages PipelineStatistics::GetAverages() const
+	{
+		PipelineStatisticsAverages averages = {};
+		averages.frameCount = frameCount;
+		averages.tickCount = tickCount;
+
+		if (frameCount > 0)
+		{
+			const double frames = static_cast<double>(frameCount);
+			averages.vertexShaderInvocations = static_cast<double>(sums.vertexShaderInvocations) / frames;
+			averages.clippingInvocations = static_cast<double>(sums.clippingInvocations) / frames;
+			averages.clippingPrimitives = static_cast<double>(sums.clippingPrimitives) / frames;
+			averages.fragmentShaderInvocations = static_cast<double>(sums.fragmentShaderInvocations) / frames;
+		}
+
+		if (tickCount > 0)
+		{
+			averages.computeShaderInvocations = static_cast<double>(sums.computeShaderInvocations) / static_cast<double>(tickCount);
+		}
+
+		return averages;
+	}
+
+	void PipelineStatistics::PrintAverages(std::ostream& out, const PipelineStatisticsAverages& averages, uint32_t particleCount)
+	{
+		if (averages.frameCount == 0 && averages.tickCount == 0)
+		{
+			out << "Pipeline statistics: not available" << std::endl;
+			return;
+		}
+
+		const double particles = static_cast<double>(particleCount);
+		out << std::fixed << std::setprecision(2)
+			<< "Pipeline statistics (" << averages.frameCount << " frames, " << averages.tickCount << " ticks):" << '\n'
+			<< "  vertex shader invocations / frame:   " << averages.vertexShaderInvocations << " (" << averages.vertexShaderInvocations / particles << " per particle)" << '\n'
+			<< "  clipping primitives / frame:         " << averages.clippingPrimitives << " (" << averages.clippingPrimitives / particles << " per particle)" << '\n'
+			<< "  fragment shader invocations / frame: " << averages.fragmentShaderInvocations << " (" << averages.fragmentShaderInvocations / particles << " per particle)" << '\n'
+			<< "  compute shader invocations / tick:   " << averages.computeShaderInvocations << " (" << averages.computeShaderInvocations / particles << " per particle)" << std::endl;
+		out << std::defaultfloat;
+	}
+
+	void PipelineStatistics::Collect(FrameSlot& slot)
+	{
+		// Each scope is read on its own, a frame without a tick has no simulation query
+		for (uint32_t scope = 0; scope < SCOPE_COUNT; ++scope)
+		{
+			const uint32_t partCount = slot.recordedPartCounts[scope];
+			if (partCount == 0)
+			{
+				continue;
+			}
+			slot.recordedPartCounts[scope] = 0;
+
+			std::array<std::array<uint64_t, STATISTIC_COUNT>, MAX_SCOPE_PARTS> partValues = {};
+			if (vkGetQueryPoolResults(device.GetVKDevice(), slot.queryPool, GetQueryIndex(static_cast<PipelineStatisticsScope>(scope), 0), partCount, sizeof(partValues[0]) * partCount, partValues.data(), sizeof(partValues[0]), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+			{
+				continue;
+			}
+
+			std::array<uint64_t, STATISTIC_COUNT> values = {};
+			for (uint32_t part = 0; part < partCount; ++part)
+			{
+				for (uint32_t statistic = 0; statistic < STATISTIC_COUNT; ++statistic)
+				{
+					values[statistic] += partValues[part][statistic];
+				}
+			}
+
+			if (scope == static_cast<uint32_t>(PipelineStatisticsScope::Simulation))
+			{
+				latest.computeShaderInvocations = values[4];
+				sums.computeShaderInvocations += values[4];
+				++tickCount;
+			}
+			else
+			{
+				latest.vertexShaderInvocations = values[0];
+				latest.clippingInvocations = values[1];
+				latest.clippingPrimitives = values[2];
+				latest.fragmentShaderInvocations = values[3];
+
+				sums.vertexShaderInvocations += values[0];
+				sums.clippingInvocations += values[1];
+				sums.clippingPrimitives += values[2];
+				sums.fragmentShaderInvocations += values[3];
+				++frameCount;
+			}
+		}
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#include "GPUDevice.h"
+
+namespace VulkanCore {
+
+	enum class PipelineStatisticsScope : uint32_t
+	{
+		Simulation = 0,		// compute dispatches of a tick
+		ParticlePass,		// particle subpass
+		Count
+	};
+
+	// Counters of the last completed frame, the graphics counters come from the particle pass and the compute counter from the last tick
+	struct PipelineStatisticsCounters
+	{
+		uint64_t vertexShaderInvocations = 0;
+		uint64_t clippingInvocations = 0;
+		uint64_t clippingPrimitives = 0;
+		uint64_t fragmentShaderInvocations = 0;
+		uint64_t computeShaderInvocations = 0;
+	};
+
+	// Means since the last ResetAverages, graphics counters per frame and the compute counter per tick
+	struct PipelineStatisticsAverages
+	{
+		uint64_t frameCount = 0;
+		uint64_t tickCount = 0;
+		double vertexShaderInvocations = 0.0;
+		double clippingInvocations = 0.0;
+		double clippingPrimitives = 0.0;
+		double fragmentShaderInvocations = 0.0;
+		double computeShaderInvocations = 0.0;
+	};
+
+	// VK_QUERY_TYPE_PIPELINE_STATISTICS queries around the simulation and the particle pass
+	// Same scheme as GPUProfiler: one query pool per frame slot, read back FRAME_SLOT_COUNT frames later without waiting,
+	// so the counters lag a few frames behind and a query that is still not available is dropped.
+	// A scope can be split in parts recorded into different command buffers (the particle pass is recorded in parallel
+	// secondary command buffers), each part has its own query and their counters are summed.
+	// Does nothing if the device does not support pipelineStatisticsQuery.
+	class PipelineStatistics final
+	{
+	public:
+		static constexpr uint32_t FRAME_SLOT_COUNT = 4;
+		static constexpr uint32_t MAX_SCOPE_PARTS = 64;
+
+		// Constructor
+		PipelineStatistics(GPUDevice& device);
+
+		// Destructor
+		~PipelineStatistics();
+
+		// Not copyable
+		PipelineStatistics(const PipelineStatistics&) = delete;
+		PipelineStatistics& operator = (const PipelineStatistics&) = delete;
+
+		// Not moveable
+		PipelineStatistics(PipelineStatistics&&) = delete;
+		PipelineStatistics& operator = (PipelineStatistics&&) = delete;
+
+		// Collects the oldest slot and makes it current, call once per frame before recording any query
+		void NewFrame();
+
+		// Queries can not be reset inside a render pass, reset the queries of a scope before beginning its render pass
+		// Every part in [0, partCount) has to be recorded in the same frame
+		void ResetQuery(VkCommandBuffer commandBuffer, PipelineStatisticsScope scope, uint32_t partCount = 1);
+
+		// Only record commands, different parts can be recorded from different threads
+		void BeginQuery(VkCommandBuffer commandBuffer, PipelineStatisticsScope scope, uint32_t part = 0) const;
+		void EndQuery(VkCommandBuffer commandBuffer, PipelineStatisticsScope scope, uint32_t part = 0) const;
+
+		void ResetAverages();
+
+		// Per frame, per tick and per particle
+		static void PrintAverages(std::ostream& out, const PipelineStatisticsAverages& averages, uint32_t particleCount);
+
+		// Getters
+		inline bool GetIsSupported() const { return bIsSupported; }
+		inline const PipelineStatisticsCounters& GetLatest() const { return latest; }
+		PipelineStatisticsAverages GetAverages() const;
+
+	private:
+		static constexpr uint32_t SCOPE_COUNT = static_cast<uint32_t>(PipelineStatisticsScope::Count);
+
+		// One value per enabled statistic, in bit order
+		static constexpr VkQueryPipelineStatisticFlags STATISTIC_FLAGS =
+			VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+			VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+		static constexpr uint32_t STATISTIC_COUNT = 5;
+
+		struct FrameSlot
+		{
+			VkQueryPool queryPool = VK_NULL_HANDLE;
+			std::array<uint32_t, SCOPE_COUNT> recordedPartCounts = {};
+		};
+
+		GPUDevice& device;
+		bool bIsSupported;
+
+		std::array<FrameSlot, FRAME_SLOT_COUNT> slots;
+		uint32_t currentSlot;
+
+		PipelineStatisticsCounters latest;
+		PipelineStatisticsCounters sums;
+		uint64_t frameCount;
+		uint64_t tickCount;
+
+		static inline uint32_t GetQueryIndex(PipelineStatisticsScope scope, uint32_t part) { return static_cast<uint32_t>(scope) * MAX_SCOPE_PARTS + part; }
+
+		void Collect(FrameSlot& slot);
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,183 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace VulkanCore {
+
+	namespace {
+
+		// Zone names are identifiers and literals, only quotes and backslashes need escaping
+		void WriteEscaped(std::ofstream& out, const char* text)
+		{
+			for (; *text != '\0'; ++text)
+			{
+				if (*text == '"' || *text == '\\')
+				{
+					out << '\\';
+				}
+				out << *text;
+			}
+		}
+
+		// Chrome trace timestamps are microseconds, nanoseconds are kept as the fraction
+		void WriteMicroseconds(std::ofstream& out, int64_t nanoseconds)
+		{
+			char text[32];
+			std::snprintf(text, sizeof(text), "%lld.%03lld", static_cast<long long>(nanoseconds / 1000), static_cast<long long>(nanoseconds % 1000));
+			out << text;
+		}
+
+	} // namespace
+
+	Profiler::Profiler()
+		: bIsEnabled(true)
+		, nextThreadId(GPU_THREAD_ID + 1)
+	{
+		gpuBuffer.threadId = GPU_THREAD_ID;
+		threadNames.emplace_back(GPU_THREAD_ID, "GPU");
+	}
+
+	Profiler& Profiler::GetInstance()
+	{
+		static Profiler instance;
+		return instance;
+	}
+
+	Profiler::ThreadBufferHandle::~ThreadBufferHandle()
+	{
+		if (buffer != nullptr)
+		{
+			buffer->bInUse.store(false, std::memory_order_release);
+		}
+	}
+
+	Profiler::ThreadBuffer* Profiler::AcquireThreadBuffer()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+
+		// Short-lived workers reuse the rings of exited threads instead of growing the registry
+		for (const std::unique_ptr<ThreadBuffer>& buffer : threadBuffers)
+		{
+			if (!buffer->bInUse.load(std::memory_order_acquire))
+			{
+				buffer->bInUse.store(true, std::memory_order_relaxed);
+				buffer->threadId = nextThreadId++;
+				return buffer.get();
+			}
+		}
+
+		threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+		threadBuffers.back()->threadId = nextThreadId++;
+		return threadBuffers.back().get();
+	}
+
+	void Profiler::SetThreadName(const std::string& threadName)
+	{
+		const uint32_t threadId = GetThreadBuffer().threadId;
+
+		std::lock_guard<std::mutex> lock(registryMutex);
+		threadNames.emplace_back(threadId, threadName);
+	}
+
+	void Profiler::RecordGPU(const char* name, Time start, Time end)
+	{
+		const uint64_t index = gpuBuffer.writeIndex.load(std::memory_order_relaxed);
+		gpuBuffer.events[index % EVENTS_PER_THREAD] = { name, start, end, GPU_THREAD_ID };
+		gpuBuffer.writeIndex.store(index + 1, std::memory_order_release);
+	}
+
+	void Profiler::Clear()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+
+		gpuBuffer.clearIndex.store(gpuBuffer.writeIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+		for (const std::unique_ptr<ThreadBuffer>& buffer : threadBuffers)
+		{
+			buffer->clearIndex.store(buffer->writeIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+		}
+	}
+
+	void Profiler::SetEnabled(bool bEnabled)
+	{
+		bIsEnabled.store(bEnabled, std::memory_order_relaxed);
+	}
+
+	void Profiler::ExportChromeTrace(const std::string& filePath)
+	{
+		std::vector<ProfileEvent> events;
+		std::vector<std::pair<uint32_t, std::string>> names;
+		{
+			std::lock_guard<std::mutex> lock(registryMutex);
+			names = threadNames;
+
+			auto snapshot = [&events](const ThreadBuffer& buffer)
+			{
+				const uint64_t end = buffer.writeIndex.load(std::memory_order_acquire);
+				const uint64_t begin = std::max(buffer.clearIndex.load(std::memory_order_relaxed), end > EVENTS_PER_THREAD ? end - EVENTS_PER_THREAD : 0);
+				const size_t first = events.size();
+				for (uint64_t i = begin; i < end; ++i)
+				{
+					events.push_back(buffer.events[i % EVENTS_PER_THREAD]);
+				}
+
+				// The owner kept writing while we copied, drop everything it may have wrapped over (including the event it is writing)
+				const uint64_t overwritten = buffer.writeIndex.load(std::memory_order_acquire) + 1;
+				if (overwritten > begin + EVENTS_PER_THREAD)
+				{
+					const uint64_t lost = std::min(overwritten - EVENTS_PER_THREAD - begin, end - begin);
+					events.erase(events.begin() + first, events.begin() + first + static_cast<size_t>(lost));
+				}
+			};
+
+			snapshot(gpuBuffer);
+			for (const std::unique_ptr<ThreadBuffer>& buffer : threadBuffers)
+			{
+				snapshot(*buffer);
+			}
+		}
+
+		std::ofstream out(filePath, std::ios::out | std::ios::trunc);
+		if (!out.is_open())
+		{
+			std::cout << "ERROR: Failed to open " << filePath << " for writing" << std::endl;
+			return;
+		}
+
+		// Timestamps relative to the first event keep the numbers short
+		int64_t origin = std::numeric_limits<int64_t>::max();
+		for (const ProfileEvent& event : events)
+		{
+			origin = std::min(origin, event.start.value);
+		}
+
+		out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+		bool bIsFirst = true;
+		for (const std::pair<uint32_t, std::string>& name : names)
+		{
+			out << (bIsFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << name.first << ",\"args\":{\"name\":\"";
+			WriteEscaped(out, name.second.c_str());
+			out << "\"}}";
+			bIsFirst = false;
+		}
+
+		for (const ProfileEvent& event : events)
+		{
+			out << ",\n{\"name\":\"";
+			WriteEscaped(out, event.name);
+			out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadId << ",\"ts\":";
+			WriteMicroseconds(out, event.start.value - origin);
+			out << ",\"dur\":";
+			WriteMicroseconds(out, std::max<int64_t>(event.end.value - event.start.value, 0));
+			out << "}";
+		}
+		out << "\n]}\n";
+
+		std::cout << "Profile exported to " << filePath << ": " << events.size() << " zones" << std::endl;
+	}
+
+} // namespace VulkanCore
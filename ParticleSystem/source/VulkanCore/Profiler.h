@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Time.h"
+
+namespace VulkanCore {
+
+	// One finished zone, names are string literals so only the pointer is stored
+	struct ProfileEvent
+	{
+		const char* name;
+		Time start;
+		Time end;
+		uint32_t threadId;
+	};
+
+	// Scoped-zone CPU profiler exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+	// Every thread appends to its own ring of EVENTS_PER_THREAD events: no lock and no allocation on the hot path,
+	// the writer only publishes its write index and the exporter drops the events that may have been overwritten while it copied them.
+	// GPU zones are converted to the Time::Now clock by GPUProfiler and recorded on their own track.
+	class Profiler final
+	{
+	public:
+		static constexpr size_t EVENTS_PER_THREAD = 1 << 16;
+
+		// Constructor
+		Profiler();
+
+		// Destructor
+		~Profiler() = default;
+
+		// Not copyable
+		Profiler(const Profiler&) = delete;
+		Profiler& operator = (const Profiler&) = delete;
+
+		// Not moveable
+		Profiler(Profiler&&) = delete;
+		Profiler& operator = (Profiler&&) = delete;
+
+		static Profiler& GetInstance();
+
+		// Names the calling thread in the exported trace
+		void SetThreadName(const std::string& threadName);
+
+		// Only called by the thread that owns the buffer
+		inline void Record(const char* name, Time start, Time end)
+		{
+			ThreadBuffer& buffer = GetThreadBuffer();
+			const uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+			buffer.events[index % EVENTS_PER_THREAD] = { name, start, end, buffer.threadId };
+			buffer.writeIndex.store(index + 1, std::memory_order_release);
+		}
+
+		// Single producer, only called from the render loop
+		void RecordGPU(const char* name, Time start, Time end);
+
+		// Drops every recorded event, the next export starts from here
+		void Clear();
+
+		// Writes the events still held by the thread rings, can be called while other threads keep recording
+		void ExportChromeTrace(const std::string& filePath);
+
+		void SetEnabled(bool bEnabled);
+
+		// Getters
+		inline bool GetIsEnabled() const { return bIsEnabled.load(std::memory_order_relaxed); }
+
+	private:
+		struct ThreadBuffer
+		{
+			uint32_t threadId = 0;
+			std::atomic<uint64_t> writeIndex = 0;
+			std::atomic<uint64_t> clearIndex = 0;
+			std::atomic<bool> bInUse = true;
+			std::array<ProfileEvent, EVENTS_PER_THREAD> events = {};
+		};
+
+		// Returns the buffer of an exited thread to the pool, its events stay exportable
+		struct ThreadBufferHandle
+		{
+			ThreadBuffer* buffer = nullptr;
+
+			~ThreadBufferHandle();
+		};
+
+		static constexpr uint32_t GPU_THREAD_ID = 0;
+
+		std::atomic<bool> bIsEnabled;
+
+		std::mutex registryMutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+		std::vector<std::pair<uint32_t, std::string>> threadNames;
+		uint32_t nextThreadId;
+
+		ThreadBuffer gpuBuffer;
+
+		inline ThreadBuffer& GetThreadBuffer()
+		{
+			thread_local ThreadBufferHandle handle;
+			if (handle.buffer == nullptr)
+			{
+				handle.buffer = AcquireThreadBuffer();
+			}
+			return *handle.buffer;
+		}
+
+		ThreadBuffer* AcquireThreadBuffer();
+	};
+
+	// Records the time between its construction and destruction, costs a single relaxed load while the profiler is disabled
+	class ProfileZone final
+	{
+	public:
+		// Constructor
+		explicit ProfileZone(const char* name)
+			: name(name)
+			, start(Profiler::GetInstance().GetIsEnabled() ? Time::Now() : Time{ 0 })
+		{
+
+		}
+
+		// Destructor
+		~ProfileZone()
+		{
+			if (!start.IsZero())
+			{
+				Profiler::GetInstance().Record(name, start, Time::Now());
+			}
+		}
+
+		// Not copyable
+		ProfileZone(const ProfileZone&) = delete;
+		ProfileZone& operator = (const ProfileZone&) = delete;
+
+		// Not moveable
+		ProfileZone(ProfileZone&&) = delete;
+		ProfileZone& operator = (ProfileZone&&) = delete;
+
+	private:
+		const char* name;
+		Time start;
+	};
+
+} // namespace VulkanCore
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// name must outlive the profiler, use string literals
+#define PROFILE_ZONE(name) ::VulkanCore::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
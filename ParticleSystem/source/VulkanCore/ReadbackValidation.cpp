@@ -0,0 +1,101 @@
+#include "ReadbackValidation.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace VulkanCore {
+
+	ReadbackValidation::ReadbackValidation(GPUDevice& device, const std::string& name, CheckFunction check, ReportFunction report)
+		: device(device)
+		, name(name)
+		, check(std::move(check))
+		, report(std::move(report))
+		, state(State::Idle)
+		, readbackBufferMapped(nullptr)
+	{
+	}
+
+	ReadbackValidation::~ReadbackValidation()
+	{
+		// Shutting down is allowed to block on a running validation
+		if (state == State::Checking)
+		{
+			Finish();
+		}
+
+		readbackBuffer.Cleanup(device);
+	}
+
+	bool ReadbackValidation::Request()
+	{
+		if (state != State::Idle)
+		{
+			return false;
+		}
+
+		state = State::Requested;
+		return true;
+	}
+
+	VkBuffer ReadbackValidation::BeginReadback(VkCommandBuffer commandBuffer, VkDeviceSize size)
+	{
+		readbackBuffer.Cleanup(device);
+		readbackBuffer.Create(device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		vkMapMemory(device.GetVKDevice(), readbackBuffer.memory, 0, size, 0, &readbackBufferMapped);
+
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		return readbackBuffer.buffer;
+	}
+
+	void ReadbackValidation::EndReadback(VkCommandBuffer commandBuffer)
+	{
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		state = State::InFlight;
+	}
+
+	void ReadbackValidation::Poll()
+	{
+		if (state == State::InFlight)
+		{
+			state = State::Checking;
+
+			JobSystem::GetInstance().Run(checkCounter, [this]()
+			{
+				check(readbackBufferMapped);
+			});
+		}
+		else if (state == State::Checking && checkCounter.GetIsDone())
+		{
+			Finish();
+		}
+	}
+
+	void ReadbackValidation::Finish()
+	{
+		try
+		{
+			JobSystem::GetInstance().Wait(checkCounter);
+			report();
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "ERROR: " << name << " validation failed: " << e.what() << std::endl;
+		}
+
+		readbackBuffer.Cleanup(device);
+		readbackBufferMapped = nullptr;
+		state = State::Idle;
+	}
+
+} // namespace VulkanCore
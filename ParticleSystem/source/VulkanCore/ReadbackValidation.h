@@ -0,0 +1,75 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "GPUDevice.h"
+#include "StorageBuffer.h"
+#include "JobSystem.h"
+
+namespace VulkanCore {
+
+	// Request, readback and CPU check of a simulation step against its reference, shared by the simulations
+	// Request marks the next step, which records its copies into the readback buffer between BeginReadback and EndReadback.
+	// Poll hands the copy to check on the job system once the frame is done and calls report when the job is.
+	class ReadbackValidation final
+	{
+	public:
+		// check runs on the job system with the mapped readback, report on the thread calling Poll
+		// Both may reference the owner, which has to declare its ReadbackValidation after the state they read
+		using CheckFunction = std::function<void(const void* data)>;
+		using ReportFunction = std::function<void()>;
+
+		// Constructor
+		ReadbackValidation(GPUDevice& device, const std::string& name, CheckFunction check, ReportFunction report);
+
+		// Destructor
+		~ReadbackValidation();
+
+		// Not copyable
+		ReadbackValidation(const ReadbackValidation&) = delete;
+		ReadbackValidation& operator = (const ReadbackValidation&) = delete;
+
+		// Not moveable
+		ReadbackValidation(ReadbackValidation&&) = delete;
+		ReadbackValidation& operator = (ReadbackValidation&&) = delete;
+
+		// Returns false while the previous validation is still running
+		bool Request();
+
+		// Returns a host visible buffer of size bytes, record the copies into it after the compute writes they read
+		VkBuffer BeginReadback(VkCommandBuffer commandBuffer, VkDeviceSize size);
+
+		// The rest of the step may overwrite what was just copied, the host reads the copy after the frame
+		void EndReadback(VkCommandBuffer commandBuffer);
+
+		// Call once per frame after Renderer::SyncNewFrame, never blocks
+		void Poll();
+
+		// Getters
+		inline bool GetIsRequested() const { return state == State::Requested; }
+		inline bool GetIsInFlight() const { return state == State::InFlight; }
+
+	private:
+		enum class State : uint32_t
+		{
+			Idle = 0,
+			Requested,		// taken by the next step
+			InFlight,		// copy recorded, waiting for the GPU
+			Checking		// owned by the check job
+		};
+
+		GPUDevice& device;
+		std::string name;
+		CheckFunction check;
+		ReportFunction report;
+
+		State state;
+		StorageBuffer readbackBuffer;
+		void* readbackBufferMapped;
+		JobCounter checkCounter;
+
+		void Finish();
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,73 @@
+#include "RecordingBenchmark.h"
+
+#include <algorithm>
+#include <iomanip>
+
+#include "BenchmarkAnalyzer.h"
+
+namespace VulkanCore {
+
+	RecordingBenchmark::RecordingBenchmark(uint32_t maxThreadCount)
+		: currentStep(0)
+		, frameIndex(0)
+	{
+		maxThreadCount = std::max(maxThreadCount, 1u);
+		for (uint32_t threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+		{
+			threadCounts.push_back(threadCount);
+		}
+		threadCounts.push_back(maxThreadCount);
+
+		frameTimes.reserve(MEASURED_FRAMES);
+	}
+
+	void RecordingBenchmark::AddFrame(Time recordingTime)
+	{
+		if (GetIsFinished())
+		{
+			return;
+		}
+
+		if (frameIndex++ < WARMUP_FRAMES)
+		{
+			return;
+		}
+
+		frameTimes.push_back(TimeToMilliseconds<double>(recordingTime));
+		if (frameTimes.size() < MEASURED_FRAMES)
+		{
+			return;
+		}
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+		results.push_back({ threadCounts[currentStep], BenchmarkAnalyzer::Percentile(frameTimes, 0.5), BenchmarkAnalyzer::Percentile(frameTimes, 0.95) });
+
+		frameTimes.clear();
+		frameIndex = 0;
+		++currentStep;
+	}
+
+	void RecordingBenchmark::PrintResults(std::ostream& out) const
+	{
+		if (results.empty())
+		{
+			out << "Recording benchmark: no results" << std::endl;
+			return;
+		}
+
+		const double baseline = results.front().medianMilliseconds;
+		out << "Recording benchmark (" << GROUP_COUNT << " secondary command buffers x " << DRAWS_PER_GROUP << " draws, " << MEASURED_FRAMES << " frames):" << '\n'
+			<< "  threads  median ms  p95 ms  speedup  efficiency" << '\n';
+
+		out << std::fixed;
+		for (const RecordingBenchmarkResult& result : results)
+		{
+			const double speedup = result.medianMilliseconds > 0.0 ? baseline / result.medianMilliseconds : 0.0;
+			out << "  " << std::setw(7) << result.threadCount
+				<< std::setprecision(3) << "  " << std::setw(9) << result.medianMilliseconds << "  " << std::setw(6) << result.p95Milliseconds
+				<< std::setprecision(2) << "  " << std::setw(6) << speedup << "x" << "  " << std::setw(9) << 100.0 * speedup / result.threadCount << "%" << '\n';
+		}
+		out << std::defaultfloat << std::flush;
+	}
+
+} // namespace VulkanCore
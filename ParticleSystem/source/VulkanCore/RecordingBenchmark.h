@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "Time.h"
+
+namespace VulkanCore {
+
+	struct RecordingBenchmarkResult
+	{
+		uint32_t threadCount;
+		double medianMilliseconds;
+		double p95Milliseconds;
+	};
+
+	// Measures how the CPU time of recording the particle pass scales with the number of recording threads
+	// The pass is split in GROUP_COUNT secondary command buffers of DRAWS_PER_GROUP draws each, then recorded
+	// for WARMUP_FRAMES + MEASURED_FRAMES frames with 1, 2, 4, ... threads up to every job system thread.
+	class RecordingBenchmark final
+	{
+	public:
+		static constexpr uint32_t GROUP_COUNT = 64;
+		static constexpr uint32_t DRAWS_PER_GROUP = 64;
+		static constexpr uint32_t WARMUP_FRAMES = 30;
+		static constexpr uint32_t MEASURED_FRAMES = 240;
+
+		// Constructor
+		explicit RecordingBenchmark(uint32_t maxThreadCount);
+
+		// Recording time of the frame recorded with GetThreadCount threads, moves on to the next thread count once enough frames were measured
+		void AddFrame(Time recordingTime);
+
+		// Median and speedup over a single thread per thread count
+		void PrintResults(std::ostream& out) const;
+
+		// Getters
+		inline bool GetIsFinished() const { return currentStep >= threadCounts.size(); }
+		inline uint32_t GetThreadCount() const { return threadCounts[currentStep]; }
+		inline const std::vector<RecordingBenchmarkResult>& GetResults() const { return results; }
+
+	private:
+		std::vector<uint32_t> threadCounts;
+		size_t currentStep;
+		uint32_t frameIndex;
+		std::vector<double> frameTimes;
+		std::vector<RecordingBenchmarkResult> results;
+	};
+
+} // namespace VulkanCore
@@ -1,7 +1,13 @@
 #include "Renderer.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <stdexcept>
+#include <thread>
+
+#include "JobSystem.h"
+#include "Profiler.h"
 
 namespace VulkanCore {
 
@@ -9,16 +15,25 @@ namespace VulkanCore {
 		: window(window)
 		, device(device)
 		, currentImageIndex(0)
+		, preferredPresentMode(VK_PRESENT_MODE_MAILBOX_KHR)
+		, preferredSampleCount(VK_SAMPLE_COUNT_8_BIT)
 	{
 		RecreateSwapChain();
 		CreateCommandBuffers();
 		CreateComputeCommandBuffers();
 		CreateSyncNewFrameCommandBuffer();
+		CreateSecondaryCommandPools();
 	}
 
 	Renderer::~Renderer()
 	{
-
+		for (std::vector<SecondaryCommandPool>& framePools : secondaryCommandPools)
+		{
+			for (SecondaryCommandPool& pool : framePools)
+			{
+				vkDestroyCommandPool(device.GetVKDevice(), pool.commandPool, nullptr);
+			}
+		}
 	}
 
 	VkCommandBuffer Renderer::BeginCompute()
@@ -80,6 +95,7 @@ namespace VulkanCore {
 		}
 		
 		vkResetCommandBuffer(commandBuffers[swapChain->GetCurrentFrameIndex()], 0);
+		ResetSecondaryCommandPools();
 
 		VkCommandBufferBeginInfo beginInfo = {};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -94,14 +110,14 @@ namespace VulkanCore {
 		return commandBuffers[swapChain->GetCurrentFrameIndex()];
 	}
 
-	void Renderer::EndFrame()
+	void Renderer::EndFrame(VkFence fence)
 	{
 		if (vkEndCommandBuffer(commandBuffers[swapChain->GetCurrentFrameIndex()]) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to record command buffer!");
 		}
 
-		VkResult resultSubmitCommandBuffer = swapChain->SubmitCommandBuffer(&commandBuffers[swapChain->GetCurrentFrameIndex()], &currentImageIndex);
+		VkResult resultSubmitCommandBuffer = swapChain->SubmitCommandBuffer(&commandBuffers[swapChain->GetCurrentFrameIndex()], &currentImageIndex, fence);
 		if (resultSubmitCommandBuffer == VK_ERROR_OUT_OF_DATE_KHR || resultSubmitCommandBuffer == VK_SUBOPTIMAL_KHR || window.GetWasWindowResized())
 		{
 			window.ResetWindowResizedFlag();
@@ -115,7 +131,7 @@ namespace VulkanCore {
 		swapChain->AdvanceFrameIndex();
 	}
 
-	void Renderer::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+	void Renderer::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
 	{
 		std::array<VkClearValue, 2> clearValues = {};
 		clearValues[0].color = {{ 0.0f, 0.0f, 0.0f, 1.0f }};
@@ -135,22 +151,18 @@ namespace VulkanCore {
 		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
 
-		// Set Dynamic States: Viewport + Scissors
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(swapChain->GetSwapChainExtent().width);
-		viewport.height = static_cast<float>(swapChain->GetSwapChainExtent().height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		// Dynamic states are not inherited, secondary command buffers set their own
+		if (contents == VK_SUBPASS_CONTENTS_INLINE)
+		{
+			SetViewportAndScissor(commandBuffer);
+		}
+	}
 
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = swapChain->GetSwapChainExtent();
-		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	void Renderer::NextSwapChainSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
+	{
+		vkCmdNextSubpass(commandBuffer, contents);
 	}
 
 	void Renderer::EndSwapChainRenderPass(VkCommandBuffer commandBuffer)
@@ -158,6 +170,87 @@ namespace VulkanCore {
 		vkCmdEndRenderPass(commandBuffer);
 	}
 
+	void Renderer::RecordSecondaryCommandBuffers(VkCommandBuffer commandBuffer, uint32_t subpass, uint32_t count, const std::function<void(VkCommandBuffer, uint32_t)>& record, uint32_t threadCount)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		std::vector<SecondaryCommandPool>& framePools = secondaryCommandPools[swapChain->GetCurrentFrameIndex()];
+		const uint32_t maxBatchCount = threadCount == 0 ? static_cast<uint32_t>(framePools.size()) : std::min(threadCount, static_cast<uint32_t>(framePools.size()));
+		const uint32_t batchCount = std::min(count, maxBatchCount);
+
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = swapChain->GetRenderPass();
+		inheritanceInfo.subpass = subpass;
+		inheritanceInfo.framebuffer = swapChain->GetSwapChainFramebuffer(currentImageIndex);
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		secondaryCommandBuffers.resize(count);
+
+		// One job per batch: a pool is only ever used by the thread running its batch, whichever thread that is
+		JobSystem::GetInstance().ParallelFor(batchCount, 1, [&](uint64_t batchBegin, uint64_t batchEnd)
+		{
+			for (uint64_t batch = batchBegin; batch < batchEnd; ++batch)
+			{
+				PROFILE_ZONE("Renderer::RecordSecondaryCommandBuffers");
+
+				SecondaryCommandPool& pool = framePools[batch];
+				const uint32_t begin = static_cast<uint32_t>(batch * count / batchCount);
+				const uint32_t end = static_cast<uint32_t>((batch + 1) * count / batchCount);
+				for (uint32_t index = begin; index < end; ++index)
+				{
+					VkCommandBuffer secondaryCommandBuffer = AcquireSecondaryCommandBuffer(pool);
+					if (vkBeginCommandBuffer(secondaryCommandBuffer, &beginInfo) != VK_SUCCESS)
+					{
+						throw std::runtime_error("Failed to begin recording secondary command buffer!");
+					}
+
+					SetViewportAndScissor(secondaryCommandBuffer);
+					record(secondaryCommandBuffer, index);
+
+					if (vkEndCommandBuffer(secondaryCommandBuffer) != VK_SUCCESS)
+					{
+						throw std::runtime_error("Failed to record secondary command buffer!");
+					}
+
+					secondaryCommandBuffers[index] = secondaryCommandBuffer;
+				}
+			}
+		});
+
+		vkCmdExecuteCommands(commandBuffer, count, secondaryCommandBuffers.data());
+	}
+
+	void Renderer::SetPreferredPresentMode(VkPresentModeKHR presentMode)
+	{
+		if (presentMode == preferredPresentMode)
+		{
+			return;
+		}
+
+		preferredPresentMode = presentMode;
+		RecreateSwapChain();
+	}
+
+	// The render pass changes, pipelines created against it have to be recreated by the caller
+	void Renderer::SetPreferredSampleCount(VkSampleCountFlagBits sampleCount)
+	{
+		if (sampleCount == preferredSampleCount)
+		{
+			return;
+		}
+
+		preferredSampleCount = sampleCount;
+		RecreateSwapChain();
+	}
+
 	void Renderer::CreateCommandBuffers()
 	{
 		commandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
@@ -204,22 +297,97 @@ namespace VulkanCore {
 		}
 	}
 
+	void Renderer::CreateSecondaryCommandPools()
+	{
+		// Transient: every secondary command buffer is recorded once, the whole pool is reset when its frame comes around again
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = device.GetPhysicalQueueFamilies().graphicsAndComputeFamily.value();
+
+		for (std::vector<SecondaryCommandPool>& framePools : secondaryCommandPools)
+		{
+			framePools.resize(JobSystem::GetInstance().GetThreadCount());
+			for (SecondaryCommandPool& pool : framePools)
+			{
+				if (vkCreateCommandPool(device.GetVKDevice(), &poolInfo, nullptr, &pool.commandPool) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to create secondary command pool!");
+				}
+			}
+		}
+	}
+
+	// SyncNewFrame waited for the previous submission, nothing recorded from these pools is still in use
+	void Renderer::ResetSecondaryCommandPools()
+	{
+		for (SecondaryCommandPool& pool : secondaryCommandPools[swapChain->GetCurrentFrameIndex()])
+		{
+			if (pool.usedCount == 0)
+			{
+				continue;
+			}
+
+			vkResetCommandPool(device.GetVKDevice(), pool.commandPool, 0);
+			pool.usedCount = 0;
+		}
+	}
+
+	VkCommandBuffer Renderer::AcquireSecondaryCommandBuffer(SecondaryCommandPool& pool)
+	{
+		if (pool.usedCount == pool.commandBuffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = pool.commandPool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			if (vkAllocateCommandBuffers(device.GetVKDevice(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate secondary command buffer!");
+			}
+			pool.commandBuffers.push_back(commandBuffer);
+		}
+
+		return pool.commandBuffers[pool.usedCount++];
+	}
+
+	void Renderer::SetViewportAndScissor(VkCommandBuffer commandBuffer)
+	{
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(swapChain->GetSwapChainExtent().width);
+		viewport.height = static_cast<float>(swapChain->GetSwapChainExtent().height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor{};
+		scissor.offset = { 0, 0 };
+		scissor.extent = swapChain->GetSwapChainExtent();
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
 	void Renderer::RecreateSwapChain()
 	{
-		// Handling minimization
-		int width = window.GetWidth();
-		int height = window.GetHeight();
-		while (width == 0 || height == 0)
+		// Handling minimization, the main thread keeps pumping events and updates the size
+		while ((window.GetWidth() == 0 || window.GetHeight() == 0) && !window.ShouldClose())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(MINIMIZED_POLL_MILLISECONDS));
+		}
+
+		if (window.GetWidth() == 0 || window.GetHeight() == 0)
 		{
-			width = window.GetWidth();
-			height = window.GetHeight();
-			glfwWaitEvents();
+			return;
 		}
 
 		vkDeviceWaitIdle(device.GetVKDevice());
 
 		swapChain.reset(nullptr);
-		swapChain = std::make_unique<SwapChain>(device, window);
+		swapChain = std::make_unique<SwapChain>(device, window, preferredPresentMode, preferredSampleCount);
 	}
 
 } // namespace VulkanCore
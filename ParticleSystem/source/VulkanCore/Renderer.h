@@ -2,7 +2,10 @@
 
 #include <glm/glm.hpp>
 
+#include <array>
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "Window.h"
 #include "GPUDevice.h"
@@ -29,26 +32,49 @@ namespace VulkanCore {
 		Renderer& operator = (Renderer&&) = delete;
 
 		VkCommandBuffer BeginFrame();
-		void EndFrame();
+		void EndFrame(VkFence fence = VK_NULL_HANDLE);
 
 		VkCommandBuffer BeginCompute();
 		void EndCompute();
 
 		void SyncNewFrame();
 
-		void BeginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		// A subpass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS is recorded with RecordSecondaryCommandBuffers
+		void BeginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+		void NextSwapChainSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void EndSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+		// Records count secondary command buffers for the current subpass on the job system and executes them in index order.
+		// record(secondaryCommandBuffer, index) is called once per index, the viewport and the scissor are already set.
+		// The indices are split in contiguous batches, one per recording thread, and every batch records from its own command pool,
+		// so the primary command buffer is the same whichever thread recorded which batch.
+		// At most threadCount threads record at once, 0 for every job system thread.
+		void RecordSecondaryCommandBuffers(VkCommandBuffer commandBuffer, uint32_t subpass, uint32_t count, const std::function<void(VkCommandBuffer, uint32_t)>& record, uint32_t threadCount = 0);
+
+		// Recreates the swap chain if the present mode is different
+		void SetPreferredPresentMode(VkPresentModeKHR presentMode);
+		void SetPreferredSampleCount(VkSampleCountFlagBits sampleCount);
+
 		// Getters
 		inline const std::unique_ptr<SwapChain>& GetSwapChain() const { return swapChain; }
 
 		inline uint32_t GetCurrentImageIndex() const { return currentImageIndex; }
+		inline VkPresentModeKHR GetPresentMode() const { return swapChain->GetPresentMode(); }
+		inline VkSampleCountFlagBits GetSampleCount() const { return swapChain->GetSampleCount(); }
 		inline VkImage GetCurrentSwapchainImage() const { return swapChain->GetSwapchainImage(static_cast<size_t>(currentImageIndex)); }
 		inline VkImage GetCurrentIntermediaryImage() const { return swapChain->GetIntermediaryImage(static_cast<size_t>(currentImageIndex)); }
 
-		inline VkFramebuffer GetCurrentImGuiFramebuffer() const { return swapChain->GetImGuiFramebuffer(currentImageIndex); }
-
 	private:
+		static constexpr uint32_t MINIMIZED_POLL_MILLISECONDS = 10;
+
+		// Pool of a recording batch, reset as a whole once the frame that used it is done
+		struct SecondaryCommandPool
+		{
+			VkCommandPool commandPool = VK_NULL_HANDLE;
+			std::vector<VkCommandBuffer> commandBuffers;
+			uint32_t usedCount = 0;
+		};
+
 		Window& window;
 		GPUDevice& device;
 		std::unique_ptr<SwapChain> swapChain;
@@ -56,11 +82,22 @@ namespace VulkanCore {
 		std::vector<VkCommandBuffer> commandBuffers;
 		std::vector<VkCommandBuffer> computeCommandBuffers;
 		VkCommandBuffer syncNewFrameCommandBuffer;
+
+		// [frame in flight][recording batch], one batch per job system thread at most
+		std::array<std::vector<SecondaryCommandPool>, SwapChain::MAX_FRAMES_IN_FLIGHT> secondaryCommandPools;
+		std::vector<VkCommandBuffer> secondaryCommandBuffers;
+
 		uint32_t currentImageIndex;
+		VkPresentModeKHR preferredPresentMode;
+		VkSampleCountFlagBits preferredSampleCount;
 
 		void CreateCommandBuffers();
 		void CreateComputeCommandBuffers();
 		void CreateSyncNewFrameCommandBuffer();
+		void CreateSecondaryCommandPools();
+		void ResetSecondaryCommandPools();
+		VkCommandBuffer AcquireSecondaryCommandBuffer(SecondaryCommandPool& pool);
+		void SetViewportAndScissor(VkCommandBuffer commandBuffer);
 		void RecreateSwapChain();
 	};
 
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace VulkanCore {
+
+	// Bounded lock-free single-producer / single-consumer ring buffer
+	// TryPush must only be called from one thread and TryPop from one (other) thread
+	template<typename T, size_t Capacity>
+	class SPSCQueue final
+	{
+		static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+	public:
+		// Constructor
+		SPSCQueue() : head(0), tail(0), buffer() {}
+
+		// Not copyable
+		SPSCQueue(const SPSCQueue&) = delete;
+		SPSCQueue& operator = (const SPSCQueue&) = delete;
+
+		// Not moveable
+		SPSCQueue(SPSCQueue&&) = delete;
+		SPSCQueue& operator = (SPSCQueue&&) = delete;
+
+		// Producer, returns false if the queue is full
+		bool TryPush(const T& value)
+		{
+			const size_t currentTail = tail.load(std::memory_order_relaxed);
+			if (currentTail - head.load(std::memory_order_acquire) == Capacity)
+			{
+				return false;
+			}
+
+			buffer[currentTail & (Capacity - 1)] = value;
+			tail.store(currentTail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer, returns false if the queue is empty
+		bool TryPop(T& value)
+		{
+			const size_t currentHead = head.load(std::memory_order_relaxed);
+			if (currentHead == tail.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+
+			value = buffer[currentHead & (Capacity - 1)];
+			head.store(currentHead + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Approximate when called concurrently
+		inline bool IsEmpty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+	private:
+		// Keep the indices on separate cache lines, producer and consumer would otherwise invalidate each other
+		alignas(64) std::atomic<size_t> head;
+		alignas(64) std::atomic<size_t> tail;
+		alignas(64) std::array<T, Capacity> buffer;
+	};
+
+} // namespace VulkanCore
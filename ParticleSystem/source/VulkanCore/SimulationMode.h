@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+namespace VulkanCore {
+
+	enum class SimulationMode : uint32_t
+	{
+		Attractor = 0,			// particle.comp, mouse attractor and scripted force sources
+		NBodyAllPairs = 1,		// nbody_direct.comp, O(N^2) tiled in shared memory
+		NBodyBarnesHut = 2,		// nbody_tree.comp + nbody_barneshut.comp, O(N log N)
+		Fluid = 3,				// spatial_grid.comp + sph_fluid.comp, SPH over a neighbour grid
+		Emitters = 4			// particle_emitter.comp, particles born and killed on the GPU, drawn indirectly
+	};
+
+} // namespace VulkanCore
@@ -0,0 +1,193 @@
+#include "SpatialGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+#include "Particle.h"
+
+namespace VulkanCore {
+
+	SpatialGrid::SpatialGrid(GPUDevice& device)
+		: device(device)
+		, particleBuffer(VK_NULL_HANDLE)
+		, particleCount(0)
+		, cellSize(0.0f)
+		, resolution(0, 0)
+		, bHasBuffers(false)
+		, cellCountBuffer(VK_NULL_HANDLE)
+		, cellCountBufferMemory(VK_NULL_HANDLE)
+		, cellStartBuffer(VK_NULL_HANDLE)
+		, cellStartBufferMemory(VK_NULL_HANDLE)
+		, blockSumBuffer(VK_NULL_HANDLE)
+		, blockSumBufferMemory(VK_NULL_HANDLE)
+		, sortedIndexBuffer(VK_NULL_HANDLE)
+		, sortedIndexBufferMemory(VK_NULL_HANDLE)
+		, descriptorSet(VK_NULL_HANDLE)
+	{
+#if defined(PLATFORM_WINDOWS) || (defined(PLATFORM_LINUX) && defined(NDEBUG))
+		static const std::string gridShaderFilePath = "shaders/spatial_grid.comp.spv";
+#elif defined(PLATFORM_LINUX) && defined(DEBUG)
+		static const std::string gridShaderFilePath = "ParticleSystem/shaders/spatial_grid.comp.spv";
+#endif
+
+		descriptorSetLayout = DescriptorSetLayout::Builder(device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// particles
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// cell counts
+			.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// cell starts
+			.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// scan block sums
+			.AddBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1)		// sorted indices
+			.Build();
+
+		pipeline = std::make_unique<Pipeline>(device, descriptorSetLayout->GetDescriptorSetLayout(), gridShaderFilePath, static_cast<uint32_t>(sizeof(SpatialGridPushConstants)));
+
+		SetCellSize(DEFAULT_CELL_SIZE);
+	}
+
+	SpatialGrid::~SpatialGrid()
+	{
+		CleanupBuffers();
+	}
+
+	void SpatialGrid::SetParticles(VkBuffer newParticleBuffer, uint32_t newParticleCount)
+	{
+		CleanupBuffers();
+
+		particleBuffer = newParticleBuffer;
+		particleCount = newParticleCount;
+	}
+
+	void SpatialGrid::SetCellSize(float newCellSize)
+	{
+		newCellSize = std::clamp(newCellSize, MIN_CELL_SIZE, MAX_CELL_SIZE);
+		if (newCellSize == cellSize)
+		{
+			return;
+		}
+
+		// Whole cells, the last row and column reach a little past the domain
+		const glm::uvec2 newResolution(
+			static_cast<uint32_t>(std::ceil(2.0f * DOMAIN_HALF_WIDTH / newCellSize)),
+			static_cast<uint32_t>(std::ceil(2.0f * DOMAIN_HALF_HEIGHT / newCellSize))
+		);
+
+		if (bHasBuffers && newResolution != resolution)
+		{
+			vkDeviceWaitIdle(device.GetVKDevice());
+			CleanupBuffers();
+		}
+
+		cellSize = newCellSize;
+		resolution = newResolution;
+	}
+
+	void SpatialGrid::Record(VkCommandBuffer commandBuffer)
+	{
+		if (!bHasBuffers)
+		{
+			CreateBuffers();
+		}
+
+		// The particles were just written by the simulation, the previous build is done with the counts
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		// Every count is back to 0 after a scatter, cleared anyway for the first build over new buffers
+		vkCmdFillBuffer(commandBuffer, cellCountBuffer, 0, VK_WHOLE_SIZE, 0);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		pipeline->BindComputePipeline(commandBuffer);
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetComputePipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+
+		SpatialGridPushConstants pushConstants = {};
+		pushConstants.origin = GetOrigin();
+		pushConstants.inverseCellSize = 1.0f / cellSize;
+		pushConstants.particleCount = particleCount;
+		pushConstants.resolution = resolution;
+		pushConstants.cellCount = GetCellCount();
+		pushConstants.blockCount = GetBlockCount();
+
+		// Every pass reads what the previous one wrote
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		const auto dispatchPass = [this, commandBuffer, &pushConstants, &barrier](GridPass pass, uint32_t workgroupCount)
+		{
+			pushConstants.pass = static_cast<uint32_t>(pass);
+			vkCmdPushConstants(commandBuffer, pipeline->GetComputePipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SpatialGridPushConstants), &pushConstants);
+			vkCmdDispatch(commandBuffer, workgroupCount, 1, 1);
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+		};
+
+		const uint32_t particleWorkgroupCount = (particleCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+		const uint32_t cellWorkgroupCount = (GetCellCount() + 1 + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+
+		dispatchPass(GridPass::Count, particleWorkgroupCount);
+		dispatchPass(GridPass::ScanBlocks, GetBlockCount());
+		dispatchPass(GridPass::ScanBlockSums, 1);
+		dispatchPass(GridPass::ScanAdd, cellWorkgroupCount);
+		dispatchPass(GridPass::Scatter, particleWorkgroupCount);
+	}
+
+	void SpatialGrid::CreateBuffers()
+	{
+		const VkDeviceSize cellCount = GetCellCount();
+
+		device.CreateBuffer(sizeof(uint32_t) * cellCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, cellCountBuffer, cellCountBufferMemory);
+		device.CreateBuffer(sizeof(uint32_t) * (cellCount + 1), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, cellStartBuffer, cellStartBufferMemory);
+		device.CreateBuffer(sizeof(uint32_t) * GetBlockCount(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, blockSumBuffer, blockSumBufferMemory);
+		device.CreateBuffer(sizeof(uint32_t) * static_cast<VkDeviceSize>(std::max(particleCount, 1u)), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, sortedIndexBuffer, sortedIndexBufferMemory);
+
+		descriptorPool = DescriptorPool::Builder(device)
+			.SetMaxSets(1)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5)
+			.Build();
+
+		const VkDescriptorBufferInfo particleBufferInfo = { particleBuffer, 0, sizeof(Particle) * static_cast<VkDeviceSize>(particleCount) };
+		const VkDescriptorBufferInfo cellCountBufferInfo = { cellCountBuffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo cellStartBufferInfo = { cellStartBuffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo blockSumBufferInfo = { blockSumBuffer, 0, VK_WHOLE_SIZE };
+		const VkDescriptorBufferInfo sortedIndexBufferInfo = { sortedIndexBuffer, 0, VK_WHOLE_SIZE };
+
+		DescriptorWriter(*descriptorSetLayout, *descriptorPool)
+			.WriteBuffer(0, particleBufferInfo)
+			.WriteBuffer(1, cellCountBufferInfo)
+			.WriteBuffer(2, cellStartBufferInfo)
+			.WriteBuffer(3, blockSumBufferInfo)
+			.WriteBuffer(4, sortedIndexBufferInfo)
+			.Build(descriptorSet);
+
+		bHasBuffers = true;
+	}
+
+	void SpatialGrid::CleanupBuffers()
+	{
+		if (!bHasBuffers)
+		{
+			return;
+		}
+
+		descriptorPool.reset();
+		descriptorSet = VK_NULL_HANDLE;
+
+		vkDestroyBuffer(device.GetVKDevice(), cellCountBuffer, nullptr);
+		vkFreeMemory(device.GetVKDevice(), cellCountBufferMemory, nullptr);
+
+		vkDestroyBuffer(device.GetVKDevice(), cellStartBuffer, nullptr);
+		vkFreeMemory(device.GetVKDevice(), cellStartBufferMemory, nullptr);
+
+		vkDestroyBuffer(device.GetVKDevice(), blockSumBuffer, nullptr);
+		vkFreeMemory(device.GetVKDevice(), blockSumBufferMemory, nullptr);
+
+		vkDestroyBuffer(device.GetVKDevice(), sortedIndexBuffer, nullptr);
+		vkFreeMemory(device.GetVKDevice(), sortedIndexBufferMemory, nullptr);
+
+		bHasBuffers = false;
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "GPUDevice.h"
+#include "Descriptor.h"
+#include "Pipeline.h"
+
+namespace VulkanCore {
+
+	// Push constants of spatial_grid.comp
+	struct SpatialGridPushConstants
+	{
+		glm::vec2 origin;
+		float inverseCellSize;
+		uint32_t particleCount;
+		glm::uvec2 resolution;
+		uint32_t cellCount;
+		uint32_t pass;
+		uint32_t blockCount;
+	};
+
+	// Uniform grid neighbour index over the particle buffer, rebuilt on the GPU in linear time
+	// Particles are counting sorted by cell (count, two-level prefix scan, scatter). Later kernels bind the cell start buffer
+	// (GetCellCount + 1 entries) and the sorted index buffer: the particles of a cell are sortedIndices[cellStarts[cell] .. cellStarts[cell + 1]).
+	// The grid covers [-DOMAIN_HALF_WIDTH, DOMAIN_HALF_WIDTH] x [-DOMAIN_HALF_HEIGHT, DOMAIN_HALF_HEIGHT] in row major cells,
+	// particles outside are kept in the border cells.
+	class SpatialGrid final
+	{
+	public:
+		// Matches spatial_grid.comp
+		static constexpr uint32_t WORKGROUP_SIZE = 128;
+		static constexpr uint32_t SCAN_BLOCK_SIZE = 4 * WORKGROUP_SIZE;
+
+		static constexpr float DOMAIN_HALF_WIDTH = 2.0f;
+		static constexpr float DOMAIN_HALF_HEIGHT = 1.0f;
+
+		static constexpr float MIN_CELL_SIZE = 0.002f;
+		static constexpr float MAX_CELL_SIZE = 0.5f;
+		static constexpr float DEFAULT_CELL_SIZE = 0.01f;
+
+		// Constructor
+		SpatialGrid(GPUDevice& device);
+
+		// Destructor
+		~SpatialGrid();
+
+		// Not copyable
+		SpatialGrid(const SpatialGrid&) = delete;
+		SpatialGrid& operator = (const SpatialGrid&) = delete;
+
+		// Not moveable
+		SpatialGrid(SpatialGrid&&) = delete;
+		SpatialGrid& operator = (SpatialGrid&&) = delete;
+
+		// Call with the GPU idle whenever the particle buffer is recreated, the buffers are allocated by the next build
+		void SetParticles(VkBuffer particleBuffer, uint32_t particleCount);
+
+		// Clamped to [MIN_CELL_SIZE, MAX_CELL_SIZE], waits for the GPU if the grid has to be reallocated
+		void SetCellSize(float cellSize);
+
+		// Records the build, the cell ranges can be read by compute shaders recorded after it
+		void Record(VkCommandBuffer commandBuffer);
+
+		// Getters
+		inline VkBuffer GetCellStartBuffer() const { return cellStartBuffer; }
+		inline VkBuffer GetSortedIndexBuffer() const { return sortedIndexBuffer; }
+		inline glm::vec2 GetOrigin() const { return glm::vec2(-DOMAIN_HALF_WIDTH, -DOMAIN_HALF_HEIGHT); }
+		inline float GetCellSize() const { return cellSize; }
+		inline glm::uvec2 GetResolution() const { return resolution; }
+		inline uint32_t GetCellCount() const { return resolution.x * resolution.y; }
+		inline bool GetHasBuffers() const { return bHasBuffers; }
+
+	private:
+		// spatial_grid.comp passes in recording order
+		enum class GridPass : uint32_t
+		{
+			Count = 0,
+			ScanBlocks,
+			ScanBlockSums,
+			ScanAdd,
+			Scatter
+		};
+
+		GPUDevice& device;
+
+		VkBuffer particleBuffer;
+		uint32_t particleCount;
+
+		float cellSize;
+		glm::uvec2 resolution;
+
+		// Buffers
+		bool bHasBuffers;
+
+		VkBuffer cellCountBuffer;
+		VkDeviceMemory cellCountBufferMemory;
+
+		VkBuffer cellStartBuffer;
+		VkDeviceMemory cellStartBufferMemory;
+
+		VkBuffer blockSumBuffer;
+		VkDeviceMemory blockSumBufferMemory;
+
+		VkBuffer sortedIndexBuffer;
+		VkDeviceMemory sortedIndexBufferMemory;
+
+		// Descriptors
+		std::unique_ptr<DescriptorSetLayout> descriptorSetLayout;
+		std::unique_ptr<DescriptorPool> descriptorPool;
+		VkDescriptorSet descriptorSet;
+
+		std::unique_ptr<Pipeline> pipeline;
+
+		void CreateBuffers();
+		void CleanupBuffers();
+
+		inline uint32_t GetBlockCount() const { return (GetCellCount() + SCAN_BLOCK_SIZE - 1) / SCAN_BLOCK_SIZE; }
+	};
+
+} // namespace VulkanCore
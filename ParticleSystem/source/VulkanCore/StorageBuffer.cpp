@@ -0,0 +1,23 @@
+#include "StorageBuffer.h"
+
+namespace VulkanCore {
+
+	void StorageBuffer::Create(GPUDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties)
+	{
+		device.CreateBuffer(size, usage, properties, buffer, memory);
+	}
+
+	void StorageBuffer::Cleanup(GPUDevice& device)
+	{
+		if (buffer == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		vkDestroyBuffer(device.GetVKDevice(), buffer, nullptr);
+		vkFreeMemory(device.GetVKDevice(), memory, nullptr);
+		buffer = VK_NULL_HANDLE;
+		memory = VK_NULL_HANDLE;
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "GPUDevice.h"
+
+namespace VulkanCore {
+
+	// Buffer and the memory bound to it, owned by the GPU stage that creates it
+	struct StorageBuffer
+	{
+		VkBuffer buffer = VK_NULL_HANDLE;
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+
+		void Create(GPUDevice& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
+
+		// Does nothing if nothing was created, can be called again
+		void Cleanup(GPUDevice& device);
+	};
+
+} // namespace VulkanCore
@@ -7,11 +7,17 @@
 
 namespace VulkanCore {
 
-	SwapChain::SwapChain(GPUDevice& device, const Window& window)
+	SwapChain::SwapChain(GPUDevice& device, const Window& window, VkPresentModeKHR preferredPresentMode, VkSampleCountFlagBits preferredSampleCount)
         : device(device)
         , window(window)
+        , preferredPresentMode(preferredPresentMode)
+        , presentMode(VK_PRESENT_MODE_FIFO_KHR)
+        , bSupportsTransferSource(false)
+        , sampleCount(VK_SAMPLE_COUNT_1_BIT)
         , currentFrameIndex(0)
 	{
+        sampleCount = ChooseSampleCount(preferredSampleCount);
+
         CreateSwapChain();
         CreateRenderPass();
         CreateImageViews();
@@ -19,10 +25,6 @@ namespace VulkanCore {
         CreateIntermediaryImageViews();
         CreateFramebuffers();
         CreateSyncObjects();
-
-        // ImGui
-        CreateImGuiRenderPass();
-        CreateImGuiFramebuffers();
 	}
 
 	SwapChain::~SwapChain()
@@ -31,22 +33,16 @@ namespace VulkanCore {
         vkDestroySemaphore(device.GetVKDevice(), imageSemaphore, nullptr);
 
         // cleanup framebuffers
-        for (VkFramebuffer framebuffer : imGuiFramebuffers)
-        {
-            vkDestroyFramebuffer(device.GetVKDevice(), framebuffer, nullptr);
-        }
-        
         for (VkFramebuffer framebuffer : swapChainFramebuffers)
         {
             vkDestroyFramebuffer(device.GetVKDevice(), framebuffer, nullptr);
         }
 
         // cleanup render pass
-        vkDestroyRenderPass(device.GetVKDevice(), imGuiRenderPass, nullptr);
         vkDestroyRenderPass(device.GetVKDevice(), renderPass, nullptr);
 
         // cleanup intermediary images
-        for (size_t i = 0; i < swapChainImages.size(); ++i)
+        for (size_t i = 0; i < intermediaryImages.size(); ++i)
         {
             vkDestroyImageView(device.GetVKDevice(), intermediaryImageViews[i], nullptr);
             vkDestroyImage(device.GetVKDevice(), intermediaryImages[i], nullptr);
@@ -91,7 +87,7 @@ namespace VulkanCore {
         }
     }
 
-    VkResult SwapChain::SubmitCommandBuffer(const VkCommandBuffer* buffer, uint32_t* imageIndex)
+    VkResult SwapChain::SubmitCommandBuffer(const VkCommandBuffer* buffer, uint32_t* imageIndex, VkFence fence)
     {
         // VkSemaphore waitSemaphores[] = { computeFinishedSemaphores[currentFrameIndex], imageAvailableSemaphores[currentFrameIndex] };
         VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
@@ -112,7 +108,7 @@ namespace VulkanCore {
         // Only reset the fence if we are submitting work
         vkResetFences(device.GetVKDevice(), 1, &device.GetImageFence());
 
-        if (vkQueueSubmit(device.GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+        if (vkQueueSubmit(device.GetGraphicsQueue(), 1, &submitInfo, fence) != VK_SUCCESS)
         {
             throw std::runtime_error("Failed to submit draw command buffer!");
         }
@@ -160,7 +156,7 @@ namespace VulkanCore {
         SwapChainSupportDetails swapChainSupport = device.GetSwapChainSupport();
 
         VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
-        VkPresentModeKHR presentMode = ChooseSwapPresentMode(swapChainSupport.presentModes);
+        presentMode = ChooseSwapPresentMode(swapChainSupport.presentModes);
         VkExtent2D extent = ChooseSwapExtent(swapChainSupport.capabilities);
 
         uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -179,6 +175,13 @@ namespace VulkanCore {
         createInfo.imageArrayLayers = 1;
         createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+        // Needed by the frame capture readback
+        bSupportsTransferSource = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+        if (bSupportsTransferSource)
+        {
+            createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+
         QueueFamilyIndices indices = device.GetPhysicalQueueFamilies();
         uint32_t queueFamilyIndices[] = { indices.graphicsAndComputeFamily.value(), indices.presentFamily.value()};
 
@@ -249,8 +252,31 @@ namespace VulkanCore {
         }
     }
 
+    VkSampleCountFlagBits SwapChain::ChooseSampleCount(VkSampleCountFlagBits preferredSampleCount) const
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device.GetPhysicalDevice(), &properties);
+
+        // Highest supported sample count that does not exceed the preferred one
+        for (VkSampleCountFlagBits candidate : { VK_SAMPLE_COUNT_64_BIT, VK_SAMPLE_COUNT_32_BIT, VK_SAMPLE_COUNT_16_BIT, VK_SAMPLE_COUNT_8_BIT, VK_SAMPLE_COUNT_4_BIT, VK_SAMPLE_COUNT_2_BIT })
+        {
+            if (candidate <= preferredSampleCount && (properties.limits.framebufferColorSampleCounts & candidate))
+            {
+                return candidate;
+            }
+        }
+
+        return VK_SAMPLE_COUNT_1_BIT;
+    }
+
     void SwapChain::CreateIntermediaryImageViews()
     {
+        // Nothing to resolve
+        if (sampleCount == VK_SAMPLE_COUNT_1_BIT)
+        {
+            return;
+        }
+
         intermediaryImageMemories.resize(swapChainImages.size());
         intermediaryImages.resize(swapChainImages.size());
         for (size_t i = 0; i < swapChainImages.size(); ++i)
@@ -260,7 +286,7 @@ namespace VulkanCore {
                 swapChainExtent.width,
                 swapChainExtent.height,
                 VK_IMAGE_TILING_OPTIMAL,
-                VK_SAMPLE_COUNT_8_BIT,
+                sampleCount,
                 VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                 intermediaryImages[i],
@@ -277,49 +303,92 @@ namespace VulkanCore {
 
     void SwapChain::CreateRenderPass()
     {
+        // Only lives inside the render pass: cleared on load and discarded after the resolve
         VkAttachmentDescription intermediaryAttachment = {};
         intermediaryAttachment.format = swapChainImageFormat;
-        intermediaryAttachment.samples = VK_SAMPLE_COUNT_8_BIT;
+        intermediaryAttachment.samples = sampleCount;
         intermediaryAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
         intermediaryAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        intermediaryAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        intermediaryAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         intermediaryAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        intermediaryAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        intermediaryAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
         intermediaryAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+        // Fully overwritten by the resolve, no need to load it
         VkAttachmentDescription colorAttachment = {};
         colorAttachment.format = swapChainImageFormat;
         colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
-        // Color Attachment Ref for Subpass = intermediaryAttachment
-        VkAttachmentReference colorAttachmentRef = {};
-        colorAttachmentRef.attachment = 0;
-        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        // Subpass 0 - Particles: render to intermediaryAttachment, resolve to colorAttachment
+        VkAttachmentReference intermediaryAttachmentRef = {};
+        intermediaryAttachmentRef.attachment = 0;
+        intermediaryAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-        // Resolve Attachment Ref for Subpass = colorAttachment
         VkAttachmentReference resolveAttachmentRef = {};
         resolveAttachmentRef.attachment = 1;
-        resolveAttachmentRef.layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        resolveAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        // Subpass 1 - UI: render on top of the resolved colorAttachment
+        VkAttachmentReference colorAttachmentRef = {};
+        colorAttachmentRef.attachment = 1;
+        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-        VkSubpassDescription subpass = {};
-        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        subpass.colorAttachmentCount = 1;
-        subpass.pColorAttachments = &colorAttachmentRef;
-        subpass.pResolveAttachments = &resolveAttachmentRef;
+        std::array<VkSubpassDescription, SUBPASS_COUNT> subpasses = {};
+        subpasses[PARTICLE_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpasses[PARTICLE_SUBPASS].colorAttachmentCount = 1;
+        subpasses[PARTICLE_SUBPASS].pColorAttachments = &intermediaryAttachmentRef;
+        subpasses[PARTICLE_SUBPASS].pResolveAttachments = &resolveAttachmentRef;
+
+        subpasses[UI_SUBPASS].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpasses[UI_SUBPASS].colorAttachmentCount = 1;
+        subpasses[UI_SUBPASS].pColorAttachments = &colorAttachmentRef;
+
+        std::array<VkSubpassDependency, 2> dependencies = {};
+
+        // Wait for the presentation engine to release the swap chain image
+        dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+        dependencies[0].dstSubpass = PARTICLE_SUBPASS;
+        dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[0].srcAccessMask = 0;
+        dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+        // The resolve must land before the UI blends on top of it
+        dependencies[1].srcSubpass = PARTICLE_SUBPASS;
+        dependencies[1].dstSubpass = UI_SUBPASS;
+        dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        dependencies[1].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+        std::vector<VkAttachmentDescription> attachments = { intermediaryAttachment, colorAttachment };
+
+        // Without multi-sampling the particles are drawn directly into colorAttachment, which becomes attachment 0
+        if (sampleCount == VK_SAMPLE_COUNT_1_BIT)
+        {
+            colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            attachments = { colorAttachment };
+
+            intermediaryAttachmentRef.attachment = 0;
+            colorAttachmentRef.attachment = 0;
+            subpasses[PARTICLE_SUBPASS].pResolveAttachments = nullptr;
+        }
 
-        std::array<VkAttachmentDescription, 2> attachments = { intermediaryAttachment, colorAttachment };
         VkRenderPassCreateInfo renderPassInfo = {};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
         renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
         renderPassInfo.pAttachments = attachments.data();
-        renderPassInfo.subpassCount = 1;
-        renderPassInfo.pSubpasses = &subpass;
+        renderPassInfo.subpassCount = static_cast<uint32_t>(subpasses.size());
+        renderPassInfo.pSubpasses = subpasses.data();
+        renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassInfo.pDependencies = dependencies.data();
 
         if (vkCreateRenderPass(device.GetVKDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
         {
@@ -333,10 +402,11 @@ namespace VulkanCore {
 
         for (size_t i = 0; i < swapChainImageViews.size(); ++i)
         {
-            std::array<VkImageView, 2> attachments = {
-                intermediaryImageViews[i],
-                swapChainImageViews[i]
-            };
+            std::vector<VkImageView> attachments = { swapChainImageViews[i] };
+            if (sampleCount != VK_SAMPLE_COUNT_1_BIT)
+            {
+                attachments = { intermediaryImageViews[i], swapChainImageViews[i] };
+            }
 
             VkFramebufferCreateInfo framebufferInfo = {};
             framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
@@ -404,78 +474,6 @@ namespace VulkanCore {
         depthImageView = CreateImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
     }
 
-    void SwapChain::CreateImGuiRenderPass()
-    {
-        VkAttachmentDescription colorAttachment = {};
-        colorAttachment.format = VK_FORMAT_B8G8R8A8_SRGB;
-        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-        VkAttachmentReference colorAttachmentRef = {};
-        colorAttachmentRef.attachment = 0;
-        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        VkSubpassDescription subpass = {};
-        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        subpass.colorAttachmentCount = 1;
-        subpass.pColorAttachments = &colorAttachmentRef;
-
-        VkSubpassDependency dependency = {};
-        dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-        dependency.dstSubpass = 0;
-        dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        dependency.srcAccessMask = 0;
-        dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-        std::array<VkAttachmentDescription, 1> attachments = {
-            colorAttachment
-        };
-
-        VkRenderPassCreateInfo renderPassInfo = {};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-        renderPassInfo.pAttachments = attachments.data();
-        renderPassInfo.subpassCount = 1;
-        renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
-
-        if (vkCreateRenderPass(device.GetVKDevice(), &renderPassInfo, nullptr, &imGuiRenderPass) != VK_SUCCESS)
-        {
-            throw std::runtime_error("Failed to create ImGui render pass!");
-        }
-    }
-
-    void SwapChain::CreateImGuiFramebuffers()
-    {
-        imGuiFramebuffers.resize(swapChainImages.size());
-
-        for (size_t i = 0; i < imGuiFramebuffers.size(); ++i)
-        {
-            std::array<VkImageView, 1> attachments = {
-                swapChainImageViews[i]
-            };
-
-            VkFramebufferCreateInfo framebufferInfo = {};
-            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            framebufferInfo.renderPass = imGuiRenderPass;
-            framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-            framebufferInfo.pAttachments = attachments.data();
-            framebufferInfo.width = swapChainExtent.width;
-            framebufferInfo.height = swapChainExtent.height;
-            framebufferInfo.layers = 1;
-
-            if (vkCreateFramebuffer(device.GetVKDevice(), &framebufferInfo, nullptr, &imGuiFramebuffers[i]) != VK_SUCCESS)
-            {
-                throw std::runtime_error("Failed to create ImGui framebuffer!");
-            }
-        }
-    }
-
     VkSurfaceFormatKHR SwapChain::ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
     {
         for (const VkSurfaceFormatKHR& availableFormat : availableFormats)
@@ -493,6 +491,21 @@ namespace VulkanCore {
     {
         // [DEBUG] list all available present modes
 
+        // Requested by the frame pacing policy
+        for (const VkPresentModeKHR& availablePresentMode : availablePresentModes)
+        {
+            if (availablePresentMode == preferredPresentMode)
+            {
+                return availablePresentMode;
+            }
+        }
+
+        // The display paces the application, no reason to look for something else
+        if (preferredPresentMode == VK_PRESENT_MODE_FIFO_KHR)
+        {
+            return VK_PRESENT_MODE_FIFO_KHR;
+        }
+
         for (const VkPresentModeKHR& availablePresentMode : availablePresentModes)
         {
             if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
@@ -11,9 +11,14 @@ namespace VulkanCore {
 	{
 	public:
         static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+
+        // Subpasses of the swap chain render pass
+        static constexpr uint32_t PARTICLE_SUBPASS = 0;
+        static constexpr uint32_t UI_SUBPASS = 1;
+        static constexpr uint32_t SUBPASS_COUNT = 2;
         
         // Constructor
-        SwapChain(GPUDevice& device, const Window& window);
+        SwapChain(GPUDevice& device, const Window& window, VkPresentModeKHR preferredPresentMode, VkSampleCountFlagBits preferredSampleCount);
 
         // Destructor
         ~SwapChain();
@@ -30,18 +35,20 @@ namespace VulkanCore {
         // void AcquireNextCompute();
 
         void SubmitComputeCommandBuffer(const VkCommandBuffer* buffer);
-        VkResult SubmitCommandBuffer(const VkCommandBuffer* buffer, uint32_t* imageIndex);
+        VkResult SubmitCommandBuffer(const VkCommandBuffer* buffer, uint32_t* imageIndex, VkFence fence = VK_NULL_HANDLE);
         void SubmitSyncNewFrameCommandBuffer(const VkCommandBuffer* buffer);
 
         void AdvanceFrameIndex();
 
         // Getters
         inline VkExtent2D GetSwapChainExtent() const { return swapChainExtent; }
+        inline VkFormat GetSwapChainImageFormat() const { return swapChainImageFormat; }
         inline VkRenderPass GetRenderPass() const { return renderPass; }
-        inline VkRenderPass GetImGuiRenderPass() const { return imGuiRenderPass; }
         inline VkFramebuffer GetSwapChainFramebuffer(const size_t& index) const { return swapChainFramebuffers[index]; }
-        inline VkFramebuffer GetImGuiFramebuffer(const size_t& index) const { return imGuiFramebuffers[index]; }
         inline uint32_t GetCurrentFrameIndex() const { return currentFrameIndex; }
+        inline VkPresentModeKHR GetPresentMode() const { return presentMode; }
+        inline VkSampleCountFlagBits GetSampleCount() const { return sampleCount; }
+        inline bool GetSupportsTransferSource() const { return bSupportsTransferSource; }
         
         inline VkImage GetIntermediaryImage(const size_t& index) const { return intermediaryImages[index]; }
         inline VkImage GetSwapchainImage(const size_t& index) const { return swapChainImages[index]; }
@@ -54,9 +61,17 @@ namespace VulkanCore {
         VkRenderPass renderPass;
 
         VkSwapchainKHR swapChain;
+        VkPresentModeKHR preferredPresentMode;
+        VkPresentModeKHR presentMode;
         VkFormat swapChainImageFormat;
         VkExtent2D swapChainExtent;
 
+        // The images can be copied from, not every surface allows VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+        bool bSupportsTransferSource;
+
+        // VK_SAMPLE_COUNT_1_BIT renders the particles straight into the swap chain image
+        VkSampleCountFlagBits sampleCount;
+
         // Color Images
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
@@ -78,16 +93,13 @@ namespace VulkanCore {
 
         VkSemaphore imageSemaphore;
 
-        // ImGui
-        VkRenderPass imGuiRenderPass;
-        std::vector<VkFramebuffer> imGuiFramebuffers;
-
         // depth image and view
         VkImage depthImage;
         VkDeviceMemory depthImageMemory;
         VkImageView depthImageView;
 
         void CreateSwapChain();
+        VkSampleCountFlagBits ChooseSampleCount(VkSampleCountFlagBits preferredSampleCount) const;
         VkImageView CreateImageView(const VkImage& image, const VkFormat& format, const VkImageAspectFlags& aspectMask) const;
         void CreateImageViews();
         void CreateIntermediaryImageViews();
@@ -96,10 +108,6 @@ namespace VulkanCore {
         void CreateSyncObjects();
         void CreateDepthResources();
 
-        // ImGui
-        void CreateImGuiRenderPass();
-        void CreateImGuiFramebuffers();
-
         VkSurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
         VkPresentModeKHR ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
         VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
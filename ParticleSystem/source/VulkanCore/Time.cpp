@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <type_traits>
 
 namespace VulkanCore {
 
@@ -41,8 +42,22 @@ namespace VulkanCore {
     template<typename T>
     T TimeToMilliseconds(Time t)
     {
-        return static_cast<T>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::nanoseconds(t.value)).count());
+        // Floating point results keep the fraction, integer results are truncated to whole milliseconds
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            return std::chrono::duration<T, std::milli>(std::chrono::nanoseconds(t.value)).count();
+        }
+        else
+        {
+            return static_cast<T>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::nanoseconds(t.value)).count());
+        }
     }
+    template float TimeToMilliseconds<float>(Time t);
+    template double TimeToMilliseconds<double>(Time t);
+    template int32_t TimeToMilliseconds<int32_t>(Time t);
+    template int64_t TimeToMilliseconds<int64_t>(Time t);
+    template uint32_t TimeToMilliseconds<uint32_t>(Time t);
+    template uint64_t TimeToMilliseconds<uint64_t>(Time t);
 
     //////////////////////////////
     // MillisecondsToTime
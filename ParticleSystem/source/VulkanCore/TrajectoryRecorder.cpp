@@ -0,0 +1,608 @@
+#include "TrajectoryRecorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "Particle.h"
+#include "Profiler.h"
+#include "JobSystem.h"
+
+namespace VulkanCore {
+
+	namespace {
+
+		// Positions further out than this are clamped, neighbouring deltas then always fit in 32 bits
+		constexpr float MAX_QUANTIZED = static_cast<float>(1 << 29);
+
+		inline int32_t Quantize(float value)
+		{
+			const float scaled = value * (1.0f / TrajectoryRecorder::QUANTIZATION_STEP);
+			if (!(scaled == scaled))
+			{
+				return 0;	// NaN
+			}
+
+			return static_cast<int32_t>(std::lround(std::clamp(scaled, -MAX_QUANTIZED, MAX_QUANTIZED)));
+		}
+
+		inline uint32_t ZigZagEncode(int32_t value)
+		{
+			return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+		}
+
+		inline int32_t ZigZagDecode(uint32_t value)
+		{
+			return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+		}
+
+		inline void WriteVarint(std::vector<uint8_t>& out, uint32_t value)
+		{
+			while (value >= 0x80)
+			{
+				out.push_back(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+			out.push_back(static_cast<uint8_t>(value));
+		}
+
+		inline uint32_t ReadVarint(const uint8_t*& data, const uint8_t* end)
+		{
+			uint32_t value = 0;
+			for (uint32_t shift = 0; shift < 35; shift += 7)
+			{
+				if (data == end)
+				{
+					throw std::runtime_error("ERROR: Trajectory block is truncated!");
+				}
+
+				const uint8_t byte = *data++;
+				value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0)
+				{
+					return value;
+				}
+			}
+
+			throw std::runtime_error("ERROR: Trajectory block is corrupted!");
+		}
+
+	} // namespace
+
+	TrajectoryRecorder::TrajectoryRecorder(GPUDevice& device)
+		: device(device)
+		, nextSlot(0)
+		, bIsRecording(false)
+		, particleCount(0)
+		, particleStride(1)
+		, tickInterval(1)
+		, header({})
+		, recordedFrameCount(0)
+		, droppedFrameCount(0)
+		, writtenBytes(0)
+		, fileOffset(0)
+		, bStopEncoder(false)
+	{
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = device.GetCommandPool();
+		allocInfo.commandBufferCount = 1;
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		for (ReadbackSlot& slot : slots)
+		{
+			if (vkAllocateCommandBuffers(device.GetVKDevice(), &allocInfo, &slot.commandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate trajectory command buffer!");
+			}
+
+			if (vkCreateFence(device.GetVKDevice(), &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create trajectory fence!");
+			}
+		}
+	}
+
+	TrajectoryRecorder::~TrajectoryRecorder()
+	{
+		Stop();
+
+		for (ReadbackSlot& slot : slots)
+		{
+			CleanupSlot(slot);
+			vkDestroyFence(device.GetVKDevice(), slot.fence, nullptr);
+			vkFreeCommandBuffers(device.GetVKDevice(), device.GetCommandPool(), 1, &slot.commandBuffer);
+		}
+	}
+
+	void TrajectoryRecorder::Start(const std::string& filePath, uint32_t newParticleCount, uint32_t newParticleStride, uint32_t newTickInterval)
+	{
+		if (bIsRecording || newParticleCount == 0)
+		{
+			return;
+		}
+
+		file.open(filePath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cout << "ERROR: Could not open " << filePath << " for trajectory recording" << std::endl;
+			return;
+		}
+
+		particleCount = newParticleCount;
+		particleStride = std::clamp(newParticleStride, 1u, newParticleCount);
+		tickInterval = std::max(newTickInterval, 1u);
+
+		// Readback buffers only change size with the particle count
+		const VkDeviceSize slotSize = static_cast<VkDeviceSize>(particleCount) * sizeof(Particle);
+		for (ReadbackSlot& slot : slots)
+		{
+			CleanupSlot(slot);
+			CreateSlot(slot, slotSize);
+		}
+
+		// frameCount, chunkCount and indexOffset are patched once the recording stops
+		header = {};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.version = VERSION;
+		header.headerSize = sizeof(TrajectoryFileHeader);
+		header.codec = TrajectoryCodec::ZigZagVarint;
+		header.quantizationStep = QUANTIZATION_STEP;
+		header.particleStride = particleStride;
+		header.particleCount = (particleCount + particleStride - 1) / particleStride;
+		header.framesPerChunk = FRAMES_PER_CHUNK;
+		header.tickInterval = tickInterval;
+		header.blockParticleCount = BLOCK_PARTICLE_COUNT;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		previousFrame.assign(header.particleCount * 2, 0);
+		encodedBlocks.clear();
+		chunkIndex.clear();
+		fileOffset = sizeof(header);
+
+		nextSlot = 0;
+		recordedFrameCount = 0;
+		droppedFrameCount = 0;
+		writtenBytes = sizeof(header);
+
+		bStopEncoder = false;
+		encoderThread = std::thread(&TrajectoryRecorder::EncoderLoop, this);
+
+		bIsRecording = true;
+	}
+
+	void TrajectoryRecorder::Stop()
+	{
+		if (!bIsRecording)
+		{
+			return;
+		}
+
+		// Flush the readbacks still on the GPU
+		for (uint32_t slotIndex : inFlightSlots)
+		{
+			vkWaitForFences(device.GetVKDevice(), 1, &slots[slotIndex].fence, VK_TRUE, UINT64_MAX);
+		}
+		Poll();
+
+		{
+			std::lock_guard<std::mutex> lock(encoderMutex);
+			bStopEncoder = true;
+		}
+		encoderCondition.notify_one();
+		encoderThread.join();
+
+		WriteIndex();
+		file.close();
+
+		std::cout << "Trajectory recorded: " << header.frameCount << " frames of " << header.particleCount << " particles, "
+			<< droppedFrameCount << " dropped, " << static_cast<double>(writtenBytes.load()) / (1024.0 * 1024.0) << " MiB" << std::endl;
+
+		// Readback buffers of a large simulation are too big to keep around
+		for (ReadbackSlot& slot : slots)
+		{
+			CleanupSlot(slot);
+		}
+		previousFrame = std::vector<int32_t>();
+
+		bIsRecording = false;
+	}
+
+	void TrajectoryRecorder::Record(VkBuffer shaderStorageBuffer, uint64_t tick)
+	{
+		if (!bIsRecording || tick % tickInterval != 0)
+		{
+			return;
+		}
+
+		ReadbackSlot& slot = slots[nextSlot];
+		if (slot.state.load(std::memory_order_acquire) != SlotState::Free)
+		{
+			++droppedFrameCount;
+			return;
+		}
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(slot.commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin recording trajectory command buffer!");
+		}
+
+		// The simulation step was submitted earlier on the same queue, wait for its writes
+		VkMemoryBarrier computeToTransfer = {};
+		computeToTransfer.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		computeToTransfer.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		computeToTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &computeToTransfer, 0, nullptr, 0, nullptr);
+
+		// The whole buffer is copied, subsampling thousands of regions on the GPU costs more than skipping particles on the CPU
+		VkBufferCopy region = {};
+		region.srcOffset = 0;
+		region.dstOffset = 0;
+		region.size = static_cast<VkDeviceSize>(particleCount) * sizeof(Particle);
+		vkCmdCopyBuffer(slot.commandBuffer, shaderStorageBuffer, slot.buffer, 1, &region);
+
+		VkMemoryBarrier transferToHost = {};
+		transferToHost.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		transferToHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		transferToHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		vkCmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &transferToHost, 0, nullptr, 0, nullptr);
+
+		// The next tick writes the particles from a later submission on this queue, it must not overtake the copy
+		vkCmdPipelineBarrier(slot.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+		if (vkEndCommandBuffer(slot.commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record trajectory command buffer!");
+		}
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &slot.commandBuffer;
+
+		vkResetFences(device.GetVKDevice(), 1, &slot.fence);
+		if (vkQueueSubmit(device.GetComputeQueue(), 1, &submitInfo, slot.fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit trajectory command buffer!");
+		}
+
+		slot.tick = tick;
+		slot.state.store(SlotState::InFlight, std::memory_order_release);
+		inFlightSlots.push_back(nextSlot);
+		nextSlot = (nextSlot + 1) % READBACK_SLOT_COUNT;
+	}
+
+	void TrajectoryRecorder::Poll()
+	{
+		bool bHasNewFrames = false;
+
+		// Frames have to reach the encoder in order, the next frame is delta coded against the previous one
+		while (!inFlightSlots.empty())
+		{
+			ReadbackSlot& slot = slots[inFlightSlots.front()];
+			if (vkGetFenceStatus(device.GetVKDevice(), slot.fence) != VK_SUCCESS)
+			{
+				break;
+			}
+
+			slot.state.store(SlotState::Encoding, std::memory_order_release);
+
+			std::lock_guard<std::mutex> lock(encoderMutex);
+			encoderQueue.push_back(inFlightSlots.front());
+			inFlightSlots.pop_front();
+			bHasNewFrames = true;
+		}
+
+		if (bHasNewFrames)
+		{
+			encoderCondition.notify_one();
+		}
+	}
+
+	void TrajectoryRecorder::CreateSlot(ReadbackSlot& slot, VkDeviceSize size)
+	{
+		// Prefer cached memory, CPU reads from uncached memory are an order of magnitude slower
+		VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		{
+			VkPhysicalDeviceMemoryProperties memoryProperties;
+			vkGetPhysicalDeviceMemoryProperties(device.GetPhysicalDevice(), &memoryProperties);
+
+			const VkMemoryPropertyFlags cachedProperties = properties | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+			for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+			{
+				if ((memoryProperties.memoryTypes[i].propertyFlags & cachedProperties) == cachedProperties)
+				{
+					properties = cachedProperties;
+					break;
+				}
+			}
+		}
+
+		device.CreateBuffer(
+			size,
+			VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			properties,
+			slot.buffer,
+			slot.memory
+		);
+
+		// Persistently mapped
+		vkMapMemory(device.GetVKDevice(), slot.memory, 0, size, 0, &slot.mapped);
+	}
+
+	void TrajectoryRecorder::CleanupSlot(ReadbackSlot& slot)
+	{
+		if (slot.buffer == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		vkUnmapMemory(device.GetVKDevice(), slot.memory);
+		vkDestroyBuffer(device.GetVKDevice(), slot.buffer, nullptr);
+		vkFreeMemory(device.GetVKDevice(), slot.memory, nullptr);
+
+		slot.buffer = VK_NULL_HANDLE;
+		slot.memory = VK_NULL_HANDLE;
+		slot.mapped = nullptr;
+	}
+
+	void TrajectoryRecorder::EncoderLoop()
+	{
+		Profiler::GetInstance().SetThreadName("Trajectory Encoder");
+
+		while (true)
+		{
+			uint32_t slotIndex = 0;
+			{
+				std::unique_lock<std::mutex> lock(encoderMutex);
+				encoderCondition.wait(lock, [this]() { return bStopEncoder || !encoderQueue.empty(); });
+
+				// Drain the queue before stopping
+				if (encoderQueue.empty())
+				{
+					break;
+				}
+
+				slotIndex = encoderQueue.front();
+				encoderQueue.pop_front();
+			}
+
+			ReadbackSlot& slot = slots[slotIndex];
+			EncodeFrame(slot);
+			slot.state.store(SlotState::Free, std::memory_order_release);
+		}
+	}
+
+	void TrajectoryRecorder::EncodeFrame(const ReadbackSlot& slot)
+	{
+		PROFILE_ZONE("TrajectoryRecorder::EncodeFrame");
+
+		const uint64_t frameIndex = header.frameCount;
+		const bool bIsKeyFrame = frameIndex % FRAMES_PER_CHUNK == 0;
+
+		if (bIsKeyFrame)
+		{
+			if (!chunkIndex.empty())
+			{
+				chunkIndex.back().size = fileOffset - chunkIndex.back().offset;
+			}
+			chunkIndex.push_back({ fileOffset, 0, frameIndex, 0 });
+		}
+
+		// Blocks are independent, they are encoded in parallel on the job system
+		const uint32_t blockCount = static_cast<uint32_t>((header.particleCount + BLOCK_PARTICLE_COUNT - 1) / BLOCK_PARTICLE_COUNT);
+		encodedBlocks.resize(blockCount);
+
+		const Particle* particles = static_cast<const Particle*>(slot.mapped);
+		JobSystem::GetInstance().ParallelFor(blockCount, 1, [this, particles, bIsKeyFrame](uint64_t firstBlock, uint64_t endBlock)
+		{
+			for (uint64_t block = firstBlock; block < endBlock; ++block)
+			{
+				const uint64_t firstParticle = block * BLOCK_PARTICLE_COUNT;
+				const uint64_t endParticle = std::min(firstParticle + BLOCK_PARTICLE_COUNT, header.particleCount);
+				EncodeBlock(particles, firstParticle, endParticle, bIsKeyFrame, encodedBlocks[block]);
+			}
+		});
+
+		TrajectoryFrameHeader frameHeader = {};
+		frameHeader.tick = slot.tick;
+		frameHeader.blockCount = blockCount;
+		file.write(reinterpret_cast<const char*>(&frameHeader), sizeof(frameHeader));
+
+		uint64_t frameSize = sizeof(frameHeader) + sizeof(uint64_t) * blockCount;
+		for (const std::vector<uint8_t>& block : encodedBlocks)
+		{
+			const uint64_t blockSize = block.size();
+			file.write(reinterpret_cast<const char*>(&blockSize), sizeof(blockSize));
+		}
+
+		for (const std::vector<uint8_t>& block : encodedBlocks)
+		{
+			file.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(block.size()));
+			frameSize += block.size();
+		}
+
+		fileOffset += frameSize;
+		writtenBytes.fetch_add(frameSize, std::memory_order_relaxed);
+
+		++chunkIndex.back().frameCount;
+		++header.frameCount;
+		recordedFrameCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Key frames code every particle against its neighbour, the others against the same particle in the previous frame
+	void TrajectoryRecorder::EncodeBlock(const Particle* particles, uint64_t firstParticle, uint64_t endParticle, bool bIsKeyFrame, std::vector<uint8_t>& out)
+	{
+		PROFILE_ZONE("TrajectoryRecorder::EncodeBlock");
+
+		out.clear();
+		out.reserve(static_cast<size_t>(endParticle - firstParticle) * 4);
+
+		int32_t neighbourX = 0;
+		int32_t neighbourY = 0;
+		for (uint64_t i = firstParticle; i < endParticle; ++i)
+		{
+			const glm::vec2& position = particles[i * particleStride].position;
+			const int32_t x = Quantize(position.x);
+			const int32_t y = Quantize(position.y);
+
+			int32_t& previousX = previousFrame[2 * i];
+			int32_t& previousY = previousFrame[2 * i + 1];
+
+			WriteVarint(out, ZigZagEncode(bIsKeyFrame ? x - neighbourX : x - previousX));
+			WriteVarint(out, ZigZagEncode(bIsKeyFrame ? y - neighbourY : y - previousY));
+
+			neighbourX = x;
+			neighbourY = y;
+			previousX = x;
+			previousY = y;
+		}
+	}
+
+	void TrajectoryRecorder::WriteIndex()
+	{
+		if (!chunkIndex.empty())
+		{
+			chunkIndex.back().size = fileOffset - chunkIndex.back().offset;
+		}
+
+		file.write(reinterpret_cast<const char*>(chunkIndex.data()), static_cast<std::streamsize>(chunkIndex.size() * sizeof(TrajectoryChunkIndexEntry)));
+		writtenBytes.fetch_add(chunkIndex.size() * sizeof(TrajectoryChunkIndexEntry), std::memory_order_relaxed);
+
+		header.chunkCount = chunkIndex.size();
+		header.indexOffset = fileOffset;
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	}
+
+	TrajectoryReader::TrajectoryReader(const std::string& filePath)
+		: file(filePath, MappedFileMode::Read)
+		, header({})
+		, chunkIndex(nullptr)
+	{
+		if (file.GetSize() < sizeof(TrajectoryFileHeader))
+		{
+			throw std::runtime_error("ERROR: " + filePath + " is not a trajectory file!");
+		}
+
+		std::memcpy(&header, file.GetData(), sizeof(header));
+		if (std::memcmp(header.magic, TrajectoryRecorder::MAGIC, sizeof(TrajectoryRecorder::MAGIC)) != 0
+			|| header.version != TrajectoryRecorder::VERSION || header.headerSize != sizeof(TrajectoryFileHeader) || header.codec != TrajectoryCodec::ZigZagVarint)
+		{
+			throw std::runtime_error("ERROR: " + filePath + " is not a supported trajectory file!");
+		}
+
+		// The index is only written when the recording stops cleanly
+		if (header.indexOffset == 0 || header.indexOffset > file.GetSize()
+			|| (file.GetSize() - header.indexOffset) / sizeof(TrajectoryChunkIndexEntry) < header.chunkCount
+			|| header.framesPerChunk == 0 || header.blockParticleCount == 0)
+		{
+			throw std::runtime_error("ERROR: " + filePath + " has no chunk index, the recording was interrupted!");
+		}
+
+		chunkIndex = reinterpret_cast<const TrajectoryChunkIndexEntry*>(file.GetData() + header.indexOffset);
+	}
+
+	std::vector<uint64_t> TrajectoryReader::ReadFrames(uint64_t firstFrame, uint64_t frameCount, std::vector<glm::vec2>& positions) const
+	{
+		if (firstFrame >= header.frameCount || frameCount > header.frameCount - firstFrame)
+		{
+			throw std::runtime_error("ERROR: Trajectory frames out of range!");
+		}
+
+		positions.resize(static_cast<size_t>(frameCount * header.particleCount));
+
+		std::vector<uint64_t> ticks;
+		ticks.reserve(static_cast<size_t>(frameCount));
+
+		std::vector<int32_t> current(static_cast<size_t>(header.particleCount * 2), 0);
+		const uint64_t endFrame = firstFrame + frameCount;
+		const uint8_t* const fileEnd = file.GetData() + header.indexOffset;
+
+		for (uint64_t chunk = firstFrame / header.framesPerChunk; chunk < header.chunkCount && chunkIndex[chunk].firstFrame < endFrame; ++chunk)
+		{
+			const TrajectoryChunkIndexEntry& entry = chunkIndex[chunk];
+			if (entry.offset < header.headerSize || entry.offset > header.indexOffset || entry.size > header.indexOffset - entry.offset)
+			{
+				throw std::runtime_error("ERROR: Trajectory chunk index is corrupted!");
+			}
+
+			const uint8_t* data = file.GetData() + entry.offset;
+			for (uint64_t frame = entry.firstFrame; frame < entry.firstFrame + entry.frameCount && frame < endFrame; ++frame)
+			{
+				TrajectoryFrameHeader frameHeader = {};
+				if (static_cast<size_t>(fileEnd - data) < sizeof(frameHeader))
+				{
+					throw std::runtime_error("ERROR: Trajectory frame is truncated!");
+				}
+				std::memcpy(&frameHeader, data, sizeof(frameHeader));
+				data += sizeof(frameHeader);
+
+				if (static_cast<size_t>(fileEnd - data) / sizeof(uint64_t) < frameHeader.blockCount)
+				{
+					throw std::runtime_error("ERROR: Trajectory frame is truncated!");
+				}
+				const uint8_t* blockSizes = data;
+				data += sizeof(uint64_t) * frameHeader.blockCount;
+
+				const bool bIsKeyFrame = frame == entry.firstFrame;
+				for (uint32_t block = 0; block < frameHeader.blockCount; ++block)
+				{
+					uint64_t blockSize = 0;
+					std::memcpy(&blockSize, blockSizes + sizeof(uint64_t) * block, sizeof(blockSize));
+					if (static_cast<uint64_t>(fileEnd - data) < blockSize)
+					{
+						throw std::runtime_error("ERROR: Trajectory block is truncated!");
+					}
+
+					const uint8_t* blockData = data;
+					const uint8_t* const blockEnd = data + blockSize;
+					data = blockEnd;
+
+					const uint64_t firstParticle = static_cast<uint64_t>(block) * header.blockParticleCount;
+					const uint64_t endParticle = std::min(firstParticle + header.blockParticleCount, header.particleCount);
+
+					int32_t neighbourX = 0;
+					int32_t neighbourY = 0;
+					for (uint64_t i = firstParticle; i < endParticle; ++i)
+					{
+						const int32_t deltaX = ZigZagDecode(ReadVarint(blockData, blockEnd));
+						const int32_t deltaY = ZigZagDecode(ReadVarint(blockData, blockEnd));
+
+						int32_t& x = current[2 * i];
+						int32_t& y = current[2 * i + 1];
+						x = bIsKeyFrame ? neighbourX + deltaX : x + deltaX;
+						y = bIsKeyFrame ? neighbourY + deltaY : y + deltaY;
+						neighbourX = x;
+						neighbourY = y;
+					}
+				}
+
+				// Frames before the requested range are only decoded to reach it
+				if (frame < firstFrame)
+				{
+					continue;
+				}
+
+				glm::vec2* framePositions = positions.data() + (frame - firstFrame) * header.particleCount;
+				for (uint64_t i = 0; i < header.particleCount; ++i)
+				{
+					framePositions[i] = glm::vec2(static_cast<float>(current[2 * i]), static_cast<float>(current[2 * i + 1])) * header.quantizationStep;
+				}
+				ticks.push_back(frameHeader.tick);
+			}
+		}
+
+		return ticks;
+	}
+
+} // namespace VulkanCore
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GPUDevice.h"
+#include "MappedFile.h"
+
+namespace VulkanCore {
+
+	struct Particle;
+
+	enum class TrajectoryCodec : uint32_t
+	{
+		ZigZagVarint = 0	// fixed-point positions, delta coded, zigzag + LEB128 varint bytes
+	};
+
+	// File layout: header, chunks, chunk index (indexOffset is patched once the recording stops)
+	// A chunk starts with a key frame (deltas between neighbouring particles) followed by frames delta coded against the previous frame,
+	// so any frame is decoded from the start of its chunk only
+	// Every frame is split in blocks of BLOCK_PARTICLE_COUNT particles that are coded independently (in parallel)
+	struct TrajectoryFileHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t headerSize;
+		TrajectoryCodec codec;
+		float quantizationStep;			// position units per integer step
+		uint32_t particleStride;		// every particleStride-th particle is recorded
+		uint64_t particleCount;			// recorded particles per frame
+		uint32_t framesPerChunk;
+		uint32_t tickInterval;			// simulation ticks between two recorded frames
+		uint32_t blockParticleCount;
+		uint32_t reserved;
+		uint64_t frameCount;
+		uint64_t chunkCount;
+		uint64_t indexOffset;
+	};
+
+	struct TrajectoryChunkIndexEntry
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint64_t firstFrame;
+		uint64_t frameCount;
+	};
+
+	// Every frame in a chunk: header, blockCount sizes, blocks
+	struct TrajectoryFrameHeader
+	{
+		uint64_t tick;
+		uint32_t blockCount;
+		uint32_t reserved;
+	};
+
+	// Records particle positions every few simulation ticks for offline analysis
+	// The particle storage buffer is copied into one of READBACK_SLOT_COUNT host-visible buffers on the compute queue, right behind the simulation step.
+	// Slots are polled with fences and handed to an encoder thread that quantizes and codes the blocks of the frame on worker threads and appends them to the file.
+	// If every slot is busy the frame is dropped instead, the render loop never waits on a readback or on the encoder.
+	class TrajectoryRecorder final
+	{
+	public:
+		static constexpr char MAGIC[4] = { 'P', 'S', 'T', 'R' };
+		static constexpr uint32_t VERSION = 1;
+
+		static constexpr uint32_t READBACK_SLOT_COUNT = 3;
+		static constexpr uint32_t FRAMES_PER_CHUNK = 16;
+		static constexpr uint32_t BLOCK_PARTICLE_COUNT = 1 << 18;
+		static constexpr float QUANTIZATION_STEP = 1.0f / 16384.0f;
+
+		// Constructor
+		TrajectoryRecorder(GPUDevice& device);
+
+		// Destructor
+		~TrajectoryRecorder();
+
+		// Not copyable
+		TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+		TrajectoryRecorder& operator = (const TrajectoryRecorder&) = delete;
+
+		// Not moveable
+		TrajectoryRecorder(TrajectoryRecorder&&) = delete;
+		TrajectoryRecorder& operator = (TrajectoryRecorder&&) = delete;
+
+		// The particle count is fixed for the whole recording
+		void Start(const std::string& filePath, uint32_t particleCount, uint32_t particleStride, uint32_t tickInterval);
+
+		// Flushes the frames still in flight and writes the chunk index, stopping is allowed to block
+		void Stop();
+
+		// Submits the readback of shaderStorageBuffer if tick is due, call after the simulation step has been submitted
+		void Record(VkBuffer shaderStorageBuffer, uint64_t tick);
+
+		// Hands every finished readback to the encoder thread, never blocks
+		void Poll();
+
+		// Getters
+		inline bool GetIsRecording() const { return bIsRecording; }
+		inline uint32_t GetParticleCount() const { return particleCount; }
+		inline uint64_t GetRecordedFrameCount() const { return recordedFrameCount.load(std::memory_order_relaxed); }
+		inline uint64_t GetDroppedFrameCount() const { return droppedFrameCount; }
+		inline uint64_t GetWrittenBytes() const { return writtenBytes.load(std::memory_order_relaxed); }
+
+	private:
+		enum class SlotState : uint32_t
+		{
+			Free = 0,
+			InFlight,		// copy submitted, waiting for the GPU
+			Encoding		// owned by the encoder thread
+		};
+
+		struct ReadbackSlot
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			void* mapped = nullptr;
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			uint64_t tick = 0;
+			std::atomic<SlotState> state = SlotState::Free;
+		};
+
+		GPUDevice& device;
+
+		std::array<ReadbackSlot, READBACK_SLOT_COUNT> slots;
+		uint32_t nextSlot;
+		std::deque<uint32_t> inFlightSlots;		// in submission order, frames are written in the order they were recorded
+
+		bool bIsRecording;
+		uint32_t particleCount;
+		uint32_t particleStride;
+		uint32_t tickInterval;
+		std::ofstream file;
+		TrajectoryFileHeader header;
+
+		std::atomic<uint64_t> recordedFrameCount;
+		uint64_t droppedFrameCount;
+		std::atomic<uint64_t> writtenBytes;
+
+		// Encoder thread, only touched by the encoder once started
+		std::vector<int32_t> previousFrame;
+		std::vector<std::vector<uint8_t>> encodedBlocks;
+		std::vector<TrajectoryChunkIndexEntry> chunkIndex;
+		uint64_t fileOffset;
+
+		std::thread encoderThread;
+		std::mutex encoderMutex;
+		std::condition_variable encoderCondition;
+		std::deque<uint32_t> encoderQueue;
+		bool bStopEncoder;
+
+		void CreateSlot(ReadbackSlot& slot, VkDeviceSize size);
+		void CleanupSlot(ReadbackSlot& slot);
+
+		void EncoderLoop();
+		void EncodeFrame(const ReadbackSlot& slot);
+		void EncodeBlock(const Particle* particles, uint64_t firstParticle, uint64_t endParticle, bool bIsKeyFrame, std::vector<uint8_t>& out);
+		void WriteIndex();
+	};
+
+	// Random access to recorded frames, only the chunk holding the requested frame is decoded
+	class TrajectoryReader final
+	{
+	public:
+		// Constructor
+		// Throws std::runtime_error if the file is not a complete trajectory recording
+		TrajectoryReader(const std::string& filePath);
+
+		// Destructor
+		~TrajectoryReader() = default;
+
+		// Not copyable
+		TrajectoryReader(const TrajectoryReader&) = delete;
+		TrajectoryReader& operator = (const TrajectoryReader&) = delete;
+
+		// Not moveable
+		TrajectoryReader(TrajectoryReader&&) = delete;
+		TrajectoryReader& operator = (TrajectoryReader&&) = delete;
+
+		// Decodes frames [firstFrame, firstFrame + frameCount), positions are stored frame after frame
+		// Returns the tick of every decoded frame
+		std::vector<uint64_t> ReadFrames(uint64_t firstFrame, uint64_t frameCount, std::vector<glm::vec2>& positions) const;
+
+		// Getters
+		inline const TrajectoryFileHeader& GetHeader() const { return header; }
+		inline uint64_t GetFrameCount() const { return header.frameCount; }
+		inline uint64_t GetParticleCount() const { return header.particleCount; }
+
+	private:
+		MappedFile file;
+		TrajectoryFileHeader header;
+		const TrajectoryChunkIndexEntry* chunkIndex;
+	};
+
+} // namespace VulkanCore
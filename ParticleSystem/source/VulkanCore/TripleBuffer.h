@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace VulkanCore {
+
+	// Lock-free single-producer / single-consumer handoff of the latest value
+	// The producer never waits and overwrites values the consumer has not read yet, the consumer always gets the most recent complete value.
+	// Publish must only be called from one thread and TryRead from one (other) thread
+	template<typename T>
+	class TripleBuffer final
+	{
+	public:
+		// Constructor
+		TripleBuffer() : buffers(), middle(MIDDLE_INITIAL), back(1), front(2) {}
+
+		// Not copyable
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator = (const TripleBuffer&) = delete;
+
+		// Not moveable
+		TripleBuffer(TripleBuffer&&) = delete;
+		TripleBuffer& operator = (TripleBuffer&&) = delete;
+
+		// Producer, fill the value returned by GetBack then publish it
+		inline T& GetBack() { return buffers[back]; }
+		void Publish()
+		{
+			back = middle.exchange(back | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+		}
+
+		// Consumer, returns false if nothing was published since the last read (value keeps the last read one)
+		bool TryRead(T& value)
+		{
+			if ((middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+			{
+				return false;
+			}
+
+			front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+			value = buffers[front];
+			return true;
+		}
+
+	private:
+		static constexpr uint32_t INDEX_MASK = 0x3;
+		static constexpr uint32_t FRESH_BIT = 0x4;
+		static constexpr uint32_t MIDDLE_INITIAL = 0;
+
+		std::array<T, 3> buffers;
+
+		// Index of the buffer between producer and consumer, FRESH_BIT is set while it holds an unread value
+		alignas(64) std::atomic<uint32_t> middle;
+
+		// Owned by the producer
+		alignas(64) uint32_t back;
+
+		// Owned by the consumer
+		alignas(64) uint32_t front;
+	};
+
+} // namespace VulkanCore
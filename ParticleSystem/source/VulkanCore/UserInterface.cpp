@@ -1,16 +1,15 @@
 #include "UserInterface.h"
 
-#include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_vulkan.h>
 #include <imgui_internal.h>
 
 #include <stdexcept>
 #include <array>
+#include <cfloat>
 #include <cmath>
 #include <iostream>
 #include <limits>
 #include <algorithm>
-#include <numeric>
 
 #include "SwapChain.h"
 #include "FrameTimeHistory.h"
@@ -21,6 +20,8 @@ namespace VulkanCore {
 	ImChunkStream<UserInterface::ImGuiWindowUserData> UserInterface::UserDataWindows;
 
 	const uint32_t UserInterface::MAX_PARTICLE_MULTIPLIER = 131072;
+	const uint32_t UserInterface::MAX_SUBSTEPS = 8;
+	const uint32_t UserInterface::MAX_REORDER_INTERVAL = 600;
 
 	std::unordered_map<std::string, bool> UserInterface::UserDataWindow = {
 		{ "Settings", false },
@@ -62,9 +63,45 @@ namespace VulkanCore {
 		, bShowMainMenuBar(true)
 		, bShouldReset(false)
 		, bCaptureInput(false)
+		, bCaptureVideo(false)
+		, captureVideoFormat(CaptureFormat::Y4M)
+		, bRecordTrajectory(false)
+		, trajectoryTickInterval(10)
+		, trajectoryParticleStride(1)
+		, bStartSweep(false)
+		, bStartRecordingBenchmark(false)
+		, bSaveCheckpoint(false)
+		, bLoadCheckpoint(false)
+		, bProfilerEnabled(true)
+		, bExportProfile(false)
+		, bValidateNBody(false)
+		, bValidateFluid(false)
 		, particleCount(131072 * 64)
+		, bImportInitialState(false)
+		, importFilePath({})
 		, staticColor(glm::vec4(1.0f, 0.0f, 0.0f, 1.0f))
 		, dynamicColor(glm::vec4(0.0f, 1.0f, 0.0f, 1.0f))
+		, sampleCount(VK_SAMPLE_COUNT_8_BIT)
+		, substeps(1)
+		, simulationMode(SimulationMode::Attractor)
+		, fluidParameters(FluidSimulation::GetDefaultParameters())
+		, emitterParameters({ 3.0f, 1.0f, 1.5f })
+		, bBuildSpatialGrid(false)
+		, spatialGridCellSize(SpatialGrid::DEFAULT_CELL_SIZE)
+		, reorderInterval(0)
+		, framePacingPolicy(FramePacingPolicy::Mailbox)
+		, targetFPS(FramePacer::DEFAULT_TARGET_FPS)
+		, bHasPipelineStatistics(false)
+		, pipelineStatistics({})
+		, pipelineStatisticsParticleCount(0)
+		, bHasNBodyEnergy(false)
+		, nbodyEnergy({})
+		, nbodyEnergyDrift(0.0)
+		, bHasEmitterCounters(false)
+		, emitterCounters({})
+		, fluidSubsteps(1)
+		, fluidSimulatedTimeRatio(1.0f)
+		, lastImGuiFrameTime({ 0 })
 	{
 		CreateDescriptorPool();
 		SetupImGui();
@@ -74,7 +111,6 @@ namespace VulkanCore {
 	{
 		// ImGui cleanup
 		ImGui_ImplVulkan_Shutdown();
-		ImGui_ImplGlfw_Shutdown();
 		ImGui::DestroyContext();
 	}
 
@@ -105,29 +141,53 @@ namespace VulkanCore {
 		{
 			bCaptureInput = !bCaptureInput;
 		}
+
+		// Toggle Capture Video Command - Shortcut
+		if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_P))
+		{
+			bCaptureVideo = !bCaptureVideo;
+		}
+
+		// Toggle Record Trajectory Command - Shortcut
+		if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_T))
+		{
+			bRecordTrajectory = !bRecordTrajectory;
+		}
+
+		// Save Checkpoint Command - Shortcut
+		if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_S, false))
+		{
+			bSaveCheckpoint = true;
+		}
+
+		// Load Checkpoint Command - Shortcut
+		if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_L, false))
+		{
+			bLoadCheckpoint = true;
+		}
+
+		// Export Profile Command - Shortcut
+		if (ImGui::GetIO().KeyCtrl && ImGui::IsKeyPressed(ImGuiKey_J, false))
+		{
+			bExportProfile = true;
+		}
 	}
 
 	void UserInterface::Draw(VkCommandBuffer commandBuffer)
 	{
 		ImGui_ImplVulkan_NewFrame();
-		ImGui_ImplGlfw_NewFrame();
+		UpdateImGuiInput();
 		ImGui::NewFrame();
 
 		DrawImGui();
 		ImGui::Render();
 
-		BeginRenderPass(commandBuffer);
+		// Recorded inside SwapChain::UI_SUBPASS, nothing to draw when every window is hidden
+		ImDrawData* drawData = ImGui::GetDrawData();
+		if (drawData->TotalVtxCount > 0)
 		{
-			ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
-
-			// Update and Render additional Platform Windows
-			if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-			{
-				ImGui::UpdatePlatformWindows();
-				ImGui::RenderPlatformWindowsDefault();
-			}
+			ImGui_ImplVulkan_RenderDrawData(drawData, commandBuffer);
 		}
-		EndRenderPass(commandBuffer);
 	}
 
 	void UserInterface::ToggleShouldReset()
@@ -168,21 +228,20 @@ namespace VulkanCore {
 		// ImGui Flags
 		ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;		// Enable Keyboard Controls
 		ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_DockingEnable;			// Enable Docking
-		ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;			// Enable Multi-Viewport / Platform Windows
+
+		// No platform backend: ImGui runs on the render thread and is fed the events forwarded by the main thread (see UpdateImGuiInput),
+		// multi-viewport platform windows would have to be created on the main thread
+		ImGui::GetIO().BackendPlatformName = "VulkanCore Window";
 
 		// Setup Dear ImGui style
 		ImGui::StyleColorsDark();
 
-		// When viewports are enabled we tweak WindowRounding/WindowBg so platform windows can look identical to regular ones.
-		ImGuiStyle& style = ImGui::GetStyle();
-		if (ImGui::GetIO().ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-		{
-			style.WindowRounding = 0.0f;
-			style.Colors[ImGuiCol_WindowBg].w = 1.0f;
-		}
+		// Setup Renderer backend
+		InitImGuiVulkan();
+	}
 
-		// Setup Platform/Renderer backends
-		ImGui_ImplGlfw_InitForVulkan(window.GetGLFWWindow(), true);
+	void UserInterface::InitImGuiVulkan()
+	{
 		ImGui_ImplVulkan_InitInfo initInfoImGui = {};
 		initInfoImGui.Instance = device.GetInstance();
 		initInfoImGui.PhysicalDevice = device.GetPhysicalDevice();
@@ -191,8 +250,8 @@ namespace VulkanCore {
 		initInfoImGui.Queue = device.GetGraphicsQueue();
 		initInfoImGui.PipelineCache = VK_NULL_HANDLE;
 		initInfoImGui.DescriptorPool = imGuiDescriptorPool->GetDescriptorPool();
-		initInfoImGui.RenderPass = renderer.GetSwapChain()->GetImGuiRenderPass();
-		initInfoImGui.Subpass = 0;
+		initInfoImGui.RenderPass = renderer.GetSwapChain()->GetRenderPass();
+		initInfoImGui.Subpass = SwapChain::UI_SUBPASS;
 		initInfoImGui.MinImageCount = 2;
 		initInfoImGui.ImageCount = SwapChain::MAX_FRAMES_IN_FLIGHT;
 		initInfoImGui.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
@@ -203,38 +262,154 @@ namespace VulkanCore {
 		ImGui_ImplVulkan_Init(&initInfoImGui);
 	}
 
-	void UserInterface::BeginRenderPass(VkCommandBuffer commandBuffer)
+	void UserInterface::UpdateImGuiInput()
 	{
-		VkRenderPassBeginInfo renderPassInfo = {};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = renderer.GetSwapChain()->GetImGuiRenderPass();
-		renderPassInfo.framebuffer = renderer.GetCurrentImGuiFramebuffer();
-		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = renderer.GetSwapChain()->GetSwapChainExtent();
-		renderPassInfo.clearValueCount = 0;
-		renderPassInfo.pClearValues = nullptr; // no clear
-
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		// Set Dynamic States: Viewport + Scissors
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = static_cast<float>(renderer.GetSwapChain()->GetSwapChainExtent().width);
-		viewport.height = static_cast<float>(renderer.GetSwapChain()->GetSwapChainExtent().height);
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
-		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-		VkRect2D scissor{};
-		scissor.offset = { 0, 0 };
-		scissor.extent = renderer.GetSwapChain()->GetSwapChainExtent();
-		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		ImGuiIO& io = ImGui::GetIO();
+
+		const int windowWidth = window.GetWindowWidth();
+		const int windowHeight = window.GetWindowHeight();
+		io.DisplaySize = ImVec2(static_cast<float>(windowWidth), static_cast<float>(windowHeight));
+		if (windowWidth > 0 && windowHeight > 0)
+		{
+			io.DisplayFramebufferScale = ImVec2(static_cast<float>(window.GetWidth()) / windowWidth, static_cast<float>(window.GetHeight()) / windowHeight);
+		}
+
+		const Time now = Time::Now();
+		io.DeltaTime = lastImGuiFrameTime.IsZero() || now <= lastImGuiFrameTime ? 1.0f / 60.0f : TimeToSeconds<float>(now - lastImGuiFrameTime);
+		lastImGuiFrameTime = now;
+
+		WindowEvent event;
+		while (window.PopEvent(event))
+		{
+			switch (event.type)
+			{
+			case WindowEventType::Key:
+			case WindowEventType::MouseButton:
+				io.AddKeyEvent(ImGuiMod_Ctrl, (event.mods & GLFW_MOD_CONTROL) != 0);
+				io.AddKeyEvent(ImGuiMod_Shift, (event.mods & GLFW_MOD_SHIFT) != 0);
+				io.AddKeyEvent(ImGuiMod_Alt, (event.mods & GLFW_MOD_ALT) != 0);
+				io.AddKeyEvent(ImGuiMod_Super, (event.mods & GLFW_MOD_SUPER) != 0);
+
+				if (event.type == WindowEventType::MouseButton)
+				{
+					if (event.code >= 0 && event.code < ImGuiMouseButton_COUNT)
+					{
+						io.AddMouseButtonEvent(event.code, event.action == GLFW_PRESS);
+					}
+				}
+				else if (const ImGuiKey key = GLFWKeyToImGuiKey(event.code); key != ImGuiKey_None)
+				{
+					io.AddKeyEvent(key, event.action != GLFW_RELEASE);
+				}
+				break;
+
+			case WindowEventType::Char:
+				io.AddInputCharacter(static_cast<unsigned int>(event.code));
+				break;
+
+			case WindowEventType::CursorPos:
+				io.AddMousePosEvent(static_cast<float>(event.x), static_cast<float>(event.y));
+				break;
+
+			case WindowEventType::CursorEnter:
+				if (!event.code)
+				{
+					io.AddMousePosEvent(-FLT_MAX, -FLT_MAX);
+				}
+				break;
+
+			case WindowEventType::Scroll:
+				io.AddMouseWheelEvent(static_cast<float>(event.x), static_cast<float>(event.y));
+				break;
+
+			case WindowEventType::Focus:
+				io.AddFocusEvent(event.code != 0);
+				break;
+			}
+		}
 	}
 
-	void UserInterface::EndRenderPass(VkCommandBuffer commandBuffer)
+	ImGuiKey UserInterface::GLFWKeyToImGuiKey(int key)
 	{
-		vkCmdEndRenderPass(commandBuffer);
+		if (key >= GLFW_KEY_A && key <= GLFW_KEY_Z)
+		{
+			return static_cast<ImGuiKey>(ImGuiKey_A + (key - GLFW_KEY_A));
+		}
+
+		if (key >= GLFW_KEY_0 && key <= GLFW_KEY_9)
+		{
+			return static_cast<ImGuiKey>(ImGuiKey_0 + (key - GLFW_KEY_0));
+		}
+
+		if (key >= GLFW_KEY_F1 && key <= GLFW_KEY_F12)
+		{
+			return static_cast<ImGuiKey>(ImGuiKey_F1 + (key - GLFW_KEY_F1));
+		}
+
+		if (key >= GLFW_KEY_KP_0 && key <= GLFW_KEY_KP_9)
+		{
+			return static_cast<ImGuiKey>(ImGuiKey_Keypad0 + (key - GLFW_KEY_KP_0));
+		}
+
+		switch (key)
+		{
+		case GLFW_KEY_TAB:				return ImGuiKey_Tab;
+		case GLFW_KEY_LEFT:				return ImGuiKey_LeftArrow;
+		case GLFW_KEY_RIGHT:			return ImGuiKey_RightArrow;
+		case GLFW_KEY_UP:				return ImGuiKey_UpArrow;
+		case GLFW_KEY_DOWN:				return ImGuiKey_DownArrow;
+		case GLFW_KEY_PAGE_UP:			return ImGuiKey_PageUp;
+		case GLFW_KEY_PAGE_DOWN:		return ImGuiKey_PageDown;
+		case GLFW_KEY_HOME:				return ImGuiKey_Home;
+		case GLFW_KEY_END:				return ImGuiKey_End;
+		case GLFW_KEY_INSERT:			return ImGuiKey_Insert;
+		case GLFW_KEY_DELETE:			return ImGuiKey_Delete;
+		case GLFW_KEY_BACKSPACE:		return ImGuiKey_Backspace;
+		case GLFW_KEY_SPACE:			return ImGuiKey_Space;
+		case GLFW_KEY_ENTER:			return ImGuiKey_Enter;
+		case GLFW_KEY_ESCAPE:			return ImGuiKey_Escape;
+		case GLFW_KEY_APOSTROPHE:		return ImGuiKey_Apostrophe;
+		case GLFW_KEY_COMMA:			return ImGuiKey_Comma;
+		case GLFW_KEY_MINUS:			return ImGuiKey_Minus;
+		case GLFW_KEY_PERIOD:			return ImGuiKey_Period;
+		case GLFW_KEY_SLASH:			return ImGuiKey_Slash;
+		case GLFW_KEY_SEMICOLON:		return ImGuiKey_Semicolon;
+		case GLFW_KEY_EQUAL:			return ImGuiKey_Equal;
+		case GLFW_KEY_LEFT_BRACKET:		return ImGuiKey_LeftBracket;
+		case GLFW_KEY_BACKSLASH:		return ImGuiKey_Backslash;
+		case GLFW_KEY_RIGHT_BRACKET:	return ImGuiKey_RightBracket;
+		case GLFW_KEY_GRAVE_ACCENT:		return ImGuiKey_GraveAccent;
+		case GLFW_KEY_CAPS_LOCK:		return ImGuiKey_CapsLock;
+		case GLFW_KEY_SCROLL_LOCK:		return ImGuiKey_ScrollLock;
+		case GLFW_KEY_NUM_LOCK:			return ImGuiKey_NumLock;
+		case GLFW_KEY_PRINT_SCREEN:		return ImGuiKey_PrintScreen;
+		case GLFW_KEY_PAUSE:			return ImGuiKey_Pause;
+		case GLFW_KEY_KP_DECIMAL:		return ImGuiKey_KeypadDecimal;
+		case GLFW_KEY_KP_DIVIDE:		return ImGuiKey_KeypadDivide;
+		case GLFW_KEY_KP_MULTIPLY:		return ImGuiKey_KeypadMultiply;
+		case GLFW_KEY_KP_SUBTRACT:		return ImGuiKey_KeypadSubtract;
+		case GLFW_KEY_KP_ADD:			return ImGuiKey_KeypadAdd;
+		case GLFW_KEY_KP_ENTER:			return ImGuiKey_KeypadEnter;
+		case GLFW_KEY_KP_EQUAL:			return ImGuiKey_KeypadEqual;
+		case GLFW_KEY_LEFT_SHIFT:		return ImGuiKey_LeftShift;
+		case GLFW_KEY_LEFT_CONTROL:		return ImGuiKey_LeftCtrl;
+		case GLFW_KEY_LEFT_ALT:			return ImGuiKey_LeftAlt;
+		case GLFW_KEY_LEFT_SUPER:		return ImGuiKey_LeftSuper;
+		case GLFW_KEY_RIGHT_SHIFT:		return ImGuiKey_RightShift;
+		case GLFW_KEY_RIGHT_CONTROL:	return ImGuiKey_RightCtrl;
+		case GLFW_KEY_RIGHT_ALT:		return ImGuiKey_RightAlt;
+		case GLFW_KEY_RIGHT_SUPER:		return ImGuiKey_RightSuper;
+		case GLFW_KEY_MENU:				return ImGuiKey_Menu;
+		default:						return ImGuiKey_None;
+		}
+	}
+
+	void UserInterface::RecreateRendererBackend()
+	{
+		vkDeviceWaitIdle(device.GetVKDevice());
+
+		ImGui_ImplVulkan_Shutdown();
+		InitImGuiVulkan();
 	}
 
 	void UserInterface::DrawImGui()
@@ -263,6 +438,38 @@ namespace VulkanCore {
 			{
 				ImGui::MenuItem("GPU Metrics", "Ctrl+C", &UserDataWindow["GPU Metrics"]);
 				ImGui::MenuItem("Capture Input", "Ctrl+R", &bCaptureInput);
+				ImGui::MenuItem("Capture Video", "Ctrl+P", &bCaptureVideo);
+				if (ImGui::BeginMenu("Capture Video Format", !bCaptureVideo))
+				{
+					if (ImGui::MenuItem("Y4M (YUV 4:4:4)", nullptr, captureVideoFormat == CaptureFormat::Y4M)) { captureVideoFormat = CaptureFormat::Y4M; }
+					if (ImGui::MenuItem("Raw RGBA", nullptr, captureVideoFormat == CaptureFormat::RawRGBA)) { captureVideoFormat = CaptureFormat::RawRGBA; }
+					ImGui::EndMenu();
+				}
+				ImGui::MenuItem("Record Trajectory", "Ctrl+T", &bRecordTrajectory);
+				if (ImGui::BeginMenu("Trajectory Settings", !bRecordTrajectory))
+				{
+					int tickInterval = static_cast<int>(trajectoryTickInterval);
+					if (ImGui::SliderInt("Every N ticks", &tickInterval, 1, 120))
+					{
+						trajectoryTickInterval = static_cast<uint32_t>(glm::max(tickInterval, 1));
+					}
+
+					int particleStride = static_cast<int>(trajectoryParticleStride);
+					if (ImGui::SliderInt("Every N-th particle", &particleStride, 1, 1024, "%d", ImGuiSliderFlags_Logarithmic))
+					{
+						trajectoryParticleStride = static_cast<uint32_t>(glm::max(particleStride, 1));
+					}
+					ImGui::EndMenu();
+				}
+				ImGui::Separator();
+				if (ImGui::MenuItem("Save Checkpoint", "Ctrl+S", nullptr)) { bSaveCheckpoint = true; }
+				if (ImGui::MenuItem("Load Checkpoint", "Ctrl+L", nullptr)) { bLoadCheckpoint = true; }
+				ImGui::Separator();
+				ImGui::MenuItem("CPU/GPU Profiler", nullptr, &bProfilerEnabled);
+				if (ImGui::MenuItem("Export Profile", "Ctrl+J", nullptr, bProfilerEnabled)) { bExportProfile = true; }
+				ImGui::Separator();
+				if (ImGui::MenuItem("Validate N-Body", nullptr, nullptr, NBodySimulation::GetIsNBodyMode(simulationMode))) { bValidateNBody = true; }
+				if (ImGui::MenuItem("Validate Fluid", nullptr, nullptr, simulationMode == SimulationMode::Fluid)) { bValidateFluid = true; }
 				ImGui::EndMenu();
 			}
 
@@ -273,6 +480,11 @@ namespace VulkanCore {
 				if (ImGui::MenuItem("Test 3", nullptr, nullptr)) { StartBenchmark(Benchmark::Test3); }
 				if (ImGui::MenuItem("Test 4", nullptr, nullptr)) { StartBenchmark(Benchmark::Test4); }
 				if (ImGui::MenuItem("Test 5", nullptr, nullptr)) { StartBenchmark(Benchmark::Test5); }
+				if (ImGui::MenuItem("Test 6", nullptr, nullptr)) { StartBenchmark(Benchmark::Test6); }
+				if (ImGui::MenuItem("Test 7", nullptr, nullptr)) { StartBenchmark(Benchmark::Test7); }
+				ImGui::Separator();
+				if (ImGui::MenuItem("Sweep", nullptr, nullptr)) { bShowMainMenuBar = false; bStartSweep = true; }
+				if (ImGui::MenuItem("Command Recording", nullptr, nullptr)) { bStartRecordingBenchmark = true; }
 				ImGui::EndMenu();
 			}
 
@@ -280,6 +492,39 @@ namespace VulkanCore {
 		}
 	}
 
+	void UserInterface::SetImportFilePath(const std::string& filePath)
+	{
+		bImportInitialState = !filePath.empty();
+		importFilePath.fill('\0');
+		filePath.copy(importFilePath.data(), importFilePath.size() - 1);
+	}
+
+	void UserInterface::SetPipelineStatistics(bool bIsSupported, const PipelineStatisticsCounters& counters, uint32_t particleCount)
+	{
+		bHasPipelineStatistics = bIsSupported;
+		pipelineStatistics = counters;
+		pipelineStatisticsParticleCount = particleCount;
+	}
+
+	void UserInterface::SetNBodyEnergy(bool bHasEnergy, const NBodyEnergy& energy, double drift)
+	{
+		bHasNBodyEnergy = bHasEnergy;
+		nbodyEnergy = energy;
+		nbodyEnergyDrift = drift;
+	}
+
+	void UserInterface::SetEmitterCounters(bool bHasCounters, const EmitterCounters& counters)
+	{
+		bHasEmitterCounters = bHasCounters;
+		emitterCounters = counters;
+	}
+
+	void UserInterface::SetFluidSubsteps(uint32_t substeps, float simulatedTimeRatio)
+	{
+		fluidSubsteps = substeps;
+		fluidSimulatedTimeRatio = simulatedTimeRatio;
+	}
+
 	void UserInterface::ShowSettingsWindow()
 	{
 		// We specify a default position/size in case there's no data in the .ini file
@@ -340,6 +585,20 @@ namespace VulkanCore {
 		particleCount = particleMultiplier * 64u;
 		ImGui::Text("Particle Count: %d", particleCount);
 
+		// Initial state
+		ImGui::Checkbox("Import initial state", &bImportInitialState);
+		ImGui::SameLine(); HelpMarker(
+			"Starts the simulation from a file instead of the random ring, the particle count is taken from the file.\n"
+			"*.csv: one particle per line, x,y or x,y,vx,vy.\n"
+			"Any other file: raw array of float x, y, vx, vy.\n"
+			"Applied with the Apply button.\n"
+		);
+
+		if (bImportInitialState)
+		{
+			ImGui::InputText("File", importFilePath.data(), importFilePath.size());
+		}
+
 		// Colors
 		ImGui::ColorEdit4("Static color", &staticColor[0], ImGuiColorEditFlags_Float);
 		ImGui::SameLine(); HelpMarker(
@@ -359,6 +618,135 @@ namespace VulkanCore {
 			"CTRL+click on individual component to input value.\n"
 		);
 
+		// Frame Pacing
+		if (ImGui::BeginCombo("Frame pacing", FramePacer::GetPolicyName(framePacingPolicy)))
+		{
+			for (FramePacingPolicy policy : { FramePacingPolicy::Uncapped, FramePacingPolicy::VSync, FramePacingPolicy::Mailbox, FramePacingPolicy::TargetFPS })
+			{
+				if (ImGui::Selectable(FramePacer::GetPolicyName(policy), policy == framePacingPolicy))
+				{
+					framePacingPolicy = policy;
+				}
+			}
+			ImGui::EndCombo();
+		}
+		ImGui::SameLine(); HelpMarker(
+			"Uncapped: IMMEDIATE present mode, renders as fast as possible.\n"
+			"VSync (FIFO): the display paces the application, lowest power usage.\n"
+			"Mailbox: renders as fast as possible without tearing.\n"
+			"Target FPS: uncapped present mode with a CPU frame limiter.\n"
+			"Applied immediately. Unsupported present modes fall back to the next available one.\n"
+		);
+
+		if (framePacingPolicy == FramePacingPolicy::TargetFPS)
+		{
+			int targetFPSValue = static_cast<int>(targetFPS);
+			if (ImGui::SliderInt("Target FPS", &targetFPSValue, 10, 480))
+			{
+				targetFPS = static_cast<uint32_t>(glm::clamp(targetFPSValue, 10, 480));
+			}
+		}
+
+		// Multi-sampling
+		if (ImGui::BeginCombo("MSAA samples", std::to_string(static_cast<uint32_t>(sampleCount)).c_str()))
+		{
+			for (VkSampleCountFlagBits samples : { VK_SAMPLE_COUNT_1_BIT, VK_SAMPLE_COUNT_2_BIT, VK_SAMPLE_COUNT_4_BIT, VK_SAMPLE_COUNT_8_BIT })
+			{
+				if (ImGui::Selectable(std::to_string(static_cast<uint32_t>(samples)).c_str(), samples == sampleCount))
+				{
+					sampleCount = samples;
+				}
+			}
+			ImGui::EndCombo();
+		}
+		ImGui::SameLine(); HelpMarker(
+			"Samples per pixel of the particle pass. Falls back to the highest count supported by the GPU.\n"
+			"Applied with the Apply button.\n"
+		);
+
+		// Substeps
+		int substepsValue = static_cast<int>(substeps);
+		if (ImGui::SliderInt("Substeps", &substepsValue, 1, static_cast<int>(MAX_SUBSTEPS)))
+		{
+			substeps = static_cast<uint32_t>(glm::clamp(substepsValue, 1, static_cast<int>(MAX_SUBSTEPS)));
+		}
+		ImGui::SameLine(); HelpMarker(
+			"Number of compute dispatches per tick, each one advancing the simulation by tick / substeps.\n"
+			"The fluid takes more when its stable timestep is shorter, shown in the Fluid panel.\n"
+			"Applied with the Apply button.\n"
+		);
+
+		// Simulation Mode
+		if (ImGui::BeginCombo("Simulation", NBodySimulation::GetModeName(simulationMode)))
+		{
+			for (SimulationMode mode : { SimulationMode::Attractor, SimulationMode::NBodyAllPairs, SimulationMode::NBodyBarnesHut, SimulationMode::Fluid, SimulationMode::Emitters })
+			{
+				if (ImGui::Selectable(NBodySimulation::GetModeName(mode), mode == simulationMode))
+				{
+					simulationMode = mode;
+				}
+			}
+			ImGui::EndCombo();
+		}
+		ImGui::SameLine(); HelpMarker(
+			"Attractor: particles follow the mouse and the scripted force sources of the benchmarks.\n"
+			"N-Body: self-gravitating bodies starting as a rotating galaxy, advanced by a fixed 15 ms per tick.\n"
+			"All pairs sums every pair in shared memory tiles, up to 131072 bodies.\n"
+			"Barnes-Hut approximates far groups of bodies by a quadtree rebuilt every step, for millions of bodies.\n"
+			"SPH Fluid: a dam of water breaking in a box, the mouse stirs it.\n"
+			"Emitters: fountains spawn particles that die after their lifetime, the particle count is the size of the pool.\n"
+			"Applied immediately. Switching between the two N-body kernels keeps the bodies.\n"
+		);
+
+		if (simulationMode == SimulationMode::Fluid)
+		{
+			ShowFluidSettings();
+		}
+		else if (simulationMode == SimulationMode::Emitters)
+		{
+			ShowEmitterSettings();
+		}
+
+		if (NBodySimulation::GetIsNBodyMode(simulationMode) && bHasNBodyEnergy)
+		{
+			ImGui::Text("Energy: %.6e (kinetic %.4e, potential %.4e)", nbodyEnergy.GetTotal(), nbodyEnergy.kinetic, nbodyEnergy.potential);
+			ImGui::Text("Energy drift: %.3e", nbodyEnergyDrift);
+			ImGui::SameLine(); HelpMarker(
+				"(E - E0) / |E0|, E0 is the energy of the first step after a restart or a kernel switch.\n"
+				"Tools > Validate N-Body compares the next step against a CPU reference, printed to the console.\n"
+			);
+		}
+
+		// Particle Reorder
+		int reorderIntervalValue = static_cast<int>(reorderInterval);
+		if (ImGui::SliderInt("Reorder interval", &reorderIntervalValue, 0, static_cast<int>(MAX_REORDER_INTERVAL), reorderInterval == 0 ? "Off" : "%d ticks", ImGuiSliderFlags_Logarithmic))
+		{
+			reorderInterval = static_cast<uint32_t>(glm::clamp(reorderIntervalValue, 0, static_cast<int>(MAX_REORDER_INTERVAL)));
+		}
+		ImGui::SameLine(); HelpMarker(
+			"Sorts the particle buffer along a Z-order curve every N ticks, so particles close in space are close in memory.\n"
+			"Compare the Simulation and Render Pass GPU zones with the Reorder zone to pick the interval,\n"
+			"or sweep it with \"reorderInterval\" in benchmark/sweep.json.\n"
+			"Paused while a trajectory is recorded. Applied immediately.\n"
+		);
+
+		// Spatial Grid
+		ImGui::Checkbox("Spatial grid", &bBuildSpatialGrid);
+		ImGui::SameLine(); HelpMarker(
+			"Sorts the particles into a uniform grid over the [-2, 2] x [-1, 1] domain after every tick, on the GPU.\n"
+			"Neighbour queries of later passes read the particles of a cell as one contiguous range.\n"
+			"Applied immediately.\n"
+		);
+
+		if (bBuildSpatialGrid)
+		{
+			ImGui::SliderFloat("Cell size", &spatialGridCellSize, SpatialGrid::MIN_CELL_SIZE, SpatialGrid::MAX_CELL_SIZE, "%.3f", ImGuiSliderFlags_Logarithmic);
+			ImGui::SameLine(); HelpMarker(
+				"Side of a grid cell in world units, usually the interaction radius of the neighbour queries.\n"
+				"Applied immediately.\n"
+			);
+		}
+
 		// Apply Button
 		if (ImGui::Button("Apply") && !inputManager.GetIsInBenchmark())
 		{
@@ -373,6 +761,69 @@ namespace VulkanCore {
 		ImGui::End();
 	}
 
+	void UserInterface::ShowFluidSettings()
+	{
+		if (!ImGui::CollapsingHeader("Fluid", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			return;
+		}
+
+		ImGui::SliderFloat("Stiffness", &fluidParameters.stiffness, 10.0f, 2000.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+		ImGui::SameLine(); HelpMarker(
+			"Squared speed of sound, how hard the fluid resists compression.\n"
+			"Stiffer fluids need smaller steps, the simulation never steps past its stable timestep\n"
+			"and takes more substeps per tick to keep up, each one a full step on the GPU.\n"
+		);
+
+		ImGui::SliderFloat("Viscosity", &fluidParameters.viscosity, 0.0f, 0.2f, "%.4f", ImGuiSliderFlags_Logarithmic);
+		ImGui::SliderFloat("Gravity", &fluidParameters.gravity, 0.0f, 10.0f, "%.2f");
+		ImGui::SliderFloat("Wall restitution", &fluidParameters.wallRestitution, 0.0f, 1.0f, "%.2f");
+		ImGui::SliderFloat("Mouse strength", &fluidParameters.attractorStrength, 0.0f, 20.0f, "%.2f");
+
+		ImGui::SliderFloat("Smoothing length", &fluidParameters.smoothingFactor, 1.2f, 4.0f, "%.2f spacings");
+		ImGui::SameLine(); HelpMarker(
+			"Radius of the SPH kernels in initial particle spacings, the spacing follows from the particle count.\n"
+			"Longer kernels are smoother and cost quadratically more neighbours.\n"
+			"Tools > Validate Fluid compares the next step against a CPU reference, up to 32768 particles.\n"
+			"Applied immediately.\n"
+		);
+
+		ImGui::Text("Substeps: %u (%ux the GPU cost of a step)", fluidSubsteps, fluidSubsteps);
+		ImGui::Text("Simulated time: %.0f%% of real time", 100.0f * fluidSimulatedTimeRatio);
+		ImGui::SameLine(); HelpMarker(
+			"Substeps per tick, enough to stay under the stable timestep and at least Substeps, up to 32.\n"
+			"Past that the steps stay stable and the fluid runs slower than real time.\n"
+		);
+	}
+
+	void UserInterface::ShowEmitterSettings()
+	{
+		if (!ImGui::CollapsingHeader("Emitters", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			return;
+		}
+
+		ImGui::SliderFloat("Lifetime", &emitterParameters.lifetime, 0.1f, 20.0f, "%.1f s", ImGuiSliderFlags_Logarithmic);
+		ImGui::SliderFloat("Emission", &emitterParameters.emission, 0.0f, 4.0f, "%.2f");
+		ImGui::SameLine(); HelpMarker(
+			"1 emits as many particles per lifetime as the pool holds, higher values run out of free slots.\n"
+			"Applied immediately.\n"
+		);
+		ImGui::SliderFloat("Emitter gravity", &emitterParameters.gravity, 0.0f, 10.0f, "%.2f");
+
+		if (bHasEmitterCounters)
+		{
+			ImGui::Text("Alive: %u, free: %d", emitterCounters.aliveCount, emitterCounters.deadCount);
+			ImGui::SameLine(); HelpMarker(
+				"Counted on the GPU, copied back a tick late for display only.\n"
+			);
+			ImGui::Text("Simulated workgroups: %u", emitterCounters.simulateGroupCount);
+			ImGui::SameLine(); HelpMarker(
+				"Sized by the GPU from the alive list, the simulation never runs over the free slots.\n"
+			);
+		}
+	}
+
 	void UserInterface::ShowGPUWindow()
 	{
 		// We specify a default position/size in case there's no data in the .ini file
@@ -389,19 +840,25 @@ namespace VulkanCore {
 
 		ImGui::Text("GPU used: %s", device.GetName().data());
 
-		// FPS Graph
-		static std::vector<float> fpsHistory;
-		const uint32_t maxFpsHistory = 240;
+		// FPS Graph, a ring buffer plotted from its oldest value
+		constexpr uint32_t maxFpsHistory = 240;
+		static std::array<float, maxFpsHistory> fpsHistory = {};
+		static uint32_t fpsHistoryCount = 0;
+		static uint32_t fpsHistoryOffset = 0;
 
-		fpsHistory.push_back(FPSCounter::GetInstance().GetFPS());
-		if (fpsHistory.size() > maxFpsHistory)
+		fpsHistory[(fpsHistoryOffset + fpsHistoryCount) % maxFpsHistory] = FPSCounter::GetInstance().GetFPS();
+		if (fpsHistoryCount < maxFpsHistory)
 		{
-			fpsHistory.erase(fpsHistory.begin());
+			++fpsHistoryCount;
+		}
+		else
+		{
+			fpsHistoryOffset = (fpsHistoryOffset + 1) % maxFpsHistory;
 		}
 
 		ImGui::Text("FPS: %.2f", FPSCounter::GetInstance().GetFPS());
 		ImGui::SameLine();
-		ImGui::PlotLines("###FPS", fpsHistory.data(), static_cast<int>(fpsHistory.size()), 0, nullptr, 0.0f, static_cast<float>(maxFpsHistory), ImVec2(0, 80));
+		ImGui::PlotLines("###FPS", fpsHistory.data(), static_cast<int>(fpsHistoryCount), static_cast<int>(fpsHistoryOffset), nullptr, 0.0f, static_cast<float>(maxFpsHistory), ImVec2(0, 80));
 
 		// Frame Time Graph
 		const float width = ImGui::GetWindowWidth();
@@ -447,18 +904,45 @@ namespace VulkanCore {
 			ImGui::Dummy(ImVec2(width - 100.0f, maxHeight));
 		}
 		
-		std::vector<float> fpsHistorySorted = fpsHistory;
-		std::sort(fpsHistorySorted.begin(), fpsHistorySorted.end());
-		int onePercentLowIndex= static_cast<int>(0.01f * fpsHistorySorted.size());
-		onePercentLowIndex = std::max(1, onePercentLowIndex);
-
-		const float avgFPS = std::accumulate(fpsHistorySorted.begin(), fpsHistorySorted.begin() + fpsHistorySorted.size(), 0.0f) / static_cast<float>(fpsHistorySorted.size());
-		const float low1FPS = std::accumulate(fpsHistorySorted.begin(), fpsHistorySorted.begin() + onePercentLowIndex, 0.0f) / static_cast<float>(onePercentLowIndex);
+		// Frame time distribution since the last reset, the 1% low is the FPS of the 99th percentile frame time
+		const FrameTimeHistogram& histogram = FrameTimeHistory::GetInstance().GetHistogram();
+		const double meanFrameTime = histogram.GetMeanMilliseconds();
+		const double p99FrameTime = histogram.GetPercentileMilliseconds(0.99);
 
-		ImGui::Text("Avg FPS: %.2f", avgFPS);
+		ImGui::Text("Avg FPS: %.2f", meanFrameTime > 0.0 ? 1000.0 / meanFrameTime : 0.0);
 		ImGui::Text("Min FPS: %.2f", FPSCounter::GetInstance().GetMinFPS());
 		ImGui::Text("Max FPS: %.2f", FPSCounter::GetInstance().GetMaxFPS());
-		ImGui::Text("1%% Low: %.2f", low1FPS);
+		ImGui::Text("1%% Low: %.2f", p99FrameTime > 0.0 ? 1000.0 / p99FrameTime : 0.0);
+		ImGui::Text("Frame time p50 / p99 / p99.9: %.2f / %.2f / %.2f ms (%llu frames)",
+			histogram.GetPercentileMilliseconds(0.5), p99FrameTime, histogram.GetPercentileMilliseconds(0.999), static_cast<unsigned long long>(histogram.GetCount()));
+
+		// Latency of the last completed frame
+		if (frameCount > 1)
+		{
+			const FrameTimeHistory::Entry lastFrame = FrameTimeHistory::GetInstance().GetEntry(1);
+			ImGui::Text("Input to present: %.2f ms", SecondsToMiliseconds(lastFrame.inputLatency));
+			ImGui::SameLine(); HelpMarker(
+				"Measured until vkQueuePresentKHR returns, the time the image waits for the display is not included.\n"
+			);
+			ImGui::Text("Pacing wait: %.2f ms", SecondsToMiliseconds(lastFrame.pacingWait));
+		}
+
+		// Pipeline statistics of the last completed frame
+		if (bHasPipelineStatistics && pipelineStatisticsParticleCount > 0)
+		{
+			const double particles = static_cast<double>(pipelineStatisticsParticleCount);
+			ImGui::Separator();
+			ImGui::Text("Pipeline statistics (last completed frame)");
+			ImGui::Text("Vertex shader invocations: %llu (%.2f per particle)", static_cast<unsigned long long>(pipelineStatistics.vertexShaderInvocations), static_cast<double>(pipelineStatistics.vertexShaderInvocations) / particles);
+			ImGui::Text("Clipping primitives: %llu (%.2f per particle, %.1f%% of clipping invocations)", static_cast<unsigned long long>(pipelineStatistics.clippingPrimitives), static_cast<double>(pipelineStatistics.clippingPrimitives) / particles,
+				pipelineStatistics.clippingInvocations > 0 ? 100.0 * static_cast<double>(pipelineStatistics.clippingPrimitives) / static_cast<double>(pipelineStatistics.clippingInvocations) : 0.0);
+			ImGui::Text("Fragment shader invocations: %llu (%.2f per particle)", static_cast<unsigned long long>(pipelineStatistics.fragmentShaderInvocations), static_cast<double>(pipelineStatistics.fragmentShaderInvocations) / particles);
+			ImGui::Text("Compute shader invocations: %llu (%.2f per particle)", static_cast<unsigned long long>(pipelineStatistics.computeShaderInvocations), static_cast<double>(pipelineStatistics.computeShaderInvocations) / particles);
+		}
+		else if (!bHasPipelineStatistics)
+		{
+			ImGui::TextDisabled("Pipeline statistics are not supported on this GPU");
+		}
 
 		// Reset Button
 		if (ImGui::Button("Reset") && !inputManager.GetIsInBenchmark())
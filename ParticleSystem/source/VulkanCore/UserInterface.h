@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -10,6 +11,13 @@
 #include "Descriptor.h"
 #include "InputManager.h"
 #include "Benchmark.h"
+#include "FramePacer.h"
+#include "FrameCapture.h"
+#include "PipelineStatistics.h"
+#include "NBodySimulation.h"
+#include "FluidSimulation.h"
+#include "ParticleEmitters.h"
+#include "SpatialGrid.h"
 
 #include <imgui.h>
 #include <imgui_internal.h>
@@ -52,17 +60,70 @@ namespace VulkanCore {
 
 		void ToggleShouldReset();
 		inline void ResetCaptureInput() { bCaptureInput = false; }
+		inline void ResetCaptureVideo() { bCaptureVideo = false; }
+		inline void ResetRecordTrajectory() { bRecordTrajectory = false; }
+		inline void ResetStartSweep() { bStartSweep = false; }
+		inline void ResetStartRecordingBenchmark() { bStartRecordingBenchmark = false; }
+		inline void ResetSaveCheckpoint() { bSaveCheckpoint = false; }
+		inline void ResetLoadCheckpoint() { bLoadCheckpoint = false; }
+		inline void ResetExportProfile() { bExportProfile = false; }
+		inline void ResetValidateNBody() { bValidateNBody = false; }
+		inline void ResetValidateFluid() { bValidateFluid = false; }
+		inline void SetSimulationMode(SimulationMode mode) { simulationMode = mode; }
+		void SetImportFilePath(const std::string& filePath);
+
+		// Shown in the GPU Metrics window, particleCount is the count the counters were measured with
+		void SetPipelineStatistics(bool bIsSupported, const PipelineStatisticsCounters& counters, uint32_t particleCount);
+
+		// Shown in the Settings window in the N-body modes, drift is relative to the first energy of the run
+		void SetNBodyEnergy(bool bHasEnergy, const NBodyEnergy& energy, double drift);
+
+		// Shown in the Settings window in the emitters mode, a tick old
+		void SetEmitterCounters(bool bHasCounters, const EmitterCounters& counters);
+
+		// Shown in the Settings window in the fluid mode, simulatedTimeRatio is the simulated time of the last tick over its wall-clock time
+		void SetFluidSubsteps(uint32_t substeps, float simulatedTimeRatio);
+
+		// The ImGui pipeline is baked against the swap chain render pass, call after its attachments change
+		void RecreateRendererBackend();
 
 		// Getters
 		bool GetIsUIFocused() const;
 		inline bool GetShouldReset() const { return bShouldReset; }
 		inline bool GetCaptureInput() const { return bCaptureInput; }
+		inline bool GetCaptureVideo() const { return bCaptureVideo; }
+		inline CaptureFormat GetCaptureVideoFormat() const { return captureVideoFormat; }
+		inline bool GetRecordTrajectory() const { return bRecordTrajectory; }
+		inline uint32_t GetTrajectoryTickInterval() const { return trajectoryTickInterval; }
+		inline uint32_t GetTrajectoryParticleStride() const { return trajectoryParticleStride; }
 		inline uint32_t GetParticleCount() const { return particleCount; }
+		inline bool GetImportInitialState() const { return bImportInitialState; }
+		inline std::string GetImportFilePath() const { return std::string(importFilePath.data()); }
 		inline const glm::vec4& GetStaticColor() const { return staticColor; }
 		inline const glm::vec4& GetDynamicColor() const { return dynamicColor; }
+		inline FramePacingPolicy GetFramePacingPolicy() const { return framePacingPolicy; }
+		inline uint32_t GetTargetFPS() const { return targetFPS; }
+		inline VkSampleCountFlagBits GetSampleCount() const { return sampleCount; }
+		inline uint32_t GetSubsteps() const { return substeps; }
+		inline bool GetStartSweep() const { return bStartSweep; }
+		inline bool GetStartRecordingBenchmark() const { return bStartRecordingBenchmark; }
+		inline bool GetSaveCheckpoint() const { return bSaveCheckpoint; }
+		inline bool GetLoadCheckpoint() const { return bLoadCheckpoint; }
+		inline bool GetProfilerEnabled() const { return bProfilerEnabled; }
+		inline bool GetExportProfile() const { return bExportProfile; }
+		inline SimulationMode GetSimulationMode() const { return simulationMode; }
+		inline bool GetValidateNBody() const { return bValidateNBody; }
+		inline bool GetValidateFluid() const { return bValidateFluid; }
+		inline const FluidParameters& GetFluidParameters() const { return fluidParameters; }
+		inline const EmitterParameters& GetEmitterParameters() const { return emitterParameters; }
+		inline bool GetBuildSpatialGrid() const { return bBuildSpatialGrid; }
+		inline float GetSpatialGridCellSize() const { return spatialGridCellSize; }
+		inline uint32_t GetReorderInterval() const { return reorderInterval; }
 
 	private:
 		static const uint32_t MAX_PARTICLE_MULTIPLIER;
+		static const uint32_t MAX_SUBSTEPS;
+		static const uint32_t MAX_REORDER_INTERVAL;
 		static std::unordered_map<std::string, bool> UserDataWindow;
 
 		Window& window;
@@ -75,10 +136,52 @@ namespace VulkanCore {
 		bool bShowMainMenuBar;
 		bool bShouldReset;
 		bool bCaptureInput;
+		bool bCaptureVideo;
+		CaptureFormat captureVideoFormat;
+		bool bRecordTrajectory;
+		uint32_t trajectoryTickInterval;
+		uint32_t trajectoryParticleStride;
+		bool bStartSweep;
+		bool bStartRecordingBenchmark;
+		bool bSaveCheckpoint;
+		bool bLoadCheckpoint;
+		bool bProfilerEnabled;
+		bool bExportProfile;
+		bool bValidateNBody;
+		bool bValidateFluid;
 
 		uint32_t particleCount;
+		bool bImportInitialState;
+		std::array<char, 260> importFilePath;
 		glm::vec4 staticColor;
 		glm::vec4 dynamicColor;
+		VkSampleCountFlagBits sampleCount;
+		uint32_t substeps;
+		SimulationMode simulationMode;
+		FluidParameters fluidParameters;
+		EmitterParameters emitterParameters;
+		bool bBuildSpatialGrid;
+		float spatialGridCellSize;
+		uint32_t reorderInterval;
+
+		FramePacingPolicy framePacingPolicy;
+		uint32_t targetFPS;
+
+		bool bHasPipelineStatistics;
+		PipelineStatisticsCounters pipelineStatistics;
+		uint32_t pipelineStatisticsParticleCount;
+
+		bool bHasNBodyEnergy;
+		NBodyEnergy nbodyEnergy;
+		double nbodyEnergyDrift;
+
+		bool bHasEmitterCounters;
+		EmitterCounters emitterCounters;
+
+		uint32_t fluidSubsteps;
+		float fluidSimulatedTimeRatio;
+
+		Time lastImGuiFrameTime;
 
 #ifdef DEBUG
 		static void CheckImGuiVulkanResult(VkResult err);
@@ -87,6 +190,7 @@ namespace VulkanCore {
 		static void HelpMarker(const std::string desc);
 
 		static glm::vec4 DeltaTimeToColor(float deltaTime);
+		static ImGuiKey GLFWKeyToImGuiKey(int key);
 
 		static ImGuiWindowUserData* CreateNewWindowUserData(const char* name);
 
@@ -96,14 +200,15 @@ namespace VulkanCore {
 
 		void CreateDescriptorPool();
 		void SetupImGui();
-
-		void BeginRenderPass(VkCommandBuffer commandBuffer);
-		void EndRenderPass(VkCommandBuffer commandBuffer);
+		void InitImGuiVulkan();
+		void UpdateImGuiInput();
 
 		void DrawImGui();
 
 		void ShowMainMenuBar();
 		void ShowSettingsWindow();
+		void ShowFluidSettings();
+		void ShowEmitterSettings();
 		void ShowGPUWindow();
 		void StartBenchmark(const Benchmark benchmark);
 	};
@@ -12,6 +12,10 @@ namespace VulkanCore {
 
     Window::Window(const WindowConfiguration& config)
         : framebufferResized(false)
+        , framebufferWidth(0)
+        , framebufferHeight(0)
+        , windowWidth(0)
+        , windowHeight(0)
     {
         if (!glfwInit())
         {
@@ -23,9 +27,30 @@ namespace VulkanCore {
 
         glfwSetWindowPos(window, 350, 150);
 
+        int width = 0;
+        int height = 0;
+        glfwGetFramebufferSize(window, &width, &height);
+        framebufferWidth.store(width, std::memory_order_relaxed);
+        framebufferHeight.store(height, std::memory_order_relaxed);
+
+        glfwGetWindowSize(window, &width, &height);
+        windowWidth.store(width, std::memory_order_relaxed);
+        windowHeight.store(height, std::memory_order_relaxed);
+
         // Set GLFW callbacks
         glfwSetWindowUserPointer(window, this);
         glfwSetFramebufferSizeCallback(window, FramebufferResizeCallback);
+        glfwSetWindowSizeCallback(window, WindowSizeCallback);
+        glfwSetKeyCallback(window, KeyCallback);
+        glfwSetCharCallback(window, CharCallback);
+        glfwSetMouseButtonCallback(window, MouseButtonCallback);
+        glfwSetCursorPosCallback(window, CursorPosCallback);
+        glfwSetCursorEnterCallback(window, CursorEnterCallback);
+        glfwSetScrollCallback(window, ScrollCallback);
+        glfwSetWindowFocusCallback(window, WindowFocusCallback);
+
+        // The first frame can be rendered before the main thread pumped any event
+        PublishInput();
     }
 
     Window::~Window()
@@ -36,7 +61,36 @@ namespace VulkanCore {
 
     void Window::Update()
     {
-        glfwPollEvents();
+        glfwWaitEventsTimeout(EVENT_WAIT_TIMEOUT_SECONDS);
+
+        // Without new input the overflow would wait for the next callback
+        FlushOverflowEvents();
+
+        WindowRequest request;
+        while (requests.TryPop(request))
+        {
+            switch (request)
+            {
+            case WindowRequest::Block:
+                glfwSetWindowSize(window, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
+                glfwSetWindowPos(window, 350, 150);
+                glfwSetWindowAttrib(window, GLFW_RESIZABLE, GLFW_FALSE);
+                glfwSetWindowAttrib(window, GLFW_DECORATED, GLFW_FALSE);
+                break;
+
+            case WindowRequest::Unblock:
+                glfwSetWindowAttrib(window, GLFW_RESIZABLE, GLFW_TRUE);
+                glfwSetWindowAttrib(window, GLFW_DECORATED, GLFW_TRUE);
+                break;
+            }
+        }
+
+        PublishInput();
+    }
+
+    void Window::Wake()
+    {
+        glfwPostEmptyEvent();
     }
 
     void Window::CreateWindowSurface(VkInstance instance, VkSurfaceKHR* surface)
@@ -49,38 +103,123 @@ namespace VulkanCore {
 
     void Window::BlockWindow()
     {
-        glfwSetWindowSize(window, DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT);
-        glfwSetWindowPos(window, 350, 150);
-        glfwSetWindowAttrib(window, GLFW_RESIZABLE, GLFW_FALSE);
-        glfwSetWindowAttrib(window, GLFW_DECORATED, GLFW_FALSE);
+        Request(WindowRequest::Block);
     }
 
     void Window::UnblockWindow()
     {
-        glfwSetWindowAttrib(window, GLFW_RESIZABLE, GLFW_TRUE);
-        glfwSetWindowAttrib(window, GLFW_DECORATED, GLFW_TRUE);
+        Request(WindowRequest::Unblock);
     }
 
-    int Window::GetWidth() const
+    void Window::PublishInput()
     {
-        int width;
-        glfwGetFramebufferSize(window, &width, nullptr);
-        
-        return width;
+        InputSnapshot& snapshot = inputSnapshots.GetBack();
+        glfwGetCursorPos(window, &snapshot.mousePosition.x, &snapshot.mousePosition.y);
+        snapshot.bMouseButtonLeftPressed = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+        snapshot.sampleTime = Time::Now();
+        inputSnapshots.Publish();
     }
 
-    int Window::GetHeight() const
+    void Window::PushEvent(const WindowEvent& event)
     {
-        int height;
-        glfwGetFramebufferSize(window, nullptr, &height);
+        FlushOverflowEvents();
+        if (overflowEvents.empty() && events.TryPush(event))
+        {
+            return;
+        }
 
-        return height;
+        // A render thread stalled for long enough to fill the queue never loses a key, button or character, a release
+        // that went missing would leave it held down. Cursor moves keep the latest position and scrolls add up instead.
+        if (!overflowEvents.empty() && overflowEvents.back().type == event.type)
+        {
+            WindowEvent& last = overflowEvents.back();
+            if (event.type == WindowEventType::CursorPos)
+            {
+                last = event;
+                return;
+            }
+            if (event.type == WindowEventType::Scroll)
+            {
+                last.x += event.x;
+                last.y += event.y;
+                return;
+            }
+        }
+
+        overflowEvents.push_back(event);
+    }
+
+    void Window::FlushOverflowEvents()
+    {
+        while (!overflowEvents.empty() && events.TryPush(overflowEvents.front()))
+        {
+            overflowEvents.pop_front();
+        }
+    }
+
+    void Window::Request(WindowRequest request)
+    {
+        if (requests.TryPush(request))
+        {
+            Wake();
+        }
     }
 
     void Window::FramebufferResizeCallback(GLFWwindow* window, int width, int height)
     {
         Window* windowPtr = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-        windowPtr->framebufferResized = true;
+        windowPtr->framebufferWidth.store(width, std::memory_order_relaxed);
+        windowPtr->framebufferHeight.store(height, std::memory_order_relaxed);
+        windowPtr->framebufferResized.store(true, std::memory_order_relaxed);
+    }
+
+    void Window::WindowSizeCallback(GLFWwindow* window, int width, int height)
+    {
+        Window* windowPtr = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+        windowPtr->windowWidth.store(width, std::memory_order_relaxed);
+        windowPtr->windowHeight.store(height, std::memory_order_relaxed);
+    }
+
+    void Window::KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+    {
+        Window* windowPtr = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+        windowPtr->PushEvent({ WindowEventType::Key, key, action, mods });
+    }
+
+    void Window::CharCallback(GLFWwindow* window, unsigned int codepoint)
+    {
+        Window* windowPtr = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+        windowPtr->PushEvent({ WindowEventType::Char, static_cast<int>(codepoint) });
+    }
+
+    void Window::MouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+    {
+        Window* windowPtr = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+        windowPtr->PushEvent({ WindowEventType::MouseButton, button, action, mods });
+    }
+
+    void Window::CursorPosCallback(GLFWwindow* window, double x, double y)
+    {
+        Window* windowPtr = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+        windowPtr->PushEvent({ WindowEventType::CursorPos, 0, 0, 0, x, y });
+    }
+
+    void Window::CursorEnterCallback(GLFWwindow* window, int entered)
+    {
+        Window* windowPtr = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+        windowPtr->PushEvent({ WindowEventType::CursorEnter, entered });
+    }
+
+    void Window::ScrollCallback(GLFWwindow* window, double x, double y)
+    {
+        Window* windowPtr = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+        windowPtr->PushEvent({ WindowEventType::Scroll, 0, 0, 0, x, y });
+    }
+
+    void Window::WindowFocusCallback(GLFWwindow* window, int focused)
+    {
+        Window* windowPtr = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+        windowPtr->PushEvent({ WindowEventType::Focus, focused });
     }
 
 } // namespace VulkanCore
@@ -7,10 +7,16 @@
 
 #include "glm/glm.hpp"
 
+#include <atomic>
+#include <deque>
 #include <string>
 
+#include "Time.h"
+#include "SPSCQueue.h"
+#include "TripleBuffer.h"
+
 namespace VulkanCore {
-    
+
     struct WindowConfiguration final
     {
         const uint32_t width;
@@ -20,6 +26,40 @@ namespace VulkanCore {
         WindowConfiguration(const uint32_t& width, const uint32_t& height, const std::string& title);
     };
 
+    // Latest mouse state, sampled on the main thread right after the events are pumped
+    struct InputSnapshot
+    {
+        Time sampleTime = { 0 };
+        glm::dvec2 mousePosition = glm::dvec2(0.0, 0.0);
+        bool bMouseButtonLeftPressed = false;
+    };
+
+    enum class WindowEventType : uint8_t
+    {
+        Key,            // code = GLFW key, action, mods
+        Char,           // code = codepoint
+        MouseButton,    // code = GLFW mouse button, action, mods
+        CursorPos,      // x, y
+        CursorEnter,    // code = entered
+        Scroll,         // x, y
+        Focus           // code = focused
+    };
+
+    // GLFW callback forwarded to the render thread, in the order it was received
+    struct WindowEvent
+    {
+        WindowEventType type = WindowEventType::Key;
+        int code = 0;
+        int action = 0;
+        int mods = 0;
+        double x = 0.0;
+        double y = 0.0;
+    };
+
+    // The GLFW window is owned by the main thread, which only pumps events and samples input (see Update)
+    // The render thread reads the input through lock-free mailboxes and never calls GLFW directly:
+    // the latest InputSnapshot through a triple buffer, every callback through an event queue, the sizes through atomics.
+    // Window changes requested by the render thread (BlockWindow, UnblockWindow) are applied by the main thread on its next Update.
     class Window final
     {
     public:
@@ -37,30 +77,80 @@ namespace VulkanCore {
         Window(Window&&) = delete;
         Window& operator = (Window&&) = delete;
 
+        // Main thread, waits for events (at most EVENT_WAIT_TIMEOUT_SECONDS), applies the pending requests and publishes an InputSnapshot
         void Update();
 
+        // Any thread, wakes the main thread from Update
+        void Wake();
+
         inline bool ShouldClose() const { return glfwWindowShouldClose(window); }
 
         void CreateWindowSurface(VkInstance instance, VkSurfaceKHR* surface);
 
-        inline void ResetWindowResizedFlag() { framebufferResized = false; }
+        inline void ResetWindowResizedFlag() { framebufferResized.store(false, std::memory_order_relaxed); }
 
+        // Render thread, applied asynchronously by the main thread
         void BlockWindow();
         void UnblockWindow();
 
+        // Render thread, keeps the last snapshot and returns false if nothing was sampled since the last read
+        inline bool ReadInput(InputSnapshot& snapshot) { return inputSnapshots.TryRead(snapshot); }
+
+        // Render thread, returns false once every forwarded event was consumed
+        inline bool PopEvent(WindowEvent& event) { return events.TryPop(event); }
+
         // Getters
         inline GLFWwindow* const GetGLFWWindow() const { return window; }
-        int GetWidth() const;
-        int GetHeight() const;
-        inline bool GetWasWindowResized() const { return framebufferResized; }
+        inline int GetWidth() const { return framebufferWidth.load(std::memory_order_relaxed); }
+        inline int GetHeight() const { return framebufferHeight.load(std::memory_order_relaxed); }
+        inline int GetWindowWidth() const { return windowWidth.load(std::memory_order_relaxed); }
+        inline int GetWindowHeight() const { return windowHeight.load(std::memory_order_relaxed); }
+        inline bool GetWasWindowResized() const { return framebufferResized.load(std::memory_order_relaxed); }
 
     private:
+        static constexpr double EVENT_WAIT_TIMEOUT_SECONDS = 0.005;
+        static constexpr size_t EVENT_QUEUE_CAPACITY = 1024;
+        static constexpr size_t REQUEST_QUEUE_CAPACITY = 16;
+
+        enum class WindowRequest : uint8_t
+        {
+            Block,
+            Unblock
+        };
+
         GLFWwindow* window;
 
-        bool framebufferResized;
+        std::atomic<bool> framebufferResized;
+        std::atomic<int> framebufferWidth;
+        std::atomic<int> framebufferHeight;
+        std::atomic<int> windowWidth;
+        std::atomic<int> windowHeight;
+
+        // Main thread -> render thread
+        TripleBuffer<InputSnapshot> inputSnapshots;
+        SPSCQueue<WindowEvent, EVENT_QUEUE_CAPACITY> events;
+
+        // Main thread only, events that did not fit in the queue, retried in order before any newer event
+        std::deque<WindowEvent> overflowEvents;
+
+        // Render thread -> main thread
+        SPSCQueue<WindowRequest, REQUEST_QUEUE_CAPACITY> requests;
+
+        void PublishInput();
+        void PushEvent(const WindowEvent& event);
+        void FlushOverflowEvents();
+        void Request(WindowRequest request);
 
         // Callbacks
         static void FramebufferResizeCallback(GLFWwindow* window, int width, int height);
+        static void WindowSizeCallback(GLFWwindow* window, int width, int height);
+        static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+        static void CharCallback(GLFWwindow* window, unsigned int codepoint);
+        static void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+        static void CursorPosCallback(GLFWwindow* window, double x, double y);
+        static void CursorEnterCallback(GLFWwindow* window, int entered);
+        static void ScrollCallback(GLFWwindow* window, double x, double y);
+        static void WindowFocusCallback(GLFWwindow* window, int focused);
     };
 
 } // namespace VulkanCore
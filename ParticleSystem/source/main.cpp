@@ -6,17 +6,72 @@
 // #define GLM_ENABLE_EXPERIMENTAL
 
 #include "VulkanCore/Application.h"
+#include "VulkanCore/BenchmarkAnalyzer.h"
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 int main(int argc, char* argv[])
 {
     std::cout << "Hello World!\n\n";
 
+    // --sweep <file>: run a benchmark sweep and exit
+    // --restore <file>: start from a checkpoint saved with Tools > Save Checkpoint
+    // --import <file>: start from the particles in a raw binary or CSV file
+    // --metrics <port|socket path>: serve live metrics in Prometheus text format on 127.0.0.1:port or a Unix-domain socket
+    // --compare <baseline> <candidate>: compare two *-frametimes.csv files without opening a window, fails on a regression
+    std::string sweepFilePath;
+    std::string checkpointFilePath;
+    std::string importFilePath;
+    std::string metricsEndpoint;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--sweep" && i + 1 < argc)
+        {
+            sweepFilePath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--restore" && i + 1 < argc)
+        {
+            checkpointFilePath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--import" && i + 1 < argc)
+        {
+            importFilePath = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--metrics" && i + 1 < argc)
+        {
+            metricsEndpoint = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--compare" && i + 2 < argc)
+        {
+            try
+            {
+                const std::vector<double> baseline = VulkanCore::BenchmarkAnalyzer::LoadFrameTimes(argv[i + 1]);
+                const std::vector<double> candidate = VulkanCore::BenchmarkAnalyzer::LoadFrameTimes(argv[i + 2]);
+
+                std::cout << "Baseline: " << argv[i + 1] << '\n';
+                VulkanCore::BenchmarkAnalyzer::PrintSummary(std::cout, VulkanCore::BenchmarkAnalyzer::Summarize(baseline));
+                std::cout << "\nCandidate: " << argv[i + 2] << '\n';
+                VulkanCore::BenchmarkAnalyzer::PrintSummary(std::cout, VulkanCore::BenchmarkAnalyzer::Summarize(candidate));
+                std::cout << '\n';
+
+                const VulkanCore::RunComparison comparison = VulkanCore::BenchmarkAnalyzer::Compare(baseline, candidate);
+                VulkanCore::BenchmarkAnalyzer::PrintComparison(std::cout, comparison);
+                return comparison.verdict == VulkanCore::ComparisonVerdict::Regression ? EXIT_FAILURE : EXIT_SUCCESS;
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << e.what() << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
     try
     {
         VulkanCore::WindowConfiguration WindowConfig(DEFAULT_WINDOW_WIDTH, DEFAULT_WINDOW_HEIGHT, "Particle System");
-        VulkanCore::ApplicationConfiguration AppConfig(WindowConfig);
+        VulkanCore::ApplicationConfiguration AppConfig(WindowConfig, sweepFilePath, checkpointFilePath, importFilePath, metricsEndpoint);
 
         VulkanCore::Application App(AppConfig);
         App.Run();